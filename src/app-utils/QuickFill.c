@@ -32,20 +32,28 @@
 #include "gnc-ui-util.h"
 
 
+/* The tree is a radix trie: each node is reached through an edge that
+ * may hold several characters, and a node only exists where strings
+ * branch or end (or where a match has been asked for).  The characters
+ * of an edge are stored upper-cased, so that matching is case
+ * insensitive, and the children of a node are kept in an array sorted
+ * by the first character of their edge.  Every position along an edge
+ * leads to the same strings, so it shares the best-guess text of the
+ * node at its end. */
 struct _QuickFill
 {
-    char *text;          /* the first matching text string     */
-    int len;             /* number of chars in text string     */
-    GHashTable *matches; /* array of children in the tree      */
+    const char *text;     /* the best matching text string, cached */
+    gunichar *key;        /* the upper-cased characters of the edge */
+    guint key_len;        /* number of characters in key           */
+    guint num_children;
+    QuickFill **children; /* sorted by the first character of key  */
 };
 
 
 /** PROTOTYPES ******************************************************/
-static void quickfill_insert_recursive (QuickFill *qf, const char *text, int len,
-                                        const char* next_char, QuickFillSort sort);
-
-static void gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text,
-        gint depth, QuickFillSort sort);
+static void quickfill_insert_key (QuickFill *qf, const gunichar *key,
+                                  glong len, const char *text,
+                                  QuickFillSort sort);
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_REGISTER;
@@ -53,35 +61,58 @@ static QofLogModule log_module = GNC_MOD_REGISTER;
 /********************************************************************\
 \********************************************************************/
 
+static QuickFill *
+quickfill_node_new (const gunichar *key, guint key_len, const char *text)
+{
+    QuickFill *qf = g_new0 (QuickFill, 1);
+
+    if (key_len > 0)
+    {
+        qf->key = g_new (gunichar, key_len);
+        memcpy (qf->key, key, key_len * sizeof (gunichar));
+        qf->key_len = key_len;
+    }
+    if (text)
+        qf->text = CACHE_INSERT (text);
+
+    return qf;
+}
+
 QuickFill *
 gnc_quickfill_new (void)
 {
-    QuickFill *qf;
-
     if (sizeof (guint) < sizeof (gunichar))
     {
         PWARN ("Can't use quickfill");
         return NULL;
     }
 
-    qf = g_new (QuickFill, 1);
-
-    qf->text = NULL;
-    qf->len = 0;
-
-    qf->matches = g_hash_table_new (g_direct_hash, g_direct_equal);
-
-    return qf;
+    return quickfill_node_new (NULL, 0, NULL);
 }
 
 /********************************************************************\
 \********************************************************************/
 
-static gboolean
-destroy_helper (gpointer key, gpointer value, gpointer data)
+static void
+quickfill_set_text (QuickFill *qf, const char *text)
 {
-    gnc_quickfill_destroy (value);
-    return TRUE;
+    const char *old_text = qf->text;
+
+    qf->text = text ? CACHE_INSERT (text) : NULL;
+    if (old_text)
+        CACHE_REMOVE (old_text);
+}
+
+static void
+quickfill_destroy_children (QuickFill *qf)
+{
+    guint i;
+
+    for (i = 0; i < qf->num_children; i++)
+        gnc_quickfill_destroy (qf->children[i]);
+    g_free (qf->children);
+    qf->children = NULL;
+    qf->num_children = 0;
 }
 
 void
@@ -90,15 +121,9 @@ gnc_quickfill_destroy (QuickFill *qf)
     if (qf == NULL)
         return;
 
-    g_hash_table_foreach (qf->matches, (GHFunc)destroy_helper, NULL);
-    g_hash_table_destroy (qf->matches);
-    qf->matches = NULL;
-
-    if (qf->text)
-        g_free(qf->text);
-    qf->text = NULL;
-    qf->len = 0;
-
+    quickfill_destroy_children (qf);
+    quickfill_set_text (qf, NULL);
+    g_free (qf->key);
     g_free (qf);
 }
 
@@ -108,12 +133,8 @@ gnc_quickfill_purge (QuickFill *qf)
     if (qf == NULL)
         return;
 
-    g_hash_table_foreach_remove (qf->matches, destroy_helper, NULL);
-
-    if (qf->text)
-        g_free (qf->text);
-    qf->text = NULL;
-    qf->len = 0;
+    quickfill_destroy_children (qf);
+    quickfill_set_text (qf, NULL);
 }
 
 /********************************************************************\
@@ -128,6 +149,116 @@ gnc_quickfill_string (QuickFill *qf)
     return qf->text;
 }
 
+/********************************************************************\
+ * Children are looked up by binary search on the first character of
+ * their edge.  Returns the index of the child, or the index where it
+ * would have to be inserted.
+\********************************************************************/
+
+static guint
+quickfill_find_child (const QuickFill *qf, gunichar key, gboolean *found)
+{
+    guint low = 0, high = qf->num_children;
+
+    while (low < high)
+    {
+        guint mid = low + (high - low) / 2;
+        gunichar mid_key = qf->children[mid]->key[0];
+
+        if (mid_key < key)
+            low = mid + 1;
+        else if (mid_key > key)
+            high = mid;
+        else
+        {
+            *found = TRUE;
+            return mid;
+        }
+    }
+    *found = FALSE;
+    return low;
+}
+
+static void
+quickfill_add_child (QuickFill *qf, guint pos, QuickFill *child)
+{
+    qf->children = g_renew (QuickFill *, qf->children, qf->num_children + 1);
+    memmove (qf->children + pos + 1, qf->children + pos,
+             (qf->num_children - pos) * sizeof (QuickFill *));
+    qf->children[pos] = child;
+    qf->num_children++;
+}
+
+static void
+quickfill_remove_child (QuickFill *qf, guint pos)
+{
+    qf->num_children--;
+    memmove (qf->children + pos, qf->children + pos + 1,
+             (qf->num_children - pos) * sizeof (QuickFill *));
+    if (qf->num_children == 0)
+    {
+        g_free (qf->children);
+        qf->children = NULL;
+    }
+}
+
+/* Puts a node after the first 'at' characters of the edge to child
+ * 'pos' of qf, and returns it.  The new node holds the same strings as
+ * the old child, so it gets the same text. */
+static QuickFill *
+quickfill_split (QuickFill *qf, guint pos, guint at)
+{
+    QuickFill *child = qf->children[pos];
+    QuickFill *middle = quickfill_node_new (child->key, at, child->text);
+
+    child->key_len -= at;
+    memmove (child->key, child->key + at, child->key_len * sizeof (gunichar));
+
+    middle->children = g_new (QuickFill *, 1);
+    middle->children[0] = child;
+    middle->num_children = 1;
+    qf->children[pos] = middle;
+
+    return middle;
+}
+
+/* The reverse of quickfill_split: once qf has a single child that has
+ * the same text, no string ends at qf and it can be dropped. */
+static void
+quickfill_merge_child (QuickFill *qf)
+{
+    QuickFill *child;
+
+    if (qf->num_children != 1 || qf->children[0]->text != qf->text)
+        return;
+
+    child = qf->children[0];
+    qf->key = g_renew (gunichar, qf->key, qf->key_len + child->key_len);
+    memcpy (qf->key + qf->key_len, child->key, child->key_len * sizeof (gunichar));
+    qf->key_len += child->key_len;
+
+    g_free (qf->children);
+    qf->children = child->children;
+    qf->num_children = child->num_children;
+
+    quickfill_set_text (child, NULL);
+    g_free (child->key);
+    g_free (child);
+}
+
+/* Converts text into the upper-cased characters the tree is keyed
+ * on. */
+static gunichar *
+quickfill_make_key (const char *text, glong *len)
+{
+    gunichar *key = g_utf8_to_ucs4_fast (text, -1, len);
+    glong i;
+
+    for (i = 0; i < *len; i++)
+        key[i] = g_unichar_toupper (key[i]);
+    return key;
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -135,12 +266,19 @@ QuickFill *
 gnc_quickfill_get_char_match (QuickFill *qf, gunichar uc)
 {
     guint key = g_unichar_toupper (uc);
+    gboolean found;
+    guint pos;
 
     if (NULL == qf) return NULL;
 
     DEBUG ("xaccGetQuickFill(): index = %u\n", key);
 
-    return g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
+    pos = quickfill_find_child (qf, key, &found);
+    if (!found)
+        return NULL;
+    if (qf->children[pos]->key_len > 1)
+        return quickfill_split (qf, pos, 1);
+    return qf->children[pos];
 }
 
 /********************************************************************\
@@ -150,25 +288,44 @@ QuickFill *
 gnc_quickfill_get_string_len_match (QuickFill *qf,
                                     const char *str, int len)
 {
+    QuickFill *parent = NULL;
     const char *c;
-    gunichar uc;
+    guint offset, pos = 0;
 
     if (NULL == qf) return NULL;
     if (NULL == str) return NULL;
 
+    /* Follow the edges as far as str goes, counting how much of the
+     * current node's edge has been matched. */
+    offset = qf->key_len;
     c = str;
     while (*c && (len > 0))
     {
-        if (qf == NULL)
-            return NULL;
+        gunichar key = g_unichar_toupper (g_utf8_get_char (c));
 
-        uc = g_utf8_get_char (c);
-        qf = gnc_quickfill_get_char_match (qf, uc);
+        if (offset == qf->key_len)
+        {
+            gboolean found;
+
+            pos = quickfill_find_child (qf, key, &found);
+            if (!found)
+                return NULL;
+            parent = qf;
+            qf = qf->children[pos];
+            offset = 0;
+        }
+        if (qf->key[offset] != key)
+            return NULL;
+        offset++;
 
         c = g_utf8_next_char (c);
         len--;
     }
 
+    /* A match that ends inside an edge gets a node of its own */
+    if (offset < qf->key_len)
+        qf = quickfill_split (parent, pos, offset);
+
     return qf;
 }
 
@@ -187,14 +344,6 @@ gnc_quickfill_get_string_match (QuickFill *qf, const char *str)
 /********************************************************************\
 \********************************************************************/
 
-static void
-unique_len_helper (gpointer key, gpointer value, gpointer data)
-{
-    QuickFill **qf_p = data;
-
-    *qf_p = value;
-}
-
 QuickFill *
 gnc_quickfill_get_unique_len_match (QuickFill *qf, int *length)
 {
@@ -204,19 +353,12 @@ gnc_quickfill_get_unique_len_match (QuickFill *qf, int *length)
     if (qf == NULL)
         return NULL;
 
-    while (1)
+    while (qf->num_children == 1)
     {
-        guint count;
-
-        count = g_hash_table_size (qf->matches);
-
-        if (count != 1)
-            break;
-
-        g_hash_table_foreach (qf->matches, unique_len_helper, &qf);
+        qf = qf->children[0];
 
         if (length != NULL)
-            (*length)++;
+            *length += qf->key_len;
     }
 
     return qf;
@@ -229,15 +371,17 @@ void
 gnc_quickfill_insert (QuickFill *qf, const char *text, QuickFillSort sort)
 {
     gchar *normalized_str;
-    int len;
+    gunichar *key;
+    glong len;
 
     if (NULL == qf) return;
     if (NULL == text) return;
 
 
     normalized_str = g_utf8_normalize (text, -1, G_NORMALIZE_NFC);
-    len = g_utf8_strlen (text, -1);
-    quickfill_insert_recursive (qf, normalized_str, len, normalized_str, sort);
+    key = quickfill_make_key (normalized_str, &len);
+    quickfill_insert_key (qf, key, len, normalized_str, sort);
+    g_free (key);
     g_free (normalized_str);
 }
 
@@ -245,32 +389,9 @@ gnc_quickfill_insert (QuickFill *qf, const char *text, QuickFillSort sort)
 \********************************************************************/
 
 static void
-quickfill_insert_recursive (QuickFill *qf, const char *text, int len,
-                            const char *next_char, QuickFillSort sort)
+quickfill_update_text (QuickFill *qf, const char *text, QuickFillSort sort)
 {
-    guint key;
-    char *old_text;
-    QuickFill *match_qf;
-    gunichar key_char_uc;
-
-    if (qf == NULL)
-        return;
-
-    if ((text == NULL) || (*next_char == '\0'))
-        return;
-
-
-    key_char_uc = g_utf8_get_char (next_char);
-    key = g_unichar_toupper (key_char_uc);
-
-    match_qf = g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
-    if (match_qf == NULL)
-    {
-        match_qf = gnc_quickfill_new ();
-        g_hash_table_insert (qf->matches, GUINT_TO_POINTER (key), match_qf);
-    }
-
-    old_text = match_qf->text;
+    const char *old_text = qf->text;
 
     switch (sort)
     {
@@ -284,167 +405,150 @@ quickfill_insert_recursive (QuickFill *qf, const char *text, int len,
         /* If there's no string there already, just put the new one in. */
         if (old_text == NULL)
         {
-            match_qf->text = g_strdup(text);
-            match_qf->len = len;
+            quickfill_set_text (qf, text);
             break;
         }
 
         /* Leave prefixes in place */
-        if ((len > match_qf->len) &&
-                (strncmp(text, old_text, strlen(old_text)) == 0))
+        if ((strlen (text) > strlen (old_text)) &&
+                (strncmp (text, old_text, strlen (old_text)) == 0))
             break;
 
-        g_free(old_text);
-        match_qf->text = g_strdup(text);
-        match_qf->len = len;
+        quickfill_set_text (qf, text);
         break;
     }
-
-    quickfill_insert_recursive (match_qf, text, len, g_utf8_next_char (next_char), sort);
 }
 
-/********************************************************************\
-\********************************************************************/
-
-void
-gnc_quickfill_remove (QuickFill *qf, const gchar *text, QuickFillSort sort)
+static void
+quickfill_insert_key (QuickFill *qf, const gunichar *key, glong len,
+                      const char *text, QuickFillSort sort)
 {
-    gchar *normalized_str;
+    glong i = 0;
 
-    if (qf == NULL) return;
-    if (text == NULL) return;
+    while (i < len)
+    {
+        QuickFill *child;
+        gboolean found;
+        guint pos, common;
 
-    normalized_str = g_utf8_normalize (text, -1, G_NORMALIZE_NFC);
-    gnc_quickfill_remove_recursive (qf, normalized_str, 0, sort);
-    g_free (normalized_str);
+        pos = quickfill_find_child (qf, key[i], &found);
+        if (!found)
+        {
+            quickfill_add_child (qf, pos, quickfill_node_new (key + i, len - i,
+                                 text));
+            return;
+        }
+
+        /* The new text ends or leaves the edge here */
+        child = qf->children[pos];
+        for (common = 1; common < child->key_len && i + common < len &&
+                child->key[common] == key[i + common]; common++);
+        if (common < child->key_len)
+            child = quickfill_split (qf, pos, common);
+
+        quickfill_update_text (child, text, sort);
+        i += common;
+        qf = child;
+    }
 }
 
 /********************************************************************\
 \********************************************************************/
 
-struct _BestText
+/* Returns the alphabetically first text of the children of qf. */
+static const char *
+quickfill_best_child_text (const QuickFill *qf)
 {
-    gchar *text;
-    QuickFillSort sort;
-};
+    const char *best_text = NULL;
+    guint i;
 
-static void
-best_text_helper (gpointer key, gpointer value, gpointer user_data)
-{
-    QuickFill *qf = value;
-    struct _BestText *best = user_data;
-
-    if (best->text == NULL)
+    for (i = 0; i < qf->num_children; i++)
     {
-        /* start with the first text */
-        best->text = qf->text;
+        const char *text = qf->children[i]->text;
 
+        if (best_text == NULL || g_utf8_collate (text, best_text) < 0)
+            best_text = text;
     }
-    else if (best->text == QUICKFILL_LIFO)
-    {
-        /* we do not track history, so ignore it */
-        return;
-
-    }
-    else if (g_utf8_collate (qf->text, best->text) < 0)
-    {
-        /* even better text */
-        best->text = qf->text;
-    }
+    return best_text;
 }
 
-
-
-static void
-gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
-                                QuickFillSort sort)
+void
+gnc_quickfill_remove (QuickFill *qf, const gchar *text, QuickFillSort sort)
 {
-    QuickFill *match_qf;
-    gchar *child_text;
-    gint child_len;
+    gchar *normalized_str;
+    gunichar *key;
+    glong len, i = 0;
+    GPtrArray *path;
+    gint depth;
 
-    child_text = NULL;
-    child_len = 0;
+    if (qf == NULL) return;
+    if (text == NULL) return;
 
-    if (depth < g_utf8_strlen (text, -1))
+    normalized_str = g_utf8_normalize (text, -1, G_NORMALIZE_NFC);
+    key = quickfill_make_key (normalized_str, &len);
+
+    /* Find the nodes that text passes through */
+    path = g_ptr_array_new ();
+    g_ptr_array_add (path, qf);
+    while (i < len)
     {
-        /* process next letter */
+        QuickFill *child;
+        gboolean found;
+        guint pos = quickfill_find_child (qf, key[i], &found);
 
-        gchar *key_char;
-        gunichar key_char_uc;
-        guint key;
+        if (!found)
+            break;
+        child = qf->children[pos];
+        if (child->key_len > len - i ||
+                memcmp (child->key, key + i, child->key_len * sizeof (gunichar)) != 0)
+            break;
+        g_ptr_array_add (path, child);
+        i += child->key_len;
+        qf = child;
+    }
 
-        key_char = g_utf8_offset_to_pointer (text, depth);
-        key_char_uc = g_utf8_get_char (key_char);
-        key = g_unichar_toupper (key_char_uc);
+    /* Going back up, replace text wherever it is the best-guess text,
+     * and drop the nodes that have no strings left. */
+    for (depth = path->len - 1; depth >= 0; depth--)
+    {
+        const char *child_text = NULL;
 
-        match_qf = g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
-        if (match_qf)
+        qf = g_ptr_array_index (path, depth);
+        if (depth + 1 < (gint) path->len)
         {
-            /* remove text from child qf */
-            gnc_quickfill_remove_recursive (match_qf, text, depth + 1, sort);
+            QuickFill *child = g_ptr_array_index (path, depth + 1);
 
-            if (match_qf->text == NULL)
+            if (child->text == NULL)
             {
-                /* text was the only word with a prefix up to match_qf */
-                g_hash_table_remove (qf->matches, GUINT_TO_POINTER (key));
-                gnc_quickfill_destroy (match_qf);
-
+                /* text was the only word with a prefix up to child */
+                gboolean found;
+                quickfill_remove_child (qf, quickfill_find_child (qf, child->key[0],
+                                        &found));
+                gnc_quickfill_destroy (child);
             }
             else
             {
                 /* remember remaining best child string */
-                child_text = match_qf->text;
-                child_len = match_qf->len;
+                child_text = child->text;
             }
         }
-    }
-
-    if (qf->text == NULL)
-        return;
-
-    if (strcmp (text, qf->text) == 0)
-    {
-        /* the currently best text is about to be removed */
 
-        gchar *best_text = NULL;
-        gint best_len = 0;
-
-        if (child_text != NULL)
+        if (qf->text != NULL && strcmp (normalized_str, qf->text) == 0)
         {
-            /* other children are pretty good as well */
-            best_text = child_text;
-            best_len = child_len;
-
-        }
-        else
-        {
-            if (g_hash_table_size (qf->matches) != 0)
-            {
-                /* otherwise search for another good text */
-                struct _BestText bts;
-                bts.text = NULL;
-                bts.sort = sort;
-
-                g_hash_table_foreach (qf->matches, (GHFunc) best_text_helper, &bts);
-                best_text = bts.text;
-                best_len = (best_text == NULL) ? 0 : g_utf8_strlen (best_text, -1);
-            }
+            /* the currently best text is about to be removed */
+            if (child_text == NULL)
+                child_text = quickfill_best_child_text (qf);
+            quickfill_set_text (qf, child_text);
         }
 
-        /* now replace or clear text */
-        g_free(qf->text);
-        if (best_text != NULL)
-        {
-            qf->text = g_strdup(best_text);
-            qf->len = best_len;
-        }
-        else
-        {
-            qf->text = NULL;
-            qf->len = 0;
-        }
+        /* The root has no edge to merge into */
+        if (depth > 0)
+            quickfill_merge_child (qf);
     }
+
+    g_ptr_array_free (path, TRUE);
+    g_free (key);
+    g_free (normalized_str);
 }
 
 /********************** END OF FILE *********************************   \
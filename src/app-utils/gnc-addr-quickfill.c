@@ -47,15 +47,10 @@ listen_for_gncaddress_events(QofInstance *entity,  QofEventId event_type,
     AddressQF *qfb = user_data;
     const char *addr2, *addr3, *addr4;
 
-    /* We only listen for GncAddress events */
-    if (!GNC_IS_ADDRESS (entity))
-        return;
-
-    /* We listen for MODIFY (if the description was changed into
-     * something non-empty, so we add the string to the quickfill) and
-     * DESTROY (to remove the description from the quickfill). */
-    if (0 == (event_type & (QOF_EVENT_MODIFY | QOF_EVENT_DESTROY)))
-        return;
+    /* We only listen for GncAddress events: MODIFY (if the description
+     * was changed into something non-empty, so we add the string to the
+     * quickfill) and DESTROY (to remove the description from the
+     * quickfill). */
 
     /*     g_warning("entity %p, entity type %s, event type %s, user data %p, ecent data %p", */
     /*               entity, entity->e_type, qofeventid_to_string(event_type), user_data, event_data); */
@@ -166,8 +161,10 @@ static AddressQF* build_shared_quickfill (QofBook *book, const char * key)
     qof_query_destroy(query);
 
     result->listener =
-        qof_event_register_handler (listen_for_gncaddress_events,
-                                    result);
+        qof_event_register_filtered_handler (GNC_ID_ADDRESS,
+                                             QOF_EVENT_MODIFY | QOF_EVENT_DESTROY,
+                                             listen_for_gncaddress_events,
+                                             result);
 
     qof_book_set_data_fin (book, key, result, shared_quickfill_destroy);
 
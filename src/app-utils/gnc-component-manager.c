@@ -40,8 +40,6 @@ typedef struct
 {
     GHashTable * event_masks;
     GHashTable * entity_events;
-
-    gboolean match;
 } ComponentEventInfo;
 
 typedef struct
@@ -55,6 +53,10 @@ typedef struct
     char *component_class;
     gint component_id;
     gpointer session;
+
+    /* number of changes matching the watches, and of refreshes */
+    guint event_count;
+    guint refresh_count;
 } ComponentInfo;
 
 
@@ -64,8 +66,22 @@ static guint  suspend_counter = 0;
 static gint   next_component_id = 1;
 static GList *components = NULL;
 
-static ComponentEventInfo changes = { NULL, NULL, FALSE };
-static ComponentEventInfo changes_backup = { NULL, NULL, FALSE };
+static ComponentEventInfo changes = { NULL, NULL };
+static ComponentEventInfo changes_backup = { NULL, NULL };
+
+/* Indexes of the components, by id and by the entities and entity
+ * types they watch, so that a refresh only visits the components
+ * affected by the changes. The watch indexes map a GncGUID or an
+ * entity type to a GPtrArray of ComponentInfo. */
+static GHashTable *components_by_id = NULL;
+static GHashTable *entity_watchers = NULL;
+static GHashTable *type_watchers = NULL;
+
+/* Refreshes for engine events wait for the main loop to be idle, so
+ * that a run of events is handled once.  Refreshes asked for by
+ * gnc_gui_refresh_all and gnc_resume_gui_refresh happen right away and
+ * take over any waiting one. */
+static guint refresh_idle_id = 0;
 
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -74,6 +90,7 @@ static QofLogModule log_module = GNC_MOD_GUI;
 
 /** Prototypes ******************************************************/
 static void gnc_gui_refresh_internal (gboolean force);
+static gboolean gnc_gui_refresh_idle (gpointer user_data);
 static GList * find_component_ids_by_class (const char *component_class);
 static gboolean got_events = FALSE;
 
@@ -177,6 +194,80 @@ clear_event_info (ComponentEventInfo *cei)
     clear_event_hash (cei->entity_events);
 }
 
+static void
+index_entity_watch (const GncGUID *entity, ComponentInfo *ci)
+{
+    GPtrArray *watchers;
+
+    watchers = g_hash_table_lookup (entity_watchers, entity);
+    if (!watchers)
+    {
+        GncGUID *key;
+
+        key = guid_malloc ();
+        *key = *entity;
+
+        watchers = g_ptr_array_new ();
+        g_hash_table_insert (entity_watchers, key, watchers);
+    }
+
+    g_ptr_array_add (watchers, ci);
+}
+
+static void
+index_type_watch (QofIdTypeConst entity_type, ComponentInfo *ci)
+{
+    GPtrArray *watchers;
+
+    watchers = g_hash_table_lookup (type_watchers, entity_type);
+    if (!watchers)
+    {
+        char * key = qof_string_cache_insert ((gpointer) entity_type);
+
+        watchers = g_ptr_array_new ();
+        g_hash_table_insert (type_watchers, key, watchers);
+    }
+
+    g_ptr_array_add (watchers, ci);
+}
+
+static void
+unindex_watch (GHashTable *index, gconstpointer key, ComponentInfo *ci)
+{
+    GPtrArray *watchers;
+
+    watchers = g_hash_table_lookup (index, key);
+    if (!watchers)
+        return;
+
+    g_ptr_array_remove_fast (watchers, ci);
+
+    if (watchers->len == 0)
+        g_hash_table_remove (index, key);
+}
+
+static void
+unindex_entity_watches (ComponentInfo *ci)
+{
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init (&iter, ci->watch_info.entity_events);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        unindex_watch (entity_watchers, key, ci);
+}
+
+static void
+unindex_type_watches (ComponentInfo *ci)
+{
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init (&iter, ci->watch_info.event_masks);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        unindex_watch (type_watchers, key, ci);
+}
+
 static void
 add_event (ComponentEventInfo *cei, const GncGUID *entity,
            QofEventId event_mask, gboolean or_in)
@@ -253,34 +344,45 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
 }
 
 static void
-gnc_cm_event_handler (QofInstance *entity,
-                      QofEventId event_type,
-                      gpointer user_data,
-                      gpointer event_data)
+gnc_cm_event_handler (const QofEventInfo *events,
+                      guint n_events,
+                      gpointer user_data)
 {
-    const GncGUID *guid = qof_entity_get_guid(entity);
+    guint i;
+
+    /* nobody to tell about it */
+    if (!components)
+        return;
+
+    for (i = 0; i < n_events; i++)
+    {
+        const QofEventInfo *event = &events[i];
 #if CM_DEBUG
-    gchar guidstr[GUID_ENCODING_LENGTH+1];
-    guid_to_string_buff (guid, guidstr);
-    fprintf (stderr, "event_handler: event %d, entity %p, guid %s\n", event_type,
-             entity, guidstr);
+        gchar guidstr[GUID_ENCODING_LENGTH+1];
+        guid_to_string_buff (&event->guid, guidstr);
+        fprintf (stderr, "event_handler: event %d, type %s, guid %s\n",
+                 event->event_type, event->entity_type, guidstr);
 #endif
-    add_event (&changes, guid, event_type, TRUE);
+        add_event (&changes, &event->guid, event->event_type, TRUE);
 
-    if (QOF_CHECK_TYPE(entity, GNC_ID_SPLIT))
-    {
-        /* split events are never generated by the engine, but might
-         * be generated by a backend (viz. the postgres backend.)
-         * Handle them like a transaction modify event. */
-        add_event_type (&changes, GNC_ID_TRANS, QOF_EVENT_MODIFY, TRUE);
+        if (g_strcmp0 (event->entity_type, GNC_ID_SPLIT) == 0)
+        {
+            /* split events are never generated by the engine, but might
+             * be generated by a backend (viz. the postgres backend.)
+             * Handle them like a transaction modify event. */
+            add_event_type (&changes, GNC_ID_TRANS, QOF_EVENT_MODIFY, TRUE);
+        }
+        else if (event->entity_type)
+            add_event_type (&changes, event->entity_type, event->event_type,
+                            TRUE);
     }
-    else
-        add_event_type (&changes, entity->e_type, event_type, TRUE);
 
     got_events = TRUE;
 
-    if (suspend_counter == 0)
-        gnc_gui_refresh_internal (FALSE);
+    /* Bulk operations generate many events in a row, so they are
+     * handled with a single refresh once the main loop is idle. */
+    if (suspend_counter == 0 && refresh_idle_id == 0)
+        refresh_idle_id = g_idle_add (gnc_gui_refresh_idle, NULL);
 }
 
 static gint handler_id;
@@ -300,7 +402,10 @@ gnc_component_manager_init (void)
     changes_backup.event_masks = g_hash_table_new (g_str_hash, g_str_equal);
     changes_backup.entity_events = guid_hash_table_new ();
 
-    handler_id = qof_event_register_handler (gnc_cm_event_handler, NULL);
+    /* Components may watch any entity, so all events are needed; taking
+     * them in batches spares bulk edits a call per event. */
+    handler_id = qof_event_register_batch_handler (NULL, QOF_EVENT_NONE,
+                                                   gnc_cm_event_handler, NULL);
 }
 
 void
@@ -324,23 +429,23 @@ gnc_component_manager_shutdown (void)
     destroy_event_hash (changes_backup.entity_events);
     changes_backup.entity_events = NULL;
 
+    if (refresh_idle_id)
+    {
+        g_source_remove (refresh_idle_id);
+        refresh_idle_id = 0;
+    }
+
     qof_event_unregister_handler (handler_id);
 }
 
 static ComponentInfo *
 find_component (gint component_id)
 {
-    GList *node;
-
-    for (node = components; node; node = node->next)
-    {
-        ComponentInfo *ci = node->data;
-
-        if (ci->component_id == component_id)
-            return ci;
-    }
+    if (!components_by_id)
+        return NULL;
 
-    return NULL;
+    return g_hash_table_lookup (components_by_id,
+                                GINT_TO_POINTER (component_id));
 }
 
 static GList *
@@ -385,6 +490,19 @@ gnc_register_gui_component_internal (const char * component_class)
 
     g_return_val_if_fail (component_class, NULL);
 
+    if (!components_by_id)
+    {
+        components_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+        entity_watchers =
+            g_hash_table_new_full (guid_hash_to_guint, guid_g_hash_table_equal,
+                                   (GDestroyNotify) guid_free,
+                                   (GDestroyNotify) g_ptr_array_unref);
+        type_watchers =
+            g_hash_table_new_full (g_str_hash, g_str_equal,
+                                   (GDestroyNotify) qof_string_cache_remove,
+                                   (GDestroyNotify) g_ptr_array_unref);
+    }
+
     /* look for a free handler id */
     component_id = next_component_id;
 
@@ -410,6 +528,7 @@ gnc_register_gui_component_internal (const char * component_class)
     ci->session = NULL;
 
     components = g_list_prepend (components, ci);
+    g_hash_table_insert (components_by_id, GINT_TO_POINTER (component_id), ci);
 
     /* update id for next registration */
     next_component_id = component_id + 1;
@@ -465,6 +584,14 @@ gnc_gui_component_watch_entity (gint component_id,
         return;
     }
 
+    if (!g_hash_table_lookup (ci->watch_info.entity_events, entity))
+    {
+        if (event_mask != 0)
+            index_entity_watch (entity, ci);
+    }
+    else if (event_mask == 0)
+        unindex_watch (entity_watchers, entity, ci);
+
     add_event (&ci->watch_info, entity, event_mask, FALSE);
 }
 
@@ -482,6 +609,10 @@ gnc_gui_component_watch_entity_type (gint component_id,
         return;
     }
 
+    if (entity_type &&
+            !g_hash_table_lookup (ci->watch_info.event_masks, entity_type))
+        index_type_watch (entity_type, ci);
+
     add_event_type (&ci->watch_info, entity_type, event_mask, FALSE);
 }
 
@@ -506,9 +637,29 @@ gnc_gui_component_clear_watches (gint component_id)
         return;
     }
 
+    unindex_entity_watches (ci);
     clear_event_info (&ci->watch_info);
 }
 
+void
+gnc_gui_component_get_event_counts (gint component_id, guint *events,
+                                    guint *refreshes)
+{
+    ComponentInfo *ci;
+
+    ci = find_component (component_id);
+    if (!ci)
+    {
+        PERR ("component not found");
+        return;
+    }
+
+    if (events)
+        *events = ci->event_count;
+    if (refreshes)
+        *refreshes = ci->refresh_count;
+}
+
 void
 gnc_unregister_gui_component (gint component_id)
 {
@@ -528,8 +679,10 @@ gnc_unregister_gui_component (gint component_id)
 #endif
 
     gnc_gui_component_clear_watches (component_id);
+    unindex_type_watches (ci);
 
     components = g_list_remove (components, ci);
+    g_hash_table_remove (components_by_id, GINT_TO_POINTER (component_id));
 
     destroy_mask_hash (ci->watch_info.event_masks);
     ci->watch_info.event_masks = NULL;
@@ -597,69 +750,94 @@ gnc_resume_gui_refresh (void)
 }
 
 static void
-match_type_helper (gpointer key, gpointer value, gpointer user_data)
+match_watchers (GHashTable *matched, GPtrArray *watchers, gboolean by_type,
+                gconstpointer key, QofEventId event_mask)
 {
-    ComponentEventInfo *cei = user_data;
-    QofIdType id_type = key;
-    QofEventId * et = value;
-    QofEventId * et_2;
+    guint i;
 
-    et_2 = g_hash_table_lookup (cei->event_masks, id_type);
-    if (!et_2)
+    if (!watchers)
         return;
 
-    if (*et & *et_2)
-        cei->match = TRUE;
-}
+    for (i = 0; i < watchers->len; i++)
+    {
+        ComponentInfo *ci = g_ptr_array_index (watchers, i);
 
-static void
-match_helper (gpointer key, gpointer value, gpointer user_data)
-{
-    GncGUID *guid = key;
-    EventInfo *ei_1 = value;
-    EventInfo *ei_2;
-    ComponentEventInfo *cei = user_data;
+        if (by_type)
+        {
+            QofEventId *mask;
 
-    ei_2 = g_hash_table_lookup (cei->entity_events, guid);
-    if (!ei_2)
-        return;
+            mask = g_hash_table_lookup (ci->watch_info.event_masks, key);
+            if (!mask || !(*mask & event_mask))
+                continue;
+        }
+        else
+        {
+            EventInfo *ei;
 
-    if (ei_1->event_mask & ei_2->event_mask)
-        cei->match = TRUE;
+            ei = g_hash_table_lookup (ci->watch_info.entity_events, key);
+            if (!ei || !(ei->event_mask & event_mask))
+                continue;
+        }
+
+        ci->event_count++;
+        g_hash_table_add (matched, GINT_TO_POINTER (ci->component_id));
+    }
 }
 
-static gboolean
-changes_match (ComponentEventInfo *cei, ComponentEventInfo *changes)
+static gint
+compare_component_ids (gconstpointer a, gconstpointer b)
 {
-    ComponentEventInfo *big_cei;
-    GHashTable *smalltable;
+    return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
+}
+
+/* Return the ids of the components watching any of the changes,
+ * in order of registration. */
+static GList *
+find_component_ids_by_changes (ComponentEventInfo *changes)
+{
+    GHashTable *matched;
+    GHashTableIter iter;
+    gpointer key, value;
+    GList *list;
 
-    if (cei == NULL)
-        return FALSE;
+    if (!type_watchers)
+        return NULL;
 
-    /* check types first, for efficiency */
-    cei->match = FALSE;
-    g_hash_table_foreach (changes->event_masks, match_type_helper, cei);
-    if (cei->match)
-        return TRUE;
+    matched = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-    if (g_hash_table_size (cei->entity_events) <=
-            g_hash_table_size (changes->entity_events))
+    g_hash_table_iter_init (&iter, changes->event_masks);
+    while (g_hash_table_iter_next (&iter, &key, &value))
     {
-        smalltable = cei->entity_events;
-        big_cei = changes;
+        QofEventId *mask = value;
+
+        match_watchers (matched, g_hash_table_lookup (type_watchers, key),
+                        TRUE, key, *mask);
     }
-    else
+
+    g_hash_table_iter_init (&iter, changes->entity_events);
+    while (g_hash_table_iter_next (&iter, &key, &value))
     {
-        smalltable = changes->entity_events;
-        big_cei = cei;
+        EventInfo *ei = value;
+
+        match_watchers (matched, g_hash_table_lookup (entity_watchers, key),
+                        FALSE, key, ei->event_mask);
     }
 
-    big_cei->match = FALSE;
+    list = g_hash_table_get_keys (matched);
+    g_hash_table_destroy (matched);
+
+    return g_list_sort (list, compare_component_ids);
+}
+
+static gboolean
+gnc_gui_refresh_idle (gpointer user_data)
+{
+    refresh_idle_id = 0;
 
-    g_hash_table_foreach (smalltable, match_helper, big_cei);
+    if (suspend_counter == 0)
+        gnc_gui_refresh_internal (FALSE);
 
-    return big_cei->match;
+    return FALSE;
 }
 
 static void
@@ -668,6 +846,12 @@ gnc_gui_refresh_internal (gboolean force)
     GList *list;
     GList *node;
 
+    if (refresh_idle_id)
+    {
+        g_source_remove (refresh_idle_id);
+        refresh_idle_id = 0;
+    }
+
     if (!got_events && !force)
         return;
 
@@ -689,7 +873,10 @@ gnc_gui_refresh_internal (gboolean force)
     fprintf (stderr, "%srefresh!\n", force ? "forced " : "");
 #endif
 
-    list = find_component_ids_by_class (NULL);
+    if (force)
+        list = find_component_ids_by_class (NULL);
+    else
+        list = find_component_ids_by_changes (&changes_backup);
 
     for (node = list; node; node = node->next)
     {
@@ -706,32 +893,12 @@ gnc_gui_refresh_internal (gboolean force)
             continue;
         }
 
-        if (force)
-        {
-            if (ci->refresh_handler)
-            {
-#if CM_DEBUG
-                fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
-#endif
-                ci->refresh_handler (NULL, ci->user_data);
-            }
-        }
-        else if (changes_match (&ci->watch_info, &changes_backup))
-        {
-            if (ci->refresh_handler)
-            {
-#if CM_DEBUG
-                fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
-#endif
-                ci->refresh_handler (changes_backup.entity_events, ci->user_data);
-            }
-        }
-        else
-        {
 #if CM_DEBUG
-            fprintf (stderr, "no match for %s:%d\n", ci->component_class, ci->component_id);
+        fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
 #endif
-        }
+        ci->refresh_count++;
+        ci->refresh_handler (force ? NULL : changes_backup.entity_events,
+                             ci->user_data);
     }
 
     clear_event_info (&changes_backup);
@@ -205,6 +205,22 @@ const EventInfo * gnc_gui_get_entity_events (GHashTable *changes,
  */
 void gnc_gui_component_clear_watches (gint component_id);
 
+/* gnc_gui_component_get_event_counts
+ *   Return how often the component's watches matched a change,
+ *   and how often its refresh handler was invoked.
+ *
+ * component_id: id of component to get the counts of.
+ * events:       if non-NULL, set to the number of matching changes.
+ * refreshes:    if non-NULL, set to the number of refreshes.
+ *
+ * Notes:        events are collected and handed to the refresh
+ *               handlers once the main loop is idle, so a
+ *               component usually sees many changes per refresh.
+ */
+void gnc_gui_component_get_event_counts (gint component_id,
+        guint *events,
+        guint *refreshes);
+
 /* gnc_unregister_gui_component
  *   Unregister a gui component from the manager.
  *
@@ -235,12 +251,15 @@ void gnc_suspend_gui_refresh (void);
  *   Each call reduces the suspend counter by one. When
  *   the counter reaches zero, all changes which have
  *   occurred since the last refresh are collected and
- *   passed to the components in refresh handlers.
+ *   passed to the components in refresh handlers before
+ *   this routine returns.
  */
 void gnc_resume_gui_refresh (void);
 
 /* gnc_gui_refresh_all
- *   Force all components to refresh.
+ *   Force all components to refresh before this routine
+ *   returns, including for any changes still waiting for
+ *   the main loop to be idle.
  *
  *   This routine may only be invoked when the suspend counter
  *   is zero. It should never be mixed with the suspend/resume
@@ -46,15 +46,10 @@ listen_for_gncentry_events(QofInstance *entity,  QofEventId event_type,
     QuickFill *qf = qfb->qf;
     const char *desc;
 
-    /* We only listen for GncEntry events */
-    if (!GNC_IS_ENTRY (entity))
-        return;
-
-    /* We listen for MODIFY (if the description was changed into
-     * something non-empty, so we add the string to the quickfill) and
-     * DESTROY (to remove the description from the quickfill). */
-    if (0 == (event_type & (QOF_EVENT_MODIFY | QOF_EVENT_DESTROY)))
-        return;
+    /* We only listen for GncEntry events: MODIFY (if the description
+     * was changed into something non-empty, so we add the string to the
+     * quickfill) and DESTROY (to remove the description from the
+     * quickfill). */
 
     /*     g_warning("entity %p, entity type %s, event type %s, user data %p, ecent data %p", */
     /*               entity, entity->e_type, qofeventid_to_string(event_type), user_data, event_data); */
@@ -139,8 +134,10 @@ static EntryQF* build_shared_quickfill (QofBook *book, const char * key, gboolea
     qof_query_destroy(query);
 
     result->listener =
-        qof_event_register_handler (listen_for_gncentry_events,
-                                    result);
+        qof_event_register_filtered_handler (GNC_ID_ENTRY,
+                                             QOF_EVENT_MODIFY | QOF_EVENT_DESTROY,
+                                             listen_for_gncentry_events,
+                                             result);
 
     qof_book_set_data_fin (book, key, result, shared_quickfill_destroy);
 
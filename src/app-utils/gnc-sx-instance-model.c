@@ -552,6 +552,7 @@ gnc_sx_instance_model_dispose(GObject *object)
     model->disposed = TRUE;
 
     qof_event_unregister_handler(model->qof_event_handler_id);
+    qof_event_unregister_handler(model->qof_sxes_event_handler_id);
 
     G_OBJECT_CLASS(parent_class)->dispose(object);
 }
@@ -668,7 +669,14 @@ gnc_sx_instance_model_init(GTypeInstance *instance, gpointer klass)
 
     g_date_clear(&inst->range_end, 1);
     inst->sx_instance_list = NULL;
-    inst->qof_event_handler_id = qof_event_register_handler(_gnc_sx_instance_event_handler, inst);
+    /* Only the SXes themselves and the book's list of them matter */
+    inst->qof_event_handler_id =
+        qof_event_register_filtered_handler(GNC_ID_SCHEDXACTION, QOF_EVENT_MODIFY,
+                                            _gnc_sx_instance_event_handler, inst);
+    inst->qof_sxes_event_handler_id =
+        qof_event_register_filtered_handler(GNC_ID_SXES,
+                                            GNC_EVENT_ITEM_ADDED | GNC_EVENT_ITEM_REMOVED,
+                                            _gnc_sx_instance_event_handler, inst);
 }
 
 static gint
@@ -1301,6 +1309,11 @@ gnc_sx_instance_model_effect_change(GncSxInstanceModel *model,
         return;
     }
 
+    /* Creating the transactions generates many events; let the batch
+     * handlers have them all at once, and a database backend store the
+     * transactions together. */
+    qof_event_begin_batch();
+    qof_book_begin_bulk_commit(gnc_get_current_book());
     for (iter = model->sx_instance_list; iter != NULL; iter = iter->next)
     {
         GList *instance_iter;
@@ -1390,6 +1403,8 @@ gnc_sx_instance_model_effect_change(GncSxInstanceModel *model,
         gnc_sx_set_instance_count(instances->sx, instance_count);
         xaccSchedXactionSetRemOccur(instances->sx, remain_occur_count);
     }
+    qof_book_end_bulk_commit(gnc_get_current_book());
+    qof_event_end_batch();
 }
 
 void
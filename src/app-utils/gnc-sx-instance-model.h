@@ -48,6 +48,7 @@ typedef struct _GncSxInstanceModel
 
     /* private */
     gint qof_event_handler_id;
+    gint qof_sxes_event_handler_id;
 
     /* signals */
     /* void (*added)(SchedXaction *sx); // gpointer user_data */
@@ -0,0 +1,141 @@
+/********************************************************************\
+ * gnc-trans-quickfill.c -- Create a transaction description        *
+ *                          quick-fill                              *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+#include <string.h>
+#include "gnc-trans-quickfill.h"
+#include "engine/gnc-event.h"
+#include "engine/gnc-engine.h"
+#include "engine/Transaction.h"
+
+/* This static indicates the debugging module that this .o belongs to. */
+G_GNUC_UNUSED static QofLogModule log_module = GNC_MOD_REGISTER;
+
+typedef struct
+{
+    QuickFill *qf;
+    QuickFillSort qf_sort;
+    QofBook *book;
+    gint  listener;
+} TransQF;
+
+static void
+listen_for_trans_events(QofInstance *entity,  QofEventId event_type,
+                        gpointer user_data, gpointer event_data)
+{
+    TransQF *qfb = user_data;
+    const char *desc;
+
+    /* We only listen for Transaction MODIFY events: a committed
+     * transaction may carry a new description.  Deleted transactions
+     * are not removed: the description is likely still used by
+     * others. */
+    if (qof_instance_get_book (entity) != qfb->book)
+        return;
+
+    desc = xaccTransGetDescription (GNC_TRANSACTION (entity));
+    if (!desc || strlen(desc) == 0)
+        return;
+
+    /* Add the new string to the quickfill */
+    gnc_quickfill_insert (qfb->qf, desc, qfb->qf_sort);
+}
+
+static void
+shared_quickfill_destroy (QofBook *book, gpointer key, gpointer user_data)
+{
+    TransQF *qfb = user_data;
+    gnc_quickfill_destroy (qfb->qf);
+    qof_event_unregister_handler (qfb->listener);
+    g_free (qfb);
+}
+
+static void trans_cb (QofInstance *inst, gpointer user_data)
+{
+    GPtrArray *transactions = user_data;
+    g_ptr_array_add (transactions, inst);
+}
+
+static gint trans_date_compare (gconstpointer a, gconstpointer b)
+{
+    time64 date_a = xaccTransGetDate (*(Transaction * const *) a);
+    time64 date_b = xaccTransGetDate (*(Transaction * const *) b);
+
+    return (date_a > date_b) - (date_a < date_b);
+}
+
+/* The transactions are taken from the book's collection rather than
+ * with a query, so that a SQL backend isn't asked to load them all. */
+static TransQF* build_shared_quickfill (QofBook *book, const char * key)
+{
+    TransQF *result;
+    GPtrArray *transactions = g_ptr_array_new ();
+    guint i;
+
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            trans_cb, transactions);
+
+    /* Oldest first, so that the latest description wins, as it used
+     * to when every register loaded its own. */
+    g_ptr_array_sort (transactions, trans_date_compare);
+
+    result = g_new0(TransQF, 1);
+
+    result->qf = gnc_quickfill_new();
+    result->qf_sort = QUICKFILL_LIFO;
+    result->book = book;
+
+    for (i = 0; i < transactions->len; i++)
+        gnc_quickfill_insert (result->qf,
+                              xaccTransGetDescription (g_ptr_array_index (transactions, i)),
+                              result->qf_sort);
+
+    g_ptr_array_free (transactions, TRUE);
+
+    result->listener =
+        qof_event_register_filtered_handler (GNC_ID_TRANS, QOF_EVENT_MODIFY,
+                                             listen_for_trans_events,
+                                             result);
+
+    qof_book_set_data_fin (book, key, result, shared_quickfill_destroy);
+
+    return result;
+}
+
+QuickFill * gnc_get_shared_trans_desc_quickfill (QofBook *book,
+        const char * key)
+{
+    TransQF *qfb;
+
+    g_assert(book);
+    g_assert(key);
+
+    qfb = qof_book_get_data (book, key);
+
+    if (!qfb)
+    {
+        qfb = build_shared_quickfill(book, key);
+    }
+
+    return qfb->qf;
+}
@@ -0,0 +1,321 @@
+/********************************************************************
+ * test-gnc-component-manager.c: GLib g_test test suite for         *
+ * gnc-component-manager.c.                                         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, you can retrieve it from        *
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html            *
+ * or contact:                                                      *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include <config.h>
+#include <glib.h>
+#include <unittest-support.h>
+#include <qof.h>
+#include "Account.h"
+#include "Transaction.h"
+
+#include "../gnc-component-manager.h"
+
+static const gchar *suitename = "/app-utils/gnc-component-manager";
+void test_suite_gnc_component_manager (void);
+
+#define TEST_COMPONENT_CLASS "test-component"
+
+typedef struct
+{
+    guint refreshes;
+    /* The events of the watched entity in the last refresh */
+    QofEventId entity_events;
+    const GncGUID *entity;
+} RefreshData;
+
+typedef struct
+{
+    QofBook *book;
+    Account *acc1;
+    Account *acc2;
+    RefreshData data1;
+    RefreshData data2;
+    gint id1;
+    gint id2;
+} Fixture;
+
+static void
+refresh_handler (GHashTable *changes, gpointer user_data)
+{
+    RefreshData *data = user_data;
+    const EventInfo *info = gnc_gui_get_entity_events (changes, data->entity);
+
+    data->refreshes++;
+    data->entity_events = info ? info->event_mask : 0;
+}
+
+/* Refreshes wait for the main loop to be idle; run it until they are
+ * done. */
+static void
+run_idle (void)
+{
+    while (g_main_context_iteration (NULL, FALSE))
+        ;
+}
+
+static void
+gen_event (Account *acc, QofEventId event_id)
+{
+    qof_event_gen (QOF_INSTANCE (acc), event_id, NULL);
+}
+
+static void
+setup (Fixture *fixture, gconstpointer pData)
+{
+    fixture->book = qof_book_new ();
+    fixture->acc1 = xaccMallocAccount (fixture->book);
+    fixture->acc2 = xaccMallocAccount (fixture->book);
+
+    /* Drop any changes left over from earlier tests */
+    gnc_gui_refresh_all ();
+
+    fixture->data1.entity = xaccAccountGetGUID (fixture->acc1);
+    fixture->data2.entity = xaccAccountGetGUID (fixture->acc1);
+    fixture->id1 = gnc_register_gui_component (TEST_COMPONENT_CLASS,
+                                               refresh_handler, NULL,
+                                               &fixture->data1);
+    fixture->id2 = gnc_register_gui_component (TEST_COMPONENT_CLASS,
+                                               refresh_handler, NULL,
+                                               &fixture->data2);
+}
+
+static void
+teardown (Fixture *fixture, gconstpointer pData)
+{
+    gnc_unregister_gui_component (fixture->id1);
+    gnc_unregister_gui_component (fixture->id2);
+    run_idle ();
+    qof_book_destroy (fixture->book);
+    test_clear_error_list ();
+}
+
+static void
+test_watch_entity (Fixture *fixture, gconstpointer pData)
+{
+    RefreshData *data = &fixture->data1;
+
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc1),
+                                    QOF_EVENT_MODIFY);
+
+    /* Another entity */
+    gen_event (fixture->acc2, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 0);
+
+    /* The watched entity */
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 1);
+    g_assert_cmpint (data->entity_events, ==, QOF_EVENT_MODIFY);
+
+    /* An event outside the mask */
+    gen_event (fixture->acc1, QOF_EVENT_DESTROY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 1);
+
+    /* A mask of 0 stops the watch */
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc1), 0);
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 1);
+
+    /* The other component never watched anything */
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 0);
+}
+
+static void
+test_watch_entity_type (Fixture *fixture, gconstpointer pData)
+{
+    Transaction *trans = xaccMallocTransaction (fixture->book);
+
+    /* Component 1 watches all accounts, component 2 only acc1 */
+    gnc_gui_component_watch_entity_type (fixture->id1, GNC_ID_ACCOUNT,
+                                         QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity (fixture->id2,
+                                    xaccAccountGetGUID (fixture->acc1),
+                                    QOF_EVENT_MODIFY);
+
+    gen_event (fixture->acc2, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 1);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 0);
+
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 2);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 1);
+
+    /* Neither the type nor the event are watched */
+    qof_event_gen (QOF_INSTANCE (trans), QOF_EVENT_MODIFY, NULL);
+    gen_event (fixture->acc2, QOF_EVENT_ADD);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 2);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 1);
+
+    /* A mask of 0 stops the type watch */
+    gnc_gui_component_watch_entity_type (fixture->id1, GNC_ID_ACCOUNT, 0);
+    gen_event (fixture->acc2, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 2);
+}
+
+static void
+test_clear_watches (Fixture *fixture, gconstpointer pData)
+{
+    RefreshData *data = &fixture->data1;
+
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc1),
+                                    QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity_type (fixture->id1, GNC_ID_ACCOUNT,
+                                         QOF_EVENT_DESTROY);
+    gnc_gui_component_clear_watches (fixture->id1);
+
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    gen_event (fixture->acc2, QOF_EVENT_DESTROY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 0);
+
+    /* Watching again after clearing */
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc2),
+                                    QOF_EVENT_MODIFY);
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 0);
+    gen_event (fixture->acc2, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 1);
+
+    gnc_gui_component_watch_entity_type (fixture->id1, GNC_ID_ACCOUNT,
+                                         QOF_EVENT_DESTROY);
+    gen_event (fixture->acc1, QOF_EVENT_DESTROY);
+    run_idle ();
+    g_assert_cmpuint (data->refreshes, ==, 2);
+}
+
+static void
+test_refresh_coalesced (Fixture *fixture, gconstpointer pData)
+{
+    guint events, refreshes, i;
+
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc1),
+                                    QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc2),
+                                    QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity_type (fixture->id2, GNC_ID_ACCOUNT,
+                                         QOF_EVENT_MODIFY | QOF_EVENT_ADD);
+
+    /* Nothing is refreshed until the main loop is idle, and then
+     * every component only once */
+    for (i = 0; i < 100; i++)
+    {
+        gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+        gen_event (fixture->acc2, QOF_EVENT_MODIFY);
+    }
+    gen_event (fixture->acc1, QOF_EVENT_ADD);
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 0);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 0);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 1);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 1);
+    g_assert_cmpint (fixture->data1.entity_events, ==,
+                     QOF_EVENT_MODIFY | QOF_EVENT_ADD);
+
+    /* The events are counted once per changed entity or type */
+    gnc_gui_component_get_event_counts (fixture->id1, &events, &refreshes);
+    g_assert_cmpuint (events, ==, 2);
+    g_assert_cmpuint (refreshes, ==, 1);
+    gnc_gui_component_get_event_counts (fixture->id2, &events, &refreshes);
+    g_assert_cmpuint (events, ==, 1);
+    g_assert_cmpuint (refreshes, ==, 1);
+
+    /* While suspended nothing is refreshed, not even when idle; resuming
+     * refreshes at once */
+    gnc_suspend_gui_refresh ();
+    for (i = 0; i < 100; i++)
+        gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 1);
+    gnc_resume_gui_refresh ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 2);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 2);
+    run_idle ();
+
+    gnc_gui_component_get_event_counts (fixture->id1, &events, &refreshes);
+    g_assert_cmpuint (events, ==, 3);
+    g_assert_cmpuint (refreshes, ==, 2);
+}
+
+static void
+test_refresh_explicit (Fixture *fixture, gconstpointer pData)
+{
+    gnc_gui_component_watch_entity (fixture->id1,
+                                    xaccAccountGetGUID (fixture->acc1),
+                                    QOF_EVENT_MODIFY);
+
+    /* Asking for a refresh doesn't wait for the main loop, and the
+     * refresh the events were waiting for doesn't happen again */
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 0);
+    gnc_gui_refresh_all ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 1);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 1);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 1);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 1);
+
+    /* Without any events, every component is still refreshed */
+    gnc_gui_refresh_all ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 2);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 2);
+
+    /* Resuming takes over an event driven refresh as well */
+    gen_event (fixture->acc1, QOF_EVENT_MODIFY);
+    gnc_suspend_gui_refresh ();
+    gnc_resume_gui_refresh ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 3);
+    run_idle ();
+    g_assert_cmpuint (fixture->data1.refreshes, ==, 3);
+    g_assert_cmpuint (fixture->data2.refreshes, ==, 2);
+}
+
+void
+test_suite_gnc_component_manager (void)
+{
+    GNC_TEST_ADD (suitename, "watch entity", Fixture, NULL, setup,
+                  test_watch_entity, teardown);
+    GNC_TEST_ADD (suitename, "watch entity type", Fixture, NULL, setup,
+                  test_watch_entity_type, teardown);
+    GNC_TEST_ADD (suitename, "clear watches", Fixture, NULL, setup,
+                  test_clear_watches, teardown);
+    GNC_TEST_ADD (suitename, "refresh coalesced", Fixture, NULL, setup,
+                  test_refresh_coalesced, teardown);
+    GNC_TEST_ADD (suitename, "refresh explicit", Fixture, NULL, setup,
+                  test_refresh_explicit, teardown);
+}
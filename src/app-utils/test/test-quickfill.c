@@ -0,0 +1,131 @@
+/********************************************************************\
+ * test-quickfill.c -- Tests of the QuickFill tree                  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+#include <glib.h>
+#include "qof.h"
+#include "QuickFill.h"
+
+static const gchar *
+match_text (QuickFill *qf, const gchar *str)
+{
+    return gnc_quickfill_string (gnc_quickfill_get_string_match (qf, str));
+}
+
+static void
+test_quickfill_match (void)
+{
+    QuickFill *qf = gnc_quickfill_new ();
+    QuickFill *match;
+    int len;
+
+    gnc_quickfill_insert (qf, "Groceries", QUICKFILL_LIFO);
+    gnc_quickfill_insert (qf, "Gas", QUICKFILL_LIFO);
+    gnc_quickfill_insert (qf, "Rent", QUICKFILL_LIFO);
+
+    /* The latest insertion wins, in any case */
+    g_assert_cmpstr (match_text (qf, "g"), ==, "Gas");
+    g_assert_cmpstr (match_text (qf, "GRO"), ==, "Groceries");
+    g_assert_cmpstr (match_text (qf, "groceries"), ==, "Groceries");
+    g_assert (gnc_quickfill_get_string_match (qf, "Grx") == NULL);
+    g_assert (gnc_quickfill_get_string_match (qf, "Groceriesx") == NULL);
+
+    /* Matching one character at a time ends up at the same node */
+    match = gnc_quickfill_get_char_match (qf, 'g');
+    match = gnc_quickfill_get_char_match (match, 'R');
+    g_assert (match == gnc_quickfill_get_string_match (qf, "gr"));
+    g_assert (match == gnc_quickfill_get_string_len_match (qf, "gravel", 2));
+
+    /* "Gr" continues with "oceries" only */
+    match = gnc_quickfill_get_unique_len_match (match, &len);
+    g_assert_cmpint (len, ==, 7);
+    g_assert_cmpstr (gnc_quickfill_string (match), ==, "Groceries");
+
+    /* A shorter string that is a prefix keeps its place */
+    gnc_quickfill_insert (qf, "Gro", QUICKFILL_LIFO);
+    gnc_quickfill_insert (qf, "Grocer", QUICKFILL_LIFO);
+    g_assert_cmpstr (match_text (qf, "gro"), ==, "Gro");
+    g_assert_cmpstr (match_text (qf, "groc"), ==, "Grocer");
+
+    gnc_quickfill_destroy (qf);
+}
+
+static void
+test_quickfill_alpha (void)
+{
+    QuickFill *qf = gnc_quickfill_new ();
+
+    gnc_quickfill_insert (qf, "beta", QUICKFILL_ALPHA);
+    gnc_quickfill_insert (qf, "bz", QUICKFILL_ALPHA);
+    gnc_quickfill_insert (qf, "bar", QUICKFILL_ALPHA);
+
+    g_assert_cmpstr (match_text (qf, "b"), ==, "bar");
+    g_assert_cmpstr (match_text (qf, "be"), ==, "beta");
+
+    gnc_quickfill_destroy (qf);
+}
+
+static void
+test_quickfill_remove (void)
+{
+    QuickFill *qf = gnc_quickfill_new ();
+
+    gnc_quickfill_insert (qf, "Groceries", QUICKFILL_LIFO);
+    gnc_quickfill_insert (qf, "Gas", QUICKFILL_LIFO);
+    gnc_quickfill_insert (qf, "Grocer", QUICKFILL_LIFO);
+
+    /* The removed text is replaced with a remaining one */
+    gnc_quickfill_remove (qf, "Grocer", QUICKFILL_LIFO);
+    g_assert_cmpstr (match_text (qf, "g"), ==, "Groceries");
+    g_assert_cmpstr (match_text (qf, "grocer"), ==, "Groceries");
+
+    /* Nothing is left that starts with "Gr" */
+    gnc_quickfill_remove (qf, "Groceries", QUICKFILL_LIFO);
+    g_assert_cmpstr (match_text (qf, "g"), ==, "Gas");
+    g_assert (gnc_quickfill_get_string_match (qf, "gr") == NULL);
+
+    /* Removing a string that isn't there changes nothing */
+    gnc_quickfill_remove (qf, "Garage", QUICKFILL_LIFO);
+    g_assert_cmpstr (match_text (qf, "ga"), ==, "Gas");
+
+    gnc_quickfill_purge (qf);
+    g_assert (gnc_quickfill_get_string_match (qf, "g") == NULL);
+
+    gnc_quickfill_destroy (qf);
+}
+
+int
+main (int argc, char *argv[])
+{
+    int result;
+
+    qof_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/app-utils/quickfill/match", test_quickfill_match);
+    g_test_add_func ("/app-utils/quickfill/alpha", test_quickfill_alpha);
+    g_test_add_func ("/app-utils/quickfill/remove", test_quickfill_remove);
+    result = g_test_run ();
+
+    qof_close ();
+    return result;
+}
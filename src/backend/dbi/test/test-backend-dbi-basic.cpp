@@ -44,6 +44,8 @@ extern "C"
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
+#include "gnc-lot.h"
+#include "Query.h"
 #include "gnc-commodity.h"
 #include "gncAddress.h"
 #include "gncCustomer.h"
@@ -59,6 +61,7 @@ extern "C"
 #include <test-stuff.h>
 }
 
+#include <set>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -373,12 +376,11 @@ test_conn_index_functions (QofBackend* qof_be)
 #endif
 /* Given a synthetic session, use the same logic as
  * QofSession::save_as to save it to a specified sql url, then load it
- * back and compare. */
+ * back and compare.  A batch_size other than 0 replaces the number of
+ * rows sync() collects into one INSERT. */
 static void
-test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
+store_and_reload (Fixture* fixture, const gchar* url, guint batch_size)
 {
-
-    const gchar* url = (const gchar*)pData;
     QofSession* session_2;
     QofSession* session_3;
 
@@ -397,6 +399,12 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
     g_assert (session_2 != NULL);
     g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    if (batch_size)
+    {
+        auto sql_be = reinterpret_cast<GncSqlBackend*>
+            (qof_session_get_backend (session_2));
+        sql_be->set_insert_batch_size (batch_size);
+    }
     qof_session_swap_data (fixture->session, session_2);
     qof_session_save (session_2, NULL);
     g_assert (session_2 != NULL);
@@ -421,6 +429,521 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+static void
+test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
+{
+    store_and_reload (fixture, (const gchar*)pData, 0);
+}
+
+/* With three rows to an INSERT every table's batch fills up and is sent
+ * many times over, and the rows of several tables are queued at once;
+ * whatever is left over has to be sent before the sync commits. */
+static void
+test_dbi_store_and_reload_batched (Fixture* fixture, gconstpointer pData)
+{
+    store_and_reload (fixture, (const gchar*)pData, 3);
+}
+
+/* Transactions committed in a bulk run, as an import does, are only
+ * stored, and the book saved, when the outermost run ends. */
+static void
+test_dbi_bulk_commit (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    auto book = qof_session_get_book (session_2);
+    auto sql_be = reinterpret_cast<GncSqlBackend*>
+        (qof_session_get_backend (session_2));
+    sql_be->set_insert_batch_size (3);
+    auto accounts = gnc_account_get_descendants (gnc_book_get_root_account (book));
+    g_assert (accounts && accounts->next);
+    auto acct1 = static_cast<Account*> (accounts->data);
+    auto acct2 = static_cast<Account*> (accounts->next->data);
+    g_list_free (accounts);
+
+    qof_book_begin_bulk_commit (book);
+    qof_book_begin_bulk_commit (book);
+    for (int i = 0; i < 10; i++)
+    {
+        auto tx = xaccMallocTransaction (book);
+        auto value = gnc_numeric_create (100 * (i + 1), 100);
+        xaccTransBeginEdit (tx);
+        xaccTransSetCurrency (tx, xaccAccountGetCommodity (acct1));
+        xaccTransSetDatePostedSecsNormalized (tx, gnc_time (nullptr));
+        xaccTransSetDescription (tx, "bulk");
+        auto split = xaccMallocSplit (book);
+        xaccSplitSetParent (split, tx);
+        xaccSplitSetAccount (split, acct1);
+        xaccSplitSetMemo (split, "bulk memo");
+        xaccSplitSetValue (split, value);
+        xaccSplitSetAmount (split, value);
+        split = xaccMallocSplit (book);
+        xaccSplitSetParent (split, tx);
+        xaccSplitSetAccount (split, acct2);
+        xaccSplitSetValue (split, gnc_numeric_neg (value));
+        xaccSplitSetAmount (split, gnc_numeric_neg (value));
+        xaccTransCommitEdit (tx);
+    }
+    qof_book_end_bulk_commit (book);
+    // Still inside the outer run, nothing is stored yet
+    g_assert (qof_book_session_not_saved (book));
+    qof_book_end_bulk_commit (book);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    g_assert (!qof_book_session_not_saved (book));
+
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    compare_books (book, qof_session_get_book (session_3));
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Open the database saved from book_1 with transactions loaded on
+ * demand and check each account against book_1, which has everything in
+ * memory: the balances as of each posted date, latest first so that each
+ * one pulls in a little more, and then the whole split list. */
+static void
+compare_on_demand_accounts (QofBook* book_1, QofBook* book_2)
+{
+    auto accounts = gnc_account_get_descendants
+                    (gnc_book_get_root_account (book_1));
+
+    for (auto node = accounts; node != NULL; node = node->next)
+    {
+        auto acc_1 = GNC_ACCOUNT (node->data);
+        auto acc_2 = xaccAccountLookup (qof_instance_get_guid (acc_1), book_2);
+
+        g_assert (acc_2 != NULL);
+        g_assert (gnc_numeric_equal (xaccAccountGetBalance (acc_1),
+                                     xaccAccountGetBalance (acc_2)));
+
+        auto splits_1 = xaccAccountGetSplitList (acc_1);
+        for (auto snode = g_list_last (splits_1); snode != NULL;
+             snode = snode->prev)
+        {
+            auto date = xaccTransGetDate (xaccSplitGetParent
+                                          (GNC_SPLIT (snode->data)));
+            g_assert (gnc_numeric_equal
+                      (xaccAccountGetBalanceAsOfDate (acc_1, date + 1),
+                       xaccAccountGetBalanceAsOfDate (acc_2, date + 1)));
+            g_assert (gnc_numeric_equal
+                      (xaccAccountGetBalanceAsOfDate (acc_1, date),
+                       xaccAccountGetBalanceAsOfDate (acc_2, date)));
+        }
+
+        auto splits_2 = xaccAccountGetSplitList (acc_2);
+        g_assert_cmpint (g_list_length (splits_1), ==,
+                         g_list_length (splits_2));
+        for (auto s1 = splits_1, s2 = splits_2; s1 && s2;
+             s1 = s1->next, s2 = s2->next)
+            g_assert (guid_equal (qof_instance_get_guid (s1->data),
+                                  qof_instance_get_guid (s2->data)));
+    }
+    g_list_free (accounts);
+}
+
+static void
+compare_on_demand_tx (QofInstance* inst, gpointer user_data)
+{
+    auto book_2 = static_cast<QofBook*>(user_data);
+
+    g_assert (xaccTransLookup (qof_instance_get_guid (inst), book_2) != NULL);
+}
+
+static QofSession*
+load_on_demand (const gchar* url)
+{
+    auto session = qof_session_new ();
+
+    gnc_prefs_set_sql_load_on_demand (TRUE);
+    qof_session_begin (session, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session, NULL);
+    g_assert_cmpint (qof_session_get_error (session), == , ERR_BACKEND_NO_ERR);
+    gnc_prefs_set_sql_load_on_demand (FALSE);
+    return session;
+}
+
+static void
+test_dbi_load_on_demand (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto book_2 = qof_session_get_book (session_2);
+
+    // Balances and split lists load single accounts
+    session_3 = load_on_demand (url);
+    compare_on_demand_accounts (book_2, qof_session_get_book (session_3));
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+
+    // A query for anything but splits loads every transaction
+    session_3 = load_on_demand (url);
+    auto book_3 = qof_session_get_book (session_3);
+    auto query = qof_query_create_for (GNC_ID_LOT);
+    qof_query_set_book (query, book_3);
+    auto lots = qof_query_run (query);
+    g_assert_cmpint (g_list_length (lots), ==,
+                     qof_collection_count (qof_book_get_collection
+                                           (book_2, GNC_ID_LOT)));
+    qof_query_destroy (query);
+    qof_collection_foreach (qof_book_get_collection (book_2, GNC_ID_TRANS),
+                            compare_on_demand_tx, book_3);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+}
+
+/* Saving a book opened with load on demand somewhere else has to write
+ * every transaction, not just those that happened to be loaded. */
+static void
+test_dbi_save_on_demand_as_xml (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto n_trans = qof_collection_count (qof_book_get_collection
+                                         (qof_session_get_book (session_2),
+                                          GNC_ID_TRANS));
+
+    /* Load a single account's transactions, then Save As */
+    auto session_3 = load_on_demand (url);
+    auto accounts = gnc_account_get_descendants
+                    (gnc_book_get_root_account (qof_session_get_book (session_3)));
+    g_assert (accounts != NULL);
+    xaccAccountGetSplitList (GNC_ACCOUNT (accounts->data));
+    g_list_free (accounts);
+    g_assert_cmpint (qof_collection_count (qof_book_get_collection
+                                           (qof_session_get_book (session_3),
+                                            GNC_ID_TRANS)), <, n_trans);
+
+    auto dir = g_dir_make_tmp ("test-dbi-on-demand-XXXXXX", NULL);
+    auto filename = g_build_filename (dir, "book.gnucash", (gchar*)NULL);
+    auto xml_url = g_strdup_printf ("xml://%s", filename);
+    auto session_4 = qof_session_new ();
+    qof_session_begin (session_4, xml_url, TRUE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (session_3, session_4);
+    qof_session_save (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+
+    auto session_5 = qof_session_new ();
+    qof_session_begin (session_5, xml_url, TRUE, FALSE, FALSE);
+    qof_session_load (session_5, NULL);
+    g_assert_cmpint (qof_session_get_error (session_5), == , ERR_BACKEND_NO_ERR);
+    g_assert_cmpint (qof_collection_count (qof_book_get_collection
+                                           (qof_session_get_book (session_5),
+                                            GNC_ID_TRANS)), ==, n_trans);
+    qof_session_end (session_5);
+    qof_session_destroy (session_5);
+
+    /* Remove the book and anything the backend left next to it */
+    auto tmpdir = g_dir_open (dir, 0, NULL);
+    const gchar* entry;
+    while (tmpdir && (entry = g_dir_read_name (tmpdir)) != NULL)
+    {
+        auto path = g_build_filename (dir, entry, (gchar*)NULL);
+        g_unlink (path);
+        g_free (path);
+    }
+    if (tmpdir)
+        g_dir_close (tmpdir);
+    g_rmdir (dir);
+    g_free (xml_url);
+    g_free (filename);
+    g_free (dir);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+}
+
+/* Split queries not limited to accounts are turned into SQL and only the
+ * transactions the SQL selects are loaded.  Running a query in a book
+ * opened that way must find the same splits as in the fully loaded book;
+ * a term translated too narrowly would lose some. */
+static std::set<std::string>
+run_split_query (QofQuery* query, QofBook* book)
+{
+    std::set<std::string> guids;
+    auto book_query = qof_query_copy (query);
+
+    qof_query_set_book (book_query, book);
+    for (auto node = qof_query_run (book_query); node; node = node->next)
+    {
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+        (void)guid_to_string_buff (qof_instance_get_guid (node->data),
+                                   guid_buf);
+        guids.insert (guid_buf);
+    }
+    qof_query_destroy (book_query);
+    return guids;
+}
+
+static void
+check_split_query (const gchar* url, QofBook* book, QofQuery* query)
+{
+    for (auto invert : {false, true})
+    {
+        auto q = invert ? qof_query_invert (query) : qof_query_copy (query);
+        auto session = load_on_demand (url);
+        auto expected = run_split_query (q, book);
+        auto found = run_split_query (q, qof_session_get_book (session));
+
+        g_assert (found == expected);
+        /* The splits found have the right running balances without any
+         * further loading */
+        for (auto& guid_str : found)
+        {
+            GncGUID guid;
+            g_assert (string_to_guid (guid_str.c_str(), &guid));
+            auto split_1 = xaccSplitLookup (&guid, book);
+            auto split_2 = xaccSplitLookup (&guid,
+                                            qof_session_get_book (session));
+            g_assert (split_1 != NULL && split_2 != NULL);
+            g_assert (gnc_numeric_equal (xaccSplitGetBalance (split_1),
+                                         xaccSplitGetBalance (split_2)));
+        }
+        qof_session_end (session);
+        qof_session_destroy (session);
+        qof_query_destroy (q);
+    }
+    qof_query_destroy (query);
+}
+
+static Split*
+find_query_split (QofBook* book)
+{
+    auto accounts = gnc_account_get_descendants
+                    (gnc_book_get_root_account (book));
+    Split* found = nullptr;
+
+    for (auto node = accounts; node != NULL; node = node->next)
+    {
+        for (auto snode = xaccAccountGetSplitList (GNC_ACCOUNT (node->data));
+             snode != NULL; snode = snode->next)
+        {
+            auto split = GNC_SPLIT (snode->data);
+            if (found == nullptr || *xaccSplitGetMemo (split))
+                found = split;
+            if (*xaccSplitGetMemo (split))
+                break;
+        }
+        if (found && *xaccSplitGetMemo (found))
+            break;
+    }
+    g_list_free (accounts);
+    return found;
+}
+
+static QofQuery*
+new_split_query (void)
+{
+    return qof_query_create_for (GNC_ID_SPLIT);
+}
+
+static void
+test_dbi_split_query_sql (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofQuery* q;
+    QofQuery* q2;
+
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto book = qof_session_get_book (session_2);
+
+    auto split = find_query_split (book);
+    g_assert (split != NULL);
+    auto account = xaccSplitGetAccount (split);
+    auto trans = xaccSplitGetParent (split);
+    auto date = xaccTransGetDate (trans);
+    auto value = xaccSplitGetValue (split);
+    auto memo = xaccSplitGetMemo (split);
+
+    // Account
+    q = new_split_query ();
+    xaccQueryAddSingleAccountMatch (q, account, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+
+    // Date, to the second and by day
+    q = new_split_query ();
+    xaccQueryAddDateMatchTT (q, TRUE, date, TRUE, date, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    q = new_split_query ();
+    xaccQueryAddDateMatchTT (q, TRUE, date - 86400, FALSE, 0, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+
+    // Amount, by absolute value and with a sign
+    q = new_split_query ();
+    xaccQueryAddValueMatch (q, gnc_numeric_neg (value), QOF_NUMERIC_MATCH_ANY,
+                            QOF_COMPARE_EQUAL, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    q = new_split_query ();
+    xaccQueryAddValueMatch (q, value, QOF_NUMERIC_MATCH_CREDIT,
+                            QOF_COMPARE_GTE, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+
+    // A negative amount matches by its absolute value, whatever the sign
+    // of the split's own value
+    auto negative = gnc_numeric_neg (gnc_numeric_abs (value));
+    q = new_split_query ();
+    xaccQueryAddValueMatch (q, negative, QOF_NUMERIC_MATCH_ANY,
+                            QOF_COMPARE_EQUAL, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    q = new_split_query ();
+    xaccQueryAddValueMatch (q, negative, QOF_NUMERIC_MATCH_DEBIT,
+                            QOF_COMPARE_EQUAL, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    q = new_split_query ();
+    xaccQueryAddValueMatch (q, negative, QOF_NUMERIC_MATCH_ANY,
+                            QOF_COMPARE_NEQ, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    q = new_split_query ();
+    xaccQueryAddSharesMatch (q, xaccSplitGetAmount (split), QOF_COMPARE_LT,
+                             QOF_QUERY_AND);
+    check_split_query (url, book, q);
+
+    // Memo and description, exact and contained, with and without case
+    q = new_split_query ();
+    xaccQueryAddMemoMatch (q, memo, TRUE, FALSE, QOF_COMPARE_EQUAL,
+                           QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    if (strlen (memo) > 2)
+    {
+        auto part = g_ascii_strup (memo + 1, strlen (memo) - 2);
+        q = new_split_query ();
+        xaccQueryAddMemoMatch (q, part, FALSE, FALSE, QOF_COMPARE_CONTAINS,
+                               QOF_QUERY_AND);
+        check_split_query (url, book, q);
+        g_free (part);
+    }
+    q = new_split_query ();
+    xaccQueryAddDescriptionMatch (q, xaccTransGetDescription (trans), TRUE,
+                                  FALSE, QOF_COMPARE_EQUAL, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+
+    // Reconcile state
+    q = new_split_query ();
+    xaccQueryAddClearedMatch (q, CLEARED_NO, QOF_QUERY_AND);
+    check_split_query (url, book, q);
+    q = new_split_query ();
+    xaccQueryAddClearedMatch (q, static_cast<cleared_match_t>
+                              (CLEARED_CLEARED | CLEARED_RECONCILED),
+                              QOF_QUERY_AND);
+    check_split_query (url, book, q);
+
+    // (date AND amount) OR (memo AND reconcile state)
+    q = new_split_query ();
+    xaccQueryAddDateMatchTT (q, TRUE, date, FALSE, 0, QOF_QUERY_AND);
+    xaccQueryAddValueMatch (q, value, QOF_NUMERIC_MATCH_ANY,
+                            QOF_COMPARE_EQUAL, QOF_QUERY_AND);
+    q2 = new_split_query ();
+    xaccQueryAddMemoMatch (q2, memo, TRUE, FALSE, QOF_COMPARE_EQUAL,
+                           QOF_QUERY_AND);
+    xaccQueryAddClearedMatch (q2, CLEARED_NO, QOF_QUERY_AND);
+    check_split_query (url, book, qof_query_merge (q, q2, QOF_QUERY_OR));
+    qof_query_destroy (q);
+    qof_query_destroy (q2);
+
+    // (account OR memo) AND description
+    q = new_split_query ();
+    xaccQueryAddSingleAccountMatch (q, account, QOF_QUERY_AND);
+    q2 = new_split_query ();
+    xaccQueryAddMemoMatch (q2, memo, TRUE, FALSE, QOF_COMPARE_EQUAL,
+                           QOF_QUERY_AND);
+    auto q_or = qof_query_merge (q, q2, QOF_QUERY_OR);
+    qof_query_destroy (q);
+    qof_query_destroy (q2);
+    q = new_split_query ();
+    xaccQueryAddDescriptionMatch (q, xaccTransGetDescription (trans), FALSE,
+                                  FALSE, QOF_COMPARE_CONTAINS, QOF_QUERY_AND);
+    check_split_query (url, book, qof_query_merge (q_or, q, QOF_QUERY_AND));
+    qof_query_destroy (q_or);
+    qof_query_destroy (q);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -642,6 +1165,16 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
     auto subsuite = g_strdup_printf ("%s/%s", suitename, dbm_name);
     GNC_TEST_ADD (subsuite, "store_and_reload", Fixture, url, setup,
                   test_dbi_store_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "store_and_reload_batched", Fixture, url, setup,
+                  test_dbi_store_and_reload_batched, teardown);
+    GNC_TEST_ADD (subsuite, "bulk_commit", Fixture, url, setup,
+                  test_dbi_bulk_commit, teardown);
+    GNC_TEST_ADD (subsuite, "load_on_demand", Fixture, url, setup,
+                  test_dbi_load_on_demand, teardown);
+    GNC_TEST_ADD (subsuite, "save_on_demand_as_xml", Fixture, url, setup,
+                  test_dbi_save_on_demand_as_xml, teardown);
+    GNC_TEST_ADD (subsuite, "split_query_sql", Fixture, url, setup,
+                  test_dbi_split_query_sql, teardown);
     GNC_TEST_ADD (subsuite, "safe_save", Fixture, url, setup_memory,
                   test_dbi_safe_save, teardown);
     GNC_TEST_ADD (subsuite, "version_control", Fixture, url, setup_memory,
@@ -69,6 +69,11 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define MAX_TABLE_NAME_LEN 50
 #define TABLE_COL_NAME "table_name"
 #define VERSION_COL_NAME "table_version"
+/* Rows and bytes of SQL collected into one multi-row INSERT during a full
+ * save.  The byte limit keeps statements well below SQLite's and MySQL's
+ * default maximum statement sizes. */
+#define DEFAULT_INSERT_BATCH_SIZE 500
+#define MAX_INSERT_BATCH_BYTES (256 * 1024)
 
 using StrVec = std::vector<std::string>;
 
@@ -81,7 +86,9 @@ static EntryVec version_table
 
 GncSqlBackend::GncSqlBackend(GncSqlConnection *conn, QofBook* book) :
     QofBackend {}, m_conn{conn}, m_book{book}, m_loading{false},
-    m_in_query{false}, m_is_pristine_db{false}
+    m_in_query{false}, m_is_pristine_db{false}, m_batch_inserts{false},
+    m_insert_batch_size{DEFAULT_INSERT_BATCH_SIZE}, m_load_on_demand{false},
+    m_all_tx_loaded{true}, m_bulk_level{0}, m_bulk_failed{false}
 {
     if (conn != nullptr)
         connect (conn);
@@ -111,6 +118,9 @@ GncSqlBackend::create_statement_from_sql(const std::string& str) const noexcept
 GncSqlResultPtr
 GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    /* Anything queued must be visible to the query. */
+    if (!flush_inserts())
+        return nullptr;
     auto result = m_conn->execute_select_statement(stmt);
     if (result == nullptr)
     {
@@ -123,6 +133,8 @@ GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const no
 int
 GncSqlBackend::execute_nonselect_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    if (!flush_inserts())
+        return -1;
     auto result = m_conn->execute_nonselect_statement(stmt);
     if (result == -1)
     {
@@ -234,6 +246,8 @@ GncSqlBackend::ObjectBackendRegistry::load_remaining(GncSqlBackend* sql_be)
         if (std::find(business_fixed_load_order.begin(),
                       business_fixed_load_order.end(),
                       type) != business_fixed_load_order.end()) continue;
+        /* Transactions are left for run_query() to fetch. */
+        if (sql_be->load_on_demand() && type == GNC_ID_TRANS) continue;
 
         obe->load_all (sql_be);
     }
@@ -273,6 +287,9 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
     {
         assert (m_book == nullptr);
         m_book = book;
+        m_load_on_demand = gnc_prefs_get_sql_load_on_demand ();
+        m_all_tx_loaded = !m_load_on_demand;
+        m_tx_loaded_since.clear();
 
         /* Load any initial stuff. Some of this needs to happen in a certain order */
         for (auto type : fixed_load_order)
@@ -306,8 +323,7 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
     else if (loadType == LOAD_TYPE_LOAD_ALL)
     {
         // Load all transactions
-        auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
-        obe->load_all (this);
+        load_remaining_tx();
     }
 
     m_loading = FALSE;
@@ -327,6 +343,71 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
     LEAVE ("");
 }
 
+void
+GncSqlBackend::run_query (QofQuery* query)
+{
+    g_return_if_fail (query != nullptr);
+
+    /* Nothing to fetch, or already fetching: a nested query (e.g. from a
+     * scrubber) must not start another load. */
+    if (m_all_tx_loaded || m_loading || m_in_query) return;
+
+    ENTER ("sql_be=%p, query=%p", this, query);
+    m_in_query = true;
+    m_loading = true;
+    if (!gnc_sql_transaction_load_for_query (this, query))
+    {
+        load_remaining_tx();
+        finish_progress();
+    }
+    m_loading = false;
+    m_in_query = false;
+    LEAVE ("");
+}
+
+void
+GncSqlBackend::load_splits (QofInstance* account, time64 since)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT (account));
+
+    /* The loader itself reads split lists, which must not start another
+     * load. */
+    if (m_all_tx_loaded || m_loading || m_in_query) return;
+    if (since >= tx_loaded_since (GNC_ACCOUNT (account))) return;
+
+    ENTER ("sql_be=%p, account=%p", this, account);
+    m_in_query = true;
+    m_loading = true;
+    gnc_sql_transaction_load_tx_for_account_since (this, GNC_ACCOUNT (account),
+                                                   since);
+    m_loading = false;
+    m_in_query = false;
+    LEAVE ("");
+}
+
+void
+GncSqlBackend::load_remaining_tx () noexcept
+{
+    if (m_all_tx_loaded) return;
+
+    auto loading = m_loading;
+    m_loading = true;
+    auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
+    obe->load_all (this);
+    m_all_tx_loaded = true;
+    m_tx_loaded_since.clear();
+    m_loading = loading;
+}
+
+time64
+GncSqlBackend::tx_loaded_since (const Account* acc) const noexcept
+{
+    if (m_all_tx_loaded)
+        return INT64_MIN;
+    auto entry = m_tx_loaded_since.find (acc);
+    return entry == m_tx_loaded_since.end() ? INT64_MAX : entry->second;
+}
+
 /* ================================================================= */
 
 bool
@@ -443,8 +524,12 @@ GncSqlBackend::sync(QofBook* book)
 {
     g_return_if_fail (book != NULL);
 
-    reset_version_info();
     ENTER ("book=%p, sql_be->book=%p", book, m_book);
+    /* Whatever is still in the database would be lost when the tables are
+     * rewritten. */
+    if (book == m_book)
+        load_remaining_tx();
+    reset_version_info();
     update_progress();
 
     /* Create new tables */
@@ -454,6 +539,7 @@ GncSqlBackend::sync(QofBook* book)
     /* Save all contents */
     m_book = book;
     auto is_ok = m_conn->begin_transaction();
+    m_batch_inserts = true;
 
     // FIXME: should write the set of commodities that are used
     // write_commodities(sql_be, book);
@@ -484,6 +570,12 @@ GncSqlBackend::sync(QofBook* book)
             std::get<1>(entry)->write (this);
     }
     if (is_ok)
+    {
+        is_ok = flush_inserts();
+    }
+    m_batch_inserts = false;
+    m_saved_commodities.clear();
+    if (is_ok)
     {
         is_ok = m_conn->commit_transaction();
     }
@@ -498,6 +590,7 @@ GncSqlBackend::sync(QofBook* book)
     }
     else
     {
+        m_insert_batches.clear();
         set_error (ERR_BACKEND_SERVER_ERR);
         is_ok = m_conn->rollback_transaction ();
     }
@@ -526,6 +619,57 @@ GncSqlBackend::rollback(QofInstance* inst)
     LEAVE ("");
 }
 
+void
+GncSqlBackend::begin_bulk_commit()
+{
+    ENTER ("level=%u", m_bulk_level);
+    if (m_bulk_level++ > 0)
+    {
+        LEAVE ("");
+        return;
+    }
+
+    /* m_batch_inserts also records that the transaction is open */
+    m_batch_inserts = m_conn->begin_transaction();
+    m_bulk_failed = !m_batch_inserts;
+    LEAVE ("");
+}
+
+void
+GncSqlBackend::end_bulk_commit()
+{
+    ENTER ("level=%u", m_bulk_level);
+    if (m_bulk_level == 0)
+    {
+        PERR ("bulk commit level underflow");
+        LEAVE ("");
+        return;
+    }
+    if (--m_bulk_level > 0)
+    {
+        LEAVE ("");
+        return;
+    }
+
+    auto began = m_batch_inserts;
+    auto is_ok = !m_bulk_failed && flush_inserts();
+    m_batch_inserts = false;
+    m_saved_commodities.clear();
+    if (is_ok)
+        is_ok = m_conn->commit_transaction();
+    if (is_ok)
+        qof_book_mark_session_saved (m_book);
+    else
+    {
+        m_insert_batches.clear();
+        set_error (ERR_BACKEND_SERVER_ERR);
+        if (began)
+            (void)m_conn->rollback_transaction ();
+    }
+    m_bulk_failed = false;
+    LEAVE ("");
+}
+
 void
 GncSqlBackend::commodity_for_postload_processing(gnc_commodity* commodity)
 {
@@ -590,7 +734,16 @@ GncSqlBackend::commit (QofInstance* inst)
         return;
     }
 
-    if (!m_conn->begin_transaction ())
+    /* A bulk run is stored all at once, in its own database transaction;
+     * after a failure nothing more of it is written. */
+    auto in_bulk = m_bulk_level > 0;
+    if (in_bulk && m_bulk_failed)
+    {
+        LEAVE ("Bulk commit already failed");
+        return;
+    }
+
+    if (!in_bulk && !m_conn->begin_transaction ())
     {
         PERR ("begin_transaction failed\n");
         LEAVE ("Rolled back - database transaction begin error");
@@ -605,7 +758,8 @@ GncSqlBackend::commit (QofInstance* inst)
     else
     {
         PERR ("Unknown object type '%s'\n", inst->e_type);
-        (void)m_conn->rollback_transaction ();
+        if (!in_bulk)
+            (void)m_conn->rollback_transaction ();
 
         // Don't let unknown items still mark the book as being dirty
         qof_book_mark_session_saved(m_book);
@@ -616,15 +770,27 @@ GncSqlBackend::commit (QofInstance* inst)
     if (!is_ok)
     {
         // Error - roll it back
-        (void)m_conn->rollback_transaction();
+        if (in_bulk)
+            m_bulk_failed = true;
+        else
+            (void)m_conn->rollback_transaction();
 
         // This *should* leave things marked dirty
         LEAVE ("Rolled back - database error");
         return;
     }
 
-    (void)m_conn->commit_transaction ();
+    if (!in_bulk)
+        (void)m_conn->commit_transaction ();
 
+    if (is_destroying && GNC_IS_ACCOUNT (inst))
+        m_tx_loaded_since.erase (GNC_ACCOUNT (inst));
+    if (in_bulk)
+    {
+        /* The book is saved once the run is. */
+        LEAVE ("Deferred to the end of the bulk commit");
+        return;
+    }
     qof_book_mark_session_saved(m_book);
     qof_instance_mark_clean (inst);
 
@@ -828,6 +994,9 @@ GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
     g_return_val_if_fail (obj_name != nullptr, false);
     g_return_val_if_fail (pObject != nullptr, false);
 
+    if (op == OP_DB_INSERT && m_batch_inserts && m_insert_batch_size > 1)
+        return queue_insert (table_name, obj_name, pObject, table);
+
     switch(op)
     {
         case  OP_DB_INSERT:
@@ -849,10 +1018,16 @@ bool
 GncSqlBackend::save_commodity(gnc_commodity* comm) noexcept
 {
     if (comm == nullptr) return false;
+    /* Every transaction saves its currency; while INSERTs are batched the
+     * lookup would send the pending ones each time. */
+    if (m_batch_inserts && m_saved_commodities.count(comm))
+        return true;
     QofInstance* inst = QOF_INSTANCE(comm);
     auto obe = m_backend_registry.get_object_backend(std::string(inst->e_type));
-    if (obe && !obe->instance_in_db(this, inst))
-        return obe->commit(this, inst);
+    if (obe && !obe->instance_in_db(this, inst) && !obe->commit(this, inst))
+        return false;
+    if (m_batch_inserts)
+        m_saved_commodities.insert(comm);
     return true;
 }
 
@@ -892,6 +1067,78 @@ GncSqlBackend::build_insert_statement (const char* table_name,
     return stmt;
 }
 
+/* Add the object's row to the pending INSERT for its table and set of
+ * non-NULL columns, sending that INSERT once it is full. */
+bool
+GncSqlBackend::queue_insert (const char* table_name, QofIdTypeConst obj_name,
+                             gpointer pObject, const EntryVec& table) const noexcept
+{
+    std::ostringstream key;
+    std::ostringstream row;
+
+    PairVec values{get_object_values(obj_name, pObject, table)};
+
+    key << "INSERT INTO " << table_name << "(";
+    row << "(";
+    for (auto const& col_value : values)
+    {
+        if (col_value != *values.begin())
+        {
+            key << ",";
+            row << ",";
+        }
+        key << col_value.first;
+        row << quote_string(col_value.second);
+    }
+    key << ") VALUES";
+    row << ")";
+
+    auto& batch = m_insert_batches[key.str()];
+    if (batch.rows == 0)
+        batch.sql = key.str();
+    else
+        batch.sql += ",";
+    batch.sql += row.str();
+
+    if (++batch.rows < m_insert_batch_size &&
+        batch.sql.size() < MAX_INSERT_BATCH_BYTES)
+        return true;
+
+    auto stmt = m_conn->create_statement_from_sql(batch.sql);
+    auto is_ok = stmt != nullptr &&
+        m_conn->execute_nonselect_statement(stmt) != -1;
+    if (!is_ok)
+    {
+        PERR ("SQL error: %s\n", batch.sql.c_str());
+        qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+    }
+    m_insert_batches.erase(key.str());
+    return is_ok;
+}
+
+/* Send every pending INSERT.  Rows of different tables don't depend on
+ * each other, so the order between batches doesn't matter. */
+bool
+GncSqlBackend::flush_inserts () const noexcept
+{
+    auto is_ok = true;
+
+    for (auto const& entry : m_insert_batches)
+    {
+        auto& sql = entry.second.sql;
+        auto stmt = m_conn->create_statement_from_sql(sql);
+        if (stmt == nullptr || m_conn->execute_nonselect_statement(stmt) == -1)
+        {
+            PERR ("SQL error: %s\n", sql.c_str());
+            qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+            is_ok = false;
+            break;
+        }
+    }
+    m_insert_batches.clear();
+    return is_ok;
+}
+
 GncSqlStatementPtr
 GncSqlBackend::build_update_statement(const gchar* table_name,
                                       QofIdTypeConst obj_name, gpointer pObject,
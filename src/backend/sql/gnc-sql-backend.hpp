@@ -29,8 +29,10 @@ extern "C"
 #include <qof.h>
 #include <Account.h>
 }
+#include <map>
 #include <memory>
 #include <exception>
+#include <set>
 #include <sstream>
 #include <vector>
 #include <qof-backend.hpp>
@@ -73,6 +75,25 @@ public:
      * @param book Book to be loaded
      */
     void load(QofBook*, QofBackendLoadType) override;
+    /**
+     * When transactions are loaded on demand, load the ones that the query
+     * could match before the engine runs it.
+     *
+     * @param query The query about to be run
+     */
+    void run_query(QofQuery*) override;
+    /**
+     * Whether some transactions are still left in the database.
+     */
+    bool loads_on_demand() const noexcept override { return !m_all_tx_loaded; }
+    /**
+     * When transactions are loaded on demand, load those of an account
+     * posted on or after a date that aren't in memory yet.
+     *
+     * @param account The account whose splits are about to be read
+     * @param since Earliest posted date to load, INT64_MIN for all
+     */
+    void load_splits(QofInstance* account, time64 since) override;
     /**
      * Save the contents of a book to an SQL database.
      *
@@ -97,6 +118,16 @@ public:
      * @param inst Object being edited
      */
     void rollback(QofInstance*) override;
+    /**
+     * Start a run of commits written in one database transaction, with the
+     * INSERTs collected into multi-row statements as sync() does.
+     */
+    void begin_bulk_commit() override;
+    /**
+     * Send what is left of the run and commit it, or roll all of it back
+     * if any part failed; the book then stays unsaved.
+     */
+    void end_bulk_commit() override;
     /** Connect the backend to a GncSqlConnection.
      * Sets up version info. Calling with nullptr clears the connection and
      * destroys the version info.
@@ -237,8 +268,31 @@ public:
     QofBook* book() const noexcept { return m_book; }
     void set_loading(bool loading) noexcept { m_loading = loading; }
     bool pristine() const noexcept { return m_is_pristine_db; }
+    /**
+     * Whether the initial load left transactions in the database, to be
+     * loaded per account when a query needs them.
+     */
+    bool load_on_demand() const noexcept { return m_load_on_demand; }
+    /**
+     * The earliest posted date from which all of an account's transactions
+     * are loaded: INT64_MAX if none are, INT64_MIN if all are.
+     */
+    time64 tx_loaded_since(const Account* acc) const noexcept;
+    void set_tx_loaded_since(const Account* acc, time64 since) noexcept
+    { m_tx_loaded_since[acc] = since; }
+    /**
+     * Load every transaction still left in the database, so that the whole
+     * book is in memory before it is written out.
+     */
+    void load_remaining_tx() noexcept;
     void update_progress() const noexcept;
     void finish_progress() const noexcept;
+    /**
+     * Set the number of rows of one table that sync() may collect into a
+     * single multi-row INSERT.  A size of 1 writes every row separately.
+     */
+    void set_insert_batch_size(uint_t size) noexcept
+    { m_insert_batch_size = size ? size : 1; }
 
 protected:
     GncSqlConnection* m_conn;  /**< SQL connection */
@@ -248,7 +302,22 @@ protected:
     bool m_is_pristine_db; /**< Are we saving to a new pristine db? */
     const char* m_timespec_format; /**< Server-specific date-time string format */
     VersionVec m_versions;    /**< Version number for each table */
+    bool m_batch_inserts;     /**< Collect INSERTs into multi-row statements */
+    uint_t m_insert_batch_size; /**< Rows per multi-row INSERT */
+    bool m_load_on_demand;    /**< Transactions are loaded as queries need them */
+    bool m_all_tx_loaded;     /**< No transaction is left to load on demand */
+    uint_t m_bulk_level;      /**< Nesting of begin_bulk_commit() */
+    bool m_bulk_failed;       /**< A commit of the bulk run failed */
 private:
+    /** A multi-row INSERT being built, keyed by table and column list. */
+    struct InsertBatch
+    {
+        std::string sql;
+        uint_t rows = 0;
+    };
+    bool queue_insert (const char* table_name, QofIdTypeConst obj_name,
+                       gpointer pObject, const EntryVec& table) const noexcept;
+    bool flush_inserts () const noexcept;
     bool write_account_tree(Account*);
     bool write_accounts();
     bool write_transactions();
@@ -287,6 +356,10 @@ private:
     };
     ObjectBackendRegistry m_backend_registry;
     std::vector<gnc_commodity*> m_postload_commodities;
+    mutable std::map<std::string, InsertBatch> m_insert_batches;
+    /** Commodities known to be in the database while INSERTs are batched */
+    std::set<const gnc_commodity*> m_saved_commodities;
+    std::map<const Account*, time64> m_tx_loaded_since;
 };
 
 #endif //__GNC_SQL_BACKEND_HPP__
@@ -51,8 +51,9 @@ extern "C"
 
 #include <string>
 #include <sstream>
-
-#include "escape.h"
+#include <algorithm>
+#include <map>
+#include <set>
 
 #include <gnc-datetime.hpp>
 #include "gnc-sql-connection.hpp"
@@ -63,9 +64,6 @@ extern "C"
 #include "gnc-commodity-sql.h"
 #include "gnc-slots-sql.h"
 
-#define SIMPLE_QUERY_COMPILATION 1
-#define LOAD_TRANSACTIONS_AS_NEEDED 0
-
 static QofLogModule log_module = G_LOG_DOMAIN;
 
 #define TRANSACTION_TABLE "transactions"
@@ -73,6 +71,10 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define SPLIT_TABLE "splits"
 #define SPLIT_TABLE_VERSION 4
 
+/* Number of transactions load_all fetches, with their splits and slots,
+ * per round trip. */
+#define TX_LOAD_CHUNK_SIZE 1000
+
 struct split_info_t : public write_objects_t
 {
     split_info_t () = default;
@@ -150,13 +152,6 @@ GncSqlSplitBackend::GncSqlSplitBackend() :
     GncSqlObjectBackend(GNC_SQL_BACKEND_VERSION, GNC_ID_SPLIT,
                         SPLIT_TABLE, split_col_table) {}
 
-/* These functions exist but have not been tested.
-   #if LOAD_TRANSACTIONS_AS_NEEDED
-   compile_split_query,
-   run_split_query,
-   free_split_query,
-*/
-
 /* ================================================================= */
 
 static  gpointer
@@ -314,21 +309,87 @@ load_single_tx (GncSqlBackend* sql_be, GncSqlRow& row)
 }
 
 /**
- * Structure to hold start/end balances for each account.  The values are
- * saved before splits are loaded, and then used to adjust the start balances
- * so that the end balances (which are calculated and correct on initial load)
- * are unchanged.
+ * When transactions are loaded on demand, every account starts out with the
+ * balances stored in the database as its starting balances.  Take the splits
+ * of newly loaded transactions back out of the starting balances, so that
+ * the accounts' ending balances stay what they were.
+ *
+ * @param sql_be SQL backend
+ * @param transactions Newly loaded transactions
  */
-typedef struct
+static void
+adjust_start_balances (GncSqlBackend* sql_be, const InstanceVec& transactions)
 {
-    Account* acc;
-    gnc_numeric start_bal;
-    gnc_numeric end_bal;
-    gnc_numeric start_cleared_bal;
-    gnc_numeric end_cleared_bal;
-    gnc_numeric start_reconciled_bal;
-    gnc_numeric end_reconciled_bal;
-} full_acct_balances_t;
+    std::map<Account*, acct_balances_t> adjustments;
+    auto root = gnc_book_get_root_account (sql_be->book());
+
+    for (auto inst : transactions)
+    {
+        for (auto node = xaccTransGetSplitList (GNC_TRANSACTION (inst));
+             node != NULL; node = node->next)
+        {
+            auto split = GNC_SPLIT (node->data);
+            auto acc = xaccSplitGetAccount (split);
+
+            /* Template accounts have a root of their own and no stored
+             * balances. */
+            if (acc == NULL || gnc_account_get_root (acc) != root)
+                continue;
+
+            auto entry = adjustments.find (acc);
+            if (entry == adjustments.end())
+                entry = adjustments.emplace (acc, acct_balances_t {acc,
+                            gnc_numeric_zero (), gnc_numeric_zero (),
+                            gnc_numeric_zero ()}).first;
+
+            auto& adj = entry->second;
+            auto amount = xaccSplitGetAmount (split);
+            auto reconcile = xaccSplitGetReconcile (split);
+            adj.balance = gnc_numeric_add (adj.balance, amount,
+                                           GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            if (reconcile != NREC)
+                adj.cleared_balance = gnc_numeric_add (adj.cleared_balance,
+                                                       amount, GNC_DENOM_AUTO,
+                                                       GNC_HOW_DENOM_LCD);
+            if (reconcile == YREC || reconcile == FREC)
+                adj.reconciled_balance =
+                    gnc_numeric_add (adj.reconciled_balance, amount,
+                                     GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        }
+    }
+
+    for (auto& entry : adjustments)
+    {
+        auto& adj = entry.second;
+        gnc_numeric* start_bal;
+        gnc_numeric* start_c_bal;
+        gnc_numeric* start_r_bal;
+
+        g_object_get (adj.acct,
+                      "start-balance", &start_bal,
+                      "start-cleared-balance", &start_c_bal,
+                      "start-reconciled-balance", &start_r_bal,
+                      NULL);
+        auto bal = gnc_numeric_sub (*start_bal, adj.balance,
+                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        auto c_bal = gnc_numeric_sub (*start_c_bal, adj.cleared_balance,
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        auto r_bal = gnc_numeric_sub (*start_r_bal, adj.reconciled_balance,
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+
+        qof_instance_increase_editlevel (adj.acct);
+        g_object_set (adj.acct,
+                      "start-balance", &bal,
+                      "start-cleared-balance", &c_bal,
+                      "start-reconciled-balance", &r_bal,
+                      NULL);
+        qof_instance_decrease_editlevel (adj.acct);
+        xaccAccountRecomputeBalance (adj.acct);
+        g_free (start_bal);
+        g_free (start_c_bal);
+        g_free (start_r_bal);
+    }
+}
 
 /**
  * Executes a transaction query statement and loads the transactions and all
@@ -336,36 +397,45 @@ typedef struct
  *
  * @param sql_be SQL backend
  * @param stmt SQL statement
+ * @param last_guid If not NULL, receives the guid of the last row returned
+ * @param loaded If not NULL, the transactions that weren't in memory before
+ * are appended to it
+ * @return Number of rows the statement returned
  */
-static void
-query_transactions (GncSqlBackend* sql_be, const GncSqlStatementPtr& stmt)
+static uint_t
+query_transactions (GncSqlBackend* sql_be, const GncSqlStatementPtr& stmt,
+                    std::string* last_guid = nullptr,
+                    InstanceVec* loaded = nullptr)
 {
-    g_return_if_fail (sql_be != NULL);
-    g_return_if_fail (stmt != NULL);
+    g_return_val_if_fail (sql_be != NULL, 0);
+    g_return_val_if_fail (stmt != NULL, 0);
 
     auto result = sql_be->execute_select_statement(stmt);
     if (result->begin() == result->end())
-        return;
+        return 0;
 
     Transaction* tx;
-#if LOAD_TRANSACTIONS_AS_NEEDED
-    GSList* bal_list = NULL;
-    Account* root = gnc_book_get_root_account (sql_be->book());
-
-    qof_event_suspend ();
-    xaccAccountBeginEdit (root);
-
-    // Save the start/ending balances (balance, cleared and reconciled) for
-    // every account.
-    gnc_account_foreach_descendant (gnc_book_get_root_account (sql_be->primary_book),
-                                    save_account_balances,
-                                    &bal_list);
-#endif
+    auto on_demand = sql_be->load_on_demand();
+
+    if (on_demand)
+        qof_event_suspend ();
 
     // Load the transactions
     InstanceVec instances;
+    uint_t num_rows = 0;
     for (auto row : *result)
     {
+        ++num_rows;
+        if (last_guid != nullptr)
+        {
+            auto guid = gnc_sql_load_guid (sql_be, row);
+            if (guid != nullptr)
+            {
+                gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+                (void)guid_to_string_buff (guid, guid_buf);
+                last_guid->assign (guid_buf);
+            }
+        }
         tx = load_single_tx (sql_be, row);
         if (tx != nullptr)
         {
@@ -385,69 +455,14 @@ query_transactions (GncSqlBackend* sql_be, const GncSqlStatementPtr& stmt)
     for (auto instance : instances)
          xaccTransCommitEdit(GNC_TRANSACTION(instance));
 
-#if LOAD_TRANSACTIONS_AS_NEEDED
-    // Update the account balances based on the loaded splits.  If the end
-    // balance has changed, update the start balance so that the end
-    // balance is the same as it was before the splits were loaded.
-    // Repeat for cleared and reconciled balances.
-    for (auto nextbal = bal_list; nextbal != NULL; nextbal = nextbal->next)
+    if (on_demand)
     {
-        full_acct_balances_t* balns = (full_acct_balances_t*)nextbal->data;
-        gnc_numeric* pnew_end_bal;
-        gnc_numeric* pnew_end_c_bal;
-        gnc_numeric* pnew_end_r_bal;
-        gnc_numeric adj;
-
-        g_object_get (balns->acc,
-                      "end-balance", &pnew_end_bal,
-                      "end-cleared-balance", &pnew_end_c_bal,
-                      "end-reconciled-balance", &pnew_end_r_bal,
-                      NULL);
-
-        qof_instance_increase_editlevel (balns - acc);
-        if (!gnc_numeric_eq (*pnew_end_bal, balns->end_bal))
-        {
-            adj = gnc_numeric_sub (balns->end_bal, *pnew_end_bal,
-                                   GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            balns->start_bal = gnc_numeric_add (balns->start_bal, adj,
-                                                GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            g_object_set (balns->acc, "start-balance", &balns->start_bal, NULL);
-            qof_instance_decrease_editlevel (balns - acc);
-        }
-        if (!gnc_numeric_eq (*pnew_end_c_bal, balns->end_cleared_bal))
-        {
-            adj = gnc_numeric_sub (balns->end_cleared_bal, *pnew_end_c_bal,
-                                   GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            balns->start_cleared_bal = gnc_numeric_add (balns->start_cleared_bal, adj,
-                                                        GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            g_object_set (balns->acc, "start-cleared-balance", &balns->start_cleared_bal,
-                          NULL);
-        }
-        if (!gnc_numeric_eq (*pnew_end_r_bal, balns->end_reconciled_bal))
-        {
-            adj = gnc_numeric_sub (balns->end_reconciled_bal, *pnew_end_r_bal,
-                                   GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            balns->start_reconciled_bal = gnc_numeric_add (balns->start_reconciled_bal,
-                                                           adj,
-                                                           GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            g_object_set (balns->acc, "start-reconciled-balance",
-                          &balns->start_reconciled_bal, NULL);
-        }
-        qof_instance_decrease_editlevel (balns - acc);
-        xaccAccountRecomputeBalance (balns->acc);
-        g_free (pnew_end_bal);
-        g_free (pnew_end_c_bal);
-        g_free (pnew_end_r_bal);
-        g_free (balns);
-    }
-    if (bal_list != NULL)
-    {
-        g_slist_free (bal_list);
+        adjust_start_balances (sql_be, instances);
+        qof_event_resume ();
     }
-
-    xaccAccountCommitEdit (root);
-    qof_event_resume ();
-#endif
+    if (loaded != nullptr)
+        loaded->insert (loaded->end(), instances.begin(), instances.end());
+    return num_rows;
 }
 
 /* ================================================================= */
@@ -759,10 +774,59 @@ void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
     }
 }
 
+/**
+ * Loads the transactions of an account posted on or after a date that
+ * aren't in memory yet.  The transactions of an account are always loaded
+ * from some date up to the present, so only those between since and the
+ * start of what's already loaded need to be read.
+ *
+ * @param sql_be SQL backend
+ * @param account Account
+ * @param since Earliest posted date to load, INT64_MIN for all
+ */
+void
+gnc_sql_transaction_load_tx_for_account_since (GncSqlBackend* sql_be,
+                                               Account* account, time64 since)
+{
+    auto loaded_since = sql_be->tx_loaded_since (account);
+    if (since >= loaded_since)
+        return;
+
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    std::stringstream sql;
+
+    (void)guid_to_string_buff (qof_instance_get_guid (QOF_INSTANCE (account)),
+                               guid_buf);
+    sql << "SELECT DISTINCT t.* FROM " << TRANSACTION_TABLE << " AS t, " <<
+        SPLIT_TABLE << " AS s WHERE s.tx_guid=t.guid AND s.account_guid='" <<
+        guid_buf << "'";
+    if (since != INT64_MIN)
+        sql << " AND t.post_date>='" <<
+            GncDateTime(since).format_zulu("%Y-%m-%d %H:%M:%S") << "'";
+    if (loaded_since != INT64_MAX)
+    {
+        sql << " AND (t.post_date<'" <<
+            GncDateTime(loaded_since).format_zulu("%Y-%m-%d %H:%M:%S") << "'";
+        if (since == INT64_MIN)
+            sql << " OR t.post_date IS NULL";
+        sql << ")";
+    }
+    auto stmt = sql_be->create_statement_from_sql(sql.str());
+    if (stmt == nullptr)
+        return;
+    query_transactions (sql_be, stmt);
+    sql_be->set_tx_loaded_since (account, since);
+}
+
 /**
  * Loads all transactions.  This might be used during a save-as operation to ensure that
  * all data is in memory and ready to be saved.
  *
+ * The transactions are read in guid order, TX_LOAD_CHUNK_SIZE at a time,
+ * each chunk starting after the last guid of the one before.  Each chunk's
+ * splits and slots are loaded before the next chunk is read, so neither the
+ * result sets nor the generated SQL grow with the size of the book.
+ *
  * @param sql_be SQL backend
  */
 void
@@ -770,374 +834,733 @@ GncSqlTransBackend::load_all (GncSqlBackend* sql_be)
 {
     g_return_if_fail (sql_be != NULL);
 
-    auto query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
-    auto stmt = sql_be->create_statement_from_sql(query_sql);
-    g_free (query_sql);
-    if (stmt != nullptr)
+    std::string last_guid;
+    uint_t num_rows;
+
+    do
     {
-        query_transactions (sql_be, stmt);
+        std::stringstream sql;
+
+        sql << "SELECT * FROM " << TRANSACTION_TABLE;
+        if (!last_guid.empty())
+            sql << " WHERE " << tx_col_table[0]->name() << " > '" <<
+                last_guid << "'";
+        sql << " ORDER BY " << tx_col_table[0]->name() << " LIMIT " <<
+            TX_LOAD_CHUNK_SIZE;
+        auto stmt = sql_be->create_statement_from_sql(sql.str());
+        if (stmt == nullptr)
+            return;
+        num_rows = query_transactions (sql_be, stmt, &last_guid);
+        sql_be->update_progress();
     }
+    while (num_rows == TX_LOAD_CHUNK_SIZE && !last_guid.empty());
 }
 
-static void
-convert_query_comparison_to_sql (QofQueryPredData* pPredData,
-                                 gboolean isInverted, std::stringstream& sql)
+/* ----------------------------------------------------------------- */
+/* Translation of split queries into SQL.
+ *
+ * compile_split_query() turns a split query into a WHERE clause over the
+ * transactions (t) and splits (s) tables.  The clause needn't be exact:
+ * the engine still runs the query over whatever is loaded, so the clause
+ * only has to select every transaction with a split the query could match.
+ * Terms that can't be expressed in SQL are left out, and those that can
+ * only be approximated (case rules and float rounding differ between the
+ * databases) are widened rather than narrowed.
+ */
+
+/** Columns that split query parameter paths of one or two elements map to */
+struct SplitQueryColumn
 {
-    if (pPredData->how == QOF_COMPARE_LT
-        || (isInverted && pPredData->how == QOF_COMPARE_GTE))
-        sql << "<";
-    else if (pPredData->how == QOF_COMPARE_LTE
-             || (isInverted && pPredData->how == QOF_COMPARE_GT))
-        sql << "<=";
-    else if (pPredData->how == QOF_COMPARE_EQUAL
-             || (isInverted && pPredData->how == QOF_COMPARE_NEQ))
-        sql << "=";
-    else if (pPredData->how == QOF_COMPARE_GT
-             || (isInverted && pPredData->how == QOF_COMPARE_LTE))
-        sql << ">";
-    else if (pPredData->how == QOF_COMPARE_GTE
-             || (isInverted && pPredData->how == QOF_COMPARE_LT))
-        sql << ">=";
-    else if (pPredData->how == QOF_COMPARE_NEQ
-             || (isInverted && pPredData->how == QOF_COMPARE_EQUAL))
-        sql <<  "~=";
-    else
+    const char* param;
+    const char* sub_param;
+    const char* column;
+};
+
+static const SplitQueryColumn split_query_columns[]
+{
+    {QOF_PARAM_GUID, nullptr, "s.guid"},
+    {SPLIT_ACCOUNT, QOF_PARAM_GUID, "s.account_guid"},
+    {SPLIT_LOT, QOF_PARAM_GUID, "s.lot_guid"},
+    {SPLIT_MEMO, nullptr, "s.memo"},
+    {SPLIT_ACTION, nullptr, "s.action"},
+    {SPLIT_RECONCILE, nullptr, "s.reconcile_state"},
+    {SPLIT_DATE_RECONCILED, nullptr, "s.reconcile_date"},
+    {SPLIT_VALUE, nullptr, "s.value"},
+    {SPLIT_AMOUNT, nullptr, "s.quantity"},
+    {SPLIT_TRANS, QOF_PARAM_GUID, "t.guid"},
+    {SPLIT_TRANS, TRANS_NUM, "t.num"},
+    {SPLIT_TRANS, TRANS_DESCRIPTION, "t.description"},
+    {SPLIT_TRANS, TRANS_DATE_POSTED, "t.post_date"},
+    {SPLIT_TRANS, TRANS_DATE_ENTERED, "t.enter_date"},
+};
+
+/* Transaction parameters kept in the slots table, by slot name */
+static const SplitQueryColumn split_query_slots[]
+{
+    {SPLIT_TRANS, TRANS_NOTES, "notes"},
+};
+
+static const char*
+find_split_query_column (const SplitQueryColumn* columns, size_t n_columns,
+                         GSList* path)
+{
+    auto param = static_cast<const char*>(path->data);
+    auto sub_param = path->next ? static_cast<const char*>(path->next->data) :
+        nullptr;
+
+    if (path->next && path->next->next)
+        return nullptr;
+    for (size_t i = 0; i < n_columns; i++)
     {
-        PERR ("Unknown comparison type\n");
-        sql << "??";
+        if (g_strcmp0 (columns[i].param, param) == 0 &&
+            g_strcmp0 (columns[i].sub_param, sub_param) == 0)
+            return columns[i].column;
     }
+    return nullptr;
 }
 
-static void
-convert_query_term_to_sql (const GncSqlBackend* sql_be, const gchar* fieldName,
-                           QofQueryTerm* pTerm, std::stringstream& sql)
+static QofQueryCompare
+invert_comparison (QofQueryCompare how)
+{
+    switch (how)
+    {
+    case QOF_COMPARE_LT:
+        return QOF_COMPARE_GTE;
+    case QOF_COMPARE_LTE:
+        return QOF_COMPARE_GT;
+    case QOF_COMPARE_GT:
+        return QOF_COMPARE_LTE;
+    case QOF_COMPARE_GTE:
+        return QOF_COMPARE_LT;
+    case QOF_COMPARE_EQUAL:
+        return QOF_COMPARE_NEQ;
+    case QOF_COMPARE_NEQ:
+        return QOF_COMPARE_EQUAL;
+    case QOF_COMPARE_CONTAINS:
+        return QOF_COMPARE_NCONTAINS;
+    case QOF_COMPARE_NCONTAINS:
+    default:
+        return QOF_COMPARE_CONTAINS;
+    }
+}
+
+static const char*
+comparison_to_sql (QofQueryCompare how)
 {
-    QofQueryPredData* pPredData;
-    gboolean isInverted;
+    switch (how)
+    {
+    case QOF_COMPARE_LT:
+        return "<";
+    case QOF_COMPARE_LTE:
+        return "<=";
+    case QOF_COMPARE_GT:
+        return ">";
+    case QOF_COMPARE_GTE:
+        return ">=";
+    case QOF_COMPARE_NEQ:
+        return "<>";
+    case QOF_COMPARE_EQUAL:
+    default:
+        return "=";
+    }
+}
 
-    g_return_if_fail (pTerm != NULL);
+static std::string
+date_to_sql (time64 t)
+{
+    return "'" + GncDateTime(t).format_zulu("%Y-%m-%d %H:%M:%S") + "'";
+}
 
-    pPredData = qof_query_term_get_pred_data (pTerm);
-    isInverted = qof_query_term_is_inverted (pTerm);
+static void
+convert_guid_term_to_sql (const char* column, query_guid_t guid_data,
+                          bool inverted, std::stringstream& sql)
+{
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
 
-    if (g_strcmp0 (pPredData->type_name, QOF_TYPE_GUID) == 0)
+    if (guid_data->options == QOF_GUID_MATCH_NULL)
     {
-        query_guid_t guid_data = (query_guid_t)pPredData;
-        GList* guid_entry;
-        sql << "(" << fieldName;
+        (void)guid_to_string_buff (guid_null (), guid_buf);
+        sql << (inverted ? "NOT " : "") << "(" << column << " IS NULL OR " <<
+            column << "='" << guid_buf << "')";
+        return;
+    }
 
-        switch (guid_data->options)
-        {
-        case QOF_GUID_MATCH_ANY:
-            sql << (isInverted ? " NOT IN (" : " IN (");
-            break;
+    auto match = guid_data->options == QOF_GUID_MATCH_ANY;
+    if (inverted)
+        match = !match;
+    if (guid_data->guids == NULL)
+    {
+        sql << (match ? "1=0" : "1=1");
+        return;
+    }
+    /* COALESCE keeps NOT IN true for splits without a lot */
+    sql << "COALESCE(" << column << ",'')" << (match ? " IN (" : " NOT IN (");
+    for (auto node = guid_data->guids; node != NULL; node = node->next)
+    {
+        (void)guid_to_string_buff (static_cast<GncGUID*>(node->data), guid_buf);
+        sql << (node != guid_data->guids ? ",'" : "'") << guid_buf << "'";
+    }
+    sql << ")";
+}
 
-        case QOF_GUID_MATCH_NONE:
-            sql << (isInverted ? " IN (" : " NOT IN (");
-            break;
+/* QOF_GUID_MATCH_ALL on the transaction's split list: the transaction has
+ * a split in each of the accounts. */
+static void
+convert_account_all_term_to_sql (query_guid_t guid_data, bool inverted,
+                                 std::stringstream& sql)
+{
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
 
-        default:
-            PERR ("Unexpected GncGUID match type: %d\n", guid_data->options);
-        }
+    sql << (inverted ? "NOT (" : "(");
+    if (guid_data->guids == NULL)
+        sql << "1=1";
+    for (auto node = guid_data->guids; node != NULL; node = node->next)
+    {
+        (void)guid_to_string_buff (static_cast<GncGUID*>(node->data), guid_buf);
+        if (node != guid_data->guids)
+            sql << " AND ";
+        sql << "t.guid IN (SELECT " << tx_guid_col_table[0]->name() <<
+            " FROM " << SPLIT_TABLE << " WHERE " <<
+            account_guid_col_table[0]->name() << "='" << guid_buf << "')";
+    }
+    sql << ")";
+}
 
-        for (guid_entry = guid_data->guids; guid_entry != NULL;
-             guid_entry = guid_entry->next)
-        {
-            gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+static void
+convert_char_term_to_sql (const char* column, query_char_t char_data,
+                          bool inverted, std::stringstream& sql)
+{
+    auto match = char_data->options == QOF_CHAR_MATCH_ANY;
+    if (inverted)
+        match = !match;
+    /* Reconcile states are letters; the empty string keeps the list
+     * well-formed and matches none of them. */
+    sql << column << (match ? " IN (''" : " NOT IN (''");
+    for (auto c = char_data->char_list; *c != '\0'; c++)
+        if (g_ascii_isalpha (*c))
+            sql << ",'" << *c << "'";
+    sql << ")";
+}
 
-            if (guid_entry != guid_data->guids) sql << ",";
-            (void)guid_to_string_buff (static_cast<GncGUID*> (guid_entry->data),
-                                       guid_buf);
-            sql << guid_buf;
-        }
-        sql << "))";
+/* The engine compares dates to the second, or by local day with
+ * QOF_DATE_MATCH_DAY.  A transaction whose date is NULL in the database
+ * gets one when it's loaded, so NULL dates always match. */
+static void
+convert_date_term_to_sql (const char* column, query_date_t date_data,
+                          bool inverted, std::stringstream& sql)
+{
+    auto how = date_data->pd.how;
+    auto date = date_data->date.tv_sec;
 
-    }
-    else if (g_strcmp0 (pPredData->type_name, QOF_TYPE_CHAR) == 0)
+    if (inverted)
+        how = invert_comparison (how);
+    sql << "(" << column << " IS NULL OR ";
+    if (date_data->options != QOF_DATE_MATCH_DAY)
     {
-        query_char_t char_data = (query_char_t)pPredData;
-        int i;
-
-        if (isInverted) sql <<  "NOT(";
-        if (char_data->options == QOF_CHAR_MATCH_NONE) sql << "NOT ";
-        sql << "(";
-        for (i = 0; char_data->char_list[i] != '\0'; i++)
-        {
-            if (i != 0) sql << " OR ";
-            sql << fieldName << " = '" << char_data->char_list[i] << "'";
-        }
-        sql << ") ";
-        if (isInverted) sql << ") ";
+        sql << column << comparison_to_sql (how) << date_to_sql (date);
     }
-    else if (g_strcmp0 (pPredData->type_name, QOF_TYPE_STRING) == 0)
+    else
     {
-        query_string_t string_data = (query_string_t)pPredData;
-        sqlEscape* escape = sqlEscape_new ();
-
-        if (isInverted ||  pPredData->how == QOF_COMPARE_NEQ)
-            sql << "NOT(";
-        sql << fieldName;
-        if (string_data->is_regex ||
-            string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE)
+        auto start = date_to_sql (gnc_time64_get_day_start (date));
+        auto end = date_to_sql (gnc_time64_get_day_end (date));
+        switch (how)
         {
-            PWARN ("String is_regex || option = QOF_STRING_MATCH_INSENSITIVE\n");
+        case QOF_COMPARE_LT:
+            sql << column << "<" << start;
+            break;
+        case QOF_COMPARE_LTE:
+            sql << column << "<=" << end;
+            break;
+        case QOF_COMPARE_GT:
+            sql << column << ">" << end;
+            break;
+        case QOF_COMPARE_GTE:
+            sql << column << ">=" << start;
+            break;
+        case QOF_COMPARE_NEQ:
+            sql << column << "<" << start << " OR " << column << ">" << end;
+            break;
+        case QOF_COMPARE_EQUAL:
+        default:
+            sql << column << " BETWEEN " << start << " AND " << end;
+            break;
         }
-//          sql << " ~" ;
-//      } else {
-        sql << " =";
-//      }
-//      if( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE ) {
-//          sql+= "*";
-//      }
-        sql << "'" << sqlEscapeString (escape, string_data->matchstring) << "'";
-        if (pPredData->how == QOF_COMPARE_NEQ) sql << ")";
-        if (isInverted) sql << ")";
-        sqlEscape_destroy (escape);
+    }
+    sql << ")";
+}
 
+/* The engine compares the absolute value of an amount after checking
+ * its sign.  EQUAL and NEQ take the absolute value of the query's amount
+ * too; the ordering comparisons use it as it is.  The SQL compares the
+ * stored num/denom with the query's p/q exactly, in integers: |num|/denom
+ * relates to p/q as |num|*q does to p*denom.
+ *
+ * EQUAL and NEQ treat amounts as equal when their difference, rounded to
+ * 1/100000, is under 1/10000.  So every amount less than 19/200000 away is
+ * equal and none 1/10000 or more away is, and EQUAL selects the former
+ * bound, NEQ the latter, each a superset of what the engine matches. */
+static bool
+convert_numeric_term_to_sql (const char* column, query_numeric_t num_data,
+                             bool inverted, std::stringstream& sql)
+{
+    auto how = num_data->pd.how;
+    auto amount = gnc_numeric_reduce (num_data->amount);
+    if (gnc_numeric_check (amount) != GNC_ERROR_OK || amount.denom <= 0)
+        return false;
+
+    std::stringstream denom;
+    denom << column << "_denom*" << amount.denom;
+    sql << "(";
+    if (num_data->options != QOF_NUMERIC_MATCH_ANY)
+    {
+        /* Credits are negative, debits positive; zero is both */
+        auto credit = num_data->options == QOF_NUMERIC_MATCH_CREDIT;
+        sql << column << "_num" << (credit != inverted ? "<=0" : ">=0") <<
+            (inverted ? " OR " : " AND ");
     }
-    else
+    if (inverted)
+        how = invert_comparison (how);
+    switch (how)
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
+        sql << "ABS(" << column << "_num)*" << amount.denom <<
+            comparison_to_sql (how) << amount.num << "*" << column << "_denom";
+        break;
+    case QOF_COMPARE_NEQ:
+    case QOF_COMPARE_EQUAL:
+    default:
     {
-        sql << "(" << fieldName;
-        convert_query_comparison_to_sql (pPredData, isInverted, sql);
+        auto num = amount.num < 0 ? -amount.num : amount.num;
+        std::stringstream diff;
+        diff << "ABS(ABS(" << column << "_num)*" << amount.denom << "-" <<
+            num << "*" << column << "_denom)";
+        if (how == QOF_COMPARE_NEQ)
+            sql << diff.str() << "*200000>=19*" << denom.str();
+        else
+            sql << diff.str() << "*10000<" << denom.str();
+        break;
+    }
+    }
+    sql << ")";
+    return true;
+}
 
-        if (strcmp (pPredData->type_name, QOF_TYPE_NUMERIC) == 0)
-        {
-            query_numeric_t pData = (query_numeric_t)pPredData;
-            sql << gnc_numeric_to_double (pData->amount);
-        }
-        else if (g_strcmp0 (pPredData->type_name, QOF_TYPE_DATE) == 0)
-        {
-            query_date_t date_data = (query_date_t)pPredData;
+static bool
+is_plain_regex (const char* str)
+{
+    return str[strcspn (str, ".[]()*+?{}|^$\\")] == '\0';
+}
 
-            GncDateTime time(date_data->date.tv_sec);
-            sql << time.format_zulu ("%Y-%m-%d %H:%M:%S");
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_INT32) == 0)
-        {
-            query_int32_t pData = (query_int32_t)pPredData;
-            sql << pData->val;
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_INT64) == 0)
-        {
-            query_int64_t pData = (query_int64_t)pPredData;
-            sql << pData->val;
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_DOUBLE) == 0)
-        {
-            query_double_t pData = (query_double_t)pPredData;
-            sql << pData->val;
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_BOOLEAN) == 0)
-        {
-            query_boolean_t pData = (query_boolean_t)pPredData;
-            sql << pData->val;
-        }
-        else
+/* Only a condition that selects at least the matching strings can be
+ * built, so a negated string term can't be converted; compile_split_query
+ * doesn't push down a query that has one.  LIKE is case-insensitive in
+ * some databases, which only widens the match.  The LIKE wildcards and
+ * escape character in the pattern are replaced with '_', which matches
+ * them too, so no ESCAPE clause is needed. */
+static bool
+is_negated_string_term (QofQueryTerm* term)
+{
+    auto pred = qof_query_term_get_pred_data (term);
+    if (g_strcmp0 (pred->type_name, QOF_TYPE_STRING) != 0)
+        return false;
+    auto how = pred->how;
+    auto positive = how == QOF_COMPARE_EQUAL || how == QOF_COMPARE_CONTAINS;
+    return positive == static_cast<bool>(qof_query_term_is_inverted (term));
+}
+
+static bool
+convert_string_term_to_sql (const GncSqlBackend* sql_be, const char* column,
+                            query_string_t string_data, bool inverted,
+                            std::stringstream& sql)
+{
+    auto how = string_data->pd.how;
+    auto positive = how == QOF_COMPARE_EQUAL || how == QOF_COMPARE_CONTAINS;
+    auto contains = how == QOF_COMPARE_CONTAINS ||
+        how == QOF_COMPARE_NCONTAINS;
+    auto nocase = string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE;
+    std::string pattern{string_data->matchstring};
+
+    if (positive == inverted)
+        return false;
+    if (string_data->is_regex)
+    {
+        /* An unanchored regex without operators matches as a substring */
+        if (!is_plain_regex (string_data->matchstring))
+            return false;
+        contains = true;
+    }
+    if (pattern.empty() && contains)
+        return false;
+    if (nocase)
+    {
+        /* LOWER() only folds ASCII in every database */
+        for (auto& c : pattern)
         {
-            PERR ("Unknown query predicate type: %s\n", pPredData->type_name);
+            if (!g_ascii_isprint (c))
+                return false;
+            c = g_ascii_tolower (c);
         }
-
-        sql << ")";
     }
+    for (auto& c : pattern)
+        if (c == '%' || c == '_' || c == '\\')
+            c = '_';
+    if (contains)
+        pattern = "%" + pattern + "%";
+
+    if (nocase)
+        sql << "LOWER(COALESCE(" << column << ",''))";
+    else
+        sql << "COALESCE(" << column << ",'')";
+    sql << " LIKE " << sql_be->quote_string (pattern);
+    return true;
 }
 
-typedef struct
+/* A transaction parameter stored as a slot: a transaction without the
+ * slot has an empty value, which the string conditions never select. */
+static bool
+convert_slot_term_to_sql (const GncSqlBackend* sql_be, const char* slot_name,
+                          QofQueryTerm* term, std::stringstream& sql)
 {
-    GncSqlStatementPtr stmt;
-    gboolean has_been_run;
-} split_query_info_t;
-
-#define TX_GUID_CHECK 0
+    auto pred = qof_query_term_get_pred_data (term);
+    std::stringstream cond;
+
+    if (g_strcmp0 (pred->type_name, QOF_TYPE_STRING) != 0 ||
+        ((query_string_t)pred)->matchstring[0] == '\0' ||
+        !convert_string_term_to_sql (sql_be, "string_val",
+                                     (query_string_t)pred,
+                                     qof_query_term_is_inverted (term), cond))
+        return false;
+
+    sql << "t.guid IN (SELECT obj_guid FROM slots WHERE name=" <<
+        sql_be->quote_string (slot_name) << " AND " << cond.str() << ")";
+    return true;
+}
 
-G_GNUC_UNUSED static  gpointer
-compile_split_query (GncSqlBackend* sql_be, QofQuery* query)
+/**
+ * Appends the SQL condition for one split query term.
+ *
+ * @param sql_be SQL backend
+ * @param term Query term
+ * @param sql Stream the condition is appended to
+ * @return false if the term has no SQL equivalent, and nothing was appended
+ */
+static bool
+convert_query_term_to_sql (const GncSqlBackend* sql_be, QofQueryTerm* term,
+                           std::stringstream& sql)
 {
-    split_query_info_t* query_info = NULL;
-    gchar* query_sql;
+    auto path = qof_query_term_get_param_path (term);
+    auto pred = qof_query_term_get_pred_data (term);
+    bool inverted = qof_query_term_is_inverted (term);
+
+    if (path == NULL)
+        return false;
+
+    auto slot_name = find_split_query_column (split_query_slots,
+                                              G_N_ELEMENTS (split_query_slots),
+                                              path);
+    if (slot_name != nullptr)
+        return convert_slot_term_to_sql (sql_be, slot_name, term, sql);
+
+    if (g_slist_length (path) == 3 &&
+        g_strcmp0 (static_cast<const char*>(path->data), SPLIT_TRANS) == 0 &&
+        g_strcmp0 (static_cast<const char*>(path->next->data),
+                   TRANS_SPLITLIST) == 0 &&
+        g_strcmp0 (static_cast<const char*>(path->next->next->data),
+                   SPLIT_ACCOUNT_GUID) == 0 &&
+        g_strcmp0 (pred->type_name, QOF_TYPE_GUID) == 0 &&
+        ((query_guid_t)pred)->options == QOF_GUID_MATCH_ALL)
+    {
+        convert_account_all_term_to_sql ((query_guid_t)pred, inverted, sql);
+        return true;
+    }
 
-    g_return_val_if_fail (sql_be != NULL, NULL);
-    g_return_val_if_fail (query != NULL, NULL);
+    auto column = find_split_query_column (split_query_columns,
+                                           G_N_ELEMENTS (split_query_columns),
+                                           path);
+    if (column == nullptr)
+        return false;
 
-    query_info = static_cast<decltype (query_info)> (
-                     g_malloc (sizeof (split_query_info_t)));
-    g_assert (query_info != NULL);
-    query_info->has_been_run = FALSE;
+    if (g_strcmp0 (pred->type_name, QOF_TYPE_GUID) == 0)
+    {
+        auto guid_data = (query_guid_t)pred;
+        if (guid_data->options != QOF_GUID_MATCH_ANY &&
+            guid_data->options != QOF_GUID_MATCH_NONE &&
+            guid_data->options != QOF_GUID_MATCH_NULL)
+            return false;
+        convert_guid_term_to_sql (column, guid_data, inverted, sql);
+    }
+    else if (g_strcmp0 (pred->type_name, QOF_TYPE_CHAR) == 0)
+        convert_char_term_to_sql (column, (query_char_t)pred, inverted, sql);
+    else if (g_strcmp0 (pred->type_name, QOF_TYPE_DATE) == 0)
+        convert_date_term_to_sql (column, (query_date_t)pred, inverted, sql);
+    else if (g_strcmp0 (pred->type_name, QOF_TYPE_NUMERIC) == 0)
+        return convert_numeric_term_to_sql (column, (query_numeric_t)pred,
+                                            inverted, sql);
+    else if (g_strcmp0 (pred->type_name, QOF_TYPE_STRING) == 0)
+        return convert_string_term_to_sql (sql_be, column, (query_string_t)pred,
+                                           inverted, sql);
+    else
+        return false;
+    return true;
+}
 
-    if (qof_query_has_terms (query))
+/**
+ * Builds the WHERE clause selecting the transactions a split query could
+ * match.
+ *
+ * @param sql_be SQL backend
+ * @param query Split query
+ * @param sql Stream the clause is appended to
+ * @return false if some part of the query can't be narrowed down in SQL,
+ * so that every transaction would have to be selected.
+ */
+static bool
+compile_split_query (const GncSqlBackend* sql_be, QofQuery* query,
+                     std::stringstream& sql)
+{
+    auto or_terms = qof_query_get_terms (query);
+    if (or_terms == NULL)
+        return false;
+
+    for (auto or_node = or_terms; or_node != NULL; or_node = or_node->next)
     {
-        GList* orterms = qof_query_get_terms (query);
-        GList* orTerm;
-        std::stringstream sql;
-        gboolean need_OR = FALSE;
+        std::stringstream and_sql;
+        bool need_and = false;
 
-        for (orTerm = orterms; orTerm != NULL; orTerm = orTerm->next)
+        /* Leaving out an ANDed term only widens the selection */
+        for (auto and_node = static_cast<GList*>(or_node->data);
+             and_node != NULL; and_node = and_node->next)
         {
-            GList* andterms = (GList*)orTerm->data;
-            GList* andTerm;
-            gboolean need_AND = FALSE;
-#if TX_GUID_CHECK
-            gboolean has_tx_guid_check = FALSE;
-#endif
-            if (need_OR)
+            std::stringstream term_sql;
+            auto term = static_cast<QofQueryTerm*>(and_node->data);
+
+            /* NOT LIKE would miss strings the engine matches wherever
+             * LIKE's case rules or the replaced wildcards differ from the
+             * engine's, so a negated string term has no SQL form.  Rather
+             * than narrow the query on its other terms alone, don't push
+             * it down at all. */
+            if (is_negated_string_term (term))
             {
-                sql << " OR ";
+                DEBUG ("Negated string term, loading everything");
+                return false;
             }
-            sql << "(";
-            for (andTerm = andterms; andTerm != NULL; andTerm = andTerm->next)
-            {
-                QofQueryTerm* term;
-                GSList* paramPath;
-                gboolean unknownPath = FALSE;
-
-                term = (QofQueryTerm*)andTerm->data;
-                paramPath = qof_query_term_get_param_path (term);
-                const char* path = static_cast<decltype (path)> (paramPath->data);
-                const char* next_path =
-                    static_cast<decltype (next_path)> (paramPath->next->data);
-                if (strcmp (path, QOF_PARAM_BOOK) == 0) continue;
-
-#if SIMPLE_QUERY_COMPILATION
-                if (strcmp (path, SPLIT_ACCOUNT) != 0 ||
-                    strcmp (next_path, QOF_PARAM_GUID) != 0) continue;
-#endif
+            if (!convert_query_term_to_sql (sql_be, term, term_sql))
+                continue;
+            if (need_and)
+                and_sql << " AND ";
+            and_sql << term_sql.str();
+            need_and = true;
+        }
+        if (!need_and)
+            return false;
 
-                if (need_AND) sql<< " AND ";
+        if (or_node != or_terms)
+            sql << " OR ";
+        sql << "(" << and_sql.str() << ")";
+    }
+    return true;
+}
 
-                if (strcmp (path, SPLIT_ACCOUNT) == 0 &&
-                    strcmp (next_path, QOF_PARAM_GUID) == 0)
-                {
-                    convert_query_term_to_sql (sql_be, "s.account_guid", term,
-                                               sql);
-#if SIMPLE_QUERY_COMPILATION
-                    goto done_compiling_query;
-#endif
+/**
+ * Loads the transactions a split query could match, selecting them in the
+ * database.  They may be anywhere in their accounts' history, but running
+ * balances are only right when everything after an account's first loaded
+ * transaction is loaded too; so each account they touch is then loaded
+ * from the earliest of them on.
+ *
+ * @param sql_be SQL backend
+ * @param query Split query
+ * @return false if the query couldn't be compiled into SQL
+ */
+static bool
+load_tx_for_split_query (GncSqlBackend* sql_be, QofQuery* query)
+{
+    std::stringstream where;
+    if (!compile_split_query (sql_be, query, where))
+        return false;
 
-                }
-                else if (strcmp (path, SPLIT_RECONCILE) == 0)
-                {
-                    convert_query_term_to_sql (sql_be, "s.reconcile_state",
-                                               term, sql);
+    std::stringstream sql;
+    sql << "SELECT DISTINCT t.* FROM " << TRANSACTION_TABLE << " AS t, " <<
+        SPLIT_TABLE << " AS s WHERE s.tx_guid=t.guid AND (" << where.str() <<
+        ")";
+    DEBUG ("%s", sql.str().c_str());
+    auto stmt = sql_be->create_statement_from_sql(sql.str());
+    if (stmt == nullptr)
+        return false;
+    InstanceVec loaded;
+    query_transactions (sql_be, stmt, nullptr, &loaded);
+
+    std::map<Account*, time64> earliest;
+    auto root = gnc_book_get_root_account (sql_be->book());
+    for (auto inst : loaded)
+    {
+        auto trans = GNC_TRANSACTION (inst);
+        auto date = xaccTransGetDate (trans);
+        for (auto node = xaccTransGetSplitList (trans); node != NULL;
+             node = node->next)
+        {
+            auto acc = xaccSplitGetAccount (GNC_SPLIT (node->data));
+            if (acc == NULL || gnc_account_get_root (acc) != root)
+                continue;
+            auto entry = earliest.find (acc);
+            if (entry == earliest.end())
+                earliest.emplace (acc, date);
+            else
+                entry->second = std::min (entry->second, date);
+        }
+    }
+    for (auto& entry : earliest)
+        gnc_sql_transaction_load_tx_for_account_since (sql_be, entry.first,
+                                                       entry.second);
+    return true;
+}
 
-                }
-                else if (strcmp (path, SPLIT_TRANS) == 0)
-                {
-#if TX_GUID_CHECK
-                    if (!has_tx_guid_check)
-                    {
-                        sql << "(splits.tx_guid = transactions.guid) AND ");
-                        has_tx_guid_check = TRUE;
-                    }
-#endif
-                    if (strcmp (next_path, TRANS_DATE_POSTED) == 0)
-                    {
-                        convert_query_term_to_sql (sql_be, "t.post_date", term,
-                                                   sql);
-                    }
-                    else if (strcmp (next_path, TRANS_DESCRIPTION) == 0)
-                    {
-                        convert_query_term_to_sql (sql_be, "t.description",
-                                                   term, sql);
-                    }
-                    else
-                    {
-                        unknownPath = TRUE;
-                    }
+/**
+ * Finds the accounts a split query restricts its splits to.
+ *
+ * @param sql_be SQL backend
+ * @param term Query term
+ * @param accounts Set the term's accounts are added to
+ * @return true if the term restricts the splits to the accounts
+ */
+static bool
+get_term_accounts (GncSqlBackend* sql_be, QofQueryTerm* term,
+                   std::set<Account*>& accounts)
+{
+    if (qof_query_term_is_inverted (term))
+        return false;
+
+    auto pred = qof_query_term_get_pred_data (term);
+    if (g_strcmp0 (pred->type_name, QOF_TYPE_GUID) != 0)
+        return false;
+
+    auto guid_data = (query_guid_t)pred;
+    auto path = qof_query_term_get_param_path (term);
+    auto param = static_cast<const char*>(path->data);
+    auto depth = g_slist_length (path);
+    /* The two forms xaccQueryAddAccountMatch() builds */
+    auto any_match = guid_data->options == QOF_GUID_MATCH_ANY && depth == 2 &&
+        g_strcmp0 (param, SPLIT_ACCOUNT) == 0;
+    auto all_match = guid_data->options == QOF_GUID_MATCH_ALL && depth == 3 &&
+        g_strcmp0 (param, SPLIT_TRANS) == 0;
+    if (!any_match && !all_match)
+        return false;
+
+    for (auto node = guid_data->guids; node != NULL; node = node->next)
+    {
+        auto acc = xaccAccountLookup (static_cast<GncGUID*>(node->data),
+                                      sql_be->book());
+        if (acc != NULL)
+            accounts.insert (acc);
+    }
+    return true;
+}
 
-                }
-                else if (strcmp (path, SPLIT_VALUE) == 0)
+/**
+ * Finds the earliest posted date a split query term lets through.
+ *
+ * @param term Query term
+ * @return The date, or INT64_MIN if the term doesn't restrict the date
+ */
+static time64
+get_term_post_date_bound (QofQueryTerm* term)
+{
+    if (qof_query_term_is_inverted (term))
+        return INT64_MIN;
+
+    auto pred = qof_query_term_get_pred_data (term);
+    if (g_strcmp0 (pred->type_name, QOF_TYPE_DATE) != 0 ||
+        (pred->how != QOF_COMPARE_GT && pred->how != QOF_COMPARE_GTE &&
+         pred->how != QOF_COMPARE_EQUAL))
+        return INT64_MIN;
+
+    auto path = qof_query_term_get_param_path (term);
+    if (g_slist_length (path) != 2 ||
+        g_strcmp0 (static_cast<const char*>(path->data), SPLIT_TRANS) != 0 ||
+        g_strcmp0 (static_cast<const char*>(path->next->data),
+                   TRANS_DATE_POSTED) != 0)
+        return INT64_MIN;
+
+    auto date_data = (query_date_t)pred;
+    if (date_data->options == QOF_DATE_MATCH_DAY)
+        return gnc_time64_get_day_start (date_data->date.tv_sec);
+    return date_data->date.tv_sec;
+}
+
+bool
+gnc_sql_transaction_load_for_query (GncSqlBackend* sql_be, QofQuery* query)
+{
+    g_return_val_if_fail (sql_be != NULL, false);
+    g_return_val_if_fail (query != NULL, false);
+
+    /* Only split queries can be narrowed down.  Anything else, even a
+     * search for lots or invoices, may reach splits of any account, so
+     * it gets the full load. */
+    auto search_type = qof_query_get_search_for (query);
+    if (g_strcmp0 (search_type, GNC_ID_SPLIT) != 0)
+        return false;
+
+    auto or_terms = qof_query_get_terms (query);
+    if (or_terms == NULL)
+        return false;
+
+    /* When each OR branch is limited to some accounts, the accounts are
+     * loaded from the earliest date their branches accept, which keeps
+     * their running balances right.  Otherwise the query's matches are
+     * selected in the database. */
+    std::map<Account*, time64> wanted;
+    for (auto or_node = or_terms; or_node != NULL; or_node = or_node->next)
+    {
+        std::set<Account*> accounts;
+        bool restricted = false;
+        time64 since = INT64_MIN;
+
+        for (auto and_node = static_cast<GList*>(or_node->data);
+             and_node != NULL; and_node = and_node->next)
+        {
+            auto term = static_cast<QofQueryTerm*>(and_node->data);
+            std::set<Account*> term_accounts;
+
+            if (get_term_accounts (sql_be, term, term_accounts))
+            {
+                /* ANDed account terms: only splits in both can match */
+                if (restricted)
                 {
-                    convert_query_term_to_sql (sql_be,
-                                               "s.value_num/s.value_denom",
-                                               term, sql);
+                    std::set<Account*> both;
+                    for (auto acc : term_accounts)
+                        if (accounts.count (acc))
+                            both.insert (acc);
+                    accounts.swap (both);
                 }
                 else
                 {
-                    unknownPath = TRUE;
+                    accounts.swap (term_accounts);
                 }
-
-                if (unknownPath)
-                {
-                    std::stringstream name;
-                    name << static_cast<char*>(paramPath->data);
-                    for (;paramPath->next != NULL; paramPath = paramPath->next)
-                    {
-                        next_path =
-                            static_cast<decltype (next_path)>(paramPath->next->data);
-                        name << "." << next_path;
-                    }
-                    PERR ("Unknown SPLIT query field: %s\n",
-                          name.str().c_str());
-                }
-                need_AND = TRUE;
-            }
-
-            /* If the last char in the string is a '(', then for some reason, there were
-               no terms added to the SQL.  If so, remove it and ignore the OR term. */
-        if (!sql.str().empty() && sql.str().back() == '(')
-            {
-                sql.str().erase(sql.str().back());
-                need_OR = FALSE;
-            }
-            else
-            {
-                sql << ")";
-                need_OR = TRUE;
+                restricted = true;
             }
+            since = std::max (since, get_term_post_date_bound (term));
         }
+        /* Not limited to accounts: select the matches in the database */
+        if (!restricted)
+            return load_tx_for_split_query (sql_be, query);
 
-#if SIMPLE_QUERY_COMPILATION
-done_compiling_query:
-#endif
-    if (!sql.str().empty())
+        for (auto acc : accounts)
         {
-#if SIMPLE_QUERY_COMPILATION
-            sql<< ")";
-#endif
-            query_sql = g_strdup_printf (
-                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s",
-                            TRANSACTION_TABLE, SPLIT_TABLE, sql.str().c_str());
-        }
-        else
-        {
-            query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
+            auto entry = wanted.find (acc);
+            if (entry == wanted.end())
+                wanted.emplace (acc, since);
+            else
+                entry->second = std::min (entry->second, since);
         }
-        query_info->stmt = sql_be->create_statement_from_sql(query_sql);
-        g_free (query_sql);
-
-    }
-    else
-    {
-        query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
-        query_info->stmt = sql_be->create_statement_from_sql(query_sql);
-        g_free (query_sql);
     }
 
-    return query_info;
-}
-
-G_GNUC_UNUSED static void
-run_split_query (GncSqlBackend* sql_be, gpointer pQuery)
-{
-    split_query_info_t* query_info = (split_query_info_t*)pQuery;
-
-    g_return_if_fail (sql_be != NULL);
-    g_return_if_fail (pQuery != NULL);
-
-    if (!query_info->has_been_run)
-    {
-        query_transactions (sql_be, query_info->stmt);
-        query_info->has_been_run = TRUE;
-        query_info->stmt = nullptr;
-    }
-}
-
-G_GNUC_UNUSED static void
-free_split_query (GncSqlBackend* sql_be, gpointer pQuery)
-{
-    g_return_if_fail (sql_be != NULL);
-    g_return_if_fail (pQuery != NULL);
-
-    g_free (pQuery);
+    for (auto& entry : wanted)
+        gnc_sql_transaction_load_tx_for_account_since (sql_be, entry.first,
+                                                       entry.second);
+    return true;
 }
 
 /* ----------------------------------------------------------------- */
@@ -1193,7 +1616,7 @@ static const EntryVec acct_balances_col_table
                                          (QofSetterFunc)set_acct_bal_balance),
 };
 
-G_GNUC_UNUSED static  single_acct_balance_t*
+static  single_acct_balance_t*
 load_single_acct_balances (const GncSqlBackend* sql_be, GncSqlRow& row)
 {
     single_acct_balance_t* bal = NULL;
@@ -1212,7 +1635,6 @@ load_single_acct_balances (const GncSqlBackend* sql_be, GncSqlRow& row)
 GSList*
 gnc_sql_get_account_balances_slist (GncSqlBackend* sql_be)
 {
-#if LOAD_TRANSACTIONS_AS_NEEDED
     gchar* buf;
     GSList* bal_slist = NULL;
 
@@ -1246,7 +1668,8 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* sql_be)
             }
             if (bal == NULL)
             {
-                bal = g_malloc ((gsize)sizeof (acct_balances_t));
+                bal = static_cast<decltype (bal)> (
+                          g_malloc (sizeof (acct_balances_t)));
                 g_assert (bal != NULL);
 
                 bal->acct = single_bal->acct;
@@ -1254,18 +1677,19 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* sql_be)
                 bal->cleared_balance = gnc_numeric_zero ();
                 bal->reconciled_balance = gnc_numeric_zero ();
             }
-            if (single_bal->reconcile_state == 'n')
+            if (single_bal->reconcile_state == NREC)
             {
                 bal->balance = gnc_numeric_add (bal->balance, single_bal->balance,
                                                 GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
             }
-            else if (single_bal->reconcile_state == 'c')
+            else if (single_bal->reconcile_state != YREC &&
+                     single_bal->reconcile_state != FREC)
             {
                 bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
                                                         single_bal->balance,
                                                         GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
             }
-            else if (single_bal->reconcile_state == 'y')
+            else
             {
                 bal->reconciled_balance = gnc_numeric_add (bal->reconciled_balance,
                                                            single_bal->balance,
@@ -1287,9 +1711,6 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* sql_be)
     }
 
     return bal_slist;
-#else
-    return NULL;
-#endif
 }
 
 /* ----------------------------------------------------------------- */
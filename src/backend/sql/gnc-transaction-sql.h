@@ -61,6 +61,35 @@ public:
  */
 void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
                                               Account* account);
+
+/**
+ * Loads the transactions of an account posted on or after a date that
+ * aren't in memory yet, for a backend that loads transactions on demand.
+ *
+ * @param sql_be SQL backend
+ * @param account Account
+ * @param since Earliest posted date to load, INT64_MIN for all
+ */
+void gnc_sql_transaction_load_tx_for_account_since (GncSqlBackend* sql_be,
+                                                    Account* account,
+                                                    time64 since);
+
+/**
+ * Loads the transactions that a split query could match, for a backend
+ * that loads transactions on demand.  Each account the query restricts the
+ * splits to has its transactions loaded from the query's earliest posted
+ * date on, so that its running balances stay right.  Other split queries
+ * are translated to SQL and the transactions they select are loaded, each
+ * account they touch from the earliest of them on.
+ *
+ * @param sql_be SQL backend
+ * @param query The query about to be run
+ * @return false if the query could not be narrowed down, as for any query
+ * that doesn't search for splits, and every transaction has to be loaded
+ * instead.
+ */
+bool gnc_sql_transaction_load_for_query (GncSqlBackend* sql_be,
+                                         QofQuery* query);
 typedef struct
 {
     Account* acct;
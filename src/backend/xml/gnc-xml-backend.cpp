@@ -32,6 +32,8 @@ extern "C"
 #include <regex.h>
 
 #include <gnc-engine.h> //for GNC_MOD_BACKEND
+#include <Account.h>
+#include <Transaction.h>
 #include <gnc-uri-utils.h>
 #include <TransLog.h>
 #include <gnc-prefs.h>
@@ -176,6 +178,17 @@ GncXmlBackend::session_end()
         return;
     }
 
+    /* Fold any journal back into the data file so that the next load
+     * doesn't have to replay it. */
+    auto journal = get_journal_filename();
+    if (m_book && !qof_book_session_not_saved (m_book) &&
+        g_file_test (journal.c_str(), G_FILE_TEST_EXISTS) &&
+        write_to_file (true))
+        g_unlink (journal.c_str());
+    m_journal.clear();
+    m_journal_full_save = false;
+    m_journal_base_ok = false;
+
     if (!m_linkfile.empty())
         g_unlink (m_linkfile.c_str());
 
@@ -243,6 +256,7 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
 
     error = ERR_BACKEND_NO_ERR;
     m_book = book;
+    m_loading = true;
 
     int rc;
     switch (determine_file_type (m_fullpath))
@@ -296,6 +310,11 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
         break;
     }
 
+    m_loading = false;
+    m_journal.clear();
+    m_journal_full_save = false;
+    m_journal_base_ok = (error == ERR_BACKEND_NO_ERR);
+
     if (error != ERR_BACKEND_NO_ERR)
     {
         set_error(error);
@@ -305,6 +324,94 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
     qof_book_mark_session_saved (book);
 }
 
+void
+GncXmlBackend::commit (QofInstance* inst)
+{
+    if (m_loading || inst == nullptr)
+        return;
+
+    if (GNC_IS_SPLIT (inst))
+    {
+        auto trans = xaccSplitGetParent (GNC_SPLIT (inst));
+        if (trans == nullptr)
+            return;
+        inst = QOF_INSTANCE (trans);
+    }
+
+    if (GNC_IS_TRANS (inst))
+    {
+        auto guid = guid_to_string (qof_instance_get_guid (inst));
+        auto& deleted = m_journal[guid];
+        deleted = deleted || qof_instance_get_destroying (inst);
+        g_free (guid);
+    }
+    else if (qof_instance_get_dirty_flag (inst) ||
+             qof_instance_get_destroying (inst))
+    {
+        m_journal_full_save = true;
+    }
+}
+
+/* Write the transactions noted by commit() to the journal.  Template
+ * transactions live in the scheduled transactions' template accounts
+ * and aren't journaled; if one changed, nothing is written and
+ * m_journal_full_save is set so that sync() saves the whole book. */
+bool
+GncXmlBackend::append_journal ()
+{
+    auto root = gnc_book_get_root_account (m_book);
+    GList* changed = nullptr;
+    GList* deleted = nullptr;
+
+    for (auto& entry : m_journal)
+    {
+        auto guid = guid_new ();
+        string_to_guid (entry.first.c_str(), guid);
+        auto trans = entry.second ? nullptr : xaccTransLookup (guid, m_book);
+
+        if (trans == nullptr)
+        {
+            deleted = g_list_prepend (deleted, guid);
+            continue;
+        }
+        guid_free (guid);
+
+        auto split = xaccTransGetSplit (trans, 0);
+        auto acct = split ? xaccSplitGetAccount (split) : nullptr;
+        if (acct && gnc_account_get_root (acct) != root)
+        {
+            m_journal_full_save = true;
+            break;
+        }
+        changed = g_list_prepend (changed, trans);
+    }
+
+    auto ok = !m_journal_full_save &&
+              gnc_book_append_to_xml_journal_v2 (m_book,
+                                                 get_journal_filename().c_str(),
+                                                 changed, deleted);
+    if (ok)
+        m_journal.clear();
+
+    g_list_free (changed);
+    g_list_free_full (deleted, (GDestroyNotify)guid_free);
+    return ok;
+}
+
+/* Once the journal outgrows the data file, loading it costs more than
+ * rewriting the data file would. */
+bool
+GncXmlBackend::journal_too_big ()
+{
+    GStatBuf base, journal;
+
+    if (g_stat (m_fullpath.c_str(), &base) != 0)
+        return true;
+    if (g_stat (get_journal_filename().c_str(), &journal) != 0)
+        return false;
+    return journal.st_size > MAX (base.st_size, 1 << 20);
+}
+
 void
 GncXmlBackend::sync(QofBook* book)
 {
@@ -324,7 +431,27 @@ GncXmlBackend::sync(QofBook* book)
         return;
     }
 
-    write_to_file (true);
+    auto journal = get_journal_filename();
+    if (gnc_prefs_get_file_save_journal () && m_journal_base_ok &&
+        !m_journal_full_save && !journal_too_big ())
+    {
+        if (append_journal ())
+        {
+            qof_book_mark_session_saved (m_book);
+            return;
+        }
+        if (!m_journal_full_save)
+            PWARN ("Unable to append to journal %s, saving the whole book",
+                   journal.c_str());
+    }
+
+    if (write_to_file (true))
+    {
+        g_unlink (journal.c_str());
+        m_journal.clear();
+        m_journal_full_save = false;
+        m_journal_base_ok = true;
+    }
     remove_old_files();
 }
 
@@ -23,6 +23,7 @@ extern "C"
 #include <qof.h>
 }
 
+#include <map>
 #include <string>
 #include <qof-backend.hpp>
 
@@ -39,11 +40,14 @@ public:
                        bool ignore_lock, bool create, bool force) override;
     void session_end() override;
     void load(QofBook* book, QofBackendLoadType loadType) override;
-    /* The XML backend isn't able to do anything with individual instances. */
+    /* The XML backend can't store individual instances, but it notes
+     * which transactions changed so that a save can journal just those. */
+    void commit(QofInstance* inst) override;
     void export_coa(QofBook*) override;
     void sync(QofBook* book) override;
     void safe_sync(QofBook* book) override { sync(book); } // XML sync is inherently safe.
     const char * get_filename() { return m_fullpath.c_str(); }
+    std::string get_journal_filename() { return m_fullpath + ".journal"; }
     QofBook* get_book() { return m_book; }
 
 private:
@@ -55,6 +59,8 @@ private:
     void remove_old_files();
     void write_accounts(QofBook* book);
     bool check_path(const char* fullpath, bool create);
+    bool append_journal();
+    bool journal_too_big();
 
     std::string m_dirname;
     std::string m_lockfile;
@@ -62,5 +68,11 @@ private:
     int m_lockfd;
 
     QofBook* m_book;  /* The primary, main open book */
+    /* Transactions changed since the last save, by GUID string, and
+     * whether they were deleted. */
+    std::map<std::string, bool> m_journal;
+    bool m_journal_full_save = false; /* Something not journaled changed */
+    bool m_journal_base_ok = false;   /* The data file matches the book */
+    bool m_loading = false;
 };
 #endif // __GNC_XML_BACKEND_HPP__
@@ -54,6 +54,7 @@ extern "C"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "gncInvoiceP.h"
 #if PLATFORM(WINDOWS)
 #ifdef __STRICT_ANSI_UNSET__
 #undef __STRICT_ANSI_UNSET__
@@ -545,6 +546,8 @@ static const char* TRANSACTION_TAG = "gnc:transaction";
 static const char* SCHEDXACTION_TAG = "gnc:schedxaction";
 static const char* TEMPLATE_TRANSACTION_TAG = "gnc:template-transactions";
 static const char* BUDGET_TAG = "gnc:budget";
+static const char* JOURNAL_TAG = "gnc-journal";
+static const char* JOURNAL_DELETE_TAG = "gnc:journal-delete";
 
 static void
 add_item (const GncXmlDataType_t& data, struct file_backend* be_data)
@@ -691,6 +694,204 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+static void
+journal_destroy_transaction (QofBook* book, const GncGUID* guid)
+{
+    Transaction* trans = xaccTransLookup (guid, book);
+
+    if (trans)
+    {
+        xaccTransBeginEdit (trans);
+        /* xaccTransDestroy leaves read-only transactions, like those of
+         * posted invoices, alone; the journal's copy carries the flag. */
+        xaccTransClearReadOnly (trans);
+        xaccTransDestroy (trans);
+        xaccTransCommitEdit (trans);
+    }
+}
+
+/* The parser state while replaying a journal.  The end handlers only
+ * collect the trees of a record in staged; they are applied once the
+ * whole record has parsed, so that a record torn off by a crash in the
+ * middle of an append changes nothing. */
+struct journal_replay_data
+{
+    gxpf_data gpdata;   /* first, as the handlers are handed a gxpf_data* */
+    GSList* staged;     /* trees of the current record, last one first */
+};
+
+/* A journaled transaction replaces any earlier version of itself. */
+static gboolean
+journal_apply_transaction (sixtp_gdv2* gd, xmlNodePtr tree)
+{
+    GncInvoice* invoice = NULL;
+    Transaction* trn;
+    xmlNodePtr node;
+
+    for (node = tree->xmlChildrenNode; node; node = node->next)
+    {
+        if (g_strcmp0 ((char*)node->name, "trn:id") == 0)
+        {
+            GncGUID* guid = dom_tree_to_guid (node);
+            if (guid)
+            {
+                /* An invoice posted to the old version has to follow it
+                 * to the new one. */
+                Transaction* old_trn = xaccTransLookup (guid, gd->book);
+                invoice = old_trn ? gncInvoiceGetInvoiceFromTxn (old_trn) : NULL;
+                if (invoice && gncInvoiceGetPostedTxn (invoice) != old_trn)
+                    invoice = NULL;
+                journal_destroy_transaction (gd->book, guid);
+            }
+            g_free (guid);
+            break;
+        }
+    }
+
+    trn = dom_tree_to_transaction (tree, gd->book);
+    if (trn)
+        add_transaction_local (gd, trn);
+    if (invoice)
+        gncInvoiceResetPostedTxn (invoice, trn);
+
+    return trn != NULL;
+}
+
+static gboolean
+journal_apply_delete (sixtp_gdv2* gd, xmlNodePtr tree)
+{
+    GncGUID* guid = dom_tree_to_guid (tree);
+
+    g_return_val_if_fail (guid, FALSE);
+
+    journal_destroy_transaction (gd->book, guid);
+    g_free (guid);
+    return TRUE;
+}
+
+static gboolean
+journal_stage_end_handler (gpointer data_for_children,
+                           GSList* data_from_children, GSList* sibling_data,
+                           gpointer parent_data, gpointer global_data,
+                           gpointer* result, const gchar* tag)
+{
+    xmlNodePtr tree = (xmlNodePtr)data_for_children;
+    journal_replay_data* jd = (journal_replay_data*)global_data;
+
+    if (parent_data || !tag)
+        return TRUE;
+
+    g_return_val_if_fail (tree, FALSE);
+
+    jd->staged = g_slist_prepend (jd->staged, tree);
+    return TRUE;
+}
+
+/* Apply the trees staged from one complete record, in the order they
+ * were written.  Returns FALSE if one of them isn't a valid change. */
+static gboolean
+journal_apply_staged (journal_replay_data* jd)
+{
+    sixtp_gdv2* gd = (sixtp_gdv2*)jd->gpdata.parsedata;
+    gboolean success = TRUE;
+    GSList* node;
+
+    jd->staged = g_slist_reverse (jd->staged);
+    for (node = jd->staged; node; node = node->next)
+    {
+        xmlNodePtr tree = (xmlNodePtr)node->data;
+
+        if (success)
+        {
+            if (g_strcmp0 ((char*)tree->name, TRANSACTION_TAG) == 0)
+                success = journal_apply_transaction (gd, tree);
+            else
+                success = journal_apply_delete (gd, tree);
+        }
+        xmlFreeNode (tree);
+    }
+    g_slist_free (jd->staged);
+    jd->staged = NULL;
+    return success;
+}
+
+static void
+journal_drop_staged (journal_replay_data* jd)
+{
+    g_slist_free_full (jd->staged, (GDestroyNotify)xmlFreeNode);
+    jd->staged = NULL;
+}
+
+/* Apply the records of the journal next to the data file, if there is
+ * one, in the order they were written.  Each record is parsed in full
+ * before any of it is applied, and one that can't be read, as when a
+ * save was cut short, ends the replay without changing the book. */
+static void
+replay_xml_journal (sixtp_gdv2* gd, QofBook* book, const char* filename)
+{
+    sixtp* top_parser;
+    sixtp* journal_parser;
+    journal_replay_data jd;
+    gchar* contents;
+    gchar* record;
+    gsize length;
+
+    if (!g_file_test (filename, G_FILE_TEST_EXISTS))
+        return;
+    if (!g_file_get_contents (filename, &contents, &length, NULL))
+    {
+        PWARN ("Unable to read journal %s", filename);
+        return;
+    }
+
+    journal_parser = sixtp_add_some_sub_parsers (
+        sixtp_new (), TRUE,
+        TRANSACTION_TAG, sixtp_dom_parser_new (journal_stage_end_handler,
+                                               NULL, NULL),
+        JOURNAL_DELETE_TAG, sixtp_dom_parser_new (journal_stage_end_handler,
+                                                  NULL, NULL),
+        NULL, NULL);
+    top_parser = sixtp_add_some_sub_parsers (
+        sixtp_new (), TRUE,
+        JOURNAL_TAG, journal_parser,
+        NULL, NULL);
+    if (!top_parser)
+    {
+        g_free (contents);
+        return;
+    }
+
+    jd.gpdata.cb = generic_callback;
+    jd.gpdata.parsedata = gd;
+    jd.gpdata.bookdata = book;
+    jd.staged = NULL;
+
+    record = contents;
+    while (record < contents + length)
+    {
+        gchar* next = g_strstr_len (record + 1, contents + length - record - 1,
+                                    "\n<?xml");
+        gsize record_len = next ? next + 1 - record : contents + length - record;
+
+        if (!sixtp_parse_buffer (top_parser, record, record_len, NULL, &jd,
+                                 NULL))
+        {
+            journal_drop_staged (&jd);
+            PWARN ("Ignoring the unreadable end of journal %s", filename);
+            break;
+        }
+        if (!journal_apply_staged (&jd))
+        {
+            PWARN ("Ignoring the invalid end of journal %s", filename);
+            break;
+        }
+        record += record_len;
+    }
+
+    sixtp_destroy (top_parser);
+    g_free (contents);
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full (
     GncXmlBackend* xml_be, QofBook* book,
@@ -810,6 +1011,9 @@ qof_session_load_from_xml_file_v2_full (
             fclose (file);
             if (is_compressed)
                 wait_for_gzip (file);
+            if (retval)
+                replay_xml_journal (gd, book,
+                                    xml_be->get_journal_filename ().c_str ());
         }
     }
 
@@ -1190,17 +1394,165 @@ xml_add_trn_data (Transaction* t, gpointer data)
     return 0;
 }
 
+/* The number of threads a save serializes transactions and compresses
+ * with: GNC_XML_SAVE_THREADS if it is set, one per processor otherwise.
+ * With one thread all of the work is done by the thread saving. */
+static guint
+xml_save_threads (void)
+{
+    const gchar* env = g_getenv ("GNC_XML_SAVE_THREADS");
+    guint64 n_threads = env ? g_ascii_strtoull (env, NULL, 10) : 0;
+
+    if (n_threads == 0)
+        return g_get_num_processors ();
+    return MIN (n_threads, G_MAXINT);
+}
+
+/* Transactions are turned into XML by a pool of threads, a batch at a
+ * time, and the batches are written out in order by the saving thread.
+ * Each worker builds the DOM trees of its batch, dumps them into the
+ * batch's buffer and frees them.  Outside of its batch, a worker only
+ * reads:
+ *  - the transaction's fields, its split GList and its KVP frame;
+ *  - each split's fields and KVP frame, and the GUIDs of its account
+ *    and lot;
+ *  - the namespace name and mnemonic of the transaction's currency;
+ *  - the time zone table used to format dates, whose transition table
+ *    is built once under a std::call_once guard;
+ *  - the process locale and libxml2's per-thread output settings.
+ * The book doesn't change while it is saved, and the progress counter
+ * and callback are only run by the saving thread. */
+#define TRN_BATCH_SIZE 256
+
+typedef struct
+{
+    Transaction* trans[TRN_BATCH_SIZE];
+    guint n_trans;
+    xmlBufferPtr buf;
+    gboolean done;
+} trn_batch_t;
+
+typedef struct
+{
+    GMutex mutex;
+    GCond cond;
+} trn_writer_t;
+
+static void
+xml_serialize_trn_batch (gpointer data, gpointer user_data)
+{
+    trn_batch_t* batch = static_cast<decltype (batch)> (data);
+    trn_writer_t* writer = static_cast<decltype (writer)> (user_data);
+    guint i;
+
+    batch->buf = xmlBufferCreate ();
+    for (i = 0; i < batch->n_trans; i++)
+    {
+        xmlNodePtr node = gnc_transaction_dom_tree_create (batch->trans[i]);
+
+        /* Same output as xmlElemDump gives */
+        xmlNodeDump (batch->buf, NULL, node, 0, 1);
+        xmlBufferCCat (batch->buf, "\n");
+        xmlFreeNode (node);
+    }
+
+    g_mutex_lock (&writer->mutex);
+    batch->done = TRUE;
+    g_cond_broadcast (&writer->cond);
+    g_mutex_unlock (&writer->mutex);
+}
+
+static gboolean
+xml_write_trn_batch (trn_batch_t* batch, trn_writer_t* writer,
+                     struct file_backend* be_data)
+{
+    gboolean ok;
+    guint i;
+
+    g_mutex_lock (&writer->mutex);
+    while (!batch->done)
+        g_cond_wait (&writer->cond, &writer->mutex);
+    g_mutex_unlock (&writer->mutex);
+
+    ok = fwrite (xmlBufferContent (batch->buf), 1, xmlBufferLength (batch->buf),
+                 be_data->out) == (size_t) xmlBufferLength (batch->buf)
+         && !ferror (be_data->out);
+    xmlBufferFree (batch->buf);
+    if (ok)
+    {
+        for (i = 0; i < batch->n_trans; i++)
+        {
+            be_data->gd->counter.transactions_loaded++;
+            sixtp_run_callback (be_data->gd, "transaction");
+        }
+    }
+    g_free (batch);
+    return ok;
+}
+
+static int
+xml_collect_trn (Transaction* t, gpointer data)
+{
+    g_ptr_array_add (static_cast<GPtrArray*> (data), t);
+    return 0;
+}
+
 static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     struct file_backend be_data;
+    GPtrArray* trans = g_ptr_array_new ();
+    GQueue pending = G_QUEUE_INIT;
+    guint n_threads = xml_save_threads ();
+    guint max_pending = 2 * n_threads;
+    trn_writer_t writer;
+    GThreadPool* pool;
+    gboolean ok = TRUE;
+    guint i;
 
     be_data.out = out;
     be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
-                                              xml_add_trn_data,
-                                              (gpointer) &be_data);
+
+    /* The walk marks each transaction it visits, so it has to be done
+     * before any threads get involved. */
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       xml_collect_trn, trans);
+
+    xmlInitParser ();
+    g_mutex_init (&writer.mutex);
+    g_cond_init (&writer.cond);
+    pool = n_threads > 1 ?
+           g_thread_pool_new (xml_serialize_trn_batch, &writer, n_threads,
+                              FALSE, NULL) : NULL;
+
+    for (i = 0; i < trans->len; i += TRN_BATCH_SIZE)
+    {
+        trn_batch_t* batch = g_new0 (trn_batch_t, 1);
+        guint j;
+
+        batch->n_trans = MIN (TRN_BATCH_SIZE, trans->len - i);
+        for (j = 0; j < batch->n_trans; j++)
+            batch->trans[j] = static_cast<Transaction*> (trans->pdata[i + j]);
+        if (pool)
+            g_thread_pool_push (pool, batch, NULL);
+        else
+            xml_serialize_trn_batch (batch, &writer);
+        g_queue_push_tail (&pending, batch);
+
+        while (g_queue_get_length (&pending) > max_pending)
+            ok &= xml_write_trn_batch (static_cast<trn_batch_t*> (g_queue_pop_head (&pending)),
+                                       &writer, &be_data);
+    }
+    while (!g_queue_is_empty (&pending))
+        ok &= xml_write_trn_batch (static_cast<trn_batch_t*> (g_queue_pop_head (&pending)),
+                                   &writer, &be_data);
+
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+    g_cond_clear (&writer.cond);
+    g_mutex_clear (&writer.mutex);
+    g_ptr_array_free (trans, TRUE);
+    return ok;
 }
 
 static gboolean
@@ -1293,12 +1645,9 @@ write_namespace (const GncXmlDataType_t& data, FILE* out)
 }
 
 static gboolean
-write_v2_header (FILE* out)
+write_namespace_decls (FILE* out)
 {
-    if (fprintf (out, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n") < 0
-        || fprintf (out, "<" GNC_V2_STRING) < 0
-
-        || !gnc_xml2_write_namespace_decl (out, "gnc")
+    if (!gnc_xml2_write_namespace_decl (out, "gnc")
         || !gnc_xml2_write_namespace_decl (out, "act")
         || !gnc_xml2_write_namespace_decl (out, "book")
         || !gnc_xml2_write_namespace_decl (out, "cd")
@@ -1320,12 +1669,72 @@ write_v2_header (FILE* out)
     for (auto data : backend_registry)
         write_namespace(data, out);
 
-    if (ferror (out) || fprintf (out, ">\n") < 0)
+    return !ferror (out);
+}
+
+static gboolean
+write_v2_header (FILE* out)
+{
+    if (fprintf (out, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n") < 0
+        || fprintf (out, "<" GNC_V2_STRING) < 0
+        || !write_namespace_decls (out)
+        || fprintf (out, ">\n") < 0)
         return FALSE;
 
     return TRUE;
 }
 
+/* Each save in journal mode appends one record to the journal: a small
+ * XML document holding the transactions changed since the previous save,
+ * in full, and the ids of those deleted.  A record always starts on a new
+ * line with an XML declaration, which is how the reader splits them. */
+gboolean
+gnc_book_append_to_xml_journal_v2 (QofBook* book, const char* filename,
+                                   GList* changed, GList* deleted)
+{
+    gboolean success = TRUE;
+    GList* node;
+    FILE* out;
+
+    out = g_fopen (filename, "ab");
+    if (!out)
+        return FALSE;
+
+    if (fprintf (out, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n") < 0
+        || fprintf (out, "<%s", JOURNAL_TAG) < 0
+        || !write_namespace_decls (out)
+        || fprintf (out, ">\n") < 0)
+        success = FALSE;
+
+    for (node = changed; success && node; node = node->next)
+    {
+        xmlNodePtr tree =
+            gnc_transaction_dom_tree_create (static_cast<Transaction*> (node->data));
+
+        xmlElemDump (out, NULL, tree);
+        xmlFreeNode (tree);
+        if (ferror (out) || fprintf (out, "\n") < 0)
+            success = FALSE;
+    }
+    for (node = deleted; success && node; node = node->next)
+    {
+        xmlNodePtr tree =
+            guid_to_dom_tree (JOURNAL_DELETE_TAG, static_cast<GncGUID*> (node->data));
+
+        xmlElemDump (out, NULL, tree);
+        xmlFreeNode (tree);
+        if (ferror (out) || fprintf (out, "\n") < 0)
+            success = FALSE;
+    }
+
+    if (success && fprintf (out, "</%s>\n", JOURNAL_TAG) < 0)
+        success = FALSE;
+    if (fclose (out))
+        success = FALSE;
+
+    return success;
+}
+
 gboolean
 gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* out)
 {
@@ -1403,17 +1812,237 @@ gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* qof_be, QofBook* book,
 
 #define BUFLEN 4096
 
+/* Compression is done pigz-style: the data is cut into blocks that a pool
+ * of threads deflates independently, each primed with the end of the
+ * block before it.  All blocks but the last end with a sync flush, so
+ * written out in order they form a single deflate stream and the result
+ * is an ordinary .gz file. */
+#define GZ_BLOCK_SIZE (128 * 1024)
+#define GZ_DICT_SIZE (32 * 1024)
+
+typedef struct
+{
+    guchar* in;
+    gsize in_len;
+    guchar dict[GZ_DICT_SIZE];
+    gsize dict_len;
+    gboolean last;
+    guchar* out;
+    gsize out_len;
+    uLong crc;
+    gboolean ok;
+    gboolean done;
+} gz_block_t;
+
+typedef struct
+{
+    GMutex mutex;
+    GCond cond;
+} gz_writer_t;
+
+static void
+gz_deflate_block (gpointer data, gpointer user_data)
+{
+    gz_block_t* block = static_cast<decltype (block)> (data);
+    gz_writer_t* writer = static_cast<decltype (writer)> (user_data);
+    z_stream strm;
+    gboolean ok;
+
+    memset (&strm, 0, sizeof (strm));
+    ok = deflateInit2 (&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                       8, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (ok)
+    {
+        gsize bound = deflateBound (&strm, block->in_len) + 64;
+        int zval;
+
+        if (block->dict_len)
+            ok = deflateSetDictionary (&strm, block->dict, block->dict_len) == Z_OK;
+
+        block->out = static_cast<guchar*> (g_malloc (bound));
+        strm.next_in = block->in;
+        strm.avail_in = block->in_len;
+        strm.next_out = block->out;
+        strm.avail_out = bound;
+        zval = deflate (&strm, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+        if (block->last)
+            ok = ok && zval == Z_STREAM_END;
+        else
+            ok = ok && zval == Z_OK && strm.avail_in == 0;
+        block->out_len = bound - strm.avail_out;
+        deflateEnd (&strm);
+    }
+    block->crc = crc32 (crc32 (0L, Z_NULL, 0), block->in, block->in_len);
+
+    g_mutex_lock (&writer->mutex);
+    block->ok = ok;
+    block->done = TRUE;
+    g_cond_broadcast (&writer->cond);
+    g_mutex_unlock (&writer->mutex);
+}
+
+/* Wait for the block to be compressed and append it to the file. */
+static gboolean
+gz_write_block (gz_block_t* block, gz_writer_t* writer, FILE* file,
+                uLong* crc, gsize* total)
+{
+    gboolean ok;
+
+    g_mutex_lock (&writer->mutex);
+    while (!block->done)
+        g_cond_wait (&writer->cond, &writer->mutex);
+    g_mutex_unlock (&writer->mutex);
+
+    ok = block->ok &&
+         fwrite (block->out, 1, block->out_len, file) == block->out_len;
+    *crc = crc32_combine (*crc, block->crc, block->in_len);
+    *total += block->in_len;
+
+    g_free (block->in);
+    g_free (block->out);
+    g_free (block);
+    return ok;
+}
+
+static gint
+gz_write_parallel (gz_thread_params_t* params)
+{
+    /* magic, deflate, no flags, no mtime, no extra flags, Unix */
+    static const guchar header[10] = { 037, 0213, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 };
+    guchar dict[GZ_DICT_SIZE];
+    gsize dict_len = 0;
+    GQueue pending = G_QUEUE_INIT;
+    guint n_threads = xml_save_threads ();
+    guint max_pending = 2 * n_threads;
+    uLong crc = crc32 (0L, Z_NULL, 0);
+    gsize total = 0;
+    gboolean eof = FALSE;
+    gint success = 1;
+    gz_writer_t writer;
+    GThreadPool* pool;
+    FILE* file;
+
+    file = g_fopen (params->filename, "wb");
+    if (file == NULL)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                   params->filename, g_strerror (errno) ? g_strerror (errno) : "", errno);
+        return 0;
+    }
+    if (fwrite (header, 1, sizeof (header), file) != sizeof (header))
+        success = 0;
+
+    g_mutex_init (&writer.mutex);
+    g_cond_init (&writer.cond);
+    pool = n_threads > 1 ?
+           g_thread_pool_new (gz_deflate_block, &writer, n_threads,
+                              FALSE, NULL) : NULL;
+
+    while (!eof)
+    {
+        gz_block_t* block = g_new0 (gz_block_t, 1);
+        gsize keep;
+
+        block->in = static_cast<guchar*> (g_malloc (GZ_BLOCK_SIZE));
+        while (block->in_len < GZ_BLOCK_SIZE)
+        {
+            gssize bytes = read (params->fd, block->in + block->in_len,
+                                 GZ_BLOCK_SIZE - block->in_len);
+            if (bytes > 0)
+            {
+                block->in_len += bytes;
+            }
+            else if (bytes == 0)
+            {
+                eof = TRUE;
+                break;
+            }
+            else
+            {
+                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
+                success = 0;
+                eof = TRUE;
+                break;
+            }
+        }
+        block->last = eof;
+
+        /* The last 32k of input seen so far primes the next block */
+        memcpy (block->dict, dict, dict_len);
+        block->dict_len = dict_len;
+        if (block->in_len >= GZ_DICT_SIZE)
+        {
+            memcpy (dict, block->in + block->in_len - GZ_DICT_SIZE, GZ_DICT_SIZE);
+            dict_len = GZ_DICT_SIZE;
+        }
+        else
+        {
+            keep = MIN (dict_len, GZ_DICT_SIZE - block->in_len);
+            memmove (dict, dict + dict_len - keep, keep);
+            memcpy (dict + keep, block->in, block->in_len);
+            dict_len = keep + block->in_len;
+        }
+
+        if (pool)
+            g_thread_pool_push (pool, block, NULL);
+        else
+            gz_deflate_block (block, &writer);
+        g_queue_push_tail (&pending, block);
+
+        while (g_queue_get_length (&pending) > max_pending)
+            if (!gz_write_block (static_cast<gz_block_t*> (g_queue_pop_head (&pending)),
+                                 &writer, file, &crc, &total))
+                success = 0;
+    }
+    while (!g_queue_is_empty (&pending))
+        if (!gz_write_block (static_cast<gz_block_t*> (g_queue_pop_head (&pending)),
+                             &writer, file, &crc, &total))
+            success = 0;
+
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+    g_cond_clear (&writer.cond);
+    g_mutex_clear (&writer.mutex);
+
+    {
+        guchar trailer[8];
+        guint32 size = (guint32) total;
+        int i;
+
+        for (i = 0; i < 4; i++)
+        {
+            trailer[i] = (crc >> (8 * i)) & 0xff;
+            trailer[i + 4] = (size >> (8 * i)) & 0xff;
+        }
+        if (fwrite (trailer, 1, sizeof (trailer), file) != sizeof (trailer))
+            success = 0;
+    }
+
+    if (fclose (file) != 0)
+        success = 0;
+    if (!success)
+        g_warning ("Could not write the compressed file '%s'", params->filename);
+
+    return success;
+}
+
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
 gz_thread_func (gz_thread_params_t* params)
 {
     gchar buffer[BUFLEN];
-    gssize bytes;
     gint gzval;
     gzFile file;
     gint success = 1;
 
+    if (params->compress)
+    {
+        success = gz_write_parallel (params);
+        goto cleanup_gz_thread_func;
+    }
+
 #ifdef G_OS_WIN32
     {
         gchar* conv_name = g_win32_locale_filename_from_utf8 (params->filename);
@@ -1447,67 +2076,36 @@ gz_thread_func (gz_thread_params_t* params)
         goto cleanup_gz_thread_func;
     }
 
-    if (params->compress)
-    {
-        while (success)
-        {
-            bytes = read (params->fd, buffer, BUFLEN);
-            if (bytes > 0)
-            {
-                if (gzwrite (file, buffer, bytes) <= 0)
-                {
-                    gint errnum;
-                    const gchar* error = gzerror (file, &errnum);
-                    g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
-                               params->filename, error, errnum);
-                    success = 0;
-                }
-            }
-            else if (bytes == 0)
-            {
-                break;
-            }
-            else
-            {
-                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
-                           g_strerror (errno) ? g_strerror (errno) : "", errno);
-                success = 0;
-            }
-        }
-    }
-    else
+    while (success)
     {
-        while (success)
+        gzval = gzread (file, buffer, BUFLEN);
+        if (gzval > 0)
         {
-            gzval = gzread (file, buffer, BUFLEN);
-            if (gzval > 0)
-            {
-                if (
+            if (
 #if COMPILER(MSVC)
-                    _write
+                _write
 #else
-                    write
+                write
 #endif
-                    (params->fd, buffer, gzval) < 0)
-                {
-                    g_warning ("Could not write to pipe. The error is '%s' (%d)",
-                               g_strerror (errno) ? g_strerror (errno) : "", errno);
-                    success = 0;
-                }
-            }
-            else if (gzval == 0)
-            {
-                break;
-            }
-            else
+                (params->fd, buffer, gzval) < 0)
             {
-                gint errnum;
-                const gchar* error = gzerror (file, &errnum);
-                g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
-                           params->filename, error, errnum);
+                g_warning ("Could not write to pipe. The error is '%s' (%d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
                 success = 0;
             }
         }
+        else if (gzval == 0)
+        {
+            break;
+        }
+        else
+        {
+            gint errnum;
+            const gchar* error = gzerror (file, &errnum);
+            g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
+                       params->filename, error, errnum);
+            success = 0;
+        }
     }
 
     if ((gzval = gzclose (file)) != Z_OK)
@@ -93,6 +93,11 @@ gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
                                         gboolean compress);
 
+/** append the given changed transactions and the GUIDs of deleted ones
+ * to a journal file */
+gboolean gnc_book_append_to_xml_journal_v2 (QofBook* book, const char* filename,
+                                            GList* changed, GList* deleted);
+
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
                                                        QofBook* book, FILE* fh);
@@ -450,8 +450,16 @@ sixtp_sax_start_handler (void* user_data,
     /* now allocate the new stack frame and shift to it */
     new_frame = sixtp_stack_frame_new (next_parser, g_strdup ((char*) name));
 
-    new_frame->line = xmlSAX2GetLineNumber (pdata->saxParserCtxt);
-    new_frame->col  = xmlSAX2GetColumnNumber (pdata->saxParserCtxt);
+    if (pdata->saxParserCtxt)
+    {
+        new_frame->line = xmlSAX2GetLineNumber (pdata->saxParserCtxt);
+        new_frame->col  = xmlSAX2GetColumnNumber (pdata->saxParserCtxt);
+    }
+    else
+    {
+        new_frame->line = pdata->line;
+        new_frame->col  = pdata->col;
+    }
 
     pdata->stack = g_slist_prepend (pdata->stack, (gpointer) new_frame);
 
@@ -693,6 +701,30 @@ gnc_bad_xml_end_handler (gpointer data_for_children,
     return TRUE;
 }
 
+static gboolean
+sixtp_parse_finish (sixtp_parser_context* ctxt, gboolean parse_ok,
+                    gpointer* parse_result)
+{
+    sixtp_context_run_end_handler (ctxt);
+
+    if (parse_ok && ctxt->data.parsing_ok)
+    {
+        if (parse_result)
+            *parse_result = ctxt->top_frame->frame_data;
+        sixtp_context_destroy (ctxt);
+        return TRUE;
+    }
+    else
+    {
+        if (parse_result)
+            *parse_result = NULL;
+        if (g_slist_length (ctxt->data.stack) > 1)
+            sixtp_handle_catastrophe (&ctxt->data);
+        sixtp_context_destroy (ctxt);
+        return FALSE;
+    }
+}
+
 static gboolean
 sixtp_parse_file_common (sixtp* sixtp,
                          xmlParserCtxtPtr xml_context,
@@ -717,24 +749,7 @@ sixtp_parse_file_common (sixtp* sixtp,
     parse_ret = xmlParseDocument (ctxt->data.saxParserCtxt);
     //xmlSAXUserParseFile(&ctxt->handler, &ctxt->data, filename);
 
-    sixtp_context_run_end_handler (ctxt);
-
-    if (parse_ret == 0 && ctxt->data.parsing_ok)
-    {
-        if (parse_result)
-            *parse_result = ctxt->top_frame->frame_data;
-        sixtp_context_destroy (ctxt);
-        return TRUE;
-    }
-    else
-    {
-        if (parse_result)
-            *parse_result = NULL;
-        if (g_slist_length (ctxt->data.stack) > 1)
-            sixtp_handle_catastrophe (&ctxt->data);
-        sixtp_context_destroy (ctxt);
-        return FALSE;
-    }
+    return sixtp_parse_finish (ctxt, parse_ret == 0, parse_result);
 }
 
 gboolean
@@ -778,6 +793,199 @@ sixtp_parser_read (void* context, char* buffer, int len)
     return ret;
 }
 
+/* Reading a file is pipelined: libxml tokenizes it on a thread of its
+ * own and hands the SAX events over in blocks, while the sixtp handlers,
+ * and with them everything that creates objects in the book, run on the
+ * calling thread in document order. */
+#define SIXTP_EVENT_BLOCK_SIZE 4096
+#define SIXTP_EVENT_BLOCKS 4
+
+typedef enum
+{
+    SIXTP_EVENT_START,
+    SIXTP_EVENT_CHARS,
+    SIXTP_EVENT_END,
+} sixtp_event_type;
+
+typedef struct
+{
+    sixtp_event_type type;
+    gchar* text;    /* the tag name, or the characters */
+    int len;        /* length of the characters */
+    guint attrs;    /* index of the NULL terminated attributes, or G_MAXUINT */
+    int line;
+    int col;
+} sixtp_event;
+
+typedef struct
+{
+    GArray* events;
+    GStringChunk* strings;
+    GPtrArray* attrs;
+    gboolean last;      /* the tokenizer is done */
+    gboolean parse_ok;  /* set in the last block */
+} sixtp_event_block;
+
+typedef struct
+{
+    FILE* fd;
+    xmlParserCtxtPtr xml_context;
+    sixtp_event_block* block;
+    GAsyncQueue* full;  /* blocks waiting to be replayed */
+    GAsyncQueue* empty; /* blocks the tokenizer may fill */
+} sixtp_tokenizer;
+
+static sixtp_event_block*
+sixtp_event_block_new (void)
+{
+    sixtp_event_block* block = g_new0 (sixtp_event_block, 1);
+
+    block->events = g_array_sized_new (FALSE, FALSE, sizeof (sixtp_event),
+                                       SIXTP_EVENT_BLOCK_SIZE);
+    block->strings = g_string_chunk_new (64 * 1024);
+    block->attrs = g_ptr_array_new ();
+    return block;
+}
+
+static void
+sixtp_event_block_free (sixtp_event_block* block)
+{
+    g_array_free (block->events, TRUE);
+    g_string_chunk_free (block->strings);
+    g_ptr_array_free (block->attrs, TRUE);
+    g_free (block);
+}
+
+static sixtp_event*
+sixtp_tokenizer_add_event (sixtp_tokenizer* tok, sixtp_event_type type)
+{
+    sixtp_event event;
+    GArray* events;
+
+    if (tok->block->events->len == SIXTP_EVENT_BLOCK_SIZE)
+    {
+        g_async_queue_push (tok->full, tok->block);
+        tok->block = static_cast<sixtp_event_block*> (g_async_queue_pop (tok->empty));
+    }
+
+    event.type = type;
+    event.text = NULL;
+    event.len = 0;
+    event.attrs = G_MAXUINT;
+    event.line = xmlSAX2GetLineNumber (tok->xml_context);
+    event.col = xmlSAX2GetColumnNumber (tok->xml_context);
+
+    events = tok->block->events;
+    g_array_append_val (events, event);
+    return &g_array_index (events, sixtp_event, events->len - 1);
+}
+
+static void
+sixtp_tokenizer_start_handler (void* user_data, const xmlChar* name,
+                               const xmlChar** attrs)
+{
+    sixtp_tokenizer* tok = (sixtp_tokenizer*) user_data;
+    sixtp_event* event = sixtp_tokenizer_add_event (tok, SIXTP_EVENT_START);
+    sixtp_event_block* block = tok->block;
+
+    event->text = g_string_chunk_insert_const (block->strings, (gchar*) name);
+    if (attrs)
+    {
+        event->attrs = block->attrs->len;
+        for (; *attrs; attrs++)
+            g_ptr_array_add (block->attrs,
+                             g_string_chunk_insert_const (block->strings,
+                                                          (gchar*) *attrs));
+        g_ptr_array_add (block->attrs, NULL);
+    }
+}
+
+static void
+sixtp_tokenizer_characters_handler (void* user_data, const xmlChar* text,
+                                    int len)
+{
+    sixtp_tokenizer* tok = (sixtp_tokenizer*) user_data;
+    sixtp_event* event = sixtp_tokenizer_add_event (tok, SIXTP_EVENT_CHARS);
+
+    event->text = g_string_chunk_insert_len (tok->block->strings,
+                                             (gchar*) text, len);
+    event->len = len;
+}
+
+static void
+sixtp_tokenizer_end_handler (void* user_data, const xmlChar* name)
+{
+    sixtp_tokenizer* tok = (sixtp_tokenizer*) user_data;
+    sixtp_event* event = sixtp_tokenizer_add_event (tok, SIXTP_EVENT_END);
+
+    event->text = g_string_chunk_insert_const (tok->block->strings,
+                                               (gchar*) name);
+}
+
+static gpointer
+sixtp_tokenizer_thread (gpointer data)
+{
+    sixtp_tokenizer* tok = (sixtp_tokenizer*) data;
+    xmlSAXHandler handler;
+    gboolean parse_ok = FALSE;
+
+    memset (&handler, 0, sizeof (handler));
+    handler.startElement = sixtp_tokenizer_start_handler;
+    handler.endElement = sixtp_tokenizer_end_handler;
+    handler.characters = sixtp_tokenizer_characters_handler;
+    handler.getEntity = sixtp_sax_get_entity_handler;
+
+    tok->block = static_cast<sixtp_event_block*> (g_async_queue_pop (tok->empty));
+    tok->xml_context = xmlCreateIOParserCtxt (NULL, NULL, sixtp_parser_read,
+                                              NULL /*no close */, tok->fd,
+                                              XML_CHAR_ENCODING_NONE);
+    if (tok->xml_context)
+    {
+        tok->xml_context->sax = &handler;
+        tok->xml_context->userData = tok;
+        parse_ok = (xmlParseDocument (tok->xml_context) == 0);
+        tok->xml_context->userData = NULL;
+        tok->xml_context->sax = NULL;
+        xmlFreeParserCtxt (tok->xml_context);
+        tok->xml_context = NULL;
+    }
+
+    tok->block->last = TRUE;
+    tok->block->parse_ok = parse_ok;
+    g_async_queue_push (tok->full, tok->block);
+    return NULL;
+}
+
+static void
+sixtp_replay_events (sixtp_sax_data* pdata, sixtp_event_block* block)
+{
+    guint i;
+
+    for (i = 0; i < block->events->len; i++)
+    {
+        sixtp_event* event = &g_array_index (block->events, sixtp_event, i);
+
+        pdata->line = event->line;
+        pdata->col = event->col;
+        switch (event->type)
+        {
+        case SIXTP_EVENT_START:
+            sixtp_sax_start_handler (pdata, (xmlChar*) event->text,
+                                     event->attrs == G_MAXUINT ? NULL :
+                                     (const xmlChar**) &g_ptr_array_index (block->attrs,
+                                             event->attrs));
+            break;
+        case SIXTP_EVENT_CHARS:
+            sixtp_sax_characters_handler (pdata, (xmlChar*) event->text,
+                                          event->len);
+            break;
+        case SIXTP_EVENT_END:
+            sixtp_sax_end_handler (pdata, (xmlChar*) event->text);
+            break;
+        }
+    }
+}
+
 gboolean
 sixtp_parse_fd (sixtp* sixtp,
                 FILE* fd,
@@ -785,13 +993,55 @@ sixtp_parse_fd (sixtp* sixtp,
                 gpointer global_data,
                 gpointer* parse_result)
 {
-    gboolean ret;
-    xmlParserCtxtPtr context = xmlCreateIOParserCtxt (NULL, NULL,
-                                                      sixtp_parser_read, NULL /*no close */, fd,
-                                                      XML_CHAR_ENCODING_NONE);
-    ret = sixtp_parse_file_common (sixtp, context, data_for_top_level,
-                                   global_data, parse_result);
-    return ret;
+    sixtp_parser_context* ctxt;
+    sixtp_tokenizer tok;
+    sixtp_event_block* block;
+    GThread* thread;
+    gboolean parse_ok;
+    int i;
+
+    if (! (ctxt = sixtp_context_new (sixtp, global_data, data_for_top_level)))
+    {
+        g_critical ("sixtp_context_new returned null");
+        return FALSE;
+    }
+    ctxt->data.bad_xml_parser = sixtp_dom_parser_new (gnc_bad_xml_end_handler,
+                                                      NULL, NULL);
+
+    /* libxml must be initialized before it is used from two threads */
+    xmlInitParser ();
+
+    tok.fd = fd;
+    tok.xml_context = NULL;
+    tok.block = NULL;
+    tok.full = g_async_queue_new ();
+    tok.empty = g_async_queue_new ();
+    for (i = 0; i < SIXTP_EVENT_BLOCKS; i++)
+        g_async_queue_push (tok.empty, sixtp_event_block_new ());
+
+    thread = g_thread_new ("xml_tokenizer", sixtp_tokenizer_thread, &tok);
+    while (TRUE)
+    {
+        block = static_cast<sixtp_event_block*> (g_async_queue_pop (tok.full));
+        sixtp_replay_events (&ctxt->data, block);
+        if (block->last)
+            break;
+
+        g_array_set_size (block->events, 0);
+        g_ptr_array_set_size (block->attrs, 0);
+        g_string_chunk_clear (block->strings);
+        g_async_queue_push (tok.empty, block);
+    }
+    g_thread_join (thread);
+
+    parse_ok = block->parse_ok;
+    sixtp_event_block_free (block);
+    while ((block = static_cast<sixtp_event_block*> (g_async_queue_try_pop (tok.empty))))
+        sixtp_event_block_free (block);
+    g_async_queue_unref (tok.full);
+    g_async_queue_unref (tok.empty);
+
+    return sixtp_parse_finish (ctxt, parse_ok, parse_result);
 }
 
 gboolean
@@ -840,24 +1090,7 @@ sixtp_parse_push (sixtp* sixtp,
 
     (*push_handler) (xml_context, push_user_data);
 
-    sixtp_context_run_end_handler (ctxt);
-
-    if (ctxt->data.parsing_ok)
-    {
-        if (parse_result)
-            *parse_result = ctxt->top_frame->frame_data;
-        sixtp_context_destroy (ctxt);
-        return TRUE;
-    }
-    else
-    {
-        if (parse_result)
-            *parse_result = NULL;
-        if (g_slist_length (ctxt->data.stack) > 1)
-            sixtp_handle_catastrophe (&ctxt->data);
-        sixtp_context_destroy (ctxt);
-        return FALSE;
-    }
+    return sixtp_parse_finish (ctxt, TRUE, parse_result);
 }
 
 /***********************************************************************/
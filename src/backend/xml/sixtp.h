@@ -195,8 +195,10 @@ typedef struct sixtp_sax_data
     gboolean parsing_ok;
     GSList* stack;
     gpointer global_data;
-    xmlParserCtxtPtr saxParserCtxt;
+    xmlParserCtxtPtr saxParserCtxt; /* NULL when replaying tokenized events */
     sixtp* bad_xml_parser;
+    int line;                       /* position of the replayed event */
+    int col;
 } sixtp_sax_data;
 
 gboolean is_child_result_from_node_named (sixtp_child_result* cr,
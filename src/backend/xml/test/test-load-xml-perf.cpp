@@ -0,0 +1,181 @@
+/********************************************************************
+ * test-load-xml-perf.cpp: Time saving and loading a large          *
+ * synthetic book with the XML backend.                             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+/* Not run as part of make check: this is a benchmark.  It builds a
+ * book of random accounts and transactions, saves it to a temporary
+ * XML file and then times loading that file into a fresh session.
+ *
+ * Usage: test-load-xml-perf [number-of-transactions]
+ * The default is half a million transactions.
+ */
+extern "C"
+{
+#include "config.h"
+#include <stdlib.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "TransLog.h"
+#include "Transaction.h"
+#include "gnc-engine.h"
+#include "test-engine-stuff.h"
+#include "test-stuff.h"
+}
+
+#include <vector>
+
+#define GNC_LIB_NAME "gncmod-backend-xml"
+
+static const guint num_accounts = 100;
+static const gint64 twenty_years = 20 * 365 * 24 * 3600LL;
+
+static double
+seconds_since (gint64 start)
+{
+    return (g_get_monotonic_time () - start) / 1000000.0;
+}
+
+static void
+make_book (QofBook* book, guint num_trans)
+{
+    auto currency = get_random_commodity (book);
+    std::vector<Account*> accounts;
+    auto root = gnc_book_get_root_account (book);
+    time64 now = gnc_time (NULL);
+
+    for (guint i = 0; i < num_accounts; i++)
+    {
+        auto acc = xaccMallocAccount (book);
+        auto name = g_strdup_printf ("Account %u", i);
+
+        xaccAccountBeginEdit (acc);
+        xaccAccountSetName (acc, name);
+        xaccAccountSetType (acc, ACCT_TYPE_BANK);
+        xaccAccountSetCommodity (acc, currency);
+        gnc_account_append_child (root, acc);
+        accounts.push_back (acc);
+        g_free (name);
+    }
+
+    for (guint i = 0; i < num_trans; i++)
+    {
+        auto trans = xaccMallocTransaction (book);
+        auto amount = gnc_numeric_create (g_random_int_range (1, 1000000), 100);
+        auto desc = g_strdup_printf ("Transaction %u", i);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, currency);
+        xaccTransSetDescription (trans, desc);
+        xaccTransSetDatePostedSecs (trans, now - g_random_int_range (0, G_MAXINT32)
+                                    % twenty_years);
+        for (int j = 0; j < 2; j++)
+        {
+            auto split = xaccMallocSplit (book);
+            xaccSplitSetParent (split, trans);
+            xaccSplitSetAccount (split, accounts[g_random_int_range (0, num_accounts)]);
+            xaccSplitSetAmount (split, amount);
+            xaccSplitSetValue (split, amount);
+            amount = gnc_numeric_neg (amount);
+        }
+        xaccTransCommitEdit (trans);
+        g_free (desc);
+    }
+    for (auto acc : accounts)
+        xaccAccountCommitEdit (acc);
+}
+
+static void
+run_test (guint num_trans)
+{
+    auto dir = g_dir_make_tmp ("test-load-xml-perf-XXXXXX", NULL);
+    auto filename = g_build_filename (dir, "book.gnucash", (gchar*)NULL);
+    auto url = g_strdup_printf ("xml://%s", filename);
+    QofSession* session;
+    gint64 start;
+
+    session = qof_session_new ();
+    qof_session_begin (session, url, TRUE, TRUE, TRUE);
+    make_book (qof_session_get_book (session), num_trans);
+    start = g_get_monotonic_time ();
+    qof_session_save (session, NULL);
+    printf ("Saved %u transactions in %.2f s\n", num_trans,
+            seconds_since (start));
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+             "session save");
+    qof_session_end (session);
+    qof_session_destroy (session);
+
+    session = qof_session_new ();
+    qof_session_begin (session, url, TRUE, FALSE, FALSE);
+    start = g_get_monotonic_time ();
+    qof_session_load (session, NULL);
+    printf ("Loaded %u transactions in %.2f s\n", num_trans,
+            seconds_since (start));
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+             "session load");
+    do_test (qof_collection_count (qof_book_get_collection (qof_session_get_book (session),
+                                                            GNC_ID_TRANS)) == num_trans,
+             "all transactions loaded");
+    qof_session_end (session);
+    qof_session_destroy (session);
+
+    /* Remove the book and anything the backend left next to it */
+    {
+        auto tmpdir = g_dir_open (dir, 0, NULL);
+        const gchar* entry;
+
+        while (tmpdir && (entry = g_dir_read_name (tmpdir)) != NULL)
+        {
+            auto path = g_build_filename (dir, entry, (gchar*)NULL);
+            g_unlink (path);
+            g_free (path);
+        }
+        if (tmpdir)
+            g_dir_close (tmpdir);
+        g_rmdir (dir);
+    }
+    g_free (url);
+    g_free (filename);
+    g_free (dir);
+}
+
+int
+main (int argc, char** argv)
+{
+    guint num_trans = 500000;
+
+    if (argc > 1)
+        num_trans = strtoul (argv[1], NULL, 10);
+
+    qof_init ();
+    if (cashobjects_register () &&
+        qof_load_backend_library ("../.libs/", GNC_LIB_NAME))
+    {
+        xaccLogDisable ();
+        run_test (num_trans);
+        print_test_results ();
+    }
+    qof_close ();
+    return get_rv ();
+}
@@ -41,9 +41,12 @@ extern "C"
 #include <glib/gstdio.h>
 
 #include <cashobjects.h>
+#include <Account.h>
+#include <Transaction.h>
 #include <TransLog.h>
 #include <gnc-engine.h>
 #include <gnc-prefs.h>
+#include <SX-book.h>
 
 #include <test-stuff.h>
 #include <unittest-support.h>
@@ -117,6 +120,367 @@ test_load_file (const char* filename)
     qof_session_end (session);
 }
 
+static void
+compare_reloaded_trans (QofInstance* inst, gpointer data)
+{
+    Transaction* t_1 = GNC_TRANSACTION (inst);
+    Transaction* t_2 = xaccTransLookup (qof_instance_get_guid (inst),
+                                        static_cast<QofBook*> (data));
+
+    do_test (xaccTransEqual (t_1, t_2, TRUE, TRUE, TRUE, FALSE),
+             "reloaded transaction matches the saved one");
+}
+
+/* Transactions are saved in batches of 256 by a pool of threads, and
+ * compressed saves are deflated block by block in parallel; save a book
+ * big enough for several of each, load it back and check that nothing
+ * was lost or reordered. */
+static void
+test_save_reload_book (gboolean compressed)
+{
+    QofSession* session_1;
+    QofSession* session_2;
+    Account* root_1;
+    Account* root_2;
+    gchar* filename;
+    gchar* url;
+    gint fd;
+
+    fd = g_file_open_tmp ("test-load-xml2-XXXXXX", &filename, NULL);
+    do_test (fd != -1, "open temporary file");
+    if (fd == -1)
+        return;
+    close (fd);
+    g_unlink (filename);
+    url = g_strdup_printf ("xml://%s", filename);
+
+    random_timespec_zero_nsec (TRUE);
+    session_1 = get_random_session ();
+    add_random_transactions_to_book (qof_session_get_book (session_1), 1000);
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    qof_session_swap_data (session_1, session_2);
+    gnc_prefs_set_file_save_compressed (compressed);
+    qof_session_save (session_2, NULL);
+    do_test_args (qof_session_get_error (session_2) == ERR_BACKEND_NO_ERR,
+                  "session save xml2", __FILE__, __LINE__,
+                  "qof error=%d compressed=%d",
+                  qof_session_get_error (session_2), compressed);
+    qof_session_destroy (session_1);
+
+    session_1 = qof_session_new ();
+    qof_session_begin (session_1, url, TRUE, FALSE, FALSE);
+    qof_session_load (session_1, NULL);
+    do_test_args (qof_session_get_error (session_1) == ERR_BACKEND_NO_ERR,
+                  "session reload xml2", __FILE__, __LINE__,
+                  "qof error=%d compressed=%d",
+                  qof_session_get_error (session_1), compressed);
+
+    root_1 = gnc_book_get_root_account (qof_session_get_book (session_2));
+    root_2 = gnc_book_get_root_account (qof_session_get_book (session_1));
+    do_test (xaccAccountEqual (root_1, root_2, TRUE),
+             "reloaded account tree matches the saved one");
+
+    qof_collection_foreach (qof_book_get_collection
+                            (qof_session_get_book (session_2), GNC_ID_TRANS),
+                            compare_reloaded_trans,
+                            qof_session_get_book (session_1));
+
+    qof_session_end (session_1);
+    qof_session_destroy (session_1);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    gnc_prefs_set_file_save_compressed (FALSE);
+    g_unlink (filename);
+    g_free (filename);
+    g_free (url);
+}
+
+static void
+collect_trans (QofInstance* inst, gpointer data)
+{
+    GList** list = static_cast<GList**> (data);
+
+    *list = g_list_prepend (*list, inst);
+}
+
+static void
+remove_test_dir (const gchar* dirname)
+{
+    GDir* dir = g_dir_open (dirname, 0, NULL);
+    const gchar* entry;
+
+    if (!dir)
+        return;
+    while ((entry = g_dir_read_name (dir)) != NULL)
+    {
+        gchar* path = g_build_filename (dirname, entry, (gchar*)NULL);
+        g_unlink (path);
+        g_free (path);
+    }
+    g_dir_close (dir);
+    g_rmdir (dirname);
+}
+
+static gchar*
+save_with_threads (QofSession* session, const gchar* filename,
+                   const gchar* n_threads, gsize* length)
+{
+    gchar* contents = NULL;
+
+    g_setenv ("GNC_XML_SAVE_THREADS", n_threads, TRUE);
+    qof_session_save (session, NULL);
+    do_test_args (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+                  "session save xml2", __FILE__, __LINE__,
+                  "qof error=%d threads=%s",
+                  qof_session_get_error (session), n_threads);
+    g_unsetenv ("GNC_XML_SAVE_THREADS");
+
+    if (!g_file_get_contents (filename, &contents, length, NULL))
+        failure ("read saved file");
+    /* Otherwise the next save backs it up, under a name made of the
+     * time in seconds it may well share with this one. */
+    g_unlink (filename);
+    return contents;
+}
+
+/* Whatever the number of threads, a save has to write the same bytes
+ * as one done by the saving thread alone. */
+static void
+test_save_threads (gboolean compressed)
+{
+    QofSession* session_1;
+    QofSession* session_2;
+    gchar* dirname;
+    gchar* filename;
+    gchar* url;
+    gchar* serial;
+    gchar* parallel;
+    gsize serial_len = 0;
+    gsize parallel_len = 0;
+
+    dirname = g_dir_make_tmp ("test-load-xml2-XXXXXX", NULL);
+    do_test (dirname != NULL, "make temporary directory");
+    if (!dirname)
+        return;
+    filename = g_build_filename (dirname, "threads.gnucash", (gchar*)NULL);
+    url = g_strdup_printf ("xml://%s", filename);
+
+    random_timespec_zero_nsec (TRUE);
+    session_1 = get_random_session ();
+    add_random_transactions_to_book (qof_session_get_book (session_1), 1000);
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    qof_session_swap_data (session_1, session_2);
+    qof_session_destroy (session_1);
+    gnc_prefs_set_file_save_compressed (compressed);
+
+    serial = save_with_threads (session_2, filename, "1", &serial_len);
+    parallel = save_with_threads (session_2, filename, "4", &parallel_len);
+    do_test_args (serial && parallel && serial_len == parallel_len
+                  && memcmp (serial, parallel, serial_len) == 0,
+                  "threaded save matches serial save", __FILE__, __LINE__,
+                  "compressed=%d serial=%" G_GSIZE_FORMAT
+                  " parallel=%" G_GSIZE_FORMAT,
+                  compressed, serial_len, parallel_len);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    gnc_prefs_set_file_save_compressed (FALSE);
+    g_free (serial);
+    g_free (parallel);
+    remove_test_dir (dirname);
+    g_free (url);
+    g_free (filename);
+    g_free (dirname);
+}
+
+/* Save a book in journal mode, making each kind of change the journal
+ * has to cope with, then load the file without ending the session, as
+ * after a crash, and check that replaying the journal brought back
+ * every change and nothing twice. */
+static void
+test_journal_replay (void)
+{
+    QofSession* session_1;
+    QofSession* session_2;
+    QofSession* session_3;
+    QofBook* book;
+    QofBook* book_2;
+    QofBook* book_3;
+    Account* templ;
+    Split* split;
+    Transaction* t_templ;
+    Transaction* t_changed;
+    Transaction* t_deleted;
+    Transaction* t_readonly;
+    Transaction* t_torn;
+    GncGUID changed_guid;
+    GncGUID deleted_guid;
+    GncGUID readonly_guid;
+    GncGUID torn_guid;
+    GStatBuf journal_stat;
+    GList* trans = NULL;
+    gchar* dirname;
+    gchar* filename;
+    gchar* journal;
+    gchar* url;
+
+    dirname = g_dir_make_tmp ("test-load-xml2-XXXXXX", NULL);
+    do_test (dirname != NULL, "make temporary directory");
+    if (!dirname)
+        return;
+    filename = g_build_filename (dirname, "journal.gnucash", (gchar*)NULL);
+    journal = g_strdup_printf ("%s.journal", filename);
+    url = g_strdup_printf ("xml://%s", filename);
+
+    random_timespec_zero_nsec (TRUE);
+    session_1 = get_random_session ();
+    book = qof_session_get_book (session_1);
+    add_random_transactions_to_book (book, 50);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            collect_trans, &trans);
+    if (!do_test (g_list_length (trans) >= 4, "random transactions"))
+    {
+        g_list_free (trans);
+        qof_session_destroy (session_1);
+        g_free (url);
+        g_free (journal);
+        g_free (filename);
+        g_rmdir (dirname);
+        g_free (dirname);
+        return;
+    }
+    t_changed = GNC_TRANSACTION (trans->data);
+    t_deleted = GNC_TRANSACTION (trans->next->data);
+    t_readonly = GNC_TRANSACTION (trans->next->next->data);
+    t_torn = GNC_TRANSACTION (trans->next->next->next->data);
+    g_list_free (trans);
+
+    templ = xaccMallocAccount (book);
+    xaccAccountBeginEdit (templ);
+    xaccAccountSetName (templ, "journal template");
+    xaccAccountSetType (templ, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (templ, xaccTransGetCurrency (t_changed));
+    gnc_account_append_child (gnc_book_get_template_root (book), templ);
+    xaccAccountCommitEdit (templ);
+
+    t_templ = xaccMallocTransaction (book);
+    xaccTransBeginEdit (t_templ);
+    xaccTransSetCurrency (t_templ, xaccTransGetCurrency (t_changed));
+    xaccTransSetDescription (t_templ, "template");
+    split = xaccMallocSplit (book);
+    xaccSplitSetAccount (split, templ);
+    xaccSplitSetParent (split, t_templ);
+    xaccTransCommitEdit (t_templ);
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    qof_session_swap_data (session_1, session_2);
+    qof_session_destroy (session_1);
+    gnc_prefs_set_file_save_journal (TRUE);
+    qof_session_save (session_2, NULL);
+    do_test (!g_file_test (journal, G_FILE_TEST_EXISTS),
+             "first save writes the whole book");
+
+    /* Template transactions aren't journaled. */
+    xaccTransBeginEdit (t_templ);
+    xaccTransSetDescription (t_templ, "changed template");
+    xaccTransCommitEdit (t_templ);
+    qof_session_save (session_2, NULL);
+    do_test (!g_file_test (journal, G_FILE_TEST_EXISTS),
+             "template change writes the whole book");
+    do_test (!qof_book_session_not_saved (book),
+             "template change is saved");
+
+    xaccTransBeginEdit (t_changed);
+    xaccTransSetDescription (t_changed, "changed in the journal");
+    xaccTransCommitEdit (t_changed);
+    deleted_guid = *qof_instance_get_guid (t_deleted);
+    xaccTransBeginEdit (t_deleted);
+    xaccTransDestroy (t_deleted);
+    xaccTransCommitEdit (t_deleted);
+    readonly_guid = *qof_instance_get_guid (t_readonly);
+    xaccTransSetReadOnly (t_readonly, "journal test");
+    qof_session_save (session_2, NULL);
+    do_test (g_file_test (journal, G_FILE_TEST_EXISTS),
+             "transaction changes go to the journal");
+
+    /* The journal's second record replaces a read-only transaction. */
+    xaccTransBeginEdit (t_readonly);
+    xaccTransSetDescription (t_readonly, "changed while read-only");
+    xaccTransCommitEdit (t_readonly);
+    qof_session_save (session_2, NULL);
+    do_test_args (qof_session_get_error (session_2) == ERR_BACKEND_NO_ERR,
+                  "journal save", __FILE__, __LINE__,
+                  "qof error=%d", qof_session_get_error (session_2));
+    do_test (!qof_book_session_not_saved (book), "journal save is saved");
+
+    session_1 = qof_session_new ();
+    qof_session_begin (session_1, url, TRUE, FALSE, FALSE);
+    qof_session_load (session_1, NULL);
+    do_test_args (qof_session_get_error (session_1) == ERR_BACKEND_NO_ERR,
+                  "journal reload", __FILE__, __LINE__,
+                  "qof error=%d", qof_session_get_error (session_1));
+    book_2 = qof_session_get_book (session_1);
+
+    do_test (xaccAccountEqual (gnc_book_get_root_account (book),
+                               gnc_book_get_root_account (book_2), TRUE),
+             "replayed account tree matches the saved one");
+    do_test (xaccAccountEqual (gnc_book_get_template_root (book),
+                               gnc_book_get_template_root (book_2), TRUE),
+             "replayed template accounts match the saved ones");
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            compare_reloaded_trans, book_2);
+    do_test (xaccTransLookup (&deleted_guid, book_2) == NULL,
+             "deleted transaction stays deleted");
+    do_test (xaccTransGetReadOnly (xaccTransLookup (&readonly_guid, book_2))
+             != NULL, "read-only transaction is still read-only");
+
+    /* A record torn off in the middle, as by a crash while appending,
+     * must leave the book as the earlier records left it, even though
+     * its first change was written out in full. */
+    changed_guid = *qof_instance_get_guid (t_changed);
+    xaccTransBeginEdit (t_changed);
+    xaccTransSetDescription (t_changed, "changed in a torn record");
+    xaccTransCommitEdit (t_changed);
+    torn_guid = *qof_instance_get_guid (t_torn);
+    xaccTransBeginEdit (t_torn);
+    xaccTransDestroy (t_torn);
+    xaccTransCommitEdit (t_torn);
+    qof_session_save (session_2, NULL);
+    /* Cut off the closing tag and the end of the deletion before it. */
+    if (do_test (g_stat (journal, &journal_stat) == 0, "stat journal"))
+        do_test (truncate (journal, journal_stat.st_size - 20) == 0,
+                 "truncate the last journal record");
+
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    qof_session_load (session_3, NULL);
+    book_3 = qof_session_get_book (session_3);
+    do_test (g_strcmp0 (xaccTransGetDescription (
+                            xaccTransLookup (&changed_guid, book_3)),
+                        "changed in the journal") == 0,
+             "torn record's change is not applied");
+    do_test (xaccTransLookup (&torn_guid, book_3) != NULL,
+             "torn record's deletion is not applied");
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+
+    qof_session_end (session_1);
+    qof_session_destroy (session_1);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    gnc_prefs_set_file_save_journal (FALSE);
+    remove_test_dir (dirname);
+    g_free (url);
+    g_free (journal);
+    g_free (filename);
+    g_free (dirname);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -166,6 +530,12 @@ main (int argc, char** argv)
         failure ("handled 0 files in test-load-xml2");
     }
 
+    test_save_reload_book (FALSE);
+    test_save_reload_book (TRUE);
+    test_save_threads (FALSE);
+    test_save_threads (TRUE);
+    test_journal_replay ();
+
     print_test_results ();
     qof_close ();
     exit (get_rv ());
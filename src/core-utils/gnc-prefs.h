@@ -107,6 +107,12 @@ void gnc_prefs_set_extra(gboolean enabled);
 gboolean gnc_prefs_get_file_save_compressed(void);
 void gnc_prefs_set_file_save_compressed(gboolean compressed);
 
+gboolean gnc_prefs_get_file_save_journal(void);
+void gnc_prefs_set_file_save_journal(gboolean journal);
+
+gboolean gnc_prefs_get_sql_load_on_demand(void);
+void gnc_prefs_set_sql_load_on_demand(gboolean on_demand);
+
 gint gnc_prefs_get_file_retention_policy(void);
 void gnc_prefs_set_file_retention_policy(gint policy);
 
@@ -119,6 +119,7 @@ enum
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void imap_bayes_index_free (struct imap_bayes_index *index);
 
 
 /********************************************************************\
@@ -273,9 +274,18 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
 
-    priv->splits = NULL;
+    priv->splits = g_ptr_array_new ();
+    priv->splits_pending = NULL;
+    priv->splits_nodes = g_ptr_array_new ();
+    priv->splits_list = NULL;
     priv->sort_dirty = FALSE;
+
+    priv->balance_index = NULL;
+    priv->balance_index_valid = FALSE;
+
+    priv->imap_bayes = NULL;
 }
 
 static void
@@ -1180,6 +1190,199 @@ xaccFreeOneChildAccount (Account *acc, gpointer dummy)
     xaccAccountDestroy(acc);
 }
 
+/* Split array helpers.
+ *
+ * The front of priv->splits, everything but the splits_pending tail,
+ * is in xaccSplitOrder, so it can be binary searched.  That keeps
+ * inserting into a sorted account and finding a split to remove at
+ * O(log n), and lets a bulk load append splits in O(1) each and sort
+ * them once at the end.
+ */
+static guint
+gnc_account_n_pending_splits (const AccountPrivate *priv)
+{
+    return priv->splits_pending ? g_hash_table_size (priv->splits_pending) : 0;
+}
+
+static gint
+xaccSplitOrderIndirect (gconstpointer a, gconstpointer b)
+{
+    return xaccSplitOrder (*(Split * const *) a, *(Split * const *) b);
+}
+
+/* A split whose transaction is open for editing may have had its sort
+ * key changed without having been moved yet, so comparing against it
+ * says nothing about where other splits belong. */
+static gboolean
+gnc_account_split_is_settled (const Split *other, const Split *s)
+{
+    return other == s || !other->parent ||
+           qof_instance_get_editlevel (other->parent) == 0;
+}
+
+/* Return the position in the sorted front of the array at which s is,
+ * or would be inserted.  If settled is given, it is cleared when the
+ * search had to compare s with a split that isn't settled, in which
+ * case the position can't be trusted. */
+static guint
+gnc_account_split_lower_bound (const AccountPrivate *priv, const Split *s,
+                               gboolean *settled)
+{
+    guint lo = 0;
+    guint hi = priv->splits->len - gnc_account_n_pending_splits (priv);
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Split *other = g_ptr_array_index (priv->splits, mid);
+        if (settled && !gnc_account_split_is_settled (other, s))
+            *settled = FALSE;
+        if (xaccSplitOrder (other, s) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Mark the running balances dirty from position pos in the split array
+ * onward. */
+static void
+gnc_account_balance_dirty_from (AccountPrivate *priv, guint pos)
+{
+    if (!priv->balance_dirty || pos < priv->balance_dirty_from)
+        priv->balance_dirty_from = pos;
+    priv->balance_dirty = TRUE;
+}
+
+/* Return the index of s in the account's split array, or -1.  Unless
+ * exhaustive is set this only checks where s ought to be, which is
+ * enough to tell that a split being added isn't there yet. A split
+ * being removed may have been edited out of its sorted position, so
+ * removal searches exhaustively when the quick check fails. */
+static gint
+gnc_account_find_split (const AccountPrivate *priv, const Split *s,
+                        gboolean exhaustive)
+{
+    guint i;
+
+    if (priv->splits_pending && g_hash_table_contains (priv->splits_pending, s))
+    {
+        for (i = priv->splits->len; i > 0; i--)
+            if (g_ptr_array_index (priv->splits, i - 1) == s)
+                return i - 1;
+        return -1;
+    }
+
+    i = gnc_account_split_lower_bound (priv, s, NULL);
+    if (i < priv->splits->len && g_ptr_array_index (priv->splits, i) == s)
+        return i;
+
+    if (!exhaustive)
+        return -1;
+    for (i = 0; i < priv->splits->len; i++)
+        if (g_ptr_array_index (priv->splits, i) == s)
+            return i;
+    return -1;
+}
+
+static GList *
+gnc_account_copy_split_list (const AccountPrivate *priv)
+{
+    GList *list = NULL;
+    guint i;
+
+    for (i = priv->splits->len; i > 0; i--)
+        list = g_list_prepend (list, g_ptr_array_index (priv->splits, i - 1));
+    return list;
+}
+
+/* Build the list handed out by xaccAccountGetSplitList, and the index
+ * of its nodes that keeps it in step with the split array from then
+ * on. */
+static void
+gnc_account_build_split_list (AccountPrivate *priv)
+{
+    GList *node;
+
+    priv->splits_list = gnc_account_copy_split_list (priv);
+    g_ptr_array_set_size (priv->splits_nodes, 0);
+    for (node = priv->splits_list; node; node = node->next)
+        g_ptr_array_add (priv->splits_nodes, node);
+}
+
+static void
+gnc_account_free_split_list (AccountPrivate *priv)
+{
+    g_list_free (priv->splits_list);
+    priv->splits_list = NULL;
+    g_ptr_array_set_size (priv->splits_nodes, 0);
+}
+
+/* The split s was just put at pos in the split array; put it in the
+ * same place in the list. */
+static void
+gnc_account_split_list_insert (AccountPrivate *priv, guint pos, Split *s)
+{
+    GList *node;
+
+    if (!priv->splits_list)
+        return;
+    node = g_list_alloc ();
+    node->data = s;
+    if (pos < priv->splits_nodes->len)
+    {
+        GList *next = g_ptr_array_index (priv->splits_nodes, pos);
+        node->prev = next->prev;
+        node->next = next;
+        next->prev = node;
+    }
+    else
+    {
+        node->prev = g_ptr_array_index (priv->splits_nodes, pos - 1);
+    }
+    if (node->prev)
+        node->prev->next = node;
+    else
+        priv->splits_list = node;
+    g_ptr_array_insert (priv->splits_nodes, pos, node);
+}
+
+/* The split at pos was just taken out of the split array. */
+static void
+gnc_account_split_list_remove (AccountPrivate *priv, guint pos)
+{
+    GList *node;
+
+    if (!priv->splits_list)
+        return;
+    node = g_ptr_array_index (priv->splits_nodes, pos);
+    g_ptr_array_remove_index (priv->splits_nodes, pos);
+    priv->splits_list = g_list_delete_link (priv->splits_list, node);
+}
+
+/* The split array was just sorted. */
+static void
+gnc_account_split_list_reorder (AccountPrivate *priv)
+{
+    guint i;
+
+    for (i = 0; i < priv->splits_nodes->len; i++)
+    {
+        GList *node = g_ptr_array_index (priv->splits_nodes, i);
+        node->data = g_ptr_array_index (priv->splits, i);
+    }
+}
+
+static void
+gnc_account_clear_splits (AccountPrivate *priv)
+{
+    g_ptr_array_set_size (priv->splits, 0);
+    if (priv->splits_pending)
+        g_hash_table_remove_all (priv->splits_pending);
+    gnc_account_free_split_list (priv);
+}
+
 static void
 xaccFreeAccountChildren (Account *acc)
 {
@@ -1241,7 +1444,7 @@ xaccFreeAccount (Account *acc)
     /* NB there shouldn't be any splits by now ... they should
      * have been all been freed by CommitEdit().  We can remove this
      * check once we know the warning isn't occurring any more. */
-    if (priv->splits)
+    if (priv->splits->len)
     {
         GList *slist;
         PERR (" instead of calling xaccFreeAccount(), please call \n"
@@ -1249,7 +1452,7 @@ xaccFreeAccount (Account *acc)
 
         qof_instance_reset_editlevel(acc);
 
-        slist = g_list_copy(priv->splits);
+        slist = gnc_account_copy_split_list(priv);
         for (lp = slist; lp; lp = lp->next)
         {
             Split *s = (Split *) lp->data;
@@ -1257,8 +1460,8 @@ xaccFreeAccount (Account *acc)
             xaccSplitDestroy (s);
         }
         g_list_free(slist);
-/* Nothing here (or in xaccAccountCommitEdit) NULLs priv->splits, so this asserts every time.
-        g_assert(priv->splits == NULL);
+/* Nothing here (or in xaccAccountCommitEdit) empties priv->splits, so this asserts every time.
+        g_assert(priv->splits->len == 0);
 */
     }
 
@@ -1283,6 +1486,24 @@ xaccFreeAccount (Account *acc)
     priv->balance_dirty = FALSE;
     priv->sort_dirty = FALSE;
 
+    if (priv->balance_index)
+        g_array_free (priv->balance_index, TRUE);
+    priv->balance_index = NULL;
+    priv->balance_index_valid = FALSE;
+
+    imap_bayes_index_free (priv->imap_bayes);
+    priv->imap_bayes = NULL;
+
+    g_ptr_array_free (priv->splits, TRUE);
+    priv->splits = NULL;
+    if (priv->splits_pending)
+        g_hash_table_destroy (priv->splits_pending);
+    priv->splits_pending = NULL;
+    g_list_free (priv->splits_list);
+    priv->splits_list = NULL;
+    g_ptr_array_free (priv->splits_nodes, TRUE);
+    priv->splits_nodes = NULL;
+
     /* qof_instance_release (&acc->inst); */
     g_object_unref(acc);
 }
@@ -1341,9 +1562,15 @@ xaccAccountCommitEdit (Account *acc)
     g_return_if_fail(acc);
     if (!qof_commit_edit(&acc->inst)) return;
 
+    /* The edit may have changed the import map by any route, even
+     * qof_instance_set_kvp, so the Bayes index is rebuilt when next
+     * needed. */
+    priv = GET_PRIVATE(acc);
+    imap_bayes_index_free (priv->imap_bayes);
+    priv->imap_bayes = NULL;
+
     /* If marked for deletion, get rid of subaccounts first,
      * and then the splits ... */
-    priv = GET_PRIVATE(acc);
     if (qof_instance_get_destroying(acc))
     {
         GList *lp, *slist;
@@ -1363,7 +1590,7 @@ xaccAccountCommitEdit (Account *acc)
            themselves will be destroyed by the transaction code */
         if (!qof_book_shutting_down(book))
         {
-            slist = g_list_copy(priv->splits);
+            slist = gnc_account_copy_split_list(priv);
             for (lp = slist; lp; lp = lp->next)
             {
                 Split *s = lp->data;
@@ -1373,8 +1600,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            gnc_account_clear_splits(priv);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1382,7 +1608,7 @@ xaccAccountCommitEdit (Account *acc)
            deleting all the splits in it.  The splits will just get
            recreated and put right back into the same account!
 
-           g_assert(priv->splits == NULL || qof_book_shutting_down(acc->inst.book));
+           g_assert(priv->splits->len == 0 || qof_book_shutting_down(acc->inst.book));
         */
 
         if (!qof_book_shutting_down(book))
@@ -1654,36 +1880,31 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
     /* no parent; always compare downwards. */
 
     {
-        GList *la = priv_aa->splits;
-        GList *lb = priv_ab->splits;
+        guint na = priv_aa->splits->len;
+        guint nb = priv_ab->splits->len;
+        guint i;
 
-        if ((la && !lb) || (!la && lb))
+        if ((na && !nb) || (!na && nb))
         {
             PWARN ("only one has splits");
             return FALSE;
         }
 
-        if (la && lb)
+        if (na != nb)
         {
-            /* presume that the splits are in the same order */
-            while (la && lb)
-            {
-                Split *sa = (Split *) la->data;
-                Split *sb = (Split *) lb->data;
-
-                if (!xaccSplitEqual(sa, sb, check_guids, TRUE, FALSE))
-                {
-                    PWARN ("splits differ");
-                    return(FALSE);
-                }
+            PWARN ("number of splits differs");
+            return(FALSE);
+        }
 
-                la = la->next;
-                lb = lb->next;
-            }
+        /* presume that the splits are in the same order */
+        for (i = 0; i < na; i++)
+        {
+            Split *sa = g_ptr_array_index (priv_aa->splits, i);
+            Split *sb = g_ptr_array_index (priv_ab->splits, i);
 
-            if ((la != NULL) || (lb != NULL))
+            if (!xaccSplitEqual(sa, sb, check_guids, TRUE, FALSE))
             {
-                PWARN ("number of splits differs");
+                PWARN ("splits differ");
                 return(FALSE);
             }
         }
@@ -1725,7 +1946,7 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 /********************************************************************\
@@ -1735,25 +1956,35 @@ gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    gboolean settled = TRUE;
+    guint pos = 0;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    if (gnc_account_find_split (priv, s, FALSE) >= 0)
         return FALSE;
 
-    if (qof_instance_get_editlevel(acc) == 0)
+    if (qof_instance_get_editlevel(acc) == 0 && !priv->sort_dirty)
+        pos = gnc_account_split_lower_bound (priv, s, &settled);
+
+    if (qof_instance_get_editlevel(acc) == 0 && !priv->sort_dirty && settled)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        g_ptr_array_insert (priv->splits, pos, s);
+        gnc_account_split_list_insert (priv, pos, s);
+        gnc_account_balance_dirty_from (priv, pos);
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        if (!priv->splits_pending)
+            priv->splits_pending = g_hash_table_new (g_direct_hash,
+                                                     g_direct_equal);
+        g_hash_table_add (priv->splits_pending, s);
+        g_ptr_array_add (priv->splits, s);
+        gnc_account_split_list_insert (priv, priv->splits->len - 1, s);
         priv->sort_dirty = TRUE;
+        gnc_account_balance_dirty_from (priv, 0);
     }
 
     //FIXME: find better event
@@ -1761,7 +1992,6 @@ gnc_account_insert_split (Account *acc, Split *s)
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1771,23 +2001,26 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    gint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    pos = gnc_account_find_split (priv, s, TRUE);
+    if (pos < 0)
         return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
+    g_ptr_array_remove_index (priv->splits, pos);
+    gnc_account_split_list_remove (priv, pos);
+    if (priv->splits_pending)
+        g_hash_table_remove (priv->splits_pending, s);
+    gnc_account_balance_dirty_from (priv, pos);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
@@ -1802,9 +2035,126 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+    g_ptr_array_sort (priv->splits, (GCompareFunc)xaccSplitOrderIndirect);
+    gnc_account_split_list_reorder (priv);
+    if (priv->splits_pending)
+        g_hash_table_remove_all (priv->splits_pending);
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
+}
+
+void
+gnc_account_split_balance_dirty (Account *acc, Split *s)
+{
+    AccountPrivate *priv;
+    gint pos;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_SPLIT(s));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    if (priv->balance_dirty && priv->balance_dirty_from == 0)
+        return;
+    pos = gnc_account_find_split (priv, s, TRUE);
+    gnc_account_balance_dirty_from (priv, pos < 0 ? 0 : (guint) pos);
+}
+
+/* Is the split at pos in order with respect to its neighbours?  An
+ * unsettled neighbour doesn't count as being in order. */
+static gboolean
+gnc_account_split_in_place (const AccountPrivate *priv, guint pos)
+{
+    Split *s = g_ptr_array_index (priv->splits, pos);
+
+    if (pos > 0)
+    {
+        Split *prev = g_ptr_array_index (priv->splits, pos - 1);
+        if (!gnc_account_split_is_settled (prev, s) ||
+            xaccSplitOrder (prev, s) > 0)
+            return FALSE;
+    }
+    if (pos + 1 < priv->splits->len)
+    {
+        Split *next = g_ptr_array_index (priv->splits, pos + 1);
+        if (!gnc_account_split_is_settled (next, s) ||
+            xaccSplitOrder (s, next) > 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Move the split at pos to the pending tail, where the next sort will
+ * put it in place.  Leaving it at pos would break the order of the
+ * front of the array that gnc_account_find_split relies on. */
+static void
+gnc_account_defer_split (AccountPrivate *priv, guint pos)
+{
+    Split *s = g_ptr_array_index (priv->splits, pos);
+
+    g_ptr_array_remove_index (priv->splits, pos);
+    gnc_account_split_list_remove (priv, pos);
+    g_ptr_array_add (priv->splits, s);
+    gnc_account_split_list_insert (priv, priv->splits->len - 1, s);
+    if (!priv->splits_pending)
+        priv->splits_pending = g_hash_table_new (g_direct_hash,
+                                                 g_direct_equal);
+    g_hash_table_add (priv->splits_pending, s);
+    priv->sort_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
+}
+
+void
+gnc_account_split_changed (Account *acc, Split *s)
+{
+    AccountPrivate *priv;
+    gboolean settled = TRUE;
+    gint pos;
+    guint new_pos;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_SPLIT(s));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    if (priv->splits_pending && g_hash_table_contains (priv->splits_pending, s))
+    {
+        /* The split will find its place in the next sort. */
+        gnc_account_balance_dirty_from (priv, 0);
+        return;
+    }
+
+    pos = gnc_account_find_split (priv, s, TRUE);
+    if (pos < 0)
+        return;
+
+    if (gnc_account_split_in_place (priv, pos))
+    {
+        gnc_account_balance_dirty_from (priv, pos);
+        return;
+    }
+
+    if (!priv->sort_dirty && qof_instance_get_editlevel(acc) == 0)
+    {
+        g_ptr_array_remove_index (priv->splits, pos);
+        new_pos = gnc_account_split_lower_bound (priv, s, &settled);
+        if (settled)
+        {
+            g_ptr_array_insert (priv->splits, new_pos, s);
+            gnc_account_split_list_remove (priv, pos);
+            gnc_account_split_list_insert (priv, new_pos, s);
+            gnc_account_balance_dirty_from (priv, MIN ((guint) pos, new_pos));
+            return;
+        }
+        g_ptr_array_insert (priv->splits, pos, s);
+    }
+
+    /* Can't tell where it goes right now, so leave it for a full sort. */
+    gnc_account_defer_split (priv, pos);
 }
 
 static void
@@ -1972,6 +2322,20 @@ xaccAccountInsertLot (Account *acc, GNCLot *lot)
     LEAVE ("(acc=%p, lot=%p)", acc, lot);
 }
 
+/* A backend that loads transactions on demand only has some of an
+ * account's splits in memory.  Ask it for those posted on or after
+ * since (all of them for INT64_MIN) before looking at the splits or
+ * their running balances; splits before since only make up the
+ * starting balance.  Every reader of priv->splits goes through here,
+ * and the backend keeps track of what it has already loaded, so this
+ * costs nothing for a fully loaded book. */
+static void
+gnc_account_load_splits_since (const Account *acc, time64 since)
+{
+    qof_book_load_splits (gnc_account_get_book (acc),
+                          QOF_INSTANCE (acc), since);
+}
+
 /********************************************************************\
 \********************************************************************/
 static void
@@ -1995,14 +2359,16 @@ void
 xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
 {
     AccountPrivate *from_priv;
+    GList *splits;
 
     /* errors */
     g_return_if_fail(GNC_IS_ACCOUNT(accfrom));
     g_return_if_fail(GNC_IS_ACCOUNT(accto));
 
     /* optimizations */
+    gnc_account_load_splits_since (accfrom, INT64_MIN);
     from_priv = GET_PRIVATE(accfrom);
-    if (!from_priv->splits || accfrom == accto)
+    if (!from_priv->splits->len || accfrom == accto)
         return;
 
     /* check for book mix-up */
@@ -2012,7 +2378,7 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
     xaccAccountBeginEdit(accfrom);
     xaccAccountBeginEdit(accto);
     /* Begin editing both accounts and all transactions in accfrom. */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPreSplitMove, NULL);
+    g_ptr_array_foreach(from_priv->splits, (GFunc)xaccPreSplitMove, NULL);
 
     /* Concatenate accfrom's lists of splits and lots to accto's lists. */
     //to_priv->splits = g_list_concat(to_priv->splits, from_priv->splits);
@@ -2029,10 +2395,12 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
      * Convert each split's amount to accto's commodity.
      * Commit to editing each transaction.
      */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPostSplitMove, (gpointer)accto);
+    splits = gnc_account_copy_split_list(from_priv);
+    g_list_foreach(splits, (GFunc)xaccPostSplitMove, (gpointer)accto);
+    g_list_free(splits);
 
     /* Finally empty accfrom. */
-    g_assert(from_priv->splits == NULL);
+    g_assert(from_priv->splits->len == 0);
     g_assert(from_priv->lots == NULL);
     xaccAccountCommitEdit(accfrom);
     xaccAccountCommitEdit(accto);
@@ -2076,7 +2444,7 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
+    guint i;
 
     if (NULL == acc) return;
 
@@ -2086,16 +2454,39 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    if (!priv->balance_index)
+        priv->balance_index = g_array_new (FALSE, FALSE,
+                                           sizeof (AccountBalanceEntry));
+
+    /* The splits before the dirty watermark kept their running
+     * balances, so carry on from the last of them.  That needs the
+     * balance index to have been built over the same, sorted, array. */
+    i = priv->balance_dirty_from;
+    if (i > 0 && i <= priv->splits->len && !priv->sort_dirty &&
+        priv->balance_index_valid && priv->balance_index->len >= i)
+    {
+        AccountBalanceEntry *last =
+            &g_array_index (priv->balance_index, AccountBalanceEntry, i - 1);
+        balance            = last->balance;
+        cleared_balance    = last->cleared_balance;
+        reconciled_balance = last->reconciled_balance;
+    }
+    else
+    {
+        i = 0;
+        balance            = priv->starting_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
+    g_array_set_size (priv->balance_index, i);
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    PINFO ("acct=%s from split %u baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
+           priv->accountName, i, balance.num, balance.denom);
+    for (; i < priv->splits->len; i++)
     {
-        Split *split = (Split *) lp->data;
+        Split *split = g_ptr_array_index (priv->splits, i);
         gnc_numeric amt = xaccSplitGetAmount (split);
+        AccountBalanceEntry entry;
 
         balance = gnc_numeric_add_fixed(balance, amt);
 
@@ -2115,12 +2506,53 @@ xaccAccountRecomputeBalance (Account * acc)
         split->cleared_balance = cleared_balance;
         split->reconciled_balance = reconciled_balance;
 
+        entry.date = xaccTransGetDate (xaccSplitGetParent (split));
+        entry.balance = balance;
+        entry.cleared_balance = cleared_balance;
+        entry.reconciled_balance = reconciled_balance;
+        g_array_append_val (priv->balance_index, entry);
     }
 
     priv->balance = balance;
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
+    /* Running balances computed over an unsorted list can't be searched
+     * by date; the next sort will dirty the balances again anyway. */
+    priv->balance_index_valid = !priv->sort_dirty;
+}
+
+/* Whether the balance index matches the current splits. */
+static gboolean
+xaccAccountBalanceIndexUsable (const AccountPrivate *priv)
+{
+    return priv->balance_index && priv->balance_index_valid &&
+           !priv->balance_dirty && !priv->sort_dirty;
+}
+
+/* Return the number of entries in the balance index posted strictly
+ * before date, or -1 if the index can't be used right now. */
+static gint
+xaccAccountBalanceIndexPosition (const AccountPrivate *priv, time64 date)
+{
+    const AccountBalanceEntry *entries;
+    guint lo = 0, hi;
+
+    if (!xaccAccountBalanceIndexUsable (priv))
+        return -1;
+
+    entries = (const AccountBalanceEntry *) priv->balance_index->data;
+    hi = priv->balance_index->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (entries[mid].date < date)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (gint) lo;
 }
 
 /********************************************************************\
@@ -2235,7 +2667,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    gnc_account_balance_dirty_from (priv, 0); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2387,7 +2819,7 @@ void
 xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
 {
     AccountPrivate *priv;
-    GList *lp;
+    guint i;
 
     /* errors */
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
@@ -2406,9 +2838,10 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     priv->non_standard_scu = FALSE;
 
     /* iterate over splits */
-    for (lp = priv->splits; lp; lp = lp->next)
+    gnc_account_load_splits_since (acc, INT64_MIN);
+    for (i = 0; i < priv->splits->len; i++)
     {
-        Split *s = (Split *) lp->data;
+        Split *s = g_ptr_array_index (priv->splits, i);
         Transaction *trans = xaccSplitGetParent (s);
 
         xaccTransBeginEdit (trans);
@@ -2417,7 +2850,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3203,7 +3636,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3216,7 +3649,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3229,7 +3662,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    gnc_account_balance_dirty_from (priv, 0);
 }
 
 gnc_numeric
@@ -3257,7 +3690,7 @@ gnc_numeric
 xaccAccountGetProjectedMinimumBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint i;
     time64 today;
     gnc_numeric lowest = gnc_numeric_zero ();
     int seen_a_transaction = 0;
@@ -3266,9 +3699,10 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    gnc_account_load_splits_since (acc, INT64_MIN);
+    for (i = priv->splits->len; i > 0; i--)
     {
-        Split *split = node->data;
+        Split *split = g_ptr_array_index (priv->splits, i - 1);
 
         if (!seen_a_transaction)
         {
@@ -3301,19 +3735,35 @@ xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
      * values rather than gints.
      */
     AccountPrivate *priv;
-    GList   *lp;
+    guint    i;
     Timespec ts, trans_ts;
     gboolean found = FALSE;
     gnc_numeric balance;
+    gint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    gnc_account_load_splits_since (acc, date);
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
     priv = GET_PRIVATE(acc);
     balance = priv->balance;
 
+    /* Normally the balance index is current and answers this with a
+     * binary search; the walk below is only needed while the account
+     * is open for editing and its balances can't be recomputed. */
+    pos = xaccAccountBalanceIndexPosition (priv, date);
+    if (pos >= 0)
+    {
+        if ((guint) pos == priv->balance_index->len)
+            return balance;
+        if (pos == 0)
+            return priv->starting_balance;
+        return g_array_index (priv->balance_index, AccountBalanceEntry,
+                              pos - 1).balance;
+    }
+
     /* Since transaction post times are stored as a Timespec,
      * convert date into a Timespec as well rather than converting
      * each transaction's Timespec into a time64.
@@ -3329,30 +3779,34 @@ xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
     ts.tv_sec = date;
     ts.tv_nsec = 0;
 
-    lp = priv->splits;
-    while ( lp && !found )
+    i = 0;
+    while ( i < priv->splits->len && !found )
     {
-        xaccTransGetDatePostedTS( xaccSplitGetParent( (Split *)lp->data ),
-                                  &trans_ts );
+        xaccTransGetDatePostedTS(
+            xaccSplitGetParent( g_ptr_array_index( priv->splits, i ) ),
+            &trans_ts );
         if ( timespec_cmp( &trans_ts, &ts ) >= 0 )
             found = TRUE;
         else
-            lp = lp->next;
+            i++;
     }
 
-    if ( lp )
+    if ( found )
     {
-        if ( lp->prev )
+        if ( i > 0 )
         {
-            /* Since lp is now pointing to a split which was past the reconcile
+            /* Since i is now pointing to a split which was past the reconcile
              * date, get the running balance of the previous split.
              */
-            balance = xaccSplitGetBalance( (Split *)lp->prev->data );
+            balance = xaccSplitGetBalance( g_ptr_array_index( priv->splits,
+                                                              i - 1 ) );
         }
         else
         {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
+            /* AsOf date must be before any entries, return the
+             * starting balance (zero unless the backend left some
+             * transactions unloaded). */
+            balance = priv->starting_balance;
         }
     }
 
@@ -3375,22 +3829,24 @@ gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint i;
     time64 today;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
-    priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    gnc_account_load_splits_since (acc, today);
+
+    priv = GET_PRIVATE(acc);
+    for (i = priv->splits->len; i > 0; i--)
     {
-        Split *split = node->data;
+        Split *split = g_ptr_array_index (priv->splits, i - 1);
 
         if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
             return xaccSplitGetBalance (split);
     }
 
-    return gnc_numeric_zero ();
+    return priv->starting_balance;
 }
 
 
@@ -3705,6 +4161,213 @@ xaccAccountGetBalanceChangeForPeriod (Account *acc, time64 t1, time64 t2,
     return gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
 }
 
+/********************************************************************\
+\********************************************************************/
+
+struct gnc_balance_grid_s
+{
+    GPtrArray *accounts;
+    /* Account * -> row + 1 */
+    GHashTable *rows;
+    GArray *dates;
+    /* accounts->len rows of dates->len balances, NULL until needed */
+    gnc_numeric *balances;
+};
+
+GncBalanceGrid *
+gnc_balance_grid_new (void)
+{
+    GncBalanceGrid *grid = g_new0 (GncBalanceGrid, 1);
+
+    grid->accounts = g_ptr_array_new ();
+    grid->rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+    grid->dates = g_array_new (FALSE, FALSE, sizeof (time64));
+    return grid;
+}
+
+void
+gnc_balance_grid_destroy (GncBalanceGrid *grid)
+{
+    if (!grid) return;
+
+    g_ptr_array_free (grid->accounts, TRUE);
+    g_hash_table_destroy (grid->rows);
+    g_array_free (grid->dates, TRUE);
+    g_free (grid->balances);
+    g_free (grid);
+}
+
+void
+gnc_balance_grid_add_account (GncBalanceGrid *grid, Account *acc)
+{
+    g_return_if_fail (grid);
+    g_return_if_fail (GNC_IS_ACCOUNT (acc));
+
+    if (g_hash_table_lookup (grid->rows, acc))
+        return;
+
+    g_ptr_array_add (grid->accounts, acc);
+    g_hash_table_insert (grid->rows, acc,
+                         GUINT_TO_POINTER (grid->accounts->len));
+    g_free (grid->balances);
+    grid->balances = NULL;
+}
+
+guint
+gnc_balance_grid_add_date (GncBalanceGrid *grid, time64 date)
+{
+    g_return_val_if_fail (grid, 0);
+
+    g_array_append_val (grid->dates, date);
+    g_free (grid->balances);
+    grid->balances = NULL;
+    return grid->dates->len - 1;
+}
+
+static gint
+balance_grid_date_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const time64 *dates = user_data;
+    time64 date_a = dates[*(const guint *) a];
+    time64 date_b = dates[*(const guint *) b];
+
+    return (date_a > date_b) - (date_a < date_b);
+}
+
+/* Fill in one row of the grid, advancing through the account's splits
+ * and the dates, in date order, together. */
+static void
+balance_grid_sweep_account (GncBalanceGrid *grid, guint row,
+                            const guint *order)
+{
+    Account *acc = g_ptr_array_index (grid->accounts, row);
+    const time64 *dates = (const time64 *) grid->dates->data;
+    gnc_numeric *balances = grid->balances + (gsize) row * grid->dates->len;
+    gnc_numeric balance;
+    AccountPrivate *priv;
+    gboolean use_index;
+    guint i, j = 0, n;
+    gint pos;
+
+    if (grid->dates->len == 0)
+        return;
+
+    gnc_account_load_splits_since (acc, dates[order[0]]);
+    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+    xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
+
+    /* The index is a contiguous copy of the running balances; the
+     * splits themselves are only needed while the account is being
+     * edited. */
+    priv = GET_PRIVATE (acc);
+    balance = priv->starting_balance;
+    use_index = xaccAccountBalanceIndexUsable (priv);
+    n = use_index ? priv->balance_index->len : priv->splits->len;
+
+    /* Skip the splits before the earliest date with a binary search
+     * instead of stepping over them. */
+    if (use_index && dates[order[0]] < INT64_MAX)
+    {
+        pos = xaccAccountBalanceIndexPosition (priv, dates[order[0]] + 1);
+        if (pos > 0)
+        {
+            j = pos;
+            balance = g_array_index (priv->balance_index, AccountBalanceEntry,
+                                     j - 1).balance;
+        }
+    }
+
+    for (i = 0; i < grid->dates->len; i++)
+    {
+        time64 date = dates[order[i]];
+
+        for (; j < n; j++)
+        {
+            if (use_index)
+            {
+                const AccountBalanceEntry *entry =
+                    &g_array_index (priv->balance_index, AccountBalanceEntry, j);
+                if (entry->date > date)
+                    break;
+                balance = entry->balance;
+            }
+            else
+            {
+                Split *split = g_ptr_array_index (priv->splits, j);
+                if (xaccTransGetDate (xaccSplitGetParent (split)) > date)
+                    break;
+                balance = xaccSplitGetBalance (split);
+            }
+        }
+        balances[order[i]] = balance;
+    }
+}
+
+static void
+balance_grid_compute (GncBalanceGrid *grid)
+{
+    guint *order;
+    guint i;
+
+    if (grid->balances)
+        return;
+
+    order = g_new (guint, grid->dates->len);
+    for (i = 0; i < grid->dates->len; i++)
+        order[i] = i;
+    g_qsort_with_data (order, grid->dates->len, sizeof (guint),
+                       balance_grid_date_compare, grid->dates->data);
+
+    grid->balances = g_new (gnc_numeric,
+                            (gsize) grid->accounts->len * grid->dates->len);
+    for (i = 0; i < grid->accounts->len; i++)
+        balance_grid_sweep_account (grid, i, order);
+
+    g_free (order);
+}
+
+static gnc_numeric *
+balance_grid_lookup (GncBalanceGrid *grid, const Account *acc, guint date)
+{
+    guint row;
+
+    row = GPOINTER_TO_UINT (g_hash_table_lookup (grid->rows, acc));
+    if (row == 0 || date >= grid->dates->len)
+        return NULL;
+
+    balance_grid_compute (grid);
+    return grid->balances + (gsize) (row - 1) * grid->dates->len + date;
+}
+
+gnc_numeric
+gnc_balance_grid_get_balance (GncBalanceGrid *grid, const Account *acc,
+                              guint date)
+{
+    gnc_numeric *balance;
+
+    g_return_val_if_fail (grid, gnc_numeric_zero ());
+
+    balance = balance_grid_lookup (grid, acc, date);
+    g_return_val_if_fail (balance, gnc_numeric_zero ());
+    return *balance;
+}
+
+gnc_numeric
+gnc_balance_grid_get_change (GncBalanceGrid *grid, const Account *acc,
+                             guint date)
+{
+    gnc_numeric *balance;
+
+    g_return_val_if_fail (grid, gnc_numeric_zero ());
+
+    balance = balance_grid_lookup (grid, acc, date);
+    g_return_val_if_fail (balance, gnc_numeric_zero ());
+    if (date == 0)
+        return *balance;
+    return gnc_numeric_sub (balance[0], balance[-1], GNC_DENOM_AUTO,
+                            GNC_HOW_DENOM_FIXED);
+}
+
 
 /********************************************************************\
 \********************************************************************/
@@ -3723,9 +4386,42 @@ xaccAccountGetBalanceChangeForPeriod (Account *acc, time64 t1, time64 t2,
 SplitList *
 xaccAccountGetSplitList (const Account *acc)
 {
+    AccountPrivate *priv;
+
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    gnc_account_load_splits_since (acc, INT64_MIN);
     xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
-    return GET_PRIVATE(acc)->splits;
+    priv = GET_PRIVATE(acc);
+    if (!priv->splits_list && priv->splits->len)
+        gnc_account_build_split_list (priv);
+    return priv->splits_list;
+}
+
+gint
+xaccAccountForEachSplit (const Account *acc, SplitCallback thunk,
+                         gpointer data)
+{
+    AccountPrivate *priv;
+    guint i = 0;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
+    g_return_val_if_fail(thunk, 0);
+
+    gnc_account_load_splits_since (acc, INT64_MIN);
+    xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
+    priv = GET_PRIVATE(acc);
+    while (i < priv->splits->len)
+    {
+        Split *s = g_ptr_array_index (priv->splits, i);
+        gint result = thunk (s, data);
+        if (result)
+            return result;
+        /* If the thunk removed s, the next split has moved into its
+         * place. */
+        if (i < priv->splits->len && g_ptr_array_index (priv->splits, i) == s)
+            i++;
+    }
+    return 0;
 }
 
 gint64
@@ -3736,7 +4432,8 @@ xaccAccountCountSplits (const Account *acc, gboolean include_children)
     nr = 0;
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
 
-    nr = g_list_length(xaccAccountGetSplitList(acc));
+    gnc_account_load_splits_since (acc, INT64_MIN);
+    nr = GET_PRIVATE(acc)->splits->len;
     if (include_children && (gnc_account_n_children(acc) != 0))
     {
         for (i=0; i < gnc_account_n_children(acc); i++)
@@ -4746,7 +5443,7 @@ finder_help_function(const Account *acc, const char *description,
                      Split **split, Transaction **trans )
 {
     AccountPrivate *priv;
-    GList *slp;
+    guint i;
 
     /* First, make sure we set the data to NULL BEFORE we start */
     if (split) *split = NULL;
@@ -4758,10 +5455,11 @@ finder_help_function(const Account *acc, const char *description,
     /* Why is this loop iterated backwards ?? Presumably because the split
      * list is in date order, and the most recent matches should be
      * returned!?  */
+    gnc_account_load_splits_since (acc, INT64_MIN);
     priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    for (i = priv->splits->len; i > 0; i--)
     {
-        Split *lsplit = slp->data;
+        Split *lsplit = g_ptr_array_index (priv->splits, i - 1);
         Transaction *ltrans = xaccSplitGetParent(lsplit);
 
         if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
@@ -4878,8 +5576,9 @@ gnc_account_merge_children (Account *parent)
             gnc_account_merge_children (acc_a);
 
             /* consolidate transactions */
-            while (priv_b->splits)
-                xaccSplitSetAccount (priv_b->splits->data, acc_a);
+            while (priv_b->splits->len)
+                xaccSplitSetAccount (g_ptr_array_index (priv_b->splits, 0),
+                                     acc_a);
 
             /* move back one before removal. next iteration around the loop
              * will get the node after node_b */
@@ -4897,6 +5596,13 @@ gnc_account_merge_children (Account *parent)
 /* Transaction Traversal functions                                  */
 
 
+static void do_one_split (Split *s, gpointer data)
+{
+    Transaction *trans = s->parent;
+    if (trans)
+        trans->marker = 0;
+}
+
 void
 xaccSplitsBeginStagedTransactionTraversals (GList *splits)
 {
@@ -4920,8 +5626,9 @@ xaccAccountBeginStagedTransactionTraversals (const Account *account)
 
     if (!account)
         return;
+    gnc_account_load_splits_since (account, INT64_MIN);
     priv = GET_PRIVATE(account);
-    xaccSplitsBeginStagedTransactionTraversals(priv->splits);
+    g_ptr_array_foreach(priv->splits, (GFunc)do_one_split, NULL);
 }
 
 gboolean
@@ -4938,16 +5645,13 @@ xaccTransactionTraverse (Transaction *trans, int stage)
     return FALSE;
 }
 
-static void do_one_split (Split *s, gpointer data)
-{
-    Transaction *trans = s->parent;
-    trans->marker = 0;
-}
-
 static void do_one_account (Account *account, gpointer data)
 {
-    AccountPrivate *priv = GET_PRIVATE(account);
-    g_list_foreach(priv->splits, (GFunc)do_one_split, NULL);
+    AccountPrivate *priv;
+
+    gnc_account_load_splits_since (account, INT64_MIN);
+    priv = GET_PRIVATE(account);
+    g_ptr_array_foreach(priv->splits, (GFunc)do_one_split, NULL);
 }
 
 /* Replacement for xaccGroupBeginStagedTransactionTraversals */
@@ -4968,24 +5672,18 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
                                        void *cb_data)
 {
     AccountPrivate *priv;
-    GList *split_p;
-    GList *next;
+    guint i = 0;
     Transaction *trans;
     Split *s;
     int retval;
 
     if (!acc) return 0;
 
+    gnc_account_load_splits_since (acc, INT64_MIN);
     priv = GET_PRIVATE(acc);
-    for (split_p = priv->splits; split_p; split_p = next)
+    while (i < priv->splits->len)
     {
-        /* Get the next element in the split list now, just in case some
-         * naughty thunk destroys the one we're using. This reduces, but
-         * does not eliminate, the possibility of undefined results if
-         * a thunk removes splits from this account. */
-        next = g_list_next(split_p);
-
-        s = split_p->data;
+        s = g_ptr_array_index (priv->splits, i);
         trans = s->parent;
         if (trans && (trans->marker < stage))
         {
@@ -4996,6 +5694,13 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
                 if (retval) return retval;
             }
         }
+
+        /* Some naughty thunks destroy the transaction, taking s out of
+         * the array and moving the next split into its place.  This
+         * reduces, but does not eliminate, the possibility of undefined
+         * results if a thunk removes other splits from this account. */
+        if (i < priv->splits->len && g_ptr_array_index (priv->splits, i) == s)
+            i++;
     }
 
     return 0;
@@ -5008,7 +5713,8 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
         void *cb_data)
 {
     const AccountPrivate *priv;
-    GList *acc_p, *split_p;
+    GList *acc_p;
+    guint i = 0;
     Transaction *trans;
     Split *s;
     int retval;
@@ -5025,9 +5731,10 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
-    for (split_p = priv->splits; split_p; split_p = g_list_next(split_p))
+    gnc_account_load_splits_since (acc, INT64_MIN);
+    while (i < priv->splits->len)
     {
-        s = split_p->data;
+        s = g_ptr_array_index (priv->splits, i);
         trans = s->parent;
         if (trans && (trans->marker < stage))
         {
@@ -5038,6 +5745,8 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
                 if (retval) return retval;
             }
         }
+        if (i < priv->splits->len && g_ptr_array_index (priv->splits, i) == s)
+            i++;
     }
 
     return 0;
@@ -5180,147 +5889,232 @@ gnc_account_imap_delete_account (GncImportMatchMap *imap,
 --------------------------------------------------------------------------*/
 
 
-struct account_token_count
+/** The Bayesian map is indexed in memory the first time it is searched:
+ * every token is interned to a small integer, and for each one the
+ * index keeps the total count and a compact array of (account, count)
+ * pairs, the accounts themselves being interned as well.  A lookup is
+ * then one hash lookup per token followed by arithmetic on arrays.
+ */
+struct imap_bayes_count
 {
-    char* account_guid;
-    gint64 token_count; /**< occurrences of a given token for this account_guid */
+    guint account;      /**< index into imap_bayes_index.account_keys */
+    gint64 token_count; /**< occurrences of the token for this account */
 };
 
 /** total_count and the token_count for a given account let us calculate the
  * probability of a given account with any single token
  */
-struct token_accounts_info
+struct imap_bayes_token
 {
-    GList *accounts; /**< array of struct account_token_count */
+    GArray *accounts; /**< array of struct imap_bayes_count */
     gint64 total_count;
 };
 
-/** gpointer is a pointer to a struct token_accounts_info
- * \note Can always assume that keys are unique, reduces code in this function
- */
+struct imap_bayes_index
+{
+    GHashTable *token_ids;   /**< token -> its index in tokens, plus one */
+    GPtrArray *tokens;       /**< array of struct imap_bayes_token */
+    GHashTable *account_ids; /**< account key -> its index, plus one */
+    GPtrArray *account_keys; /**< the keys, normally guid strings */
+    /** Scratch space for a lookup, one entry per account.  product is
+     * negative for accounts that the current lookup hasn't seen. */
+    GArray *product;
+    GArray *product_difference;
+    GArray *seen;            /**< accounts the current lookup has seen */
+};
+
 static void
-buildTokenInfo(const char *key, const GValue *value, gpointer data)
+imap_bayes_token_free (gpointer data)
 {
-    struct token_accounts_info *tokenInfo = (struct token_accounts_info*)data;
-    struct account_token_count* this_account;
-
-    //  PINFO("buildTokenInfo: account '%s', token_count: '%" G_GINT64_FORMAT "'", (char*)key,
-    //                  g_value_get_int64(value));
-
-    /* add the count to the total_count */
-    tokenInfo->total_count += g_value_get_int64(value);
-
-    /* allocate a new structure for this account and it's token count */
-    this_account = (struct account_token_count*)
-                   g_new0(struct account_token_count, 1);
+    struct imap_bayes_token *token = data;
+    g_array_free (token->accounts, TRUE);
+    g_free (token);
+}
 
-    /* fill in the account guid and number of tokens found for this account guid */
-    this_account->account_guid = (char*)key;
-    this_account->token_count = g_value_get_int64(value);
+static struct imap_bayes_index *
+imap_bayes_index_new (void)
+{
+    struct imap_bayes_index *index = g_new0 (struct imap_bayes_index, 1);
 
-    /* append onto the glist a pointer to the new account_token_count structure */
-    tokenInfo->accounts = g_list_prepend(tokenInfo->accounts, this_account);
+    index->token_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+    index->tokens = g_ptr_array_new_with_free_func (imap_bayes_token_free);
+    index->account_ids = g_hash_table_new (g_str_hash, g_str_equal);
+    index->account_keys = g_ptr_array_new_with_free_func (g_free);
+    index->product = g_array_new (FALSE, FALSE, sizeof (double));
+    index->product_difference = g_array_new (FALSE, FALSE, sizeof (double));
+    index->seen = g_array_new (FALSE, FALSE, sizeof (guint));
+    return index;
 }
 
-/** intermediate values used to calculate the bayes probability of a given account
-  where p(AB) = (a*b)/[a*b + (1-a)(1-b)], product is (a*b),
-  product_difference is (1-a) * (1-b)
- */
-struct account_probability
+static void
+imap_bayes_index_free (struct imap_bayes_index *index)
 {
-    double product; /* product of probabilities */
-    double product_difference; /* product of (1-probabilities) */
-};
+    if (!index) return;
+    g_hash_table_destroy (index->token_ids);
+    g_ptr_array_free (index->tokens, TRUE);
+    g_hash_table_destroy (index->account_ids);
+    g_ptr_array_free (index->account_keys, TRUE);
+    g_array_free (index->product, TRUE);
+    g_array_free (index->product_difference, TRUE);
+    g_array_free (index->seen, TRUE);
+    g_free (index);
+}
 
-/** convert a hash table of account names and (struct account_probability*)
-  into a hash table of 100000x the percentage match value, ie. 10% would be
-  0.10 * 100000 = 10000
- */
-#define PROBABILITY_FACTOR 100000
+/** Forget the index, for when the import-map-bayes frame is changed
+ * behind its back. */
 static void
-buildProbabilities(gpointer key, gpointer value, gpointer data)
+imap_bayes_index_drop (Account *acc)
 {
-    GHashTable *final_probabilities = (GHashTable*)data;
-    struct account_probability *account_p = (struct account_probability*)value;
-
-    /* P(AB) = A*B / [A*B + (1-A)*(1-B)]
-     * NOTE: so we only keep track of a running product(A*B*C...)
-     * and product difference ((1-A)(1-B)...)
-     */
-    gint32 probability =
-        (account_p->product /
-         (account_p->product + account_p->product_difference))
-        * PROBABILITY_FACTOR;
-
-    PINFO("P('%s') = '%d'", (char*)key, probability);
+    AccountPrivate *priv = GET_PRIVATE (acc);
+    imap_bayes_index_free (priv->imap_bayes);
+    priv->imap_bayes = NULL;
+}
 
-    g_hash_table_insert(final_probabilities, key, GINT_TO_POINTER(probability));
+static struct imap_bayes_token *
+imap_bayes_index_lookup (const struct imap_bayes_index *index,
+                         const char *token)
+{
+    guint id = GPOINTER_TO_UINT (g_hash_table_lookup (index->token_ids,
+                                                      token));
+    return id ? g_ptr_array_index (index->tokens, id - 1) : NULL;
 }
 
-/** Frees an array of the same time that buildProperties built */
+/** Add count to the number of times token has been seen for the
+ * account with the given key. */
 static void
-freeProbabilities(gpointer key, gpointer value, gpointer data)
+imap_bayes_index_add (struct imap_bayes_index *index, const char *token,
+                      const char *account_key, gint64 count)
 {
-    /* free up the struct account_probability that was allocated
-     * in gnc_account_find_account_bayes()
-     */
-    g_free(value);
+    struct imap_bayes_token *info = imap_bayes_index_lookup (index, token);
+    struct imap_bayes_count entry;
+    guint account, i;
+
+    if (!info)
+    {
+        info = g_new0 (struct imap_bayes_token, 1);
+        info->accounts = g_array_new (FALSE, FALSE,
+                                      sizeof (struct imap_bayes_count));
+        g_ptr_array_add (index->tokens, info);
+        g_hash_table_insert (index->token_ids, g_strdup (token),
+                             GUINT_TO_POINTER (index->tokens->len));
+    }
+
+    account = GPOINTER_TO_UINT (g_hash_table_lookup (index->account_ids,
+                                                     account_key));
+    if (!account)
+    {
+        char *key = g_strdup (account_key);
+        double unseen = -1.0;
+
+        g_ptr_array_add (index->account_keys, key);
+        account = index->account_keys->len;
+        g_hash_table_insert (index->account_ids, key,
+                             GUINT_TO_POINTER (account));
+        g_array_append_val (index->product, unseen);
+        g_array_append_val (index->product_difference, unseen);
+    }
+    account--;
+
+    info->total_count += count;
+    for (i = 0; i < info->accounts->len; i++)
+    {
+        struct imap_bayes_count *c =
+            &g_array_index (info->accounts, struct imap_bayes_count, i);
+        if (c->account == account)
+        {
+            c->token_count += count;
+            return;
+        }
+    }
+    entry.account = account;
+    entry.token_count = count;
+    g_array_append_val (info->accounts, entry);
 }
 
-/** holds an account guid and its corresponding integer probability
-  the integer probability is some factor of 10
- */
-struct account_info
+struct imap_bayes_build
 {
-    char* account_guid;
-    gint32 probability;
+    Account *acc;
+    struct imap_bayes_index *index;
+    const char *token;
 };
 
-/** Find the highest probability and the corresponding account guid
-    store in data, a (struct account_info*)
-    NOTE: this is a g_hash_table_foreach() function for a hash table of entries
-    key is a  pointer to the account guid, value is a gint32, 100000x
-    the probability for this account
-*/
+/** Counts are normally int64; anything else counts as zero, as it
+ * always has.  A frame in the account position comes from a token
+ * containing the path separator, so it is walked as a token too. */
 static void
-highestProbability(gpointer key, gpointer value, gpointer data)
+imap_bayes_build_token (const char *key, const GValue *value, gpointer data)
 {
-    struct account_info *account_i = (struct account_info*)data;
+    struct imap_bayes_build *build = data;
+    struct imap_bayes_build nested = *build;
+    char *token, *kvp_path;
 
-    /* if the current probability is greater than the stored, store the current */
-    if (GPOINTER_TO_INT(value) > account_i->probability)
+    if (G_VALUE_HOLDS_INT64 (value))
     {
-        /* Save the new highest probability and the assoaciated account guid */
-        account_i->probability = GPOINTER_TO_INT(value);
-        account_i->account_guid = key;
+        imap_bayes_index_add (build->index, build->token, key,
+                              g_value_get_int64 (value));
+        return;
     }
+    imap_bayes_index_add (build->index, build->token, key, 0);
+
+    token = g_strconcat (build->token, "/", key, NULL);
+    kvp_path = g_strconcat (IMAP_FRAME_BAYES "/", token, NULL);
+    nested.token = token;
+    qof_instance_foreach_slot (QOF_INSTANCE (build->acc), kvp_path,
+                               imap_bayes_build_token, &nested);
+    g_free (kvp_path);
+    g_free (token);
+}
+
+static void
+imap_bayes_build_tokens (const char *key, const GValue *value, gpointer data)
+{
+    struct imap_bayes_build build = *(struct imap_bayes_build*)data;
+    char *kvp_path = g_strconcat (IMAP_FRAME_BAYES "/", key, NULL);
+
+    build.token = key;
+    qof_instance_foreach_slot (QOF_INSTANCE (build.acc), kvp_path,
+                               imap_bayes_build_token, &build);
+    g_free (kvp_path);
 }
 
+static struct imap_bayes_index *
+imap_bayes_index_get (Account *acc)
+{
+    AccountPrivate *priv = GET_PRIVATE (acc);
+    struct imap_bayes_build build;
+
+    if (priv->imap_bayes)
+        return priv->imap_bayes;
 
+    build.acc = acc;
+    build.index = imap_bayes_index_new ();
+    build.token = NULL;
+    qof_instance_foreach_slot (QOF_INSTANCE (acc), IMAP_FRAME_BAYES,
+                               imap_bayes_build_tokens, &build);
+    PINFO("indexed %u tokens for %u accounts", build.index->tokens->len,
+          build.index->account_keys->len);
+    priv->imap_bayes = build.index;
+    return priv->imap_bayes;
+}
+
+/** convert the running product (A*B*C...) and product difference
+  ((1-A)(1-B)...) into 100000x the percentage match value, ie. 10% would be
+  0.10 * 100000 = 10000
+ */
+#define PROBABILITY_FACTOR 100000
 #define threshold (.90 * PROBABILITY_FACTOR) /* 90% */
 
 /** Look up an Account in the map */
 Account*
 gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
 {
-    struct token_accounts_info tokenInfo; /**< holds the accounts and total
-                                           * token count for a single token */
-    GList *current_token;                 /**< pointer to the current
-                                           * token from the input GList
-                                           * tokens */
-    GList *current_account_token;         /**< pointer to the struct
-                                           * account_token_count */
-    struct account_token_count *account_c; /**< an account name and the number
-                                            * of times a token has appeared
-                                            * for the account */
-    struct account_probability *account_p; /**< intermediate storage of values
-                                            * to compute the bayes probability
-                                            * of an account */
-    GHashTable *running_probabilities = g_hash_table_new(g_str_hash,
-                                                         g_str_equal);
-    GHashTable *final_probabilities = g_hash_table_new(g_str_hash,
-                                                       g_str_equal);
-    struct account_info account_i;
+    struct imap_bayes_index *index;
+    double *product, *product_difference;
+    const char *best_key = NULL;
+    gint32 best_probability = 0;
+    GList *current_token;
+    guint i;
 
     ENTER(" ");
 
@@ -5332,135 +6126,90 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
         return NULL;
     }
 
+    index = imap_bayes_index_get (imap->acc);
+    product = (double*)index->product->data;
+    product_difference = (double*)index->product_difference->data;
+    g_array_set_size (index->seen, 0);
+
     /* find the probability for each account that contains any of the tokens
      * in the input tokens list
      */
     for (current_token = tokens; current_token;
          current_token = current_token->next)
     {
-        char* path = g_strdup_printf (IMAP_FRAME_BAYES "/%s",
-                                            (char*)current_token->data);
-        /* zero out the token_accounts_info structure */
-        memset(&tokenInfo, 0, sizeof(struct token_accounts_info));
+        struct imap_bayes_token *info;
 
-        PINFO("token: '%s'", (char*)current_token->data);
+        if (!current_token->data)
+            continue;
+        info = imap_bayes_index_lookup (index, current_token->data);
+        PINFO("token: '%s'%s", (char*)current_token->data,
+              info ? "" : " not found");
+        if (!info)
+            continue;
 
-        /* process the accounts for this token, adding the account if it
-         * doesn't already exist or adding to the existing accounts token
-         * count if it does
-         */
-        qof_instance_foreach_slot(QOF_INSTANCE (imap->acc), path,
-                                  buildTokenInfo, &tokenInfo);
-        g_free (path);
-        /* for each account we have just found, see if the account
-         * already exists in the list of account probabilities, if not
-         * add it
-         */
-        for (current_account_token = tokenInfo.accounts; current_account_token;
-                current_account_token = current_account_token->next)
+        for (i = 0; i < info->accounts->len; i++)
         {
-            /* get the account name and corresponding token count */
-            account_c = (struct account_token_count*)current_account_token->data;
-
-            PINFO("account_c->account_guid('%s'), "
-                  "account_c->token_count('%" G_GINT64_FORMAT
-                  "')/total_count('%" G_GINT64_FORMAT "')",
-                  account_c->account_guid, account_c->token_count,
-                  tokenInfo.total_count);
+            struct imap_bayes_count *c =
+                &g_array_index (info->accounts, struct imap_bayes_count, i);
+            double p = (double)c->token_count / (double)info->total_count;
 
-            account_p = g_hash_table_lookup(running_probabilities,
-                                            account_c->account_guid);
-
-            /* if the account exists in the list then continue
-             * the running probablities
+            /* P(AB) = A*B / [A*B + (1-A)*(1-B)]
+             * NOTE: so we only keep track of a running product(A*B*C...)
+             * and product difference ((1-A)(1-B)...)
              */
-            if (account_p)
+            if (product[c->account] < 0)
             {
-                account_p->product = (((double)account_c->token_count /
-                                      (double)tokenInfo.total_count)
-                                      * account_p->product);
-                account_p->product_difference =
-                    ((double)1 - ((double)account_c->token_count /
-                                  (double)tokenInfo.total_count))
-                    * account_p->product_difference;
-                PINFO("product == %f, product_difference == %f",
-                      account_p->product, account_p->product_difference);
+                product[c->account] = p;
+                product_difference[c->account] = 1 - p;
+                g_array_append_val (index->seen, c->account);
             }
             else
             {
-                /* add a new entry */
-                PINFO("adding a new entry for this account");
-                account_p = (struct account_probability*)
-                            g_new0(struct account_probability, 1);
-
-                /* set the product and product difference values */
-                account_p->product = ((double)account_c->token_count /
-                                      (double)tokenInfo.total_count);
-                account_p->product_difference =
-                    (double)1 - ((double)account_c->token_count /
-                                 (double)tokenInfo.total_count);
-
-                PINFO("product == %f, product_difference == %f",
-                      account_p->product, account_p->product_difference);
-
-                /* add the account guid and (struct account_probability*)
-                 * to the hash table */
-                g_hash_table_insert(running_probabilities,
-                                    account_c->account_guid, account_p);
+                product[c->account] *= p;
+                product_difference[c->account] *= 1 - p;
             }
-        } /* for all accounts in tokenInfo */
+        }
+    }
 
-        /* free the data in tokenInfo */
-        for (current_account_token = tokenInfo.accounts; current_account_token;
-                current_account_token = current_account_token->next)
+    /* find the highest probabilty and the corresponding account, and
+     * reset the scratch space for the next lookup */
+    for (i = 0; i < index->seen->len; i++)
+    {
+        guint account = g_array_index (index->seen, guint, i);
+        gint32 probability =
+            (product[account] /
+             (product[account] + product_difference[account]))
+            * PROBABILITY_FACTOR;
+
+        PINFO("P('%s') = '%d'",
+              (char*)g_ptr_array_index (index->account_keys, account),
+              probability);
+        if (probability > best_probability)
         {
-            /* free up each struct account_token_count we allocated */
-            g_free((struct account_token_count*)current_account_token->data);
+            best_probability = probability;
+            best_key = g_ptr_array_index (index->account_keys, account);
         }
-
-        g_list_free(tokenInfo.accounts); /* free the accounts GList */
+        product[account] = product_difference[account] = -1.0;
     }
 
-    /* build a hash table of account names and their final probabilities
-     * from each entry in the running_probabilties hash table
-     */
-    g_hash_table_foreach(running_probabilities, buildProbabilities,
-                         final_probabilities);
-
-    /* find the highest probabilty and the corresponding account */
-    memset(&account_i, 0, sizeof(struct account_info));
-    g_hash_table_foreach(final_probabilities, highestProbability, &account_i);
-
-    /* free each element of the running_probabilities hash */
-    g_hash_table_foreach(running_probabilities, freeProbabilities, NULL);
-
-    /* free the hash tables */
-    g_hash_table_destroy(running_probabilities);
-    g_hash_table_destroy(final_probabilities);
-
-    PINFO("highest P('%s') = '%d'",
-          account_i.account_guid ? account_i.account_guid : "(null)",
-          account_i.probability);
+    PINFO("highest P('%s') = '%d'", best_key ? best_key : "(null)",
+          best_probability);
 
     /* has this probability met our threshold? */
-    if (account_i.probability >= threshold)
+    if (best_probability >= threshold)
     {
-        GncGUID *guid;
+        GncGUID guid;
         Account *account = NULL;
 
         PINFO("Probability has met threshold");
 
-        guid = g_new (GncGUID, 1);
-
-        if (string_to_guid (account_i.account_guid, guid))
-            account = xaccAccountLookup (guid, imap->book);
-
-        g_free (guid);
+        if (string_to_guid (best_key, &guid))
+            account = xaccAccountLookup (&guid, imap->book);
 
         if (account != NULL)
             LEAVE("Return account is '%s'", xaccAccountGetName (account));
         else
-            LEAVE("Return NULL, account for Guid '%s' can not be found", account_i.account_guid);
+            LEAVE("Return NULL, account for Guid '%s' can not be found", best_key);
 
         return account;
     }
@@ -5520,6 +6269,7 @@ gnc_account_imap_add_account_bayes (GncImportMatchMap *imap,
     gint64 token_count;
     char *account_fullname, *kvp_path;
     char *guid_string;
+    struct imap_bayes_index *index;
 
     ENTER(" ");
     if (!imap)
@@ -5531,6 +6281,7 @@ gnc_account_imap_add_account_bayes (GncImportMatchMap *imap,
     g_return_if_fail (acc != NULL);
     account_fullname = gnc_account_get_full_name(acc);
     xaccAccountBeginEdit (imap->acc);
+    index = GET_PRIVATE (imap->acc)->imap_bayes;
 
     PINFO("account name: '%s'", account_fullname);
 
@@ -5560,12 +6311,26 @@ gnc_account_imap_add_account_bayes (GncImportMatchMap *imap,
         /* change the imap entry for the account */
         change_imap_entry (imap, kvp_path, token_count);
 
+        /* and keep the index in step, unless the token nests */
+        if (index && strchr ((char*)current_token->data, '/'))
+        {
+            imap_bayes_index_drop (imap->acc);
+            index = NULL;
+        }
+        if (index)
+            imap_bayes_index_add (index, current_token->data, guid_string,
+                                  token_count);
+
         g_free (kvp_path);
     }
 
     /* free up the account fullname and guid string */
     qof_instance_set_dirty (QOF_INSTANCE (imap->acc));
+    /* The index already has the new tokens, so keep it past the commit. */
+    index = GET_PRIVATE (imap->acc)->imap_bayes;
+    GET_PRIVATE (imap->acc)->imap_bayes = NULL;
     xaccAccountCommitEdit (imap->acc);
+    GET_PRIVATE (imap->acc)->imap_bayes = index;
     g_free (account_fullname);
     g_free (guid_string);
 
@@ -5778,6 +6543,7 @@ gnc_account_delete_map_entry (Account *acc, char *full_category, gboolean empty)
     if ((acc != NULL) && qof_instance_has_slot (QOF_INSTANCE(acc), kvp_path))
     {
         xaccAccountBeginEdit (acc);
+        imap_bayes_index_drop (acc);
 
         if (empty)
             qof_instance_slot_delete_if_empty (QOF_INSTANCE(acc), kvp_path);
@@ -5873,6 +6639,7 @@ convert_imap_entry (GncImapInfo *imapInfo, Account *map_account)
 
     // change the imap entry of source_account
     change_imap_entry (imap, kvp_path, token_count);
+    imap_bayes_index_drop (imapInfo->source_account);
 
     qof_instance_set_dirty (QOF_INSTANCE (imapInfo->source_account));
     xaccAccountCommitEdit (imapInfo->source_account);
@@ -601,6 +601,43 @@ gnc_numeric xaccAccountGetBalanceAsOfDateInCurrency(
 gnc_numeric xaccAccountGetBalanceChangeForPeriod (
     Account *acc, time64 date1, time64 date2, gboolean recurse);
 
+/** A grid of the balances of a number of accounts at a number of
+ *  dates.  Reports asking for many balances, such as one column per
+ *  month for a whole account tree, should collect the accounts and
+ *  dates in a grid: all of its balances are then computed in a
+ *  single sweep over each account's splits, in date order.
+ *
+ *  The balances are computed when first asked for, and are not
+ *  updated when the accounts change afterwards.
+ */
+typedef struct gnc_balance_grid_s GncBalanceGrid;
+
+/** Create an empty balance grid.  Free it with
+ *  gnc_balance_grid_destroy(). */
+GncBalanceGrid * gnc_balance_grid_new (void);
+void gnc_balance_grid_destroy (GncBalanceGrid *grid);
+
+/** Add an account to the grid.  Adding an account twice does
+ *  nothing. */
+void gnc_balance_grid_add_account (GncBalanceGrid *grid, Account *account);
+
+/** Add a date to the grid.  The dates need not be in order.
+ *
+ *  @return The index of the date, counting from 0 in order of
+ *  addition. */
+guint gnc_balance_grid_add_date (GncBalanceGrid *grid, time64 date);
+
+/** Get the balance of the account, in its own commodity, including
+ *  the splits posted on or before the date with the given index. */
+gnc_numeric gnc_balance_grid_get_balance (GncBalanceGrid *grid,
+        const Account *account, guint date);
+
+/** Get the change of the balance of the account from the date added
+ *  before the given one to the given one, i.e. the total of the splits
+ *  posted in between.  For the first date, this is the balance. */
+gnc_numeric gnc_balance_grid_get_change (GncBalanceGrid *grid,
+        const Account *account, guint date);
+
 /** @} */
 
 /** @name Account Children and Parents.
@@ -990,15 +1027,26 @@ gboolean xaccAccountIsEquityType(GNCAccountType t);
  *    the splits in the account.
  * @note This GList is the account's internal
  *    data structure: do not delete it when done; treat it as a read-only
- *    structure.  Note that some routines (such as xaccAccountRemoveSplit())
- *    modify this list directly, and could leave you with a corrupted
- *    pointer.
- * @note This should be changed so that the returned value is a copy
- * of the list. No other part of the code should have access to the
- * internal data structure used by this object.
+ *    structure.  It is built when first asked for and then kept in step
+ *    with the account's splits.  Note that some routines (such as
+ *    xaccSplitDestroy()) modify this list directly, and could leave you
+ *    with a corrupted pointer if you are walking it at the time.
+ * @note Code that only needs to visit the splits should prefer
+ *    xaccAccountForEachSplit(), which doesn't need the list at all.
  */
 SplitList* xaccAccountGetSplitList (const Account *account);
 
+/** Call @a thunk on each split of the account, in sort order, without
+ *  building a list.  Traversal stops as soon as @a thunk returns a
+ *  non-zero value, which is then returned.  @a thunk may remove the
+ *  split it is passed from the account, but must not otherwise add
+ *  or remove splits in this account.
+ *
+ *  @return 0 if every split was visited, else the value returned by
+ *  the thunk that stopped the traversal. */
+gint xaccAccountForEachSplit (const Account *account, SplitCallback thunk,
+                              gpointer data);
+
 
 /** The xaccAccountCountSplits() routine returns the number of all
  *    the splits in the account.
@@ -45,6 +45,19 @@
 
 /** STRUCTS *********************************************************/
 
+/** One entry of an account's balance index: the running balances
+ *  immediately after a split posted at @a date.  The entries are kept
+ *  in the same order as the account's splits, so the dates are
+ *  non-decreasing and the array can be binary searched.
+ */
+typedef struct
+{
+    time64 date;
+    gnc_numeric balance;
+    gnc_numeric cleared_balance;
+    gnc_numeric reconciled_balance;
+} AccountBalanceEntry;
+
 /** This is the data that describes an account.
  *
  * This is the *private* header for the account structure.
@@ -109,13 +122,41 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
-
-    GList *splits;              /* list of split pointers */
+    /* While balance_dirty is set, the running balances of the splits
+     * before this position in the split array are still correct, and
+     * xaccAccountRecomputeBalance only has to start from here. */
+    guint balance_dirty_from;
+
+    /* The splits are kept in a contiguous array in xaccSplitOrder.
+     * While sort_dirty is set, splits added since the last sort are
+     * appended at the end and also recorded in splits_pending, so that
+     * the front of the array stays sorted and searchable. */
+    GPtrArray *splits;          /* array of split pointers */
+    GHashTable *splits_pending; /* splits appended since the last sort */
     gboolean sort_dirty;        /* sort order of splits is bad */
 
+    /* The GList handed out by xaccAccountGetSplitList.  It is only
+     * built when asked for; from then on splits_nodes holds its nodes
+     * in the order of splits, so that every change to the array is
+     * made to the list in constant time too. */
+    GList *splits_list;
+    GPtrArray *splits_nodes;
+
+    /* Contiguous array of AccountBalanceEntry, one per split, rebuilt
+     * by xaccAccountRecomputeBalance.  Only meaningful while
+     * balance_index_valid is set and balance_dirty is not. */
+    GArray *balance_index;
+    gboolean balance_index_valid;
+
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
+    /* In-memory form of the Bayesian import map kept in the
+     * import-map-bayes frame.  Built on the first Bayesian lookup and
+     * then kept in step by gnc_account_imap_add_account_bayes, so that
+     * a whole import matches against it instead of the KVP tree. */
+    struct imap_bayes_index *imap_bayes;
+
     /* The "mark" flag can be used by the user to mark this account
      * in any way desired.  Handy for specialty traversals of the
      * account tree. */
@@ -135,6 +176,18 @@ void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
+/* Tell the account that one of its splits, or the split's transaction,
+ * has been edited and committed.  If the split's sort position changed
+ * it is moved to its new place, and the running balances are marked
+ * dirty from the split's old or new position, whichever is earlier, so
+ * that only the splits from there on are rebalanced. */
+void gnc_account_split_changed (Account *acc, Split *s);
+
+/* Tell the account that one of its splits is being edited.  The
+ * running balances are marked dirty from the split's position on; the
+ * split isn't moved until it is committed. */
+void gnc_account_split_balance_dirty (Account *acc, Split *s);
+
 /* Structure for accessing static functions for testing */
 typedef struct
 {
@@ -738,10 +738,10 @@ xaccFreeSplit (Split *split)
 
 void mark_split (Split *s)
 {
+    /* The split is moved to its new place in the account when it is
+     * committed, see xaccSplitCommitEdit. */
     if (s->acc)
-    {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
-    }
+        gnc_account_split_balance_dirty (s->acc, s);
 
     /* set dirty flag on lot too. */
     if (s->lot) gnc_lot_set_closed_unknown(s->lot);
@@ -1027,7 +1027,7 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_split_changed(acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1756,6 +1756,8 @@ qofSplitSetReconcile (Split *split, char recn)
         case VREC:
             split->reconciled = recn;
             mark_split (split);
+            if (split->acc)
+                gnc_account_split_changed (split->acc, split);
             xaccAccountRecomputeBalance (split->acc);
             break;
         default:
@@ -1579,6 +1579,20 @@ static void trans_on_error(Transaction *trans, QofBackendError errcode)
     gnc_engine_signal_commit_error( errcode );
 }
 
+/* Has anything that xaccTransOrder looks at changed in this edit? */
+static gboolean
+trans_sort_key_changed (const Transaction *trans)
+{
+    const Transaction *orig = trans->orig;
+
+    if (!orig)
+        return TRUE;
+    return !timespec_equal (&trans->date_posted, &orig->date_posted) ||
+           !timespec_equal (&trans->date_entered, &orig->date_entered) ||
+           g_strcmp0 (trans->num, orig->num) != 0 ||
+           g_strcmp0 (trans->description, orig->description) != 0;
+}
+
 static void trans_cleanup_commit(Transaction *trans)
 {
     GList *slist, *node;
@@ -1593,7 +1607,16 @@ static void trans_cleanup_commit(Transaction *trans)
     {
         Split *s = node->data;
         if (!qof_instance_is_dirty(QOF_INSTANCE(s)))
+        {
+            /* A change to the transaction, its date say, can still
+             * move the split within its account. */
+            if (s->acc && trans_sort_key_changed(trans))
+            {
+                gnc_account_split_changed(s->acc, s);
+                xaccAccountRecomputeBalance(s->acc);
+            }
             continue;
+        }
 
         if ((s->parent != trans) || qof_instance_get_destroying(s))
         {
@@ -1862,6 +1885,18 @@ xaccTransRollbackEdit (Transaction *trans)
 
     /* Put back to zero. */
     qof_instance_decrease_editlevel(trans);
+
+    /* Put the restored splits back in their places in their accounts
+     * and bring the balances back to the restored amounts. */
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        if (s->acc)
+        {
+            gnc_account_split_changed(s->acc, s);
+            xaccAccountRecomputeBalance(s->acc);
+        }
+    }
     /* FIXME: The register code seems to depend on the engine to
        generate an event during rollback, even though the state is just
        reverting to what it was. */
@@ -57,6 +57,15 @@ struct gnc_price_db_s
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
+
+    /* The commodities that prices link each commodity to, and the
+     * intermediate commodities found between pairs of commodities, for
+     * converting balances.  Both are built when needed and cleared when
+     * a pair of commodities gets its first or loses its last price. */
+    GHashTable *conversion_graph;
+    GHashTable *conversion_paths;
+    guint conversion_path_hits;
+    guint conversion_path_misses;
 };
 
 struct _GncPriceDBClass
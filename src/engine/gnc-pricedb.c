@@ -32,14 +32,17 @@
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_PRICE;
 
+typedef struct price_series_s PriceSeries;
+
 static gboolean add_price(GNCPriceDB *db, GNCPrice *p);
 static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
+static void pricedb_clear_conversion_paths(GNCPriceDB *db);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         Timespec t, gboolean sameday);
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
+                            gboolean (*f)(PriceSeries *s, gpointer user_data),
                             gpointer user_data);
 
 enum
@@ -819,15 +822,261 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* price series functions
+
+   A PriceSeries holds the prices of one commodity in one currency in
+   a GPtrArray, sorted in the reverse of the PriceList order: the
+   oldest price comes first and the latest one last.  Prices at a
+   given time are found with a binary search, and new quotes, which
+   are mostly the latest ones, are appended.
+
+   While the database is in bulk update mode prices are appended
+   without checking their order, and the series is sorted the next
+   time it is searched or listed.
+ */
+
+struct price_series_s
+{
+    GPtrArray *prices;
+    gboolean sorted;
+};
+
+static gint
+compare_series_prices (gconstpointer a, gconstpointer b)
+{
+    /* g_ptr_array_sort passes pointers to the elements */
+    return compare_prices_by_date (*(GNCPrice * const *) b,
+                                   *(GNCPrice * const *) a);
+}
+
+static PriceSeries *
+price_series_new (void)
+{
+    PriceSeries *series = g_new0 (PriceSeries, 1);
+
+    series->prices = g_ptr_array_new ();
+    series->sorted = TRUE;
+    return series;
+}
+
+static void
+price_series_destroy (PriceSeries *series)
+{
+    guint i;
+
+    for (i = 0; i < series->prices->len; i++)
+    {
+        GNCPrice *p = g_ptr_array_index (series->prices, i);
+
+        p->db = NULL;
+        gnc_price_unref (p);
+    }
+    g_ptr_array_free (series->prices, TRUE);
+    g_free (series);
+}
+
+static void
+price_series_sort (PriceSeries *series)
+{
+    if (series->sorted) return;
+    g_ptr_array_sort (series->prices, compare_series_prices);
+    series->sorted = TRUE;
+}
+
+static GNCPrice *
+price_series_index (const PriceSeries *series, guint i)
+{
+    if (i >= series->prices->len) return NULL;
+    return g_ptr_array_index (series->prices, i);
+}
+
+/* Returns the index of the first price that is not older than p, which
+ * is where p is or belongs in a sorted series. */
+static guint
+price_series_position (const PriceSeries *series, const GNCPrice *p)
+{
+    guint lo = 0, hi = series->prices->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (compare_prices_by_date (g_ptr_array_index (series->prices, mid), p) > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Returns the index of the first price later than t, or if upper is
+ * FALSE the first one not earlier than t. */
+static guint
+price_series_bound (PriceSeries *series, Timespec t, gboolean upper)
+{
+    guint lo = 0, hi = series->prices->len;
+
+    price_series_sort (series);
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Timespec price_t = gnc_price_get_time (g_ptr_array_index (series->prices, mid));
+        gint cmp = timespec_cmp (&price_t, &t);
+
+        if (cmp < 0 || (upper && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The latest price at or before t, NULL if there is none. */
+static GNCPrice *
+price_series_latest_before (PriceSeries *series, Timespec t)
+{
+    guint pos;
+
+    if (!series) return NULL;
+    pos = price_series_bound (series, t, TRUE);
+    return pos > 0 ? price_series_index (series, pos - 1) : NULL;
+}
+
+/* The earliest price after t, NULL if there is none. */
+static GNCPrice *
+price_series_first_after (PriceSeries *series, Timespec t)
+{
+    if (!series) return NULL;
+    return price_series_index (series, price_series_bound (series, t, TRUE));
+}
+
+static GNCPrice *
+price_series_latest (PriceSeries *series)
+{
+    if (!series || series->prices->len == 0) return NULL;
+    price_series_sort (series);
+    return g_ptr_array_index (series->prices, series->prices->len - 1);
+}
+
+/* Duplicates have the same value on the same day.  Prices on one day
+ * are next to each other, so only the neighbours of pos are checked. */
+static gboolean
+price_series_is_duplicate (const PriceSeries *series, guint pos, GNCPrice *p)
+{
+    PriceListIsDuplStruct dupl = { p, FALSE };
+    Timespec p_day = timespecCanonicalDayTime (gnc_price_get_time (p));
+    guint i;
+
+    for (i = pos; i > 0 && !dupl.isDupl; i--)
+    {
+        GNCPrice *other = g_ptr_array_index (series->prices, i - 1);
+        Timespec day = timespecCanonicalDayTime (gnc_price_get_time (other));
+        if (!timespec_equal (&day, &p_day)) break;
+        price_list_is_duplicate (other, &dupl);
+    }
+    for (i = pos; i < series->prices->len && !dupl.isDupl; i++)
+    {
+        GNCPrice *other = g_ptr_array_index (series->prices, i);
+        Timespec day = timespecCanonicalDayTime (gnc_price_get_time (other));
+        if (!timespec_equal (&day, &p_day)) break;
+        price_list_is_duplicate (other, &dupl);
+    }
+    return dupl.isDupl;
+}
+
+/* Like gnc_price_list_insert, p gets a reference even if it turns out
+ * to be a duplicate and isn't inserted. */
+static void
+price_series_insert (PriceSeries *series, GNCPrice *p, gboolean check_dupl)
+{
+    guint pos;
+
+    gnc_price_ref (p);
+    price_series_sort (series);
+    pos = price_series_position (series, p);
+    if (check_dupl && price_series_is_duplicate (series, pos, p))
+        return;
+
+    if (pos == series->prices->len)
+        g_ptr_array_add (series->prices, p);
+    else
+        g_ptr_array_insert (series->prices, pos, p);
+}
+
+/* The bulk update path: no duplicate check and no search. */
+static void
+price_series_append (PriceSeries *series, GNCPrice *p)
+{
+    GNCPrice *last = price_series_index (series, series->prices->len - 1);
+
+    gnc_price_ref (p);
+    if (last && compare_prices_by_date (p, last) > 0)
+        series->sorted = FALSE;
+    g_ptr_array_add (series->prices, p);
+}
+
+static void
+price_series_remove (PriceSeries *series, GNCPrice *p)
+{
+    if (series->sorted)
+    {
+        guint pos = price_series_position (series, p);
+        if (price_series_index (series, pos) == p)
+        {
+            g_ptr_array_remove_index (series->prices, pos);
+            gnc_price_unref (p);
+            return;
+        }
+    }
+    if (g_ptr_array_remove (series->prices, p))
+        gnc_price_unref (p);
+}
+
+/* Returns the prices as a PriceList, without taking references. */
+static PriceList *
+price_series_to_list (PriceSeries *series)
+{
+    PriceList *result = NULL;
+    guint i;
+
+    price_series_sort (series);
+    for (i = 0; i < series->prices->len; i++)
+        result = g_list_prepend (result, g_ptr_array_index (series->prices, i));
+    return result;
+}
+
+/* The newer and the older of two prices in PriceList order, either of
+ * which may be NULL. */
+static GNCPrice *
+price_newer (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) <= 0 ? a : b;
+}
+
+static GNCPrice *
+price_older (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) > 0 ? a : b;
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
-   you want the prices for, and the second level key is the commodity
-   that the value is expressed in terms of.
+   type gnc_commodity*) to PriceSeries (see above).  The top-level key
+   is the commodity you want the prices for, and the second level key
+   is the commodity that the value is expressed in terms of.
+
+   A price of a commodity in a currency is also a price of the
+   currency in the commodity.  Lookups for a pair of commodities
+   therefore search the series in both directions and take the best
+   match of the two, which gives the same result as searching the
+   merged PriceList.
  */
 
 /* GObject Initialization */
@@ -878,6 +1127,12 @@ gnc_pricedb_create(QofBook * book)
 
     result->commodity_hash = g_hash_table_new(NULL, NULL);
     g_return_val_if_fail (result->commodity_hash, NULL);
+    result->conversion_graph =
+        g_hash_table_new_full(NULL, NULL, NULL,
+                              (GDestroyNotify) g_hash_table_destroy);
+    result->conversion_paths =
+        g_hash_table_new_full(NULL, NULL, NULL,
+                              (GDestroyNotify) g_hash_table_destroy);
     return result;
 }
 
@@ -886,18 +1141,7 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
-
-    for (node = price_list; node; node = node->next)
-    {
-        p = node->data;
-
-        p->db = NULL;
-    }
-
-    gnc_price_list_destroy(price_list);
+    price_series_destroy ((PriceSeries *) data);
 }
 
 static void
@@ -925,6 +1169,10 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    g_hash_table_destroy (db->conversion_graph);
+    db->conversion_graph = NULL;
+    g_hash_table_destroy (db->conversion_paths);
+    db->conversion_paths = NULL;
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -1007,7 +1255,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = price_series_to_list (val);
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -1017,6 +1265,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
     if (!gnc_price_list_equal (price_list1, price_list2))
         equal_data->equal = FALSE;
 
+    g_list_free (price_list1);
     gnc_price_list_destroy (price_list2);
 }
 
@@ -1066,7 +1315,7 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    PriceSeries *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1105,19 +1354,22 @@ add_price(GNCPriceDB *db, GNCPrice *p)
     }
 /* Check for an existing price on the same day. If there is no existing price,
  * add this one. If this price is of equal or better precedence than the old
- * one, copy this one over the old one.
+ * one, copy this one over the old one.  A bulk update doesn't check.
  */
-    old_price = gnc_pricedb_lookup_day (db, p->commodity, p->currency,
-                                        p->tmspec);
-    if (!db->bulk_update && old_price != NULL)
+    if (!db->bulk_update)
     {
-        if (p->source > old_price->source)
+        old_price = gnc_pricedb_lookup_day (db, p->commodity, p->currency,
+                                            p->tmspec);
+        if (old_price != NULL)
         {
-            gnc_price_unref(p);
-            LEAVE ("Better price already in DB.");
-            return FALSE;
+            if (p->source > old_price->source)
+            {
+                gnc_price_unref(p);
+                LEAVE ("Better price already in DB.");
+                return FALSE;
+            }
+            gnc_pricedb_remove_price(db, old_price);
         }
-        gnc_pricedb_remove_price(db, old_price);
     }
 
     currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
@@ -1127,20 +1379,18 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
     {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
+        series = price_series_new();
+        g_hash_table_insert(currency_hash, currency, series);
+        pricedb_clear_conversion_paths(db);
     }
 
-    if (!price_list)
-    {
-        LEAVE (" no price list");
-        return FALSE;
-    }
-
-    g_hash_table_insert(currency_hash, currency, price_list);
+    if (db->bulk_update)
+        price_series_append(series, p);
+    else
+        price_series_insert(series, p, TRUE);
     p->db = db;
 
     qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
@@ -1191,7 +1441,7 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    PriceSeries *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1227,24 +1477,22 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
     {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
+        LEAVE (" no price series");
+        return TRUE;
     }
+    gnc_price_ref(p);
+    price_series_remove(series, p);
 
-    /* if the price list is empty, then remove this currency from the
+    /* if the price series is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (series->prices->len == 0)
     {
         g_hash_table_remove(currency_hash, currency);
+        price_series_destroy(series);
+        pricedb_clear_conversion_paths(db);
 
         if (cleanup)
         {
@@ -1339,18 +1587,21 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    PriceSeries *series = (PriceSeries *) val;
     remove_info *data = (remove_info *) user_data;
+    guint i;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* The most recent price is the first in the list */
-    if (!data->delete_last)
-        node = g_list_next(node);
+    /* The most recent price is the last in the series */
+    price_series_sort(series);
+    i = series->prices->len;
+    if (!data->delete_last && i > 0)
+        i--;
 
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* now check each item in the series, latest first */
+    while (i > 0)
+        check_one_price_date(g_ptr_array_index(series->prices, --i), data);
 
     LEAVE(" ");
 }
@@ -1420,30 +1671,33 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
+    GList *prices = price_series_to_list (value);
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, value);
+        new_l = pricedb_price_list_merge(*l, prices);
         g_list_free (*l);
+        g_list_free (prices);
         *l = new_l;
     }
     else
-        *l = g_list_copy (value);
+        *l = prices;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = NULL, *result = NULL ;
+    PriceSeries *series;
+    GList *result = NULL;
     if (currency)
     {
-        price_list = g_hash_table_lookup(hash, currency);
-        if (!price_list)
+        series = g_hash_table_lookup(hash, currency);
+        if (!series)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = price_series_to_list (series);
     }
     else
     {
@@ -1532,44 +1786,37 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     return forward_list;
 }
 
+static PriceSeries *
+pricedb_get_series(GNCPriceDB *db, const gnc_commodity *commodity,
+                   const gnc_commodity *currency)
+{
+    GHashTable *currency_hash;
+
+    currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
+    if (!currency_hash) return NULL;
+    return g_hash_table_lookup(currency_hash, currency);
+}
+
 GNCPrice *
 gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
     GNCPrice *result;
-    GHashTable *currency_hash;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+    /* The latest price is the last one of either series. */
+    result = price_newer(price_series_latest(pricedb_get_series(db, commodity,
+                                                                currency)),
+                         price_series_latest(pricedb_get_series(db, currency,
+                                                                commodity)));
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE(" ");
     return result;
 }
 
-
-static void
-lookup_latest(gpointer key, gpointer val, gpointer user_data)
-{
-    //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
-    GList **return_list = (GList **)user_data;
-
-    if (!price_list) return;
-
-    /* the latest price is the first in list */
-    gnc_price_list_insert(return_list, price_list->data, FALSE);
-}
-
 typedef struct
 {
     GList **list;
@@ -1581,60 +1828,58 @@ typedef struct
  * pricedb_pricelist_traversal by the "any_currency" price lookup functions. It
  * builds a list of prices that are either to or from the commodity "com".
  * The resulting list will include the last price newer than "t" and the first
- * price older than "t".  All other prices will be ignored.  Since in the most
- * common cases we will be looking for recent prices which are at the front of
- * the various price lists, this is considerably faster than concatenating all
- * the relevant price lists and sorting the result.
+ * price older than "t".  All other prices will be ignored.  The two are found
+ * with a binary search of each price series, so this is considerably faster
+ * than concatenating all the relevant price lists and sorting the result.
 */
 
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_list_scan_any_currency(PriceSeries *series, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
+    GNCPrice *first;
     gnc_commodity *com;
     gnc_commodity *cur;
+    guint pos;
 
-    if (!price_list)
+    /* Appended prices may not be in place yet; the earliest is wanted. */
+    price_series_sort(series);
+    first = price_series_index(series, 0);
+    if (!first)
         return TRUE;
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
+    com = gnc_price_get_commodity(first);
+    cur = gnc_price_get_currency(first);
 
-    /* if this price list isn't for the commodity we are interested in,
+    /* if this price series isn't for the commodity we are interested in,
        ignore it. */
     if (com != helper->com && cur != helper->com)
         return TRUE;
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    while (node != NULL)
+    /* The series is sorted in increasing order of time.  Find the last
+       price in it that is older than the requested time and add it and the
+       next price to the result list. */
+    pos = price_series_bound(series, helper->t, FALSE);
+    if (pos > 0)
     {
-        GNCPrice *price = node->data;
-        Timespec price_t = gnc_price_get_time(price);
-        if (timespec_cmp(&price_t, &helper->t) < 0)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == NULL)
+        GNCPrice *price = g_ptr_array_index(series->prices, pos - 1);
+        GNCPrice *next_price = price_series_index(series, pos);
+
+        /* If there is a next price add it to the results. */
+        if (next_price)
         {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
+            gnc_price_ref(next_price);
+            *helper->list = g_list_prepend(*helper->list, next_price);
         }
-        node = node->next;
+        /* Add the last price before the desired time */
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
+    }
+    else
+    {
+        /* The first price is later than given time, add it */
+        gnc_price_ref(first);
+        *helper->list = g_list_prepend(*helper->list, first);
     }
 
     return TRUE;
@@ -1840,7 +2085,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    PriceSeries *series;
     GHashTable *currency_hash;
     gint size;
 
@@ -1855,8 +2100,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        series = g_hash_table_lookup(currency_hash, currency);
+        if (series)
         {
             LEAVE("yes");
             return TRUE;
@@ -1900,9 +2145,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     int *result = data;
-    GList *price_list = value;
+    PriceSeries *series = value;
 
-    *result += g_list_length(price_list);
+    *result += series->prices->len;
 }
 
 int
@@ -1951,60 +2196,70 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
             g_hash_table_iter_init(&iter, currency_hash);
             if (g_hash_table_iter_next(&iter, &key, &value))
             {
-                PriceList *prices = value;
-                result = g_list_nth_data(prices, n);
+                PriceSeries *series = value;
+                price_series_sort(series);
+                if ((guint)n < series->prices->len)
+                    result = g_ptr_array_index(series->prices,
+                                               series->prices->len - 1 - n);
             }
         }
         else if (num_currencies > 1)
         {
             /* Prices for multiple currencies, must find the nth entry in the
                merged currency list. */
-            GList **price_array = (GList **)g_new(gpointer, num_currencies);
-            GList **next_list;
-            int i, j;
+            PriceSeries **series_array = g_new(PriceSeries *, num_currencies);
+            guint *remaining = g_new(guint, num_currencies);
+            int i, j, next;
             GHashTableIter iter;
             gpointer key, value;
 
-            /* Build an array of all the currencies this commodity has prices for */
+            /* Build an array of all the currencies this commodity has prices
+               for, with the number of their prices not yet passed */
             for (i = 0, g_hash_table_iter_init(&iter, currency_hash);
                  g_hash_table_iter_next(&iter, &key, &value) && i < num_currencies;
                  i++)
             {
-                price_array[i] = value;
+                series_array[i] = value;
+                price_series_sort(series_array[i]);
+                remaining[i] = series_array[i]->prices->len;
             }
 
             /* Iterate n times to get the nth price, each time finding the currency
                with the latest price */
             for (i = 0; i <= n; i++)
             {
-                next_list = NULL;
+                next = -1;
                 for (j = 0; j < num_currencies; j++)
                 {
                     /* Save this entry if it's the first one or later than
                        the saved one. */
-                    if (price_array[j] != NULL &&
-                        (next_list == NULL || *next_list == NULL ||
-                        compare_prices_by_date((*next_list)->data, (price_array[j])->data) > 0))
+                    if (remaining[j] > 0 &&
+                        (next < 0 ||
+                         compare_prices_by_date(g_ptr_array_index(series_array[next]->prices,
+                                                                  remaining[next] - 1),
+                                                g_ptr_array_index(series_array[j]->prices,
+                                                                  remaining[j] - 1)) > 0))
                     {
-                        next_list = &price_array[j];
+                        next = j;
                     }
                 }
-                /* next_list points to the list with the latest price unless all
-                   the lists are empty */
-                if (next_list && *next_list)
+                /* next is the series with the latest price unless all
+                   the series are passed */
+                if (next >= 0)
                 {
-                    result = (*next_list)->data;
-                    *next_list = (*next_list)->next;
+                    result = g_ptr_array_index(series_array[next]->prices,
+                                               --remaining[next]);
                 }
                 else
                 {
-                    /* all the lists are empty, "n" is greater than the number
-                       of prices for this commodity. */
+                    /* all the series are passed, "n" is greater than the
+                       number of prices for this commodity. */
                     result = NULL;
                     break;
                 }
             }
-            g_free(price_array);
+            g_free(remaining);
+            g_free(series_array);
         }
     }
 
@@ -2027,29 +2282,29 @@ gnc_pricedb_lookup_at_time(GNCPriceDB *db,
                            const gnc_commodity *currency,
                            Timespec t)
 {
-    GList *price_list;
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    GNCPrice *forward, *inverse;
+    Timespec price_time;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    forward = price_series_latest_before (pricedb_get_series (db, c, currency), t);
+    if (forward)
     {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_equal(&price_time, &t))
-        {
-            gnc_price_ref(p);
-            g_list_free (price_list);
-            return p;
-        }
-        item = item->next;
+        price_time = gnc_price_get_time (forward);
+        if (!timespec_equal (&price_time, &t))
+            forward = NULL;
     }
-    g_list_free (price_list);
+    inverse = price_series_latest_before (pricedb_get_series (db, currency, c), t);
+    if (inverse)
+    {
+        price_time = gnc_price_get_time (inverse);
+        if (!timespec_equal (&price_time, &t))
+            inverse = NULL;
+    }
+    forward = price_newer (forward, inverse);
+    gnc_price_ref (forward);
     LEAVE (" ");
-    return NULL;
+    return forward;
 }
 
 static GNCPrice *
@@ -2059,36 +2314,27 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        Timespec t,
                        gboolean sameday)
 {
-    GList *price_list;
+    PriceSeries *forward, *inverse;
     GNCPrice *current_price = NULL;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_cmp(&price_time, &t) <= 0)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
-    }
+    forward = pricedb_get_series (db, c, currency);
+    inverse = pricedb_get_series (db, currency, c);
+    if (!forward && !inverse) return NULL;
+
+    /* next_price is the latest price at or before t, and current_price
+       the earliest one after it.  If there is none after t, the answer
+       is next_price, and if there is none before t, the earliest price
+       there is. */
+    next_price = price_newer (price_series_latest_before (forward, t),
+                              price_series_latest_before (inverse, t));
+    current_price = price_older (price_series_first_after (forward, t),
+                                 price_series_first_after (inverse, t));
+    if (!current_price)
+        current_price = next_price;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2160,7 +2406,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2180,29 +2425,14 @@ gnc_pricedb_lookup_latest_before (GNCPriceDB *db,
                                   gnc_commodity *currency,
                                   Timespec t)
 {
-    GList *price_list;
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    GHashTable *currency_hash;
-    Timespec price_time;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time (item->data);
-        if (timespec_cmp(&price_time, &t) <= 0)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (timespec_cmp(&price_time, &t) > 0 && item);
+    current_price =
+        price_newer (price_series_latest_before (pricedb_get_series (db, c, currency), t),
+                     price_series_latest_before (pricedb_get_series (db, currency, c), t));
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
@@ -2243,43 +2473,117 @@ typedef struct
     GNCPrice *to;
 } PriceTuple;
 
-static PriceTuple
-extract_common_prices (PriceList *from_prices, PriceList *to_prices)
+/* ==================================================================== */
+/* commodity conversion graph
+
+   A balance with no price between its commodity and the one it is
+   converted to is converted through an intermediate commodity with
+   prices for both.  The conversion graph maps each commodity to the
+   set of commodities it has prices with, in either direction, and the
+   conversion paths map pairs of commodities to the intermediates
+   between them.  Which of these is used depends on the prices around
+   the date of the conversion and is decided for each conversion.
+ */
+
+static void
+pricedb_clear_conversion_paths(GNCPriceDB *db)
 {
-    PriceTuple retval = {NULL, NULL};
-    GList *from_node = NULL, *to_node = NULL;
-    GNCPrice *from_price, *to_price;
+    g_hash_table_remove_all(db->conversion_graph);
+    g_hash_table_remove_all(db->conversion_paths);
+}
 
-    for (from_node = from_prices; from_node != NULL;
-         from_node = g_list_next(from_node))
+static void
+conversion_graph_link(GHashTable *graph, gnc_commodity *a, gnc_commodity *b)
+{
+    GHashTable *links = g_hash_table_lookup(graph, a);
+
+    if (!links)
     {
-        for (to_node = to_prices; to_node != NULL;
-             to_node = g_list_next(to_node))
+        links = g_hash_table_new(NULL, NULL);
+        g_hash_table_insert(graph, a, links);
+    }
+    g_hash_table_add(links, b);
+}
+
+static void
+pricedb_build_conversion_graph(GNCPriceDB *db)
+{
+    GHashTableIter commodity_iter, currency_iter;
+    gpointer commodity, currency_hash, currency;
+
+    g_hash_table_iter_init(&commodity_iter, db->commodity_hash);
+    while (g_hash_table_iter_next(&commodity_iter, &commodity, &currency_hash))
+    {
+        g_hash_table_iter_init(&currency_iter, currency_hash);
+        while (g_hash_table_iter_next(&currency_iter, &currency, NULL))
         {
-            gnc_commodity *to_com, *to_cur;
-            gnc_commodity *from_com, *from_cur;
-            to_price = GNC_PRICE(to_node->data);
-            from_price = GNC_PRICE(from_node->data);
-            to_com = gnc_price_get_commodity (to_price);
-            to_cur = gnc_price_get_currency (to_price);
-            from_com = gnc_price_get_commodity (from_price);
-            from_cur = gnc_price_get_currency (from_price);
-            if (to_com == from_com || to_com == from_cur ||
-                to_cur == from_com || to_cur == from_cur)
-                break;
-            to_price = NULL;
-            from_price = NULL;
+            conversion_graph_link(db->conversion_graph, commodity, currency);
+            conversion_graph_link(db->conversion_graph, currency, commodity);
         }
-        if (to_price != NULL && from_price != NULL)
-            break;
     }
-    if (from_price == NULL || to_price == NULL)
-        return retval;
-    gnc_price_ref(from_price);
-    gnc_price_ref(to_price);
-    retval.from = from_price;
-    retval.to = to_price;
-    return retval;
+}
+
+/* Returns the commodities with prices for both from and to.  The array
+ * belongs to the cache, which is cleared when a pair of commodities gets
+ * its first or loses its last price. */
+static GPtrArray *
+pricedb_conversion_path(GNCPriceDB *db, const gnc_commodity *from,
+                        const gnc_commodity *to)
+{
+    GHashTable *paths, *from_links, *to_links;
+    GPtrArray *path;
+    GHashTableIter iter;
+    gpointer via;
+
+    paths = g_hash_table_lookup(db->conversion_paths, from);
+    if (!paths)
+    {
+        paths = g_hash_table_new_full(NULL, NULL, NULL,
+                                      (GDestroyNotify) g_ptr_array_unref);
+        g_hash_table_insert(db->conversion_paths, (gpointer) from, paths);
+    }
+    path = g_hash_table_lookup(paths, to);
+    if (path)
+    {
+        db->conversion_path_hits++;
+        return path;
+    }
+    db->conversion_path_misses++;
+
+    if (g_hash_table_size(db->conversion_graph) == 0)
+        pricedb_build_conversion_graph(db);
+
+    path = g_ptr_array_new();
+    from_links = g_hash_table_lookup(db->conversion_graph, from);
+    to_links = g_hash_table_lookup(db->conversion_graph, to);
+    if (from_links && to_links)
+    {
+        g_hash_table_iter_init(&iter, from_links);
+        while (g_hash_table_iter_next(&iter, &via, NULL))
+            if (g_hash_table_contains(to_links, via))
+                g_ptr_array_add(path, via);
+    }
+    g_hash_table_insert(paths, (gpointer) to, path);
+    return path;
+}
+
+void
+gnc_pricedb_get_conversion_path_stats(GNCPriceDB *db, guint *hits,
+                                      guint *misses)
+{
+    if (hits) *hits = db ? db->conversion_path_hits : 0;
+    if (misses) *misses = db ? db->conversion_path_misses : 0;
+}
+
+/* The price between c and via to convert with, the one nearest to t or
+ * the latest one if t is NULL. */
+static GNCPrice *
+conversion_price(GNCPriceDB *db, const gnc_commodity *c,
+                 gnc_commodity *via, Timespec *t, Timespec now)
+{
+    if (t != NULL)
+        return gnc_pricedb_lookup_nearest_in_time(db, c, via, *t);
+    return gnc_pricedb_lookup_latest_before(db, (gnc_commodity *) c, via, now);
 }
 
 static gnc_numeric
@@ -2317,37 +2621,52 @@ indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
                              const gnc_commodity *from, const gnc_commodity *to,
                              Timespec *t )
 {
-    GList *from_prices = NULL, *to_prices = NULL;
-    PriceTuple tuple;
-    gnc_numeric zero = gnc_numeric_zero();
+    PriceTuple tuple = {NULL, NULL};
+    gnc_numeric result = gnc_numeric_zero();
+    Timespec now = timespec_now();
+    GPtrArray *path;
+    guint i;
+
     if (from == NULL || to == NULL)
-        return zero;
+        return result;
     if (gnc_numeric_zero_p(bal))
-        return zero;
-    if (t == NULL)
+        return result;
+
+    /* Use the intermediate commodity with the latest price for "from"
+       that also has a price for "to". */
+    path = pricedb_conversion_path(db, from, to);
+    for (i = 0; i < path->len; i++)
     {
-        from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
-        /* "to" is often the book currency which may have lots of prices,
-            so avoid getting them if they aren't needed. */
-        if (from_prices)
-            to_prices = gnc_pricedb_lookup_latest_any_currency(db, to);
+        gnc_commodity *via = g_ptr_array_index(path, i);
+        GNCPrice *from_price, *to_price;
+
+        from_price = conversion_price(db, from, via, t, now);
+        if (from_price == NULL)
+            continue;
+        if (tuple.from &&
+            compare_prices_by_date(from_price, tuple.from) >= 0)
+        {
+            gnc_price_unref(from_price);
+            continue;
+        }
+        to_price = conversion_price(db, to, via, t, now);
+        if (to_price == NULL)
+        {
+            gnc_price_unref(from_price);
+            continue;
+        }
+        gnc_price_unref(tuple.from);
+        gnc_price_unref(tuple.to);
+        tuple.from = from_price;
+        tuple.to = to_price;
     }
-    else
-    {
-        from_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
-                                                                      from, *t);
-        if (from_prices)
-            to_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
-                                                                    to, *t);
-    }
-    if (from_prices == NULL || to_prices == NULL)
-        return zero;
-    tuple = extract_common_prices(from_prices, to_prices);
-    gnc_price_list_destroy(from_prices);
-    gnc_price_list_destroy(to_prices);
     if (tuple.from)
-        return convert_balance(bal, from, to, tuple);
-    return zero;
+    {
+        result = convert_balance(bal, from, to, tuple);
+        gnc_price_unref(tuple.from);
+        gnc_price_unref(tuple.to);
+    }
+    return result;
 }
 
 
@@ -2422,16 +2741,15 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    PriceSeries *series = (PriceSeries *) val;
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
+    guint i;
 
     /* stop traversal when func returns FALSE */
-    while (foreach_data->ok && node)
+    for (i = 0; foreach_data->ok && i < series->prices->len; i++)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index(series->prices, i);
         foreach_data->ok = foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -2468,18 +2786,18 @@ unstable_price_traversal(GNCPriceDB *db,
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(PriceSeries *s, gpointer user_data);
     gpointer user_data;
 } GNCPriceListForeachData;
 
 static void
 pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    PriceSeries *series = (PriceSeries *) val;
     GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(series, foreach_data->user_data);
     }
 }
 
@@ -2492,7 +2810,7 @@ pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer u
 
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+                         gboolean (*f)(PriceSeries *s, gpointer user_data),
                          gpointer user_data)
 {
     GNCPriceListForeachData foreach_data;
@@ -2564,12 +2882,14 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             HashEntry *pricelist_entry = (HashEntry *) j->data;
-            GList *price_list = (GList *) pricelist_entry->value;
-            GList *node;
+            PriceSeries *series = (PriceSeries *) pricelist_entry->value;
+            guint k;
 
-            for (node = (GList *) price_list; node; node = node->next)
+            /* latest first, in PriceList order */
+            price_series_sort(series);
+            for (k = series->prices->len; k > 0; k--)
             {
-                GNCPrice *price = (GNCPrice *) node->data;
+                GNCPrice *price = g_ptr_array_index(series->prices, k - 1);
 
                 /* stop traversal when f returns FALSE */
                 if (FALSE == ok) break;
@@ -2789,15 +3109,14 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    PriceSeries *series = (PriceSeries *) val;
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
+    guint i;
 
-    while (node)
+    for (i = 0; i < series->prices->len; i++)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index(series->prices, i);
         foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -568,6 +568,16 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
                                           const gnc_commodity *new_currency,
                                           Timespec t);
 
+/** @brief Get the statistics of the cache of intermediate commodities used
+ * by the balance conversions when there is no direct price between two
+ * commodities.
+ * @param pdb The pricedb
+ * @param hits Returns the number of lookups answered from the cache
+ * @param misses Returns the number of lookups that had to search the prices
+ */
+void gnc_pricedb_get_conversion_path_stats(GNCPriceDB *pdb, guint *hits,
+                                           guint *misses);
+
 typedef gboolean (*GncPriceForeachFunc)(GNCPrice *p, gpointer user_data);
 
 /** @brief Call a GncPriceForeachFunction once for each price in db, until the
@@ -606,6 +606,17 @@ void gncInvoiceSetPostedTxn (GncInvoice *invoice, Transaction *txn)
     gncInvoiceCommitEdit (invoice);
 }
 
+void gncInvoiceResetPostedTxn (GncInvoice *invoice, Transaction *txn)
+{
+    if (!invoice) return;
+    g_return_if_fail (invoice->posted_txn != NULL);
+
+    gncInvoiceBeginEdit (invoice);
+    invoice->posted_txn = txn;
+    mark_invoice (invoice);
+    gncInvoiceCommitEdit (invoice);
+}
+
 void gncInvoiceSetPostedLot (GncInvoice *invoice, GNCLot *lot)
 {
     if (!invoice) return;
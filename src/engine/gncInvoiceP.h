@@ -38,6 +38,9 @@ gboolean gncInvoiceRegister (void);
 gchar *gncInvoiceNextID (QofBook *book, const GncOwner *owner);
 void gncInvoiceSetPostedAcc (GncInvoice *invoice, Account *acc);
 void gncInvoiceSetPostedTxn (GncInvoice *invoice, Transaction *txn);
+/* Point a posted invoice at the transaction that replaced its posted
+ * transaction, as when a backend reads a newer copy of it back in. */
+void gncInvoiceResetPostedTxn (GncInvoice *invoice, Transaction *txn);
 void gncInvoiceSetPostedLot (GncInvoice *invoice, GNCLot *lot);
 //void gncInvoiceSetPaidTxn (GncInvoice *invoice, Transaction *txn);
 
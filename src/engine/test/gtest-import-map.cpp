@@ -30,6 +30,9 @@ extern "C"
 
 #include <kvp_frame.hpp>
 #include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
 
 class ImapTest : public testing::Test
 {
@@ -270,6 +273,162 @@ TEST_F(ImapBayesTest, FindAccountBayes)
     EXPECT_EQ(nullptr, account);
 }
 
+TEST_F(ImapBayesTest, FindAccountBayesAfterAdd)
+{
+    gnc_account_imap_add_account_bayes(t_imap, t_list1, t_expense_account1);
+    EXPECT_EQ(t_expense_account1,
+              gnc_account_imap_find_account_bayes(t_imap, t_list1));
+    EXPECT_EQ(nullptr, gnc_account_imap_find_account_bayes(t_imap, t_list5));
+
+    // The lookups above indexed the map; adding has to update the index too.
+    for (int i = 0; i < 4; ++i)
+        gnc_account_imap_add_account_bayes(t_imap, t_list1, t_expense_account2);
+    EXPECT_EQ(t_expense_account2,
+              gnc_account_imap_find_account_bayes(t_imap, t_list1));
+
+    // And deleting an entry has to be noticed: with only bar left at 4:1
+    // the match falls below the threshold.
+    gnc_account_delete_map_entry(t_bank_account,
+                                 g_strdup_printf("%s/%s", IMAP_FRAME_BAYES, foo),
+                                 FALSE);
+    EXPECT_EQ(nullptr, gnc_account_imap_find_account_bayes(t_imap, t_list1));
+}
+
+/* The KVP walk that gnc_account_imap_find_account_bayes did before the
+ * map was indexed, to check the index against. */
+static Account*
+find_account_bayes_by_walk (GncImportMatchMap *imap, GList *tokens)
+{
+    auto root = qof_instance_get_slots(QOF_INSTANCE(imap->acc));
+    std::map<std::string, std::pair<double, double>> running;
+
+    for (auto node = tokens; node; node = node->next)
+    {
+        auto value = root->get_slot({IMAP_FRAME_BAYES,
+                                     static_cast<char*>(node->data)});
+        if (!value || value->get_type() != KvpValue::Type::FRAME)
+            continue;
+        auto frame = value->get<KvpFrame*>();
+        int64_t total = 0;
+        for (auto key : frame->get_keys())
+            total += frame->get_slot(key.c_str())->get<int64_t>();
+        for (auto key : frame->get_keys())
+        {
+            auto p = static_cast<double>(frame->get_slot(key.c_str())->get<int64_t>()) / total;
+            auto entry = running.find(key);
+            if (entry == running.end())
+                running[key] = {p, 1 - p};
+            else
+            {
+                entry->second.first *= p;
+                entry->second.second *= 1 - p;
+            }
+        }
+    }
+
+    std::string best_key;
+    int32_t best_probability = 0;
+    for (auto entry : running)
+    {
+        int32_t probability = (entry.second.first /
+                               (entry.second.first + entry.second.second))
+                              * 100000;
+        if (probability > best_probability)
+        {
+            best_probability = probability;
+            best_key = entry.first;
+        }
+    }
+    if (best_probability < .90 * 100000)
+        return nullptr;
+
+    GncGUID guid;
+    if (!string_to_guid(best_key.c_str(), &guid))
+        return nullptr;
+    return xaccAccountLookup(&guid, imap->book);
+}
+
+TEST_F(ImapBayesTest, FindAccountBayesSameAsWalk)
+{
+    Account* accounts[] = {t_expense_account1, t_expense_account2,
+                           t_sav_account, t_asset_account1};
+    const char* tokens[] = {foo, bar, baz, waldo, pepper, salt, pork, sausage};
+    std::vector<GList*> lists;
+
+    /* Each token goes mostly to one account and once to the next one */
+    for (int i = 0; i < 8; ++i)
+    {
+        auto list = g_list_prepend(nullptr, const_cast<char*>(tokens[i]));
+        for (int j = 0; j < 3 * (i + 3); ++j)
+            gnc_account_imap_add_account_bayes(t_imap, list, accounts[i % 4]);
+        gnc_account_imap_add_account_bayes(t_imap, list,
+                                           accounts[(i + 1) % 4]);
+        lists.push_back(list);
+    }
+    for (int i = 0; i < 7; ++i)
+        lists.push_back(g_list_append(g_list_copy(lists[i]),
+                                      const_cast<char*>(tokens[i + 1])));
+    for (int i = 0; i < 4; ++i)
+        lists.push_back(g_list_append(g_list_copy(lists[i]),
+                                      const_cast<char*>(tokens[i + 4])));
+    lists.push_back(g_list_append(nullptr, const_cast<char*>("unknown")));
+
+    auto matched = 0;
+    for (auto list : lists)
+    {
+        auto expected = find_account_bayes_by_walk(t_imap, list);
+        EXPECT_EQ(expected, gnc_account_imap_find_account_bayes(t_imap, list));
+        if (expected)
+            ++matched;
+    }
+    EXPECT_LT(0, matched);
+
+    /* The index has to follow later additions as well */
+    for (int j = 0; j < 40; ++j)
+        gnc_account_imap_add_account_bayes(t_imap, lists[0], accounts[1]);
+    for (auto list : lists)
+        EXPECT_EQ(find_account_bayes_by_walk(t_imap, list),
+                  gnc_account_imap_find_account_bayes(t_imap, list));
+
+    for (auto list : lists)
+        g_list_free(list);
+}
+
+/* The map can also change without going through the import map
+ * functions, as when a backend loads it or undo puts it back.  Committing
+ * the account has to make the next lookup see the change. */
+TEST_F(ImapBayesTest, FindAccountBayesAfterKvpChange)
+{
+    gnc_account_imap_add_account_bayes(t_imap, t_list1, t_expense_account1);
+    EXPECT_EQ(t_expense_account1,
+              gnc_account_imap_find_account_bayes(t_imap, t_list1));
+
+    auto acct2_guid = guid_to_string(xaccAccountGetGUID(t_expense_account2));
+    auto foo_path = g_strdup_printf("%s/%s/%s", IMAP_FRAME_BAYES, foo, acct2_guid);
+    auto bar_path = g_strdup_printf("%s/%s/%s", IMAP_FRAME_BAYES, bar, acct2_guid);
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, G_TYPE_INT64);
+    g_value_set_int64(&value, 100);
+    xaccAccountBeginEdit(t_bank_account);
+    qof_instance_set_kvp(QOF_INSTANCE(t_bank_account), foo_path, &value);
+    qof_instance_set_kvp(QOF_INSTANCE(t_bank_account), bar_path, &value);
+    xaccAccountCommitEdit(t_bank_account);
+    EXPECT_EQ(t_expense_account2,
+              gnc_account_imap_find_account_bayes(t_imap, t_list1));
+
+    // Replacing the whole frame is noticed as well
+    xaccAccountBeginEdit(t_bank_account);
+    auto root = qof_instance_get_slots(QOF_INSTANCE(t_bank_account));
+    delete root->set(IMAP_FRAME_BAYES, nullptr);
+    xaccAccountCommitEdit(t_bank_account);
+    EXPECT_EQ(nullptr, gnc_account_imap_find_account_bayes(t_imap, t_list1));
+
+    g_value_unset(&value);
+    g_free(foo_path);
+    g_free(bar_path);
+    g_free(acct2_guid);
+}
+
 TEST_F(ImapBayesTest, AddAccountBayes)
 {
     // prevent the embedded beginedit/committedit from doing anything
@@ -0,0 +1,147 @@
+/********************************************************************
+ * test-account-splits-perf.cpp: Time loading and balancing a large *
+ * synthetic book.                                                  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+/* Not run as part of make check: this is a benchmark.  It builds a
+ * book of random accounts, then adds transactions to it the way the
+ * backends do during a load (all accounts open for editing, so the
+ * splits are appended and sorted once on commit), and finally forces
+ * every account to recompute its running balances.
+ *
+ * Usage: test-account-splits-perf [number-of-splits]
+ * The default is one million splits.
+ */
+extern "C"
+{
+#include "config.h"
+#include <stdlib.h>
+#include <glib.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "TransLog.h"
+#include "Transaction.h"
+#include "gnc-engine.h"
+#include "test-engine-stuff.h"
+#include "test-stuff.h"
+}
+
+#include <vector>
+
+static const guint num_accounts = 100;
+static const gint64 twenty_years = 20 * 365 * 24 * 3600LL;
+
+static double
+seconds_since (gint64 start)
+{
+    return (g_get_monotonic_time () - start) / 1000000.0;
+}
+
+static void
+run_test (guint num_splits)
+{
+    QofSession *session = qof_session_new ();
+    QofBook *book = qof_session_get_book (session);
+    auto currency = get_random_commodity (book);
+    std::vector<Account*> accounts;
+    gint64 start;
+    time64 now = gnc_time (NULL);
+
+    for (guint i = 0; i < num_accounts; i++)
+    {
+        auto acc = get_random_account (book);
+        xaccAccountBeginEdit (acc);
+        xaccAccountSetCommodity (acc, currency);
+        accounts.push_back (acc);
+    }
+
+    start = g_get_monotonic_time ();
+    for (guint i = 0; i < num_splits / 2; i++)
+    {
+        auto trans = xaccMallocTransaction (book);
+        auto amount = gnc_numeric_create (g_random_int_range (1, 1000000), 100);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, currency);
+        xaccTransSetDatePostedSecs (trans, now - g_random_int_range (0, G_MAXINT32)
+                                    % twenty_years);
+        for (int j = 0; j < 2; j++)
+        {
+            auto split = xaccMallocSplit (book);
+            xaccSplitSetParent (split, trans);
+            xaccSplitSetAccount (split, accounts[g_random_int_range (0, num_accounts)]);
+            xaccSplitSetAmount (split, amount);
+            xaccSplitSetValue (split, amount);
+            amount = gnc_numeric_neg (amount);
+        }
+        xaccTransCommitEdit (trans);
+    }
+    for (auto acc : accounts)
+        xaccAccountCommitEdit (acc);
+    printf ("Loaded %u splits into %u accounts in %.2f s\n",
+            num_splits, num_accounts, seconds_since (start));
+
+    start = g_get_monotonic_time ();
+    for (auto acc : accounts)
+    {
+        gnc_account_set_balance_dirty (acc);
+        xaccAccountRecomputeBalance (acc);
+    }
+    printf ("Recomputed all balances in %.2f s\n", seconds_since (start));
+
+    start = g_get_monotonic_time ();
+    for (auto acc : accounts)
+        for (int month = 0; month < 240; month++)
+            xaccAccountGetBalanceAsOfDate (acc, now - month * 30 * 24 * 3600LL);
+    printf ("Looked up 240 monthly balances per account in %.2f s\n",
+            seconds_since (start));
+
+    for (auto acc : accounts)
+    {
+        auto balance = gnc_numeric_zero ();
+        auto splits = xaccAccountGetSplitList (acc);
+        for (auto node = splits; node; node = node->next)
+            balance = gnc_numeric_add_fixed (balance,
+                                             xaccSplitGetAmount (static_cast<Split*>(node->data)));
+        do_test (gnc_numeric_equal (balance, xaccAccountGetBalance (acc)),
+                 "account balance matches its splits");
+    }
+    qof_session_destroy (session);
+}
+
+int
+main (int argc, char **argv)
+{
+    guint num_splits = 1000000;
+
+    if (argc > 1)
+        num_splits = strtoul (argv[1], NULL, 10);
+
+    qof_init ();
+    if (cashobjects_register ())
+    {
+        xaccLogDisable ();
+        run_test (num_splits);
+        print_test_results ();
+    }
+    qof_close ();
+    return get_rv ();
+}
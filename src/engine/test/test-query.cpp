@@ -31,8 +31,13 @@ extern "C"
 #include "gnc-engine.h"
 #include "test-engine-stuff.h"
 #include "test-stuff.h"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
 }
 
+#include <set>
+#include <vector>
+
 static int
 test_trans_query (Transaction *trans, gpointer data)
 {
@@ -67,6 +72,254 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* Check a term the way qof_query_run did before the terms were
+ * compiled into a program: walk the parameters, then call the type's
+ * registered predicate. */
+static gboolean
+term_matches (QofIdTypeConst type, const QofQueryTerm *qt, gpointer object)
+{
+    const QofParam *getter = NULL;
+
+    for (auto node = qof_query_term_get_param_path (qt); node;
+         node = node->next)
+    {
+        auto param = qof_class_get_parameter (type,
+                                              static_cast<char*>(node->data));
+        if (!param)
+            break;
+        if (getter)
+            object = getter->param_getfcn (object,
+                                           const_cast<QofParam*>(getter));
+        getter = param;
+        type = param->param_type;
+    }
+    if (!getter)
+        return TRUE;
+
+    auto pred = qof_query_core_get_predicate (getter->param_type);
+    if (!pred)
+        return TRUE;
+    return (pred (object, const_cast<QofParam*>(getter),
+                  qof_query_term_get_pred_data (qt)) != 0) !=
+           (qof_query_term_is_inverted (qt) != 0);
+}
+
+static gboolean
+query_matches (QofQuery *q, gpointer object)
+{
+    auto terms = qof_query_get_terms (q);
+
+    if (!terms)
+        return TRUE;
+    for (auto or_node = terms; or_node; or_node = or_node->next)
+    {
+        gboolean match = TRUE;
+        for (auto and_node = static_cast<GList*>(or_node->data);
+             and_node && match; and_node = and_node->next)
+            match = term_matches (qof_query_get_search_for (q),
+                                  static_cast<QofQueryTerm*>(and_node->data),
+                                  object);
+        if (match)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+collect_object (QofInstance *inst, gpointer data)
+{
+    static_cast<std::vector<gpointer>*>(data)->push_back (inst);
+}
+
+/* The compiled query program must select exactly what evaluating the
+ * terms one by one selects. */
+static gboolean
+check_query_program (QofQuery *q, QofBook *book, const char *what)
+{
+    std::vector<gpointer> splits;
+    std::set<gpointer> expected, found;
+
+    qof_query_set_book (q, book);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_SPLIT),
+                            collect_object, &splits);
+    for (auto split : splits)
+        if (query_matches (q, split))
+            expected.insert (split);
+    for (auto node = qof_query_run (q); node; node = node->next)
+        found.insert (node->data);
+
+    if (expected != found)
+    {
+        failure_args ("query program", __FILE__, __LINE__,
+                      "%s: %zu matches, %zu expected", what,
+                      found.size (), expected.size ());
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+test_query_program (QofBook *book)
+{
+    std::vector<Transaction*> txns;
+    std::vector<QofQuery*> queries;
+    gboolean ok = TRUE;
+
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       [](Transaction *t, gpointer data)
+                                       {
+                                           static_cast<std::vector<Transaction*>*>(data)->push_back (t);
+                                           return 0;
+                                       }, &txns);
+
+    /* Each test query type on its own, ANDed and ORed with another
+     * transaction's query, and inverted. */
+    for (size_t i = 0; i + 1 < txns.size () && i < 10; i++)
+    {
+        auto qa = make_trans_query (txns[i], ALL_QT);
+        auto qb = make_trans_query (txns[i + 1],
+                                    static_cast<TestQueryTypes>(SIMPLE_QT |
+                                                                GUID_QT));
+        if (!qa || !qb)
+        {
+            qof_query_destroy (qa);
+            qof_query_destroy (qb);
+            continue;
+        }
+        queries.push_back (qof_query_merge (qa, qb, QOF_QUERY_OR));
+        queries.push_back (qof_query_merge (qa, qb, QOF_QUERY_AND));
+        queries.push_back (qof_query_merge (qa, qb, QOF_QUERY_NAND));
+        queries.push_back (qof_query_invert (qa));
+        queries.push_back (qa);
+        queries.push_back (qb);
+    }
+    for (int i = 0; i < 20; i++)
+    {
+        auto q = get_random_query ();
+        queries.push_back (qof_query_invert (q));
+        queries.push_back (q);
+    }
+
+    for (auto q : queries)
+    {
+        if (!check_query_program (q, book, "query"))
+            ok = FALSE;
+        qof_query_destroy (q);
+    }
+    if (ok)
+        success ("compiled queries match the terms");
+}
+
+/* With max_results set only the last results in sort order are kept,
+ * and they must come out just as if all the results had been sorted
+ * and the list cut afterwards. */
+static void
+test_query_max_results (QofBook *book)
+{
+    auto q = qof_query_create_for (GNC_ID_SPLIT);
+    GSList *reconcile = g_slist_prepend (NULL,
+                                         const_cast<char*>(SPLIT_RECONCILE));
+    gboolean ok = TRUE;
+
+    qof_query_set_book (q, book);
+    /* The reconcile flag has few values, so there are plenty of ties. */
+    qof_query_set_sort_order (q, reconcile, NULL, NULL);
+
+    for (auto increasing : {TRUE, FALSE})
+    {
+        qof_query_set_sort_increasing (q, increasing, TRUE, TRUE);
+        qof_query_set_max_results (q, -1);
+        auto all = g_list_copy (qof_query_run (q));
+        gint len = g_list_length (all);
+
+        for (auto max : {0, 1, 2, len / 2, len - 1, len, len + 10})
+        {
+            if (max < 0)
+                continue;
+            qof_query_set_max_results (q, max);
+            auto found = qof_query_run (q);
+            auto expected = max < len ? g_list_nth (all, len - max) : all;
+
+            if (max == 0)
+                expected = NULL;
+            while (found && expected && found->data == expected->data)
+            {
+                found = found->next;
+                expected = expected->next;
+            }
+            if (found || expected)
+            {
+                failure_args ("max results", __FILE__, __LINE__,
+                              "%d of %d results differ", max, len);
+                ok = FALSE;
+            }
+        }
+        g_list_free (all);
+    }
+    qof_query_destroy (q);
+    if (ok)
+        success ("max results keep the last results in order");
+}
+
+/* Test parameters on splits: whether a split is in a lot, and the lot
+ * itself, counting the splits it was asked of that aren't in one. */
+static int lot_getter_misses;
+
+static gboolean
+test_split_has_lot (gpointer split, QofParam *param)
+{
+    return xaccSplitGetLot (GNC_SPLIT (split)) != NULL;
+}
+
+static gpointer
+test_split_lot (gpointer split, QofParam *param)
+{
+    auto lot = xaccSplitGetLot (GNC_SPLIT (split));
+    if (!lot)
+        lot_getter_misses++;
+    return lot;
+}
+
+static QofParam test_split_params[] =
+{
+    {
+        "test-has-lot", QOF_TYPE_BOOLEAN, (QofAccessFunc)test_split_has_lot,
+        NULL, NULL
+    },
+    { "test-lot", GNC_ID_LOT, (QofAccessFunc)test_split_lot, NULL, NULL },
+    { NULL },
+};
+
+/* A term that walks a chain of getters may rely on the terms before it
+ * to weed out the objects whose chain is broken, so the compiled program
+ * must not run it ahead of them, however cheap it is. */
+static void
+test_query_chain_order (QofBook *book)
+{
+    auto q = qof_query_create_for (GNC_ID_SPLIT);
+    GncGUID guid;
+
+    qof_class_register (GNC_ID_SPLIT, NULL, test_split_params);
+    qof_query_set_book (q, book);
+    qof_query_add_boolean_match (q, qof_query_build_param_list
+                                 ("test-has-lot", NULL),
+                                 TRUE, QOF_QUERY_AND);
+    guid_replace (&guid);
+    qof_query_add_guid_match (q, qof_query_build_param_list
+                              ("test-lot", QOF_PARAM_GUID, NULL),
+                              &guid, QOF_QUERY_AND);
+
+    lot_getter_misses = 0;
+    qof_query_run (q);
+    qof_query_destroy (q);
+    if (lot_getter_misses)
+        failure_args ("chain order", __FILE__, __LINE__,
+                      "lot getter ran on %d splits without a lot",
+                      lot_getter_misses);
+    else
+        success ("chained terms keep their place");
+}
+
 static void
 run_test (void)
 {
@@ -81,6 +334,9 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    test_query_program (book);
+    test_query_max_results (book);
+    test_query_chain_order (book);
 
     qof_session_end (session);
 }
@@ -43,6 +43,7 @@ void test_suite_account (void);
 }
 
 #include <kvp_frame.hpp>
+#include <vector>
 
 typedef struct
 {
@@ -893,7 +894,7 @@ test_xaccFreeAccount (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert_cmpuint (p_priv->splits->len, >, 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1008,7 +1009,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert_cmpuint (p_priv->splits->len, >, 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1024,7 +1025,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     test_signal_assert_hits (sig2, 0);
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert_cmpuint (p_priv->splits->len, >, 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1114,19 +1115,19 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that the call fails with invalid account and split (throws) */
     g_assert (!gnc_account_insert_split (NULL, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->splits->len, == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     g_assert (!gnc_account_insert_split (fixture->acct, NULL));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->splits->len, == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     /* g_assert (!gnc_account_insert_split (fixture->acct, (Split*)priv)); */
-    /* g_assert_cmpuint (g_list_length (priv->splits), == , 0); */
+    /* g_assert_cmpuint (priv->splits->len, == , 0); */
     /* g_assert (!priv->sort_dirty); */
     /* g_assert (!priv->balance_dirty); */
     /* test_signal_assert_hits (sig1, 0); */
@@ -1139,30 +1140,37 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that it works the first time */
     g_assert (gnc_account_insert_split (fixture->acct, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 1);
+    g_assert_cmpuint (priv->splits->len, == , 1);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 1);
     test_signal_assert_hits (sig2, 1);
     /* Check that it fails if the split has already been added once */
     g_assert (!gnc_account_insert_split (fixture->acct, split1));
+    /* The split list is built when asked for and dropped on any change */
+    g_assert_cmpuint (g_list_length (xaccAccountGetSplitList (fixture->acct)),
+                      == , 1);
+    g_assert (priv->splits_list != NULL);
     /* Free up hdlr2 and set up hdlr2 */
     test_signal_free (sig2);
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_ADDED, split2);
     /* Now add a second split to the account and check that sort_dirty isn't set. We have to bump the editlevel to force this. */
     g_assert (gnc_account_insert_split (fixture->acct, split2));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->len, == , 2);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 2);
     test_signal_assert_hits (sig3, 1);
+    g_assert (priv->splits_list == NULL);
+    g_assert_cmpuint (g_list_length (xaccAccountGetSplitList (fixture->acct)),
+                      == , 2);
     /* One more add, incrementing the editlevel to get sort_dirty set. */
     test_signal_free (sig3);
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_ADDED, split3);
     qof_instance_increase_editlevel (fixture->acct);
     g_assert (gnc_account_insert_split (fixture->acct, split3));
     qof_instance_decrease_editlevel (fixture->acct);
-    g_assert_cmpuint (g_list_length (priv->splits), == , 3);
+    g_assert_cmpuint (priv->splits->len, == , 3);
     g_assert (priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 3);
@@ -1173,7 +1181,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_REMOVED,
                             split3);
     g_assert (gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->len, == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1181,7 +1189,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     /* And do it again to make sure that it fails when the split has
      * already been removed */
     g_assert (!gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->len, == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1191,6 +1199,69 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     test_signal_free (sig3);
     test_signal_free (sig1);
 }
+/* Once built, the list from xaccAccountGetSplitList is kept in step with
+ * the split array rather than rebuilt, so a caller walking it sees the
+ * splits added and removed behind the node it's on. */
+static void
+check_split_list (Fixture *fixture, GList *list)
+{
+    Account *acct = fixture->acct;
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    GList *node = list;
+    guint i;
+
+    g_assert (xaccAccountGetSplitList (acct) == list);
+    for (i = 0; i < priv->splits->len; i++, node = node->next)
+    {
+        g_assert (node != NULL);
+        g_assert (node->data == g_ptr_array_index (priv->splits, i));
+    }
+    g_assert (node == NULL);
+}
+
+static void
+test_xaccAccountGetSplitList_walk (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Split *split1 = xaccMallocSplit (book);
+    Split *split2 = xaccMallocSplit (book);
+    Split *split3 = xaccMallocSplit (book);
+    Split *added = xaccMallocSplit (book);
+    GList *list, *node;
+    gint visited = 0, position;
+
+    g_assert (gnc_account_insert_split (fixture->acct, split1));
+    g_assert (gnc_account_insert_split (fixture->acct, split2));
+    g_assert (gnc_account_insert_split (fixture->acct, split3));
+    list = xaccAccountGetSplitList (fixture->acct);
+    g_assert_cmpuint (g_list_length (list), == , 3);
+    check_split_list (fixture, list);
+
+    /* Remove the last split and add another while on the first */
+    node = list;
+    g_assert (gnc_account_remove_split (fixture->acct,
+                                        GNC_SPLIT (g_list_last (list)->data)));
+    g_assert (gnc_account_insert_split (fixture->acct, added));
+    list = xaccAccountGetSplitList (fixture->acct);
+    check_split_list (fixture, list);
+    position = g_list_position (list, node);
+    g_assert_cmpint (position, >= , 0);
+    for (; node; node = node->next)
+        ++visited;
+    g_assert_cmpint (visited, == , 3 - position);
+    g_assert (g_list_find (list, added) != NULL);
+
+    /* A sort reorders the list in place */
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    list = xaccAccountGetSplitList (fixture->acct);
+    check_split_list (fixture, list);
+
+    g_assert (gnc_account_remove_split (fixture->acct, added));
+    list = xaccAccountGetSplitList (fixture->acct);
+    g_assert_cmpuint (g_list_length (list), == , 2);
+    check_split_list (fixture, list);
+    g_assert (g_list_find (list, added) == NULL);
+}
 /* xaccAccountSortSplits
 void
 xaccAccountSortSplits (Account *acc, gboolean force)// C: 4 in 2
@@ -1341,6 +1412,130 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (!priv->balance_dirty);
 }
 
+/* gnc_account_split_changed
+void
+gnc_account_split_changed (Account *acc, Split *s)// C: 3 in 2
+
+Moves the split to its place if needed and marks the running balances
+dirty from the first position affected, so that
+xaccAccountRecomputeBalance can start there.
+*/
+static void
+check_running_balances (AccountPrivate *priv)
+{
+    gnc_numeric bal = gnc_numeric_zero ();
+    Split *prev = NULL;
+
+    g_assert (!priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_index->len, ==, priv->splits->len);
+    for (guint i = 0; i < priv->splits->len; i++)
+    {
+        auto split = static_cast<Split*>(g_ptr_array_index (priv->splits, i));
+        auto entry = &g_array_index (priv->balance_index, AccountBalanceEntry, i);
+        if (prev)
+            g_assert_cmpint (xaccSplitOrder (prev, split), <, 0);
+        bal = gnc_numeric_add_fixed (bal, xaccSplitGetAmount (split));
+        g_assert (gnc_numeric_equal (xaccSplitGetBalance (split), bal));
+        g_assert (gnc_numeric_equal (entry->balance, bal));
+        g_assert_cmpint (entry->date, ==,
+                         xaccTransGetDate (xaccSplitGetParent (split)));
+        prev = split;
+    }
+    g_assert (gnc_numeric_equal (priv->balance, bal));
+}
+
+static void
+test_gnc_account_split_changed (Fixture *fixture, gconstpointer pData)
+{
+    auto acct = fixture->acct;
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    xaccAccountSortSplits (acct, TRUE);
+    gnc_account_set_balance_dirty (acct);
+    xaccAccountRecomputeBalance (acct);
+    g_assert_cmpuint (priv->splits->len, ==, 5);
+    check_running_balances (priv);
+
+    auto second = static_cast<Split*>(g_ptr_array_index (priv->splits, 1));
+    auto third = static_cast<Split*>(g_ptr_array_index (priv->splits, 2));
+
+    /* A new amount leaves the split where it is, so only the balances
+     * from there on need recomputing. */
+    auto txn = xaccSplitGetParent (third);
+    xaccTransBeginEdit (txn);
+    xaccSplitSetAmount (third, gnc_numeric_create (27182, 100));
+    g_assert (priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, ==, 2);
+    gnc_account_split_changed (acct, third);
+    /* xaccTransCommitEdit () does a bunch of scrubbing that we don't need */
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert (!priv->sort_dirty);
+    g_assert (priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, ==, 2);
+    g_assert (g_ptr_array_index (priv->splits, 2) == third);
+    xaccAccountRecomputeBalance (acct);
+    check_running_balances (priv);
+
+    /* Posting the second split's transaction after all the others
+     * moves it to the end. */
+    txn = xaccSplitGetParent (second);
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecs (txn, gnc_time (NULL) + 30 * 24 * 3600);
+    gnc_account_split_changed (acct, second);
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert (!priv->sort_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, ==, 1);
+    g_assert (g_ptr_array_index (priv->splits, 4) == second);
+    xaccAccountRecomputeBalance (acct);
+    check_running_balances (priv);
+
+    /* The watermark only ever moves down until the next recompute. */
+    gnc_account_split_changed (acct, static_cast<Split*>(g_ptr_array_index (priv->splits, 3)));
+    gnc_account_split_changed (acct, static_cast<Split*>(g_ptr_array_index (priv->splits, 1)));
+    g_assert_cmpuint (priv->balance_dirty_from, ==, 1);
+    gnc_account_set_balance_dirty (acct);
+    g_assert_cmpuint (priv->balance_dirty_from, ==, 0);
+    xaccAccountRecomputeBalance (acct);
+    check_running_balances (priv);
+}
+
+/* A split that can't be put in place right away waits for the next sort
+ * with the other pending splits, so the rest of the array can still be
+ * searched and the split can't be added a second time. */
+static void
+test_gnc_account_split_changed_deferred (Fixture *fixture, gconstpointer pData)
+{
+    auto acct = fixture->acct;
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    xaccAccountSortSplits (acct, TRUE);
+    g_assert_cmpuint (priv->splits->len, ==, 5);
+
+    auto second = static_cast<Split*>(g_ptr_array_index (priv->splits, 1));
+    auto txn = xaccSplitGetParent (second);
+    xaccAccountBeginEdit (acct);
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecs (txn, gnc_time (NULL) + 30 * 24 * 3600);
+    gnc_account_split_changed (acct, second);
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert (priv->sort_dirty);
+    g_assert (priv->splits_pending != NULL);
+    g_assert (g_hash_table_contains (priv->splits_pending, second));
+    g_assert (g_ptr_array_index (priv->splits, 4) == second);
+
+    g_assert (!gnc_account_insert_split (acct, second));
+    g_assert_cmpuint (priv->splits->len, ==, 5);
+    for (guint i = 0; i < 4; i++)
+        g_assert (!gnc_account_insert_split
+                  (acct, static_cast<Split*>(g_ptr_array_index (priv->splits, i))));
+    g_assert_cmpuint (priv->splits->len, ==, 5);
+
+    qof_commit_edit (QOF_INSTANCE (acct));
+    xaccAccountSortSplits (acct, TRUE);
+    g_assert (!priv->sort_dirty);
+    g_assert (g_ptr_array_index (priv->splits, 4) == second);
+    xaccAccountRecomputeBalance (acct);
+    check_running_balances (priv);
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -1944,6 +2139,98 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+/* The balance index must give the same answers as walking the split
+ * list, on either side of every posted date and while the account is
+ * open for editing (when the walk is used instead). */
+static gnc_numeric
+balance_as_of_date_by_walk (Account *acct, time64 date)
+{
+    gnc_numeric bal = gnc_numeric_zero ();
+    for (auto node = xaccAccountGetSplitList (acct); node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        if (xaccTransGetDate (xaccSplitGetParent (split)) >= date)
+            break;
+        bal = xaccSplitGetBalance (split);
+    }
+    return bal;
+}
+
+static void
+test_xaccAccountGetBalanceAsOfDate_index (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (priv->balance_index_valid);
+    g_assert_cmpint (priv->balance_index->len, ==,
+                     g_list_length (xaccAccountGetSplitList (fixture->acct)));
+
+    for (auto node = xaccAccountGetSplitList (fixture->acct); node;
+         node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        auto date = xaccTransGetDate (xaccSplitGetParent (split));
+        for (auto when : {date - 1, date, date + 1})
+        {
+            auto expected = balance_as_of_date_by_walk (fixture->acct, when);
+            g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (fixture->acct, when), expected));
+            qof_instance_increase_editlevel (fixture->acct);
+            priv->balance_dirty = TRUE;
+            g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (fixture->acct, when), expected));
+            qof_instance_decrease_editlevel (fixture->acct);
+            xaccAccountRecomputeBalance (fixture->acct);
+        }
+    }
+}
+/* gnc_balance_grid_get_balance
+ * The grid includes the splits posted on the date itself, so it must
+ * agree with the walk up to the next second. */
+static void
+test_gnc_balance_grid (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    std::vector<time64> dates;
+
+    for (auto node = xaccAccountGetSplitList (fixture->acct); node;
+         node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        auto date = xaccTransGetDate (xaccSplitGetParent (split));
+        dates.insert (dates.begin (), {date + 1, date, date - 1});
+    }
+
+    for (auto editing : {false, true})
+    {
+        auto grid = gnc_balance_grid_new ();
+        gnc_balance_grid_add_account (grid, fixture->acct);
+        gnc_balance_grid_add_account (grid, fixture->acct);
+        for (auto date : dates)
+            gnc_balance_grid_add_date (grid, date);
+        if (editing)
+        {
+            qof_instance_increase_editlevel (fixture->acct);
+            priv->balance_dirty = TRUE;
+        }
+
+        for (guint i = 0; i < dates.size (); i++)
+        {
+            auto expected = balance_as_of_date_by_walk (fixture->acct,
+                                                        dates[i] + 1);
+            auto change = i ? gnc_numeric_sub (expected,
+                                               balance_as_of_date_by_walk (fixture->acct, dates[i - 1] + 1),
+                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED) : expected;
+            g_assert (gnc_numeric_equal (gnc_balance_grid_get_balance (grid, fixture->acct, i), expected));
+            g_assert (gnc_numeric_equal (gnc_balance_grid_get_change (grid, fixture->acct, i), change));
+        }
+
+        if (editing)
+        {
+            qof_instance_decrease_editlevel (fixture->acct);
+            xaccAccountRecomputeBalance (fixture->acct);
+        }
+        gnc_balance_grid_destroy (grid);
+    }
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -2570,8 +2857,11 @@ test_suite_account (void)
 // GNC_TEST_ADD (suitename, "xaccAcctChildrenEqual", Fixture, NULL, setup, test_xaccAcctChildrenEqual,  teardown );
 // GNC_TEST_ADD (suitename, "xaccAccountEqual", Fixture, NULL, setup, test_xaccAccountEqual,  teardown );
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetSplitList walk", Fixture, NULL, setup, test_xaccAccountGetSplitList_walk,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account split changed", Fixture, &some_data, setup, test_gnc_account_split_changed,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account split changed deferred", Fixture, &some_data, setup, test_gnc_account_split_changed_deferred,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2590,6 +2880,8 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate index", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate_index,  teardown );
+    GNC_TEST_ADD (suitename, "gnc balance grid", Fixture, &some_data, setup, test_gnc_balance_grid,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
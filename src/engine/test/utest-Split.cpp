@@ -356,7 +356,8 @@ Not testable and wrong besides.
 */
 /* mark_split
 void mark_split (Split *s)// C: 2 in 2 SCM: 10 in 1 Local: 8:0:0
-OK, weird. Doesn't mark the split, marks the account sort-dirty and balance-dirty parameters.
+Doesn't mark the split, marks the account's balances dirty from the
+split on; the split is moved to its new place when it is committed.
 */
 static void
 test_mark_split (Fixture *fixture, gconstpointer pData)
@@ -375,7 +376,7 @@ test_mark_split (Fixture *fixture, gconstpointer pData)
                   "sort-dirty", &sort_dirty,
                   "balance-dirty", &balance_dirty,
                   NULL);
-    g_assert_cmpint (sort_dirty, ==, TRUE);
+    g_assert_cmpint (sort_dirty, ==, FALSE);
     g_assert_cmpint (balance_dirty, ==, TRUE);
 }
 // Not Used
@@ -589,7 +590,8 @@ test_xaccSplitCommitEdit (Fixture *fixture, gconstpointer pData)
                   "sort-dirty", &sort_dirty,
                   "balance-dirty", &balance_dirty,
                   NULL);
-    g_assert_cmpint (sort_dirty, ==, TRUE);
+    /* The split was inserted straight into its place. */
+    g_assert_cmpint (sort_dirty, ==, FALSE);
     g_assert_cmpint (balance_dirty, ==, FALSE);
     g_assert (qof_instance_is_dirty (QOF_INSTANCE (fixture->split->parent)));
     g_assert (qof_instance_is_dirty (QOF_INSTANCE (fixture->split)));
@@ -275,7 +275,7 @@ test_xaccTransStillHasSplit (Fixture *fixture, gconstpointer pData)
 /* mark_trans
 void mark_trans (Transaction *trans)// Local: 3:0:0
 */
-#define check_split_dirty(xsplit, test)                \
+#define check_split_dirty(xsplit, sort, balance)       \
 {                                                      \
     gboolean sort_dirty, balance_dirty;                \
     auto split = xsplit;                             \
@@ -283,8 +283,8 @@ void mark_trans (Transaction *trans)// Local: 3:0:0
 		  "sort-dirty", &sort_dirty,           \
 		  "balance-dirty", &balance_dirty,     \
 		  NULL);                               \
-    g_assert_cmpint (sort_dirty, ==, test);            \
-    g_assert_cmpint (balance_dirty, ==, test);         \
+    g_assert_cmpint (sort_dirty, ==, sort);            \
+    g_assert_cmpint (balance_dirty, ==, balance);      \
 }
 
 static void
@@ -297,7 +297,7 @@ test_mark_trans (Fixture *fixture, gconstpointer pData)
     {
         if (!splits->data) continue;
         g_assert (!qof_instance_get_dirty_flag (splits->data));
-        check_split_dirty (static_cast<Split*>(splits->data), FALSE);
+        check_split_dirty (static_cast<Split*>(splits->data), FALSE, FALSE);
     }
     fixture->func->mark_trans (fixture->txn);
     g_assert (!qof_instance_get_dirty_flag (fixture->txn));
@@ -305,7 +305,9 @@ test_mark_trans (Fixture *fixture, gconstpointer pData)
     {
         if (!splits->data) continue;
         g_assert (!qof_instance_get_dirty_flag (splits->data));
-        check_split_dirty (static_cast<Split*>(splits->data), TRUE);
+        /* The balances are dirty, the splits are only moved to their
+         * new places when they commit. */
+        check_split_dirty (static_cast<Split*>(splits->data), FALSE, TRUE);
     }
 }
 /* gen_event_trans
@@ -1750,6 +1752,28 @@ test_xaccTransRollbackEdit (Fixture *fixture, gconstpointer pData)
     g_object_unref (orig);
 
 }
+/* Rolling back an edited amount must bring the account balance back
+ * too, even after the balance was recomputed during the edit. */
+static void
+test_xaccTransRollbackEdit_Balance (Fixture *fixture, gconstpointer pData)
+{
+    auto split = xaccTransFindSplitByAccount (fixture->txn, fixture->acc1);
+    auto amount = xaccSplitGetAmount (split);
+    auto balance = xaccAccountGetBalance (fixture->acc1);
+    g_assert (gnc_numeric_equal (balance, amount));
+
+    xaccTransBeginEdit (fixture->txn);
+    xaccSplitSetAmount (split, gnc_numeric_create (150000, 1000));
+    xaccAccountRecomputeBalance (fixture->acc1);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (fixture->acc1),
+                                 gnc_numeric_create (150000, 1000)));
+    xaccTransRollbackEdit (fixture->txn);
+
+    g_assert (gnc_numeric_equal (xaccSplitGetAmount (split), amount));
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (fixture->acc1),
+                                 balance));
+    g_assert (gnc_numeric_equal (xaccSplitGetBalance (split), balance));
+}
 /* A second xaccTransRollbackEdit test to check the backend error handling */
 static void
 test_xaccTransRollbackEdit_BackendErrors (Fixture *fixture, gconstpointer pData)
@@ -2080,6 +2104,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "trans cleanup commit", Fixture, NULL, setup, test_trans_cleanup_commit, teardown);
     GNC_TEST_ADD_FUNC (suitename, "xaccTransCommitEdit", test_xaccTransCommitEdit);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit", Fixture, NULL, setup, test_xaccTransRollbackEdit, teardown);
+    GNC_TEST_ADD (suitename, "xaccTransRollbackEdit - Balance", Fixture, NULL, setup, test_xaccTransRollbackEdit_Balance, teardown);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit - Backend Errors", Fixture, NULL, setup, test_xaccTransRollbackEdit_BackendErrors, teardown);
     GNC_TEST_ADD (suitename, "xaccTransOrder_num_action", Fixture, NULL, setup, test_xaccTransOrder_num_action, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetTxnType", Fixture, NULL, setup, test_xaccTransGetTxnType, teardown);
@@ -614,10 +614,62 @@ test_gnc_pricedb_destroy (Fixture *fixture, gconstpointer pData)
 void
 gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update)// C: 4 in 2  Local: 0:0:0
 */
-/* static void
-test_gnc_pricedb_set_bulk_update (Fixture *fixture, gconstpointer pData)
+static void
+test_gnc_pricedb_set_bulk_update (PriceDBFixture *fixture, gconstpointer pData)
 {
-}*/
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    Commodities *c = fixture->com;
+    Timespec t = gnc_dmy2timespec(1, 1, 2013);
+    PriceList *prices;
+    GNCPrice *price;
+
+    /* Prices added in bulk needn't come in order */
+    gnc_pricedb_set_bulk_update(db, TRUE);
+    gnc_pricedb_add_price(db, construct_price(book, c->eur, c->bgn,
+                                              gnc_dmy2timespec(12, 11, 2014),
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(19558, 10000)));
+    gnc_pricedb_add_price(db, construct_price(book, c->eur, c->bgn,
+                                              gnc_dmy2timespec(11, 4, 2009),
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(19559, 10000)));
+    gnc_pricedb_add_price(db, construct_price(book, c->bgn, c->eur,
+                                              gnc_dmy2timespec(17, 11, 2012),
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(5113, 10000)));
+    gnc_pricedb_add_price(db, construct_price(book, c->eur, c->bgn,
+                                              gnc_dmy2timespec(20, 7, 2011),
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(19557, 10000)));
+    gnc_pricedb_set_bulk_update(db, FALSE);
+
+    /* Before any lookup has sorted the series, the price nearest to a time
+     * before all of them is still the earliest */
+    prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db, c->bgn,
+                                                             gnc_dmy2timespec(1, 1, 2009));
+    g_assert_cmpint(g_list_length(prices), ==, 1);
+    g_assert_cmpint(gnc_price_get_value(prices->data).num, ==, 19559);
+    gnc_price_list_destroy(prices);
+
+    prices = gnc_pricedb_get_prices(db, c->eur, c->bgn);
+    g_assert_cmpint(g_list_length(prices), ==, 3);
+    g_assert_cmpint(gnc_price_get_value(prices->data).num, ==, 19558);
+    g_assert_cmpint(gnc_price_get_value(prices->next->data).num, ==, 19557);
+    g_assert_cmpint(gnc_price_get_value(prices->next->next->data).num, ==, 19559);
+    gnc_price_list_destroy(prices);
+
+    price = gnc_pricedb_nth_price(db, c->eur, 1);
+    g_assert_cmpint(gnc_price_get_value(price).num, ==, 19557);
+
+    /* Lookups find the prices in both directions */
+    price = gnc_pricedb_lookup_latest_before(db, c->eur, c->bgn, t);
+    g_assert(gnc_price_get_commodity(price) == c->bgn);
+    gnc_price_unref(price);
+    price = gnc_pricedb_lookup_latest(db, c->bgn, c->eur);
+    g_assert_cmpint(gnc_price_get_value(price).num, ==, 19558);
+    gnc_price_unref(price);
+}
 /* gnc_collection_get_pricedb
 GNCPriceDB *
 gnc_collection_get_pricedb(QofCollection *col)// Local: 1:0:0
@@ -1135,6 +1187,45 @@ test_gnc_pricedb_convert_balance_nearest_price (PriceDBFixture *fixture, gconstp
     g_assert_cmpint(result.denom, ==, 100);
 
 }
+
+static void
+test_gnc_pricedb_get_conversion_path_stats (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    Commodities *c = fixture->com;
+    Timespec t = gnc_dmy2timespec(15, 8, 2011);
+    gnc_numeric from = gnc_numeric_create(10000, 100);
+    gnc_numeric result;
+    guint hits, misses;
+
+    gnc_pricedb_get_conversion_path_stats(db, &hits, &misses);
+    g_assert_cmpint(hits, ==, 0);
+    g_assert_cmpint(misses, ==, 0);
+
+    /* AMZN has no AUD prices and is converted through USD */
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->amzn,
+                                                       c->aud, t);
+    g_assert_cmpint(result.num, ==, 2089782);
+    result = gnc_pricedb_convert_balance_latest_price(db, from, c->amzn,
+                                                      c->aud);
+    g_assert_cmpint(result.num, ==, 3575636);
+    gnc_pricedb_get_conversion_path_stats(db, &hits, &misses);
+    g_assert_cmpint(hits, ==, 1);
+    g_assert_cmpint(misses, ==, 1);
+
+    /* A price for a new pair of commodities may give new paths */
+    gnc_pricedb_add_price(db, construct_price(book, c->eur, c->bgn,
+                                              gnc_dmy2timespec(12, 11, 2014),
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(19558, 10000)));
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->amzn,
+                                                       c->aud, t);
+    g_assert_cmpint(result.num, ==, 2089782);
+    gnc_pricedb_get_conversion_path_stats(db, &hits, &misses);
+    g_assert_cmpint(hits, ==, 1);
+    g_assert_cmpint(misses, ==, 2);
+}
 /* pricedb_foreach_pricelist
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)// Local: 0:1:0
@@ -1351,7 +1442,7 @@ test_suite_gnc_pricedb (void)
 // GNC_TEST_ADD (suitename, "destroy pricedb currency hash data", Fixture, NULL, setup, test_destroy_pricedb_currency_hash_data, teardown);
 // GNC_TEST_ADD (suitename, "destroy pricedb commodity hash data", Fixture, NULL, setup, test_destroy_pricedb_commodity_hash_data, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb destroy", Fixture, NULL, setup, test_gnc_pricedb_destroy, teardown);
-// GNC_TEST_ADD (suitename, "gnc pricedb set bulk update", Fixture, NULL, setup, test_gnc_pricedb_set_bulk_update, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb set bulk update", PriceDBFixture, NULL, setup, test_gnc_pricedb_set_bulk_update, teardown);
 // GNC_TEST_ADD (suitename, "gnc collection get pricedb", Fixture, NULL, setup, test_gnc_collection_get_pricedb, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb get db", Fixture, NULL, setup, test_gnc_pricedb_get_db, teardown);
 // GNC_TEST_ADD (suitename, "num prices helper", Fixture, NULL, setup, test_num_prices_helper, teardown);
@@ -1391,6 +1482,7 @@ test_suite_gnc_pricedb (void)
 // GNC_TEST_ADD (suitename, "indirect balance conversion", Fixture, NULL, setup, test_indirect_balance_conversion, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_nearest_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb get conversion path stats", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_conversion_path_stats, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);
@@ -297,8 +297,10 @@ gnc_tree_model_account_new (Account *root)
     priv->book = gnc_get_current_book();
     priv->root = root;
 
-    priv->event_handler_id = qof_event_register_handler
-                             ((QofEventHandler)gnc_tree_model_account_event_handler, model);
+    priv->event_handler_id = qof_event_register_filtered_handler
+                             (GNC_ID_ACCOUNT,
+                              QOF_EVENT_ADD | QOF_EVENT_REMOVE | QOF_EVENT_MODIFY,
+                              (QofEventHandler)gnc_tree_model_account_event_handler, model);
 
     LEAVE("model %p", model);
     return GTK_TREE_MODEL (model);
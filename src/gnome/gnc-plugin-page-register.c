@@ -534,6 +534,7 @@ typedef struct GncPluginPageRegisterPrivate
     GtkWidget *widget;
 
     gint event_handler_id;
+    gint account_event_handler_id;
     gint component_manager_id;
     GncGUID key;  /* The guid of the Account we're watching */
 
@@ -1195,8 +1196,12 @@ gnc_plugin_page_register_create_widget (GncPluginPage *plugin_page)
                                page);
     }
 
-    priv->event_handler_id = qof_event_register_handler
-                             ((QofEventHandler)gnc_plugin_page_register_event_handler, page);
+    priv->event_handler_id = qof_event_register_filtered_handler
+                             (GNC_ID_TRANS, QOF_EVENT_MODIFY | QOF_EVENT_DESTROY,
+                              (QofEventHandler)gnc_plugin_page_register_event_handler, page);
+    priv->account_event_handler_id = qof_event_register_filtered_handler
+                                     (GNC_ID_ACCOUNT, QOF_EVENT_NONE,
+                                      (QofEventHandler)gnc_plugin_page_register_event_handler, page);
     priv->component_manager_id =
         gnc_register_gui_component(GNC_PLUGIN_PAGE_REGISTER_NAME,
                                    gnc_plugin_page_register_refresh_cb,
@@ -1251,6 +1256,12 @@ gnc_plugin_page_register_destroy_widget (GncPluginPage *plugin_page)
         priv->event_handler_id = 0;
     }
 
+    if (priv->account_event_handler_id)
+    {
+        qof_event_unregister_handler(priv->account_event_handler_id);
+        priv->account_event_handler_id = 0;
+    }
+
     if (priv->sd.dialog)
     {
         gtk_widget_destroy(priv->sd.dialog);
@@ -1928,6 +1928,7 @@ CsvImpTransAssist::assist_match_page_prepare ()
             draft_trans->trans = nullptr;
         }
     }
+    gnc_gen_trans_list_show_all (gnc_csv_importer_gui);
 }
 
 
@@ -6,10 +6,40 @@
 #include <string>
 #include <algorithm>    // copy
 #include <iterator>     // ostream_operator
+#include <cstdint>
+#include <cstring>
 
-#include <boost/tokenizer.hpp>
-#include <boost/locale.hpp>
-#include <boost/algorithm/string.hpp>
+GncCsvTokenizer::GncCsvTokenizer(const GncCsvTokenizer& other) :
+    GncTokenizer(other), m_sep_str{other.m_sep_str}
+{
+}
+
+GncCsvTokenizer&
+GncCsvTokenizer::operator=(const GncCsvTokenizer& other)
+{
+    GncTokenizer::operator=(other);
+    m_sep_str = other.m_sep_str;
+    m_field_views.clear();
+    m_row_starts.clear();
+    m_unquoted.clear();
+    return *this;
+}
+
+GncCsvTokenizer::GncCsvTokenizer(GncCsvTokenizer&& other) :
+    GncTokenizer(std::move(other)), m_sep_str{std::move(other.m_sep_str)}
+{
+}
+
+GncCsvTokenizer&
+GncCsvTokenizer::operator=(GncCsvTokenizer&& other)
+{
+    GncTokenizer::operator=(std::move(other));
+    m_sep_str = std::move(other.m_sep_str);
+    m_field_views.clear();
+    m_row_starts.clear();
+    m_unquoted.clear();
+    return *this;
+}
 
 void
 GncCsvTokenizer::set_separators(const std::string& separators)
@@ -17,50 +47,183 @@ GncCsvTokenizer::set_separators(const std::string& separators)
     m_sep_str = separators;
 }
 
-
-int GncCsvTokenizer::tokenize()
+/* Returns the first byte from pos on that ends an unquoted field, or end.
+ * Eight bytes are tested at a time for any of the special bytes: xor-ing a
+ * word with a byte repeated eight times gives a zero byte where they match,
+ * which (x - 0x01..01) & ~x & 0x80..80 detects. */
+const char*
+GncCsvTokenizer::find_special (const char* pos, const char* end) const noexcept
 {
-    using Tokenizer = boost::tokenizer< boost::escaped_list_separator<char>>;
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
 
-    boost::escaped_list_separator<char> sep("\\", m_sep_str, "\"");
+    if (m_special_bytes.size() <= 8)
+    {
+        while (end - pos >= 8)
+        {
+            uint64_t word, hit = 0;
+            memcpy (&word, pos, sizeof(word));
+            for (auto byte : m_special_bytes)
+            {
+                auto x = word ^ (ones * byte);
+                hit |= (x - ones) & ~x & highs;
+            }
+            if (hit)
+                break;
+            pos += 8;
+        }
+    }
+    while (pos < end && !m_special[static_cast<unsigned char>(*pos)])
+        ++pos;
+    return pos;
+}
 
-    StrVec vec;
-    std::string line;
-    std::string buffer;
+/* The slow path for fields that can't be a plain slice of the contents:
+ * doubled quotes inside quotes, quotes that don't enclose the whole field
+ * or a missing closing quote.  The field is copied to m_unquoted with the
+ * quoting removed, and unquoted blanks are dropped from its end if it ends
+ * the row.  Returns where the field ends. */
+const char*
+GncCsvTokenizer::unquote_field (const char* field_start, const char* end)
+{
+    /* No field is longer than its source, so this is the only allocation */
+    if (m_unquoted.capacity() < m_utf8_contents.size())
+        m_unquoted.reserve (m_utf8_contents.size());
 
-    bool inside_quotes(false);
-    size_t last_quote(0);
+    auto start = m_unquoted.size();
+    auto kept = start; // End of the field without unquoted trailing blanks
+    bool in_quotes = false;
+    auto pos = field_start;
+    for (; pos < end; ++pos)
+    {
+        auto c = *pos;
+        if (c == '"')
+        {
+            if (in_quotes && pos + 1 < end && pos[1] == '"')
+            {
+                m_unquoted.push_back ('"');
+                ++pos;
+            }
+            else
+                in_quotes = !in_quotes;
+            kept = m_unquoted.size();
+        }
+        else if (!in_quotes && m_special[static_cast<unsigned char>(c)])
+            break;
+        else
+        {
+            m_unquoted.push_back (c);
+            if (in_quotes || (c != ' ' && c != '\t'))
+                kept = m_unquoted.size();
+        }
+    }
+    if (pos == end || *pos == '\r' || *pos == '\n')
+        m_unquoted.resize (kept);
+    m_field_views.emplace_back (m_unquoted.data() + start,
+                                m_unquoted.size() - start);
+    return pos;
+}
 
-    m_tokenized_contents.clear();
-    std::istringstream in_stream(m_utf8_contents);
+/* Splits m_utf8_contents into m_field_views in a single pass.  Fields
+ * follow RFC 4180: a field in double quotes may hold separators and line
+ * breaks, and "" in it stands for one quote.  Rows end with LF, CRLF or CR.
+ * As the line based tokenizer used to, blanks at the start and end of a
+ * row are dropped. */
+void
+GncCsvTokenizer::scan()
+{
+    std::fill (std::begin(m_special), std::end(m_special), false);
+    m_special_bytes.clear();
+    for (auto c : m_sep_str + "\"\r\n")
+    {
+        auto byte = static_cast<unsigned char>(c);
+        if (!m_special[byte])
+            m_special_bytes.push_back (byte);
+        m_special[byte] = true;
+    }
 
-    while (std::getline (in_stream, buffer))
+    m_field_views.clear();
+    m_row_starts.clear();
+    m_unquoted.clear();
+
+    auto is_blank = [](char c) { return c == ' ' || c == '\t'; };
+    auto pos = m_utf8_contents.data();
+    auto end = pos + m_utf8_contents.size();
+    while (pos < end)
     {
-        // --- deal with line breaks in quoted strings
-        buffer = boost::trim_copy (buffer); // Removes trailing newline and spaces
-        last_quote = buffer.find_first_of('"');
-        while (last_quote != std::string::npos)
+        m_row_starts.push_back (m_field_views.size());
+        while (pos < end && is_blank (*pos))
+            ++pos;
+
+        while (true)
         {
-            if (last_quote == 0) // Test separately because last_quote - 1 would be out of range
-                inside_quotes = !inside_quotes;
-            else if (buffer[ last_quote - 1 ] != '\\')
-                inside_quotes = !inside_quotes;
+            auto field_start = pos;
+            if (pos < end && *pos == '"')
+            {
+                auto close = static_cast<const char*>(memchr (pos + 1, '"',
+                                                              end - pos - 1));
+                auto after = close ? close + 1 : end;
+                /* Blanks after the closing quote at the end of a row are
+                 * dropped along with the rest of the row's trailing blanks */
+                auto next = after;
+                while (next < end && is_blank (*next))
+                    ++next;
+                if (next > after && (next == end || *next == '\r' || *next == '\n'))
+                    after = next;
+                if (close && (after == end ||
+                              (m_special[static_cast<unsigned char>(*after)] &&
+                               *after != '"')))
+                {
+                    m_field_views.emplace_back (pos + 1, close - pos - 1);
+                    pos = after;
+                }
+                else
+                    pos = unquote_field (field_start, end);
+            }
+            else
+            {
+                pos = find_special (pos, end);
+                if (pos < end && *pos == '"')
+                    pos = unquote_field (field_start, end);
+                else
+                {
+                    auto field_end = pos;
+                    if (pos == end || *pos == '\r' || *pos == '\n')
+                        while (field_end > field_start && is_blank (field_end[-1]))
+                            --field_end;
+                    m_field_views.emplace_back (field_start,
+                                                field_end - field_start);
+                }
+            }
 
-            last_quote = buffer.find_first_of('"',last_quote+1);
+            if (pos == end)
+                break;
+            if (*pos == '\r' || *pos == '\n')
+            {
+                if (*pos == '\r' && pos + 1 < end && pos[1] == '\n')
+                    ++pos;
+                ++pos;
+                break;
+            }
+            ++pos; // Separator
         }
+    }
+    m_row_starts.push_back (m_field_views.size());
+}
 
-        line.append(buffer);
-        if (inside_quotes)
-        {
-            line.append(" ");
-            continue;
-        }
-        // ---
+int GncCsvTokenizer::tokenize()
+{
+    scan();
 
-        Tokenizer tok(line, sep);
-        vec.assign(tok.begin(),tok.end());
-        m_tokenized_contents.push_back(vec);
-        line.clear();
+    m_tokenized_contents.clear();
+    m_tokenized_contents.reserve (m_row_starts.size() - 1);
+    for (size_t row = 0; row + 1 < m_row_starts.size(); row++)
+    {
+        StrVec vec;
+        vec.reserve (m_row_starts[row + 1] - m_row_starts[row]);
+        for (auto i = m_row_starts[row]; i < m_row_starts[row + 1]; i++)
+            vec.emplace_back (m_field_views[i].data(), m_field_views[i].size());
+        m_tokenized_contents.push_back (std::move (vec));
     }
 
     return 0;
@@ -42,23 +42,52 @@ extern "C" {
 #include <fstream>      // fstream
 #include <vector>
 #include <string>
+#include <boost/utility/string_ref.hpp>
 #include "gnc-tokenizer.hpp"
 
+/** A field of the tokenized contents, pointing into the tokenizer's
+ *  buffers rather than owning a copy. */
+using FieldView = boost::string_ref;
+
 class GncCsvTokenizer : public GncTokenizer
 {
 public:
     GncCsvTokenizer() = default;                                  // default constructor
-    GncCsvTokenizer(const GncCsvTokenizer&) = default;            // copy constructor
-    GncCsvTokenizer& operator=(const GncCsvTokenizer&) = default; // copy assignment
-    GncCsvTokenizer(GncCsvTokenizer&&) = default;                 // move constructor
-    GncCsvTokenizer& operator=(GncCsvTokenizer&&) = default;      // move assignment
+    /* Copies and moves leave the field views behind: they point into the
+     * original's buffers.  Tokenize the copy to get its own. */
+    GncCsvTokenizer(const GncCsvTokenizer&);                      // copy constructor
+    GncCsvTokenizer& operator=(const GncCsvTokenizer&);           // copy assignment
+    GncCsvTokenizer(GncCsvTokenizer&&);                           // move constructor
+    GncCsvTokenizer& operator=(GncCsvTokenizer&&);                // move assignment
     ~GncCsvTokenizer() = default;                                 // destructor
 
     void set_separators(const std::string& separators);
     int  tokenize() override;
 
+    /** The fields found by the last tokenize(), row after row.  They stay
+     *  valid until the contents are reloaded or tokenized again. */
+    const std::vector<FieldView>& get_field_views() const noexcept
+    { return m_field_views; }
+    /** Index in get_field_views() of the first field of each row, followed
+     *  by the total number of fields. */
+    const std::vector<size_t>& get_row_starts() const noexcept
+    { return m_row_starts; }
+
 private:
+    void scan();
+    const char* find_special (const char* pos, const char* end) const noexcept;
+    const char* unquote_field (const char* field_start, const char* end);
+
     std::string m_sep_str = ",";
+    /** Bytes that end an unquoted field: the separators, '"', CR and LF.
+     *  Set up by scan(). */
+    bool m_special[256];
+    std::vector<unsigned char> m_special_bytes;
+    std::vector<FieldView> m_field_views;
+    std::vector<size_t> m_row_starts;
+    /** Fields that had to be rewritten (doubled or misplaced quotes); it's
+     *  never reallocated while tokenizing so views into it stay valid. */
+    std::string m_unquoted;
 };
 
 #endif
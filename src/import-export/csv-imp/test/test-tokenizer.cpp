@@ -194,6 +194,52 @@ TEST_F (GncTokenizerTest, tokenize_semicolon_sep)
     test_gnc_tokenize_helper (";", semicolon_separated);
 }
 
+static tokenize_csv_test_data quoted_fields [] = {
+        { "\"Acme \"\"Inc.\"\"\",\"\",\"\"\"\"", 3, { "Acme \"Inc.\"","","\"",NULL,NULL,NULL,NULL,NULL } },
+        { "\"two\nlines\",\"a,b\"\r\nnext", 2, { "two\nlines","a,b",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { "ab\"c,d\"e,\"f\"g,\"unterminated,", 3, { "abc,de","fg","unterminated,",NULL,NULL,NULL,NULL,NULL } },
+        { "  padded , row\t", 2, { "padded "," row",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { "\"x\",\"y\"  \n", 2, { "x","y",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { "\"x\",\"y \"\t", 2, { "x","y ",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { "\"x\" ,\"y\"\"z\" \r\n", 2, { "x ","y\"z",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { "a,b\"c\" d ", 2, { "a","bc d",NULL,NULL,NULL,NULL,NULL,NULL } },
+        { NULL, 0, { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL } },
+};
+TEST_F (GncTokenizerTest, tokenize_quoted_fields)
+{
+    test_gnc_tokenize_helper (",", quoted_fields);
+}
+
+TEST_F (GncTokenizerTest, tokenize_rows_and_views)
+{
+    GncCsvTokenizer *csvtok = dynamic_cast<GncCsvTokenizer*>(csv_tok.get());
+    csvtok->set_separators (",;");
+    set_utf8_contents (csv_tok, "a;b\r\n\"c\nd\",\"e\"\"\"\n\nlast,row,without,newline,0123456789abcdef");
+    csv_tok->tokenize();
+
+    auto tokens = csv_tok->get_tokens();
+    ASSERT_EQ(4ul, tokens.size());
+    EXPECT_EQ((StrVec{"a", "b"}), tokens[0]);
+    EXPECT_EQ((StrVec{"c\nd", "e\""}), tokens[1]);
+    EXPECT_EQ((StrVec{""}), tokens[2]);
+    EXPECT_EQ((StrVec{"last", "row", "without", "newline", "0123456789abcdef"}),
+              tokens[3]);
+
+    auto views = csvtok->get_field_views();
+    auto starts = csvtok->get_row_starts();
+    ASSERT_EQ(5ul, starts.size());
+    EXPECT_EQ(10ul, starts.back());
+    EXPECT_EQ(views.size(), starts.back());
+    for (auto row = 0ul; row + 1 < starts.size(); row++)
+        for (auto i = starts[row]; i < starts[row + 1]; i++)
+            EXPECT_EQ(tokens[row][i - starts[row]], views[i].to_string());
+
+    /* Fields without doubled quotes point into the contents */
+    auto& contents = get_utf8_contents (csv_tok);
+    EXPECT_EQ(contents.data() + 2, views[1].data());
+    EXPECT_EQ(contents.data() + 6, views[2].data());
+}
+
 
 
 void
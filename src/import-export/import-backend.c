@@ -41,6 +41,7 @@
 #include "Query.h"
 #include "gnc-engine.h"
 #include "engine-helpers.h"
+#include "gnc-event.h"
 #include "gnc-prefs.h"
 #include "gnc-ui-util.h"
 
@@ -802,6 +803,84 @@ static void split_find_match (GNCImportTransInfo * trans_info,
 }/* end split_find_match */
 
 
+/** Matches the date-sorted candidate splits of one import account
+ * against each GNCImportTransInfo of that account.  Only the
+ * candidates within match_date_hardlimit days of a transaction are
+ * handed to split_find_match, and they are found by binary search, so
+ * every TransInfo costs log(candidates) plus the size of its window. */
+static void
+account_find_split_matches (Account *importaccount,
+                            GList *trans_info_list,
+                            gint process_threshold,
+                            double fuzzy_amount_difference,
+                            gint match_date_hardlimit)
+{
+    time64 range = (time64)match_date_hardlimit * 86400;
+    time64 min_time = G_MAXINT64, max_time = G_MININT64;
+    Query *query;
+    GList *node, *splits;
+    Split **candidates;
+    time64 *candidate_dates;
+    guint n_candidates, i;
+
+    for (node = trans_info_list; node; node = g_list_next (node))
+    {
+        time64 download_time =
+            xaccTransGetDate (gnc_import_TransInfo_get_trans (node->data));
+        min_time = MIN (min_time, download_time);
+        max_time = MAX (max_time, download_time);
+    }
+
+    /* One query for the whole date range of the import.  Its results
+       are sorted by date posted (see xaccSplitOrder), so the splits
+       near a given date are contiguous and in the same order as a
+       query for just that date's window would return them. */
+    query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, gnc_account_get_book (importaccount));
+    xaccQueryAddSingleAccountMatch (query, importaccount, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (query,
+                             TRUE, min_time - range,
+                             TRUE, max_time + range,
+                             QOF_QUERY_AND);
+    splits = qof_query_run (query);
+
+    n_candidates = g_list_length (splits);
+    candidates = g_new (Split *, n_candidates);
+    candidate_dates = g_new (time64, n_candidates);
+    for (node = splits, i = 0; node; node = g_list_next (node), i++)
+    {
+        candidates[i] = node->data;
+        candidate_dates[i] = xaccTransGetDate (xaccSplitGetParent (node->data));
+    }
+    qof_query_destroy (query);
+
+    for (node = trans_info_list; node; node = g_list_next (node))
+    {
+        GNCImportTransInfo *trans_info = node->data;
+        time64 download_time =
+            xaccTransGetDate (gnc_import_TransInfo_get_trans (trans_info));
+        guint low = 0, high = n_candidates;
+
+        /* Find the first candidate inside the window */
+        while (low < high)
+        {
+            guint mid = low + (high - low) / 2;
+            if (candidate_dates[mid] < download_time - range)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        for (i = low;
+             i < n_candidates && candidate_dates[i] <= download_time + range;
+             i++)
+            split_find_match (trans_info, candidates[i],
+                              process_threshold, fuzzy_amount_difference);
+    }
+
+    g_free (candidate_dates);
+    g_free (candidates);
+}
+
 /** /brief Iterate through all splits of the originating account of the given
    transaction, and find all matching splits there. */
 void gnc_import_find_split_matches(GNCImportTransInfo *trans_info,
@@ -809,55 +888,51 @@ void gnc_import_find_split_matches(GNCImportTransInfo *trans_info,
                                    double fuzzy_amount_difference,
                                    gint match_date_hardlimit)
 {
-    GList * list_element;
-    Query *query = qof_query_create_for(GNC_ID_SPLIT);
+    GList *trans_info_list;
     g_assert (trans_info);
 
-    /* Get list of splits of the originating account. */
+    trans_info_list = g_list_prepend (NULL, trans_info);
+    gnc_import_find_split_matches_list (trans_info_list, process_threshold,
+                                        fuzzy_amount_difference,
+                                        match_date_hardlimit);
+    g_list_free (trans_info_list);
+}
+
+/** /brief Find the matching splits of all the given transactions at
+   once, with one query per originating account instead of one per
+   transaction. */
+void gnc_import_find_split_matches_list (GList *trans_info_list,
+                                         gint process_threshold,
+                                         double fuzzy_amount_difference,
+                                         gint match_date_hardlimit)
+{
+    GHashTable *accounts;
+    GHashTableIter iter;
+    gpointer key, value;
+    GList *node;
+
+    /* Group the transactions by the account they were imported into,
+       keeping them in the order they were given. */
+    accounts = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = g_list_last (trans_info_list); node; node = g_list_previous (node))
     {
-        /* We used to traverse *all* splits of the account by using
-           xaccAccountGetSplitList, which is a bad idea because 90% of these
-           splits are outside the date range that is interesting. We should
-           rather use a query according to the date region, which is
-           implemented here.
-        */
         Account *importaccount =
-            xaccSplitGetAccount (gnc_import_TransInfo_get_fsplit (trans_info));
-        time64 download_time = xaccTransGetDate (gnc_import_TransInfo_get_trans (trans_info));
-
-        qof_query_set_book (query, gnc_get_current_book());
-        xaccQueryAddSingleAccountMatch (query, importaccount,
-                                        QOF_QUERY_AND);
-        xaccQueryAddDateMatchTT (query,
-                                 TRUE, download_time - match_date_hardlimit * 86400,
-                                 TRUE, download_time + match_date_hardlimit * 86400,
-                                 QOF_QUERY_AND);
-        list_element = qof_query_run (query);
-        /* Sigh. Doesn't help too much. We still create and run one query
-           for each imported transaction. Maybe it would improve
-           performance further if there is one single (master-)query at
-           the beginning, matching the full date range and all accounts in
-           question. However, this doesn't quite work because this function
-           here is called from each gnc_gen_trans_list_add_trans(), which
-           is called one at a time. Therefore the whole importer would
-           have to change its behaviour: Accept the imported txns via
-           gnc_gen_trans_list_add_trans(), and only when
-           gnc_gen_trans_list_run() is called, then calculate all the
-           different match candidates. That's too much work for now.
-        */
+            xaccSplitGetAccount (gnc_import_TransInfo_get_fsplit (node->data));
+        GList *account_list = g_hash_table_lookup (accounts, importaccount);
+
+        g_hash_table_insert (accounts, importaccount,
+                             g_list_prepend (account_list, node->data));
     }
 
-    /* Traverse that list, calling split_find_match on each one. Note
-       that xaccAccountForEachSplit is declared in Account.h but
-       implemented nowhere :-( */
-    while (list_element != NULL)
+    g_hash_table_iter_init (&iter, accounts);
+    while (g_hash_table_iter_next (&iter, &key, &value))
     {
-        split_find_match (trans_info, list_element->data,
-                          process_threshold, fuzzy_amount_difference);
-        list_element = g_list_next (list_element);
+        account_find_split_matches (key, value, process_threshold,
+                                    fuzzy_amount_difference,
+                                    match_date_hardlimit);
+        g_list_free (value);
     }
-
-    qof_query_destroy (query);
+    g_hash_table_destroy (accounts);
 }
 
 
@@ -1079,65 +1154,159 @@ gnc_import_process_trans_item (GncImportMatchMap *matchmap,
 }
 
 /********************************************************************\
- * check_trans_online_id() Callback function used by
- * gnc_import_exists_online_id.  Takes pointers to transaction and split,
- * returns 0 if their online_ids  do NOT match, or if the split
- * belongs to the transaction
+ * The online_id index of an import.  For each account that imported
+ * transactions are checked against, it maps the online_ids of the
+ * transactions in the account to the split through which the
+ * transaction belongs to the account.  A transaction's online_id is
+ * that of its first split in the account or, if that split has none,
+ * the transaction's own.
 \********************************************************************/
-static gint check_trans_online_id(Transaction *trans1, void *user_data)
+
+struct _onlineidindex
 {
-    Account *account;
-    Split *split1;
-    Split *split2 = user_data;
-    const gchar *online_id1;
-    const gchar *online_id2;
-
-    account = xaccSplitGetAccount(split2);
-    split1 = xaccTransFindSplitByAccount(trans1, account);
-    if (split1 == split2)
-        return 0;
+    GHashTable *accounts; /* Account* -> GHashTable of online_id -> Split* */
+    gint event_handler_id;
+};
 
-    /* hack - we really want to iterate over the _splits_ of the account
-       instead of the transactions */
-    g_assert(split1 != NULL);
+/* Returns the online_id by which split's transaction is known in
+   account, or NULL.  The caller owns the string. */
+static gchar *
+split_account_online_id (Split *split, Account *account)
+{
+    Transaction *trans = xaccSplitGetParent (split);
+    gchar *online_id;
+
+    if (!trans || xaccTransFindSplitByAccount (trans, account) != split)
+        return NULL;
+    online_id = (gchar *)gnc_import_get_split_online_id (split);
+    if (online_id && *online_id)
+        return online_id;
+    g_free (online_id);
+    return (gchar *)gnc_import_get_trans_online_id (trans);
+}
 
-    if (gnc_import_split_has_online_id(split1))
-        online_id1 = gnc_import_get_split_online_id(split1);
+static void
+online_ids_add_split (GHashTable *online_ids, Account *account, Split *split)
+{
+    gchar *online_id = split_account_online_id (split, account);
+
+    if (online_id && !g_hash_table_lookup (online_ids, online_id))
+        g_hash_table_insert (online_ids, online_id, split);
     else
-        online_id1 = gnc_import_get_trans_online_id(trans1);
+        g_free (online_id);
+}
 
-    online_id2 = gnc_import_get_split_online_id(split2);
+static GHashTable *
+online_ids_new (Account *account)
+{
+    GHashTable *online_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, NULL);
+    GList *node;
 
-    if ((online_id1 == NULL) ||
-            (online_id2 == NULL) ||
-            (strcmp(online_id1, online_id2) != 0))
-    {
-        return 0;
-    }
-    else
+    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+        online_ids_add_split (online_ids, account, node->data);
+    return online_ids;
+}
+
+static gboolean
+online_id_is_split (gpointer online_id, gpointer split, gpointer removed_split)
+{
+    return split == removed_split;
+}
+
+/* Keeps the indexed accounts current as transactions are committed
+   to them or removed from them. */
+static void
+online_id_index_event_handler (QofInstance *entity, QofEventId event_type,
+                               gpointer user_data, gpointer event_data)
+{
+    GNCImportOnlineIdIndex *index = user_data;
+    GHashTable *online_ids;
+    gchar *online_id;
+
+    online_ids = g_hash_table_lookup (index->accounts, entity);
+    if (!online_ids)
+        return;
+
+    if (event_type == GNC_EVENT_ITEM_ADDED)
     {
-        /*printf("test_trans_online_id(): Duplicate found\n");*/
-        return 1;
+        online_ids_add_split (online_ids, GNC_ACCOUNT (entity), event_data);
+        return;
     }
+    /* A split being destroyed or moved may no longer tell its online_id
+       in this account; then it has to be looked for by value. */
+    online_id = split_account_online_id (event_data, GNC_ACCOUNT (entity));
+    if (!online_id)
+        g_hash_table_foreach_remove (online_ids, online_id_is_split, event_data);
+    else if (g_hash_table_lookup (online_ids, online_id) == event_data)
+        g_hash_table_remove (online_ids, online_id);
+    g_free (online_id);
+}
+
+GNCImportOnlineIdIndex *
+gnc_import_OnlineIdIndex_new (void)
+{
+    GNCImportOnlineIdIndex *index = g_new0 (GNCImportOnlineIdIndex, 1);
+
+    index->accounts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL,
+                                             (GDestroyNotify)g_hash_table_destroy);
+    index->event_handler_id =
+        qof_event_register_filtered_handler (GNC_ID_ACCOUNT,
+                                             GNC_EVENT_ITEM_ADDED |
+                                             GNC_EVENT_ITEM_REMOVED,
+                                             online_id_index_event_handler,
+                                             index);
+    return index;
+}
+
+void
+gnc_import_OnlineIdIndex_delete (GNCImportOnlineIdIndex *index)
+{
+    if (!index)
+        return;
+    qof_event_unregister_handler (index->event_handler_id);
+    g_hash_table_destroy (index->accounts);
+    g_free (index);
 }
 
 /** Checks whether the given transaction's online_id already exists in
   its parent account. */
-gboolean gnc_import_exists_online_id (Transaction *trans)
+gboolean gnc_import_exists_online_id (Transaction *trans,
+                                      GNCImportOnlineIdIndex *index)
 {
     gboolean online_id_exists = FALSE;
     Account *dest_acct;
-    Split *source_split;
+    Split *source_split, *existing_split;
+    GHashTable *online_ids;
+    gchar *online_id;
 
     /* Look for an online_id in the first split */
     source_split = xaccTransGetSplit(trans, 0);
     g_assert(source_split);
+    online_id = (gchar *)gnc_import_get_split_online_id (source_split);
+    if (online_id == NULL)
+        return FALSE;
 
     /* DEBUG("%s%d%s","Checking split ",i," for duplicates"); */
     dest_acct = xaccSplitGetAccount(source_split);
-    online_id_exists = xaccAccountForEachTransaction(dest_acct,
-                       check_trans_online_id,
-                       source_split);
+    if (index)
+    {
+        online_ids = g_hash_table_lookup (index->accounts, dest_acct);
+        if (!online_ids)
+        {
+            online_ids = online_ids_new (dest_acct);
+            g_hash_table_insert (index->accounts, dest_acct, online_ids);
+        }
+    }
+    else
+        online_ids = online_ids_new (dest_acct);
+
+    existing_split = g_hash_table_lookup (online_ids, online_id);
+    online_id_exists = (existing_split != NULL && existing_split != source_split);
+    g_free (online_id);
+    if (!index)
+        g_hash_table_destroy (online_ids);
 
     /* If it does, abort the process for this transaction, since it is
        already in the system. */
@@ -1187,23 +1356,14 @@ static gint compare_probability (gconstpointer a,
            ((GNCImportMatchInfo *)a)->probability);
 }
 
-/** Iterates through all splits of the originating account of
- * trans_info. Sorts the resulting list and sets the selected_match
- * and action fields in the trans_info.
+/** Sorts the match list of trans_info and sets the selected_match
+ * and action fields from it.
  */
-void
-gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
-                                   GNCImportSettings *settings)
+static void
+trans_info_select_best_match (GNCImportTransInfo *trans_info,
+                              GNCImportSettings *settings)
 {
     GNCImportMatchInfo * best_match = NULL;
-    g_assert (trans_info);
-
-
-    /* Find all split matches in originating account. */
-    gnc_import_find_split_matches(trans_info,
-                                  gnc_import_Settings_get_display_threshold (settings),
-                                  gnc_import_Settings_get_fuzzy_amount (settings),
-                                  gnc_import_Settings_get_match_date_hardlimit (settings));
 
     if (trans_info->match_list != NULL)
     {
@@ -1253,6 +1413,42 @@ gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
     trans_info->previous_action = trans_info->action;
 }
 
+/** Iterates through all splits of the originating account of
+ * trans_info. Sorts the resulting list and sets the selected_match
+ * and action fields in the trans_info.
+ */
+void
+gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
+                                   GNCImportSettings *settings)
+{
+    g_assert (trans_info);
+
+    /* Find all split matches in originating account. */
+    gnc_import_find_split_matches(trans_info,
+                                  gnc_import_Settings_get_display_threshold (settings),
+                                  gnc_import_Settings_get_fuzzy_amount (settings),
+                                  gnc_import_Settings_get_match_date_hardlimit (settings));
+    trans_info_select_best_match (trans_info, settings);
+}
+
+/** Does gnc_import_TransInfo_init_matches for all the TransInfos of
+ * trans_info_list, looking up the candidate splits of each
+ * originating account only once.
+ */
+void
+gnc_import_TransInfo_init_matches_list (GList *trans_info_list,
+                                        GNCImportSettings *settings)
+{
+    GList *node;
+
+    gnc_import_find_split_matches_list (trans_info_list,
+                                        gnc_import_Settings_get_display_threshold (settings),
+                                        gnc_import_Settings_get_fuzzy_amount (settings),
+                                        gnc_import_Settings_get_match_date_hardlimit (settings));
+    for (node = trans_info_list; node; node = g_list_next (node))
+        trans_info_select_best_match (node->data, settings);
+}
+
 
 /* Try to automatch a transaction to a destination account if the */
 /* transaction hasn't already been manually assigned to another account */
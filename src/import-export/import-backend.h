@@ -32,6 +32,7 @@
 #include "import-settings.h"
 
 typedef struct _transactioninfo GNCImportTransInfo;
+typedef struct _onlineidindex GNCImportOnlineIdIndex;
 typedef struct _selected_match_info GNCImportSelectedMatchInfo;
 typedef struct _matchinfo
 {
@@ -57,14 +58,29 @@ typedef enum _action
 /** @name Non-GUI Functions */
 /*@{*/
 
+/** Create an index of the online_ids in the accounts that transactions
+ * are imported into, for gnc_import_exists_online_id.  Each account
+ * is indexed the first time a transaction is checked against it, and
+ * the index follows the transactions committed to or removed from
+ * that account afterwards, until it is deleted.  One index should
+ * serve a whole import. */
+GNCImportOnlineIdIndex *gnc_import_OnlineIdIndex_new (void);
+
+/** Delete an index made by gnc_import_OnlineIdIndex_new. */
+void gnc_import_OnlineIdIndex_delete (GNCImportOnlineIdIndex *index);
+
 /** Checks whether the given transaction's online_id already exists in
  * its parent account. The given transaction has to be open for
  * editing. If a matching online_id exists, the transaction is
  * destroyed (!) and TRUE is returned, otherwise FALSE is returned.
  *
  * @param trans The transaction for which to check for an existing
- * online_id. */
-gboolean gnc_import_exists_online_id (Transaction *trans);
+ * online_id.
+ *
+ * @param index The online_id index to look the online_id up in.  If
+ * NULL, the account's transactions are scanned instead. */
+gboolean gnc_import_exists_online_id (Transaction *trans,
+                                      GNCImportOnlineIdIndex *index);
 
 /** Iterate through all splits of the originating account of the given
  * transaction, find all matching splits there, and store them in the
@@ -95,6 +111,22 @@ void gnc_import_find_split_matches(GNCImportTransInfo *trans_info,
                                    double fuzzy_amount_difference,
                                    gint match_date_hardlimit);
 
+/** Like gnc_import_find_split_matches, but for a whole import at
+ * once: all the transactions of trans_info_list that come from the
+ * same account share a single query over their combined date range,
+ * and each of them is only scored against the splits in its own
+ * window of match_date_hardlimit days.
+ *
+ * @param trans_info_list A GList of the GNCImportTransInfo's for which
+ * the matching existing transactions should be found.
+ *
+ * The other parameters are those of gnc_import_find_split_matches.
+ */
+void gnc_import_find_split_matches_list (GList *trans_info_list,
+                                         gint process_threshold,
+                                         double fuzzy_amount_difference,
+                                         gint match_date_hardlimit);
+
 /** Iterates through all splits of the originating account of
  * trans_info. Sorts the resulting list and sets the selected_match
  * and action fields in the trans_info.
@@ -108,6 +140,20 @@ void
 gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
                                    GNCImportSettings *settings);
 
+/** Calls gnc_import_TransInfo_init_matches for every TransInfo of
+ * trans_info_list, but finds the matches of all of them with
+ * gnc_import_find_split_matches_list.  Importers that add many
+ * transactions should collect them first and use this.
+ *
+ * @param trans_info_list A GList of the TransInfo's for which the
+ * matches should be found, sorted, and selected.
+ *
+ * @param settings The structure that holds all the user preferences.
+ */
+void
+gnc_import_TransInfo_init_matches_list (GList *trans_info_list,
+                                        GNCImportSettings *settings);
+
 /** This function is intended to be called when the importer dialog is
  * finished. It should be called once for each imported transaction
  * and processes each ImportTransInfo according to its selected action:
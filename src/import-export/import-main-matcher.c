@@ -66,6 +66,8 @@ struct _main_matcher_info
     GNCTransactionProcessedCB transaction_processed_cb;
     gpointer user_data;
     GNCImportPendingMatches *pending_matches;
+    GList *temp_trans_list; /* Added TransInfos not yet matched and shown */
+    GNCImportOnlineIdIndex *online_id_index;
 };
 
 enum downloaded_cols
@@ -100,16 +102,22 @@ void on_matcher_help_close_clicked (GtkButton *button, gpointer user_data);
 static void
 refresh_model_row(GNCImportMainMatcher *gui, GtkTreeModel *model,
                   GtkTreeIter *iter, GNCImportTransInfo *info);
+static void
+gnc_gen_trans_list_create_matches (GNCImportMainMatcher *gui);
 
 void gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
 {
     GtkTreeModel *model;
     GtkTreeIter iter;
     GNCImportTransInfo *trans_info;
+    GList *node;
 
     if (info == NULL)
         return;
 
+    gnc_import_OnlineIdIndex_delete (info->online_id_index);
+    info->online_id_index = NULL;
+
     model = gtk_tree_view_get_model(info->view);
     if (gtk_tree_model_get_iter_first(model, &iter))
     {
@@ -131,6 +139,16 @@ void gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
         while (gtk_tree_model_iter_next (model, &iter));
     }
 
+    for (node = info->temp_trans_list; node; node = g_list_next (node))
+    {
+        trans_info = node->data;
+        if (info->transaction_processed_cb)
+            info->transaction_processed_cb(trans_info, FALSE, info->user_data);
+        gnc_import_TransInfo_delete(trans_info);
+    }
+    g_list_free (info->temp_trans_list);
+    info->temp_trans_list = NULL;
+
 
     if (!(info->dialog == NULL))
     {
@@ -155,6 +173,7 @@ on_matcher_ok_clicked (GtkButton *button,
 
     /*   DEBUG ("Begin") */
 
+    gnc_gen_trans_list_create_matches (info);
     model = gtk_tree_view_get_model(info->view);
     if (!gtk_tree_model_get_iter_first(model, &iter))
         return;
@@ -162,6 +181,9 @@ on_matcher_ok_clicked (GtkButton *button,
     /* Don't run any queries and/or split sorts while processing the matcher
     results. */
     gnc_suspend_gui_refresh();
+    qof_event_begin_batch();
+    /* Let a database backend store the new transactions together. */
+    qof_book_begin_bulk_commit(gnc_get_current_book());
 
     do
     {
@@ -181,6 +203,9 @@ on_matcher_ok_clicked (GtkButton *button,
     }
     while (gtk_tree_model_iter_next (model, &iter));
 
+    qof_book_end_bulk_commit(gnc_get_current_book());
+    /* Hand the events to the batch handlers before the refresh. */
+    qof_event_end_batch();
     /* Allow GUI refresh again. */
     gnc_resume_gui_refresh();
 
@@ -538,6 +563,7 @@ GNCImportMainMatcher *gnc_gen_trans_list_new (GtkWidget *parent,
 
     info = g_new0 (GNCImportMainMatcher, 1);
     info->pending_matches = gnc_import_PendingMatches_new();
+    info->online_id_index = gnc_import_OnlineIdIndex_new();
 
     /* Initialize user Settings. */
     info->user_settings = gnc_import_Settings_new ();
@@ -606,6 +632,7 @@ GNCImportMainMatcher * gnc_gen_trans_assist_new (GtkWidget *parent,
 
     info = g_new0 (GNCImportMainMatcher, 1);
     info->pending_matches = gnc_import_PendingMatches_new();
+    info->online_id_index = gnc_import_OnlineIdIndex_new();
 
     /* Initialize user Settings. */
     info->user_settings = gnc_import_Settings_new ();
@@ -671,6 +698,7 @@ gboolean gnc_gen_trans_list_run (GNCImportMainMatcher *info)
     gboolean result;
 
     /* DEBUG("Begin"); */
+    gnc_gen_trans_list_create_matches (info);
     result = gtk_dialog_run (GTK_DIALOG (info->dialog));
     /* DEBUG("Result was %d", result); */
 
@@ -902,24 +930,46 @@ void gnc_gen_trans_list_add_trans(GNCImportMainMatcher *gui, Transaction *trans)
 void gnc_gen_trans_list_add_trans_with_ref_id(GNCImportMainMatcher *gui, Transaction *trans, guint32 ref_id)
 {
     GNCImportTransInfo * transaction_info = NULL;
-    GtkTreeModel *model;
-    GtkTreeIter iter;
-    GNCImportMatchInfo *selected_match;
-    GncGUID *pending_match_guid;
-    gboolean match_selected_manually;
     g_assert (gui);
     g_assert (trans);
 
 
-    if (gnc_import_exists_online_id (trans))
+    if (gnc_import_exists_online_id (trans, gui->online_id_index))
         return;
     else
     {
+        /* The matches are looked up for all the added transactions
+           together, in gnc_gen_trans_list_create_matches. */
         transaction_info = gnc_import_TransInfo_new(trans, NULL);
         gnc_import_TransInfo_set_ref_id(transaction_info, ref_id);
+        gui->temp_trans_list = g_list_prepend (gui->temp_trans_list,
+                                               transaction_info);
+    }
+    return;
+}/* end gnc_import_add_trans_with_ref_id() */
 
-        gnc_import_TransInfo_init_matches(transaction_info,
-                                          gui->user_settings);
+/* Finds the matches of all the transactions added since the last call
+   and appends them to the list. */
+static void
+gnc_gen_trans_list_create_matches (GNCImportMainMatcher *gui)
+{
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    GNCImportMatchInfo *selected_match;
+    gboolean match_selected_manually;
+    GList *node;
+
+    if (gui->temp_trans_list == NULL)
+        return;
+
+    gui->temp_trans_list = g_list_reverse (gui->temp_trans_list);
+    gnc_import_TransInfo_init_matches_list (gui->temp_trans_list,
+                                            gui->user_settings);
+
+    model = gtk_tree_view_get_model(gui->view);
+    for (node = gui->temp_trans_list; node; node = g_list_next (node))
+    {
+        GNCImportTransInfo *transaction_info = node->data;
 
         selected_match =
             gnc_import_TransInfo_get_selected_match(transaction_info);
@@ -931,12 +981,20 @@ void gnc_gen_trans_list_add_trans_with_ref_id(GNCImportMainMatcher *gui, Transac
                                                 selected_match,
                                                 match_selected_manually);
 
-        model = gtk_tree_view_get_model(gui->view);
         gtk_list_store_append(GTK_LIST_STORE(model), &iter);
         refresh_model_row (gui, model, &iter, transaction_info);
     }
-    return;
-}/* end gnc_import_add_trans_with_ref_id() */
+    g_list_free (gui->temp_trans_list);
+    gui->temp_trans_list = NULL;
+}
+
+void gnc_gen_trans_list_show_all (GNCImportMainMatcher *info)
+{
+    g_assert (info);
+    gnc_gen_trans_list_create_matches (info);
+    if (info->dialog)
+        gtk_widget_show_all (GTK_WIDGET (info->dialog));
+}
 
 GtkWidget *gnc_gen_trans_list_widget (GNCImportMainMatcher *info)
 {
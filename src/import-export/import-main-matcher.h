@@ -166,6 +166,17 @@ void gnc_gen_trans_list_add_trans(GNCImportMainMatcher *gui, Transaction *trans)
 void gnc_gen_trans_list_add_trans_with_ref_id(GNCImportMainMatcher *gui, Transaction *trans, guint32 ref_id);
 
 
+/** Look up the matches of all the transactions added so far and show
+ * them in the list.  The matches are found for the whole batch at
+ * once, so importers should call this after adding their last
+ * transaction rather than leaving it to gnc_gen_trans_list_run or the
+ * Ok button, which only do it for transactions still unmatched.
+ *
+ * @param info The Transaction Importer to use.
+ */
+void gnc_gen_trans_list_show_all (GNCImportMainMatcher *info);
+
+
 /** Run this dialog and return only after the user pressed Ok, Cancel,
   or closed the window. This means that all actual importing will
   have been finished upon returning.
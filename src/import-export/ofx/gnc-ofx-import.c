@@ -1031,6 +1031,7 @@ void gnc_file_ofx_import (void)
         DEBUG("Opening selected file");
         libofx_proc_file(libofx_context, selected_filename, AUTODETECT);
         g_free(selected_filename);
+        gnc_gen_trans_list_show_all(gnc_ofx_importer_gui);
     }
 
     if (ofx_created_commodites)
@@ -0,0 +1,307 @@
+#include <config.h>
+#include <unittest-support.h>
+
+#include <glib.h>
+#include <gtk/gtk.h> /* for references in import-backend.h */
+#include "import-backend.h"
+#include "import-utilities.h"
+#include "Account.h"
+#include "Split.h"
+#include "Transaction.h"
+#include "Query.h"
+#include "cashobjects.h"
+#include "test-engine-stuff.h"
+
+static const gchar *suitename = "/import-export/import-backend";
+
+/* Noon UTC on 2015-06-15 */
+static const time64 base_time = 1434369600;
+static const gint num_days = 60;
+
+typedef struct
+{
+    QofBook *book;
+    gnc_commodity *currency;
+    Account *account1;
+    Account *account2;
+    Account *other;
+} Fixture;
+
+static Transaction *
+make_transaction (Fixture *fixture, Account *account, time64 date,
+                  gint64 amount, const gchar *description)
+{
+    Transaction *txn = xaccMallocTransaction (fixture->book);
+    Split *split = xaccMallocSplit (fixture->book);
+    Split *other_split = xaccMallocSplit (fixture->book);
+    gnc_numeric value = gnc_numeric_create (amount, 100);
+
+    xaccTransBeginEdit (txn);
+    xaccTransSetCurrency (txn, fixture->currency);
+    xaccTransSetDatePostedSecs (txn, date);
+    xaccTransSetDescription (txn, description);
+    xaccSplitSetParent (split, txn);
+    xaccSplitSetAccount (split, account);
+    xaccSplitSetAmount (split, value);
+    xaccSplitSetValue (split, value);
+    xaccSplitSetParent (other_split, txn);
+    xaccSplitSetAccount (other_split, fixture->other);
+    xaccSplitSetAmount (other_split, gnc_numeric_neg (value));
+    xaccSplitSetValue (other_split, gnc_numeric_neg (value));
+    return txn;
+}
+
+static Account *
+make_account (Fixture *fixture)
+{
+    Account *account = xaccMallocAccount (fixture->book);
+
+    xaccAccountBeginEdit (account);
+    xaccAccountSetCommodity (account, fixture->currency);
+    xaccAccountCommitEdit (account);
+    return account;
+}
+
+static void
+setup (Fixture *fixture, gconstpointer pData)
+{
+    gint day;
+
+    fixture->book = qof_book_new ();
+    fixture->currency = get_random_commodity (fixture->book);
+    fixture->account1 = make_account (fixture);
+    fixture->account2 = make_account (fixture);
+    fixture->other = make_account (fixture);
+
+    /* One existing transaction per day and account, in the book */
+    for (day = 0; day < num_days; day++)
+    {
+        time64 date = base_time + day * 86400;
+        xaccTransCommitEdit (make_transaction (fixture, fixture->account1, date,
+                                               10000 + 100 * (day % 3), "Rent"));
+        xaccTransCommitEdit (make_transaction (fixture, fixture->account2, date,
+                                               2500, "Groceries"));
+    }
+}
+
+static void
+teardown (Fixture *fixture, gconstpointer pData)
+{
+    qof_book_destroy (fixture->book);
+
+    test_clear_error_list();
+}
+
+/* Imports four transactions.  They are left open, as the importers
+ * do, and gnc_import_TransInfo_delete destroys them again. */
+static GList *
+make_trans_infos (Fixture *fixture)
+{
+    GList *trans_infos = NULL;
+
+    trans_infos =
+        g_list_prepend (trans_infos,
+                        gnc_import_TransInfo_new (make_transaction (fixture, fixture->account1,
+                                                                    base_time - 86400,
+                                                                    10000, "Rent"),
+                                                  NULL));
+    trans_infos =
+        g_list_prepend (trans_infos,
+                        gnc_import_TransInfo_new (make_transaction (fixture, fixture->account1,
+                                                                    base_time + 20 * 86400,
+                                                                    10100, "Rent"),
+                                                  NULL));
+    trans_infos =
+        g_list_prepend (trans_infos,
+                        gnc_import_TransInfo_new (make_transaction (fixture, fixture->account2,
+                                                                    base_time + 30 * 86400 + 3600,
+                                                                    2500, "Groceries"),
+                                                  NULL));
+    trans_infos =
+        g_list_prepend (trans_infos,
+                        gnc_import_TransInfo_new (make_transaction (fixture, fixture->account1,
+                                                                    base_time + (num_days + 10) * 86400,
+                                                                    10000, "Rent"),
+                                                  NULL));
+    return g_list_reverse (trans_infos);
+}
+
+static void
+free_trans_infos (GList *trans_infos)
+{
+    GList *node;
+
+    for (node = trans_infos; node; node = g_list_next (node))
+    {
+        /* The match list itself is freed with the TransInfo */
+        g_list_foreach (gnc_import_TransInfo_get_match_list (node->data),
+                        (GFunc)g_free, NULL);
+        gnc_import_TransInfo_delete (node->data);
+    }
+    g_list_free (trans_infos);
+}
+
+static void
+test_find_split_matches_list_window (Fixture *fixture, gconstpointer pData)
+{
+    GList *trans_infos = make_trans_infos (fixture);
+    GNCImportTransInfo *info;
+    GList *matches;
+
+    /* With no threshold every candidate in the window is a match */
+    gnc_import_find_split_matches_list (trans_infos, -100, 0.0, 3);
+
+    /* Day -1: the existing days 0 to 2 */
+    info = g_list_nth_data (trans_infos, 0);
+    g_assert_cmpint (g_list_length (gnc_import_TransInfo_get_match_list (info)), ==, 3);
+    /* Day 20: days 17 to 23 */
+    info = g_list_nth_data (trans_infos, 1);
+    g_assert_cmpint (g_list_length (gnc_import_TransInfo_get_match_list (info)), ==, 7);
+    /* Day 30 plus an hour in the other account: days 28 to 33 */
+    info = g_list_nth_data (trans_infos, 2);
+    matches = gnc_import_TransInfo_get_match_list (info);
+    g_assert_cmpint (g_list_length (matches), ==, 6);
+    g_assert (xaccSplitGetAccount (gnc_import_MatchInfo_get_split (matches->data))
+              == fixture->account2);
+    /* Day 70: nothing that close */
+    info = g_list_nth_data (trans_infos, 3);
+    g_assert (gnc_import_TransInfo_get_match_list (info) == NULL);
+
+    free_trans_infos (trans_infos);
+}
+
+/* The candidates the importer used to find with one query per imported
+ * transaction: the splits of its account posted within the date limit. */
+static GList *
+query_split_candidates (Fixture *fixture, GNCImportTransInfo *info,
+                        gint match_date_hardlimit)
+{
+    QofQuery *query = qof_query_create_for (GNC_ID_SPLIT);
+    Account *importaccount =
+        xaccSplitGetAccount (gnc_import_TransInfo_get_fsplit (info));
+    time64 download_time = xaccTransGetDate (gnc_import_TransInfo_get_trans (info));
+    GList *splits;
+
+    qof_query_set_book (query, fixture->book);
+    xaccQueryAddSingleAccountMatch (query, importaccount, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (query,
+                             TRUE, download_time - match_date_hardlimit * 86400,
+                             TRUE, download_time + match_date_hardlimit * 86400,
+                             QOF_QUERY_AND);
+    splits = g_list_copy (qof_query_run (query));
+    qof_query_destroy (query);
+    return splits;
+}
+
+static void
+test_find_split_matches_list_same_as_query (Fixture *fixture, gconstpointer pData)
+{
+    GList *trans_infos = make_trans_infos (fixture);
+    GList *node, *splits, *matches;
+    static const gint hardlimits[] = { 1, 3, 14 };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (hardlimits); i++)
+    {
+        gint hardlimit = hardlimits[i];
+
+        /* With no threshold every candidate is a match */
+        gnc_import_find_split_matches_list (trans_infos, -100, 2.0, hardlimit);
+
+        for (node = trans_infos; node; node = g_list_next (node))
+        {
+            GHashTable *expected = g_hash_table_new (g_direct_hash,
+                                                     g_direct_equal);
+
+            splits = query_split_candidates (fixture, node->data, hardlimit);
+            for (; splits; splits = g_list_delete_link (splits, splits))
+            {
+                /* The imported transactions are open and never matched */
+                if (!xaccTransIsOpen (xaccSplitGetParent (splits->data)))
+                    g_hash_table_add (expected, splits->data);
+            }
+
+            matches = gnc_import_TransInfo_get_match_list (node->data);
+            g_assert_cmpint (g_list_length (matches), ==,
+                             g_hash_table_size (expected));
+            for (; matches; matches = g_list_next (matches))
+            {
+                Split *split = gnc_import_MatchInfo_get_split (matches->data);
+                g_assert (g_hash_table_remove (expected, split));
+            }
+            g_hash_table_destroy (expected);
+        }
+
+        free_trans_infos (trans_infos);
+        trans_infos = make_trans_infos (fixture);
+    }
+
+    free_trans_infos (trans_infos);
+}
+
+static Transaction *
+make_imported_transaction (Fixture *fixture, const gchar *online_id)
+{
+    Transaction *txn = make_transaction (fixture, fixture->account1,
+                                         base_time, 10000, "Rent");
+    gnc_import_set_split_online_id (xaccTransGetSplit (txn, 0), online_id);
+    return txn;
+}
+
+static void
+test_online_id_index (Fixture *fixture, gconstpointer pData)
+{
+    GNCImportOnlineIdIndex *index = gnc_import_OnlineIdIndex_new ();
+    Split *split = g_list_nth_data (xaccAccountGetSplitList (fixture->account1), 5);
+    Transaction *txn, *committed;
+
+    xaccTransBeginEdit (xaccSplitGetParent (split));
+    gnc_import_set_split_online_id (split, "fitid-5");
+    xaccTransCommitEdit (xaccSplitGetParent (split));
+
+    /* Duplicates are destroyed */
+    g_assert (gnc_import_exists_online_id (make_imported_transaction (fixture, "fitid-5"),
+                                           index));
+    g_assert (gnc_import_exists_online_id (make_imported_transaction (fixture, "fitid-5"),
+                                           NULL));
+
+    committed = make_imported_transaction (fixture, "fitid-new");
+    g_assert (!gnc_import_exists_online_id (committed, index));
+
+    /* Committing adds the transaction to the index */
+    xaccTransCommitEdit (committed);
+    txn = make_imported_transaction (fixture, "fitid-new");
+    g_assert (gnc_import_exists_online_id (txn, index));
+
+    /* And destroying it removes it again */
+    xaccTransBeginEdit (committed);
+    xaccTransDestroy (committed);
+    xaccTransCommitEdit (committed);
+    txn = make_imported_transaction (fixture, "fitid-new");
+    g_assert (!gnc_import_exists_online_id (txn, index));
+    xaccTransDestroy (txn);
+    xaccTransCommitEdit (txn);
+
+    gnc_import_OnlineIdIndex_delete (index);
+}
+
+int
+main (int argc, char *argv[])
+{
+    int result;
+    qof_init();
+    cashobjects_register();
+    g_test_init (&argc, &argv, NULL);
+
+    GNC_TEST_ADD (suitename, "find_split_matches_list_window", Fixture, NULL,
+                  setup, test_find_split_matches_list_window, teardown);
+    GNC_TEST_ADD (suitename, "find_split_matches_list_same_as_query", Fixture,
+                  NULL, setup, test_find_split_matches_list_same_as_query,
+                  teardown);
+    GNC_TEST_ADD (suitename, "online_id_index", Fixture, NULL, setup,
+                  test_online_id_index, teardown);
+    result = g_test_run();
+
+    qof_close();
+    return result;
+}
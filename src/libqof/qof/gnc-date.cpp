@@ -127,7 +127,7 @@ gnc_localtime_r (const time64 *secs, struct tm* time)
 {
     try
     {
-	*time = static_cast<struct tm>(GncDateTime(*secs));
+	*time = GncDateTime::local_tm(*secs);
 	return time;
     }
     catch(std::invalid_argument)
@@ -211,14 +211,34 @@ gnc_gmtime (const time64 *secs)
 
 }
 
+/* Seconds from the POSIX epoch to a normalized struct tm taken as UTC,
+ * using Howard Hinnant's public-domain days_from_civil algorithm. */
+static time64
+utc_tm_to_time64 (const struct tm* time)
+{
+    time64 y = time->tm_year + 1900;
+    unsigned m = time->tm_mon + 1;
+    unsigned d = time->tm_mday;
+
+    y -= m <= 2;
+    auto era = (y >= 0 ? y : y - 399) / 400;
+    auto yoe = static_cast<unsigned>(y - era * 400);
+    auto doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    auto days = era * 146097 + static_cast<time64>(doe) - 719468;
+
+    return days * 86400 + time->tm_hour * 3600 + time->tm_min * 60 +
+        time->tm_sec;
+}
+
 time64
 gnc_mktime (struct tm* time)
 {
     try
     {
 	normalize_struct_tm (time);
-	GncDateTime gncdt(*time);
-	return static_cast<time64>(gncdt) - gncdt.offset();
+	auto secs = utc_tm_to_time64 (time);
+	return secs - GncDateTime::offset(secs);
     }
     catch(std::invalid_argument)
     {
@@ -229,15 +249,8 @@ gnc_mktime (struct tm* time)
 time64
 gnc_timegm (struct tm* time)
 {
-    try
-    {
-	normalize_struct_tm(time);
-	return static_cast<time64>(GncDateTime(*time));
-    }
-    catch(std::invalid_argument)
-    {
-	return 0;
-    }
+    normalize_struct_tm(time);
+    return utc_tm_to_time64 (time);
 }
 
 char*
@@ -501,6 +501,67 @@ GncDateTime::format_zulu(const char* format) const
     return m_impl->format_zulu(format);
 }
 
+/* The proleptic Gregorian date of a count of days since 1970-01-01, from
+ * Howard Hinnant's public-domain civil date algorithms. */
+static void
+civil_from_days (int64_t z, int& y, unsigned& m, unsigned& d)
+{
+    z += 719468;
+    auto era = (z >= 0 ? z : z - 146096) / 146097;
+    auto doe = static_cast<unsigned>(z - era * 146097);
+    auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    auto mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe + era * 400 + (m <= 2));
+}
+
+struct tm
+GncDateTime::local_tm(const time64 time)
+{
+    int32_t offset;
+    bool isdst;
+    if (!tzp.get_offset(time, offset, isdst))
+        return static_cast<struct tm>(GncDateTime(time));
+
+    static constexpr int64_t seconds_per_day = 24 * 3600;
+    static constexpr int days_before_month[] =
+        {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    auto local = time + offset;
+    auto days = (local >= 0 ? local : local - seconds_per_day + 1) / seconds_per_day;
+    auto secs = static_cast<int>(local - days * seconds_per_day);
+    int year;
+    unsigned month, day;
+    civil_from_days (days, year, month, day);
+
+    struct tm tm {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = secs / 3600;
+    tm.tm_min = secs / 60 % 60;
+    tm.tm_sec = secs % 60;
+    tm.tm_wday = static_cast<int>((days % 7 + 11) % 7); // 1970-01-01 was a Thursday
+    tm.tm_yday = days_before_month[month - 1] + day - 1 +
+        (month > 2 && boost::gregorian::gregorian_calendar::is_leap_year(year));
+    tm.tm_isdst = isdst ? 1 : 0;
+#if HAVE_STRUCT_TM_GMTOFF
+    tm.tm_gmtoff = offset;
+#endif
+    return tm;
+}
+
+long
+GncDateTime::offset(const time64 time)
+{
+    int32_t offset;
+    bool isdst;
+    if (tzp.get_offset(time, offset, isdst))
+        return offset;
+    return GncDateTime(time).offset();
+}
+
 /* GncDate */
 GncDate::GncDate() : m_impl{new GncDateImpl} {}
 GncDate::GncDate(int year, int month, int day) :
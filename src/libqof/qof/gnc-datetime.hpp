@@ -148,6 +148,20 @@ public:
  *  GMT (timezone Z) according to the format.
  */
     std::string format_zulu(const char* format) const;
+/** Obtain a struct tm representing a time in the current timezone, as
+ * static_cast<struct tm>(GncDateTime(time)) would but without allocating
+ * for times between 1900 and 2100.
+ * @param time Seconds from the POSIX epoch.
+ * @exception std::invalid_argument if the year is outside the constraints.
+ */
+    static struct tm local_tm(const time64 time);
+/** Obtain the UTC offset in seconds of the current timezone at a time, as
+ * GncDateTime(time).offset() would but without allocating for times
+ * between 1900 and 2100.
+ * @param time Seconds from the POSIX epoch.
+ * @exception std::invalid_argument if the year is outside the constraints.
+ */
+    static long offset(const time64 time);
 
 private:
     std::unique_ptr<GncDateTimeImpl> m_impl;
@@ -724,3 +724,116 @@ TimeZoneProvider::get(int year) const noexcept
     }
     return iter->second;
 }
+
+/* The transition table covers 1900-01-01T00:00:00Z to 2101-01-01T00:00:00Z. */
+static constexpr int64_t transitions_begin = INT64_C(-2208988800);
+static constexpr int64_t transitions_end = INT64_C(4133980800);
+static constexpr int64_t seconds_per_day = 24 * 3600;
+
+static void
+ldt_offset (const TimeZoneProvider& tzp, int64_t time, int32_t& offset,
+            bool& isdst)
+{
+    using boost::posix_time::hours;
+    using boost::posix_time::seconds;
+    boost::posix_time::ptime temp(boost::gregorian::date(1970, 1, 1),
+                                  hours(time / 3600) + seconds(time % 3600));
+    boost::local_time::local_date_time ldt(temp, tzp.get(temp.date().year()));
+    offset = (ldt.local_time() - ldt.utc_time()).total_seconds();
+    isdst = ldt.is_dst();
+}
+
+/* The instants at which a zone's DST rule for a year switches, in UTC.
+ * local_date_time applies the rules to local standard time, so a switch
+ * can happen at either end of the DST offset. */
+static void
+rule_switches (const TZ_Ptr& tz, int year, std::vector<int64_t>& times)
+{
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    if (!tz->has_dst())
+        return;
+    try
+    {
+        auto base = tz->base_utc_offset();
+        auto start = tz->dst_local_start_time(year) - base;
+        auto end = tz->dst_local_end_time(year) - base;
+        for (auto time : {start, end, end - tz->dst_offset()})
+            times.push_back((time - epoch).total_seconds());
+    }
+    catch(const std::exception& err)
+    {
+        return;
+    }
+}
+
+/* Sample the zones once a day and at every DST rule switch, then bisect
+ * each interval in which the offset changes down to the second of the
+ * change. The offsets come from boost itself, so the table agrees with
+ * local_date_time except where the offset changes back and forth within a
+ * day without a rule switch in between. */
+void
+TimeZoneProvider::build_transitions() const noexcept
+{
+    std::vector<int64_t> samples;
+    for (auto time = transitions_begin; time < transitions_end;
+         time += seconds_per_day)
+        samples.push_back(time);
+    for (int year = 1899; year <= 2101; ++year)
+    {
+        auto tz = get(year);
+        for (auto local_year = year - 1; local_year <= year + 1; ++local_year)
+            rule_switches (tz, local_year, samples);
+    }
+    std::sort(samples.begin(), samples.end());
+    samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+
+    TZ_Transition last {transitions_begin, 0, false};
+    ldt_offset (*this, last.time, last.offset, last.isdst);
+    transitions.push_back(last);
+
+    auto before = transitions_begin;
+    for (auto time : samples)
+    {
+        if (time <= transitions_begin || time >= transitions_end)
+            continue;
+        TZ_Transition next {time, 0, false};
+        ldt_offset (*this, time, next.offset, next.isdst);
+        if (next.offset == last.offset && next.isdst == last.isdst)
+        {
+            before = time;
+            continue;
+        }
+
+        while (next.time - before > 1)
+        {
+            auto mid = before + (next.time - before) / 2;
+            int32_t offset;
+            bool isdst;
+            ldt_offset (*this, mid, offset, isdst);
+            if (offset == last.offset && isdst == last.isdst)
+                before = mid;
+            else
+                next.time = mid;
+        }
+        transitions.push_back(next);
+        last = next;
+        before = time;
+    }
+}
+
+bool
+TimeZoneProvider::get_offset(int64_t time, int32_t& offset,
+                             bool& isdst) const noexcept
+{
+    if (time < transitions_begin || time >= transitions_end)
+        return false;
+
+    std::call_once(transitions_built, [this]{ build_transitions(); });
+    auto iter = std::upper_bound(transitions.begin(), transitions.end(), time,
+                                 [](int64_t t, const TZ_Transition& tr)
+                                 { return t < tr.time; });
+    --iter;
+    offset = iter->offset;
+    isdst = iter->isdst;
+    return true;
+}
@@ -32,6 +32,9 @@ extern "C"
 
 #define BOOST_ERROR_CODE_HEADER_ONLY
 #include <boost/date_time/local_time/local_time.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 namespace gnc
 {
@@ -44,6 +47,16 @@ using TZ_Entry = std::pair<int, TZ_Ptr>;
 using TZ_Vector = std::vector<TZ_Entry>;
 using time_zone_names = boost::local_time::time_zone_names;
 
+/* From time (seconds since the POSIX epoch, UTC) until the next entry,
+ * local time is offset seconds ahead of UTC. */
+struct TZ_Transition
+{
+    int64_t time;
+    int32_t offset;
+    bool isdst;
+};
+using TZ_TransitionVector = std::vector<TZ_Transition>;
+
 class TimeZoneProvider
 {
 public:
@@ -55,12 +68,26 @@ public:
     TimeZoneProvider operator=(const TimeZoneProvider&) = delete;
     TimeZoneProvider operator=(const TimeZoneProvider&&) = delete;
     TZ_Ptr get (int year) const noexcept;
+    /** Look up the offset of local time from UTC at a POSIX time, and
+     * whether DST is in effect then, without building a boost
+     * local_date_time. The answer is the same as that of a local_date_time
+     * using the zone from get() for the UTC year of the time.
+     * @param time Seconds since the POSIX epoch.
+     * @param offset Set to the number of seconds local time is ahead of UTC.
+     * @param isdst Set to whether DST is in effect.
+     * @return false if the time is outside of 1900-2100, where there is no
+     * precomputed table; offset and isdst are then unchanged.
+     */
+    bool get_offset (int64_t time, int32_t& offset, bool& isdst) const noexcept;
     static const unsigned int min_year; //1400
     static const unsigned int max_year; //9999
 private:
     void parse_file(const std::string& tzname);
     bool construct(const std::string& tzname);
+    void build_transitions() const noexcept;
     TZ_Vector zone_vector;
+    mutable std::once_flag transitions_built;
+    mutable TZ_TransitionVector transitions;
 #if PLATFORM(WINDOWS)
     void load_windows_dynamic_tz(HKEY, time_zone_names);
     void load_windows_classic_tz(HKEY, time_zone_names);
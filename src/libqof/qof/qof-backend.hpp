@@ -227,6 +227,26 @@ public:
  *    better to wait for the query).
  */
     virtual void load (QofBook*, QofBackendLoadType) = 0;
+/**
+ *    Called by qof_query_run() before it searches a book, so that a backend
+ *    which did not load the whole book can first fetch the objects that the
+ *    query might match.  Backends that keep everything in memory need not
+ *    implement it.
+ */
+    virtual void run_query(QofQuery*) {}
+/**
+ *    Whether load() left objects behind for run_query() to fetch.  The
+ *    engine skips building load-only queries when this is false, so a
+ *    backend that keeps everything in memory need not implement it.
+ */
+    virtual bool loads_on_demand() const noexcept { return false; }
+/**
+ *    Called before the engine reads the splits of an account, so that a
+ *    backend which did not load the whole book can first fetch the ones
+ *    posted on or after since (all of them for INT64_MIN).  Backends that
+ *    keep everything in memory need not implement it.
+ */
+    virtual void load_splits(QofInstance*, time64) {}
 /**
  *    Called when the engine is about to make a change to a data structure. It
  *    could provide an advisory lock on data, but no backend does this.
@@ -240,6 +260,13 @@ public:
  *    Revert changes in the engine and unlock the backend.
  */
     virtual void rollback(QofInstance*) {}
+/**
+ *    Called around a run of many commits, such as an import, which the
+ *    backend may then write out together.  Runs may nest; everything
+ *    committed is stored by the time the outermost one ends.
+ */
+    virtual void begin_bulk_commit() {}
+    virtual void end_bulk_commit() {}
 /**
  *    Synchronizes the engine contents to the backend.
  *    This should done by using version numbers (hack alert -- the engine
@@ -37,46 +37,227 @@ extern "C"
 #include "qof.h"
 }
 
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
 /* Uncomment if you need to log anything.
 static QofLogModule log_module = QOF_MOD_UTIL;
 */
 /* =================================================================== */
 /* The QOF string cache                                                */
 /*                                                                     */
-/* The cache is a GHashTable where a copy of the string is the key,    */
-/* and a ref count is the value                                        */
+/* The cache is split into shards selected by the top bits of the      */
+/* string's hash, each with its own lock, so that loader threads       */
+/* interning different strings rarely wait for each other.  Each shard */
+/* is an open-addressed table of entries; an entry holds the refcount, */
+/* the length and the string itself in one block carved out of the     */
+/* shard's arena.  Freed entries are kept on per-size free lists for   */
+/* reuse; only strings too long for the arena are g_malloc'd.          */
 /* =================================================================== */
 
-static GHashTable* qof_string_cache = NULL;
+struct CacheEntry
+{
+    guint32 refcount;
+    guint32 length;
+    char str[1];
+};
+
+struct CacheSlot
+{
+    guint32 hash;
+    CacheEntry* entry;
+};
+
+#define CACHE_SHARD_BITS 5
+#define CACHE_NUM_SHARDS (1 << CACHE_SHARD_BITS)
+#define CACHE_MIN_SLOTS 256
+#define CACHE_ALIGN 8
+#define CACHE_CHUNK_SIZE (64 * 1024)
+#define CACHE_MAX_ARENA_ENTRY 1024
+#define CACHE_NUM_FREE_LISTS (CACHE_MAX_ARENA_ENTRY / CACHE_ALIGN + 1)
+
+struct CacheShard
+{
+    std::mutex lock;
+    std::vector<CacheSlot> slots;
+    guint count = 0;
+    std::vector<char*> chunks;
+    char* chunk_pos = nullptr;
+    char* chunk_end = nullptr;
+    std::vector<CacheEntry*> free_lists;
+    guint64 references = 0;
+    gsize string_bytes = 0;
+    gsize bytes_saved = 0;
+    gsize large_bytes = 0;
+};
+
+static CacheShard qof_string_cache[CACHE_NUM_SHARDS];
 
-static GHashTable*
-qof_get_string_cache(void)
+/* FNV-1a, computing the length on the way. */
+static guint32
+cache_hash (const char* str, gsize* length)
 {
-    if (!qof_string_cache)
+    guint32 hash = 2166136261u;
+    const char* p;
+
+    for (p = str; *p; ++p)
+        hash = (hash ^ static_cast<guchar>(*p)) * 16777619u;
+    *length = p - str;
+    return hash;
+}
+
+static inline gsize
+entry_size (gsize length)
+{
+    gsize size = offsetof (CacheEntry, str) + length + 1;
+    return (size + CACHE_ALIGN - 1) & ~static_cast<gsize>(CACHE_ALIGN - 1);
+}
+
+static inline CacheShard&
+cache_shard (guint32 hash)
+{
+    return qof_string_cache[hash >> (32 - CACHE_SHARD_BITS)];
+}
+
+static CacheEntry*
+entry_alloc (CacheShard& shard, gsize size)
+{
+    CacheEntry* entry;
+
+    if (size > CACHE_MAX_ARENA_ENTRY)
+    {
+        shard.large_bytes += size;
+        return static_cast<CacheEntry*>(g_malloc (size));
+    }
+    if (shard.free_lists.empty ())
+        shard.free_lists.resize (CACHE_NUM_FREE_LISTS, nullptr);
+    /* A free entry keeps the next free entry's address in its string. */
+    entry = shard.free_lists[size / CACHE_ALIGN];
+    if (entry)
+    {
+        memcpy (&shard.free_lists[size / CACHE_ALIGN], entry->str,
+                sizeof (CacheEntry*));
+        return entry;
+    }
+    if (shard.chunk_pos + size > shard.chunk_end)
     {
-        qof_string_cache = g_hash_table_new_full(
-                               g_str_hash,               /* hash_func          */
-                               g_str_equal,              /* key_equal_func     */
-                               g_free,                   /* key_destroy_func   */
-                               g_free);                  /* value_destroy_func */
+        shard.chunk_pos = static_cast<char*>(g_malloc (CACHE_CHUNK_SIZE));
+        shard.chunk_end = shard.chunk_pos + CACHE_CHUNK_SIZE;
+        shard.chunks.push_back (shard.chunk_pos);
     }
-    return qof_string_cache;
+    entry = reinterpret_cast<CacheEntry*>(shard.chunk_pos);
+    shard.chunk_pos += size;
+    return entry;
+}
+
+static void
+entry_free (CacheShard& shard, CacheEntry* entry)
+{
+    gsize size = entry_size (entry->length);
+
+    if (size > CACHE_MAX_ARENA_ENTRY)
+    {
+        shard.large_bytes -= size;
+        g_free (entry);
+        return;
+    }
+    memcpy (entry->str, &shard.free_lists[size / CACHE_ALIGN],
+            sizeof (CacheEntry*));
+    shard.free_lists[size / CACHE_ALIGN] = entry;
+}
+
+/* Returns the index of the slot holding str, or of the empty slot
+ * where it belongs. */
+static gsize
+shard_find (const CacheShard& shard, const char* str, gsize length,
+            guint32 hash)
+{
+    gsize mask = shard.slots.size () - 1;
+    gsize i = hash & mask;
+
+    for (;; i = (i + 1) & mask)
+    {
+        const CacheSlot& slot = shard.slots[i];
+        if (!slot.entry)
+            return i;
+        if (slot.hash == hash && slot.entry->length == length &&
+            memcmp (slot.entry->str, str, length) == 0)
+            return i;
+    }
+}
+
+static void
+shard_grow (CacheShard& shard)
+{
+    gsize size = shard.slots.empty () ? CACHE_MIN_SLOTS : shard.slots.size () * 2;
+    std::vector<CacheSlot> old (size, CacheSlot{0, nullptr});
+    gsize mask = size - 1;
+
+    old.swap (shard.slots);
+    for (auto& slot : old)
+    {
+        if (!slot.entry)
+            continue;
+        gsize i = slot.hash & mask;
+        while (shard.slots[i].entry)
+            i = (i + 1) & mask;
+        shard.slots[i] = slot;
+    }
+}
+
+/* Backward-shift deletion keeps the probe sequences intact without
+ * leaving tombstones behind. */
+static void
+shard_erase (CacheShard& shard, gsize i)
+{
+    gsize mask = shard.slots.size () - 1;
+    gsize j = i;
+
+    for (;;)
+    {
+        j = (j + 1) & mask;
+        if (!shard.slots[j].entry)
+            break;
+        gsize home = shard.slots[j].hash & mask;
+        /* Move slot j back into the hole at i unless its home lies
+         * cyclically in (i, j]. */
+        if ((j > i && (home <= i || home > j)) ||
+            (j < i && (home <= i && home > j)))
+        {
+            shard.slots[i] = shard.slots[j];
+            i = j;
+        }
+    }
+    shard.slots[i] = CacheSlot{0, nullptr};
+    --shard.count;
 }
 
 void
 qof_string_cache_init(void)
 {
-    (void)qof_get_string_cache();
+    /* The shards are static and demand-grown; nothing to do. */
 }
 
 void
 qof_string_cache_destroy (void)
 {
-    if (qof_string_cache)
+    for (auto& shard : qof_string_cache)
     {
-        g_hash_table_destroy(qof_string_cache);
+        std::lock_guard<std::mutex> guard (shard.lock);
+        for (auto& slot : shard.slots)
+            if (slot.entry && entry_size (slot.entry->length) > CACHE_MAX_ARENA_ENTRY)
+                g_free (slot.entry);
+        for (auto chunk : shard.chunks)
+            g_free (chunk);
+        std::vector<CacheSlot>().swap (shard.slots);
+        std::vector<char*>().swap (shard.chunks);
+        std::vector<CacheEntry*>().swap (shard.free_lists);
+        shard.count = 0;
+        shard.chunk_pos = shard.chunk_end = nullptr;
+        shard.references = 0;
+        shard.string_bytes = shard.bytes_saved = shard.large_bytes = 0;
     }
-    qof_string_cache = NULL;
 }
 
 /* If the key exists in the cache, check the refcount.  If 1, just
@@ -86,20 +267,29 @@ qof_string_cache_remove(gconstpointer key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
+        const char* str = static_cast<const char*>(key);
+        gsize length;
+        guint32 hash = cache_hash (str, &length);
+        CacheShard& shard = cache_shard (hash);
+        std::lock_guard<std::mutex> guard (shard.lock);
+
+        if (shard.slots.empty ())
+            return;
+        gsize i = shard_find (shard, str, length, hash);
+        CacheEntry* entry = shard.slots[i].entry;
+        if (!entry)
+            return;
+        --shard.references;
+        if (entry->refcount == 1)
         {
-            guint* refcount = (guint*)value;
-            if (*refcount == 1)
-            {
-                g_hash_table_remove(cache, key);
-            }
-            else
-            {
-                --(*refcount);
-            }
+            shard.string_bytes -= length + 1;
+            shard_erase (shard, i);
+            entry_free (shard, entry);
+        }
+        else
+        {
+            --entry->refcount;
+            shard.bytes_saved -= length + 1;
         }
     }
 }
@@ -111,25 +301,56 @@ qof_string_cache_insert(gconstpointer key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
+        const char* str = static_cast<const char*>(key);
+        gsize length;
+        guint32 hash = cache_hash (str, &length);
+        CacheShard& shard = cache_shard (hash);
+        std::lock_guard<std::mutex> guard (shard.lock);
+
+        if (shard.slots.empty ())
+            shard_grow (shard);
+        gsize i = shard_find (shard, str, length, hash);
+        CacheEntry* entry = shard.slots[i].entry;
+        ++shard.references;
+        if (entry)
         {
-            guint* refcount = (guint*)value;
-            ++(*refcount);
-            return cache_key;
+            ++entry->refcount;
+            shard.bytes_saved += length + 1;
+            return entry->str;
         }
-        else
+        /* Keep the table at most 3/4 full so probe runs stay short. */
+        if ((shard.count + 1) * 4 > shard.slots.size () * 3)
         {
-            gpointer new_key = g_strdup(static_cast<const char*>(key));
-            guint* refcount = static_cast<unsigned int*>(g_malloc(sizeof(guint)));
-            *refcount = 1;
-            g_hash_table_insert(cache, new_key, refcount);
-            return new_key;
+            shard_grow (shard);
+            i = shard_find (shard, str, length, hash);
         }
+        entry = entry_alloc (shard, entry_size (length));
+        entry->refcount = 1;
+        entry->length = length;
+        memcpy (entry->str, str, length + 1);
+        shard.slots[i] = CacheSlot{hash, entry};
+        ++shard.count;
+        shard.string_bytes += length + 1;
+        return entry->str;
     }
     return NULL;
 }
 
+void
+qof_string_cache_get_stats (QofStringCacheStats* stats)
+{
+    g_return_if_fail (stats);
+    memset (stats, 0, sizeof (QofStringCacheStats));
+    for (auto& shard : qof_string_cache)
+    {
+        std::lock_guard<std::mutex> guard (shard.lock);
+        stats->unique_strings += shard.count;
+        stats->references += shard.references;
+        stats->string_bytes += shard.string_bytes;
+        stats->bytes_saved += shard.bytes_saved;
+        stats->allocated_bytes += shard.chunks.size () * CACHE_CHUNK_SIZE +
+            shard.large_bytes + shard.slots.size () * sizeof (CacheSlot);
+    }
+}
+
 /* ************************ END OF FILE ***************************** */
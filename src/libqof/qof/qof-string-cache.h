@@ -66,7 +66,8 @@ extern "C"
  * Note that all the work is done when inserting or removing.  Once
  * cached the strings are just plain C strings.
  *
- * The string cache is demand-created on first use.
+ * The string cache is demand-created on first use.  Insert and remove
+ * may be called from several threads at once.
  *
  **/
 
@@ -86,6 +87,20 @@ void qof_string_cache_remove(gconstpointer key);
 */
 gpointer qof_string_cache_insert(gconstpointer key);
 
+/** Memory statistics for the string cache. */
+typedef struct
+{
+    guint unique_strings;   /**< Distinct strings currently cached */
+    guint64 references;     /**< Outstanding references to them */
+    gsize string_bytes;     /**< Bytes of string data stored, NULs included */
+    gsize bytes_saved;      /**< Bytes that one copy per reference would
+                               have needed on top of string_bytes */
+    gsize allocated_bytes;  /**< Memory held by the cache itself */
+} QofStringCacheStats;
+
+/** Fill in stats with the current state of the string cache. */
+void qof_string_cache_get_stats(QofStringCacheStats* stats);
+
 #define CACHE_INSERT(str) qof_string_cache_insert((gconstpointer)(str))
 #define CACHE_REMOVE(str) qof_string_cache_remove((str))
 
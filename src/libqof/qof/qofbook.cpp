@@ -53,6 +53,7 @@ extern "C"
 #include "qof.h"
 #include "qofevent-p.h"
 #include "qofbackend.h"
+#include "qof-backend.hpp"
 #include "qofbook-p.h"
 #include "qofid-p.h"
 #include "qofobject-p.h"
@@ -531,6 +532,34 @@ qof_book_get_backend (const QofBook *book)
     return book->backend;
 }
 
+gboolean
+qof_book_loads_on_demand (const QofBook *book)
+{
+    if (!book || !book->backend) return FALSE;
+    return book->backend->loads_on_demand ();
+}
+
+void
+qof_book_load_splits (QofBook *book, QofInstance *account, time64 since)
+{
+    if (!book || !book->backend) return;
+    book->backend->load_splits (account, since);
+}
+
+void
+qof_book_begin_bulk_commit (QofBook *book)
+{
+    if (!book || !book->backend) return;
+    book->backend->begin_bulk_commit ();
+}
+
+void
+qof_book_end_bulk_commit (QofBook *book)
+{
+    if (!book || !book->backend) return;
+    book->backend->end_bulk_commit ();
+}
+
 gboolean
 qof_book_shutting_down (const QofBook *book)
 {
@@ -293,6 +293,26 @@ GDate* qof_book_get_autoreadonly_gdate (const QofBook *book);
  *  if it uses transaction number field */
 gboolean qof_book_use_split_action_for_num_field (const QofBook *book);
 
+/** Did the book's backend leave some objects unloaded, to be fetched when
+ *  a query or an account asks for them?  FALSE for a book without a
+ *  backend or whose backend loaded everything. */
+gboolean qof_book_loads_on_demand (const QofBook *book);
+
+/** Have the book's backend load the splits of an account posted on or
+ *  after since (all of them for INT64_MIN), if it left them unloaded.
+ *  Everything that reads an account's splits calls this first; it does
+ *  nothing for a backend that loaded the whole book. */
+void qof_book_load_splits (QofBook *book, QofInstance *account, time64 since);
+
+/** Tell the book's backend that many objects are about to be committed,
+ *  as in an import, so that it may store them together.  Calls may nest;
+ *  each has to be matched by qof_book_end_bulk_commit(). */
+void qof_book_begin_bulk_commit (QofBook *book);
+
+/** Store whatever was committed since the outermost
+ *  qof_book_begin_bulk_commit(). */
+void qof_book_end_bulk_commit (QofBook *book);
+
 /** Is the book shutting down? */
 gboolean qof_book_shutting_down (const QofBook *book);
 
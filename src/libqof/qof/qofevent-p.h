@@ -34,6 +34,16 @@ typedef struct
     gpointer user_data;
 
     gint handler_id;
+
+    /* only events on entities of entity_type (any, if NULL) and in
+     * event_mask are delivered */
+    char *entity_type;
+    QofEventId event_mask;
+
+    /* set instead of handler for batch handlers, with the events
+     * collected during a batch */
+    QofEventBatchHandler batch_handler;
+    GArray *batch;
 } HandlerInfo;
 
 /* generates an event even when events are suspended! */
@@ -28,15 +28,28 @@ extern "C"
 #include <glib.h>
 }
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include "qof.h"
 #include "qofevent-p.h"
 
+/* Handlers are kept oldest first, and invoked newest first. */
+typedef std::vector<HandlerInfo*> HandlerList;
+
 /* Static Variables ************************************************/
 static guint   suspend_counter   = 0;
 static gint    next_handler_id   = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
-static GList   *handlers  =   NULL;
+static guint   batch_level       = 0;
+
+static HandlerList handlers;
+static std::unordered_map<gint, HandlerInfo*> handlers_by_id;
+
+/* Batch handlers with events collected in the current batch. */
+static HandlerList batch_handlers;
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -46,36 +59,49 @@ static QofLogModule log_module = QOF_MOD_ENGINE;
 static gint
 find_next_handler_id(void)
 {
-    HandlerInfo *hi;
     gint handler_id;
-    GList *node;
 
     /* look for a free handler id */
     handler_id = next_handler_id;
-    node = handlers;
+    while (handlers_by_id.count (handler_id))
+        handler_id++;
 
-    while (node)
-    {
-        hi = static_cast<HandlerInfo*>(node->data);
-
-        if (hi->handler_id == handler_id)
-        {
-            handler_id++;
-            node = handlers;
-            continue;
-        }
-
-        node = node->next;
-    }
     /* Update id for next registration */
     next_handler_id = handler_id + 1;
     return handler_id;
 }
 
+static gint
+register_handler (QofIdTypeConst entity_type, QofEventId event_mask,
+                  QofEventHandler handler, QofEventBatchHandler batch_handler,
+                  gpointer user_data)
+{
+    HandlerInfo *hi;
+    gint handler_id;
+
+    /* look for a free handler id */
+    handler_id = find_next_handler_id();
+
+    /* Found one, add the handler */
+    hi = g_new0 (HandlerInfo, 1);
+
+    hi->handler = handler;
+    hi->batch_handler = batch_handler;
+    hi->user_data = user_data;
+    hi->handler_id = handler_id;
+    if (entity_type)
+        hi->entity_type = qof_string_cache_insert (entity_type);
+    hi->event_mask = event_mask ? event_mask : ~QOF_EVENT_NONE;
+
+    handlers.push_back (hi);
+    handlers_by_id[handler_id] = hi;
+
+    return handler_id;
+}
+
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
 {
-    HandlerInfo *hi;
     gint handler_id;
 
     ENTER ("(handler=%p, data=%p)", handler, user_data);
@@ -87,61 +113,147 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
         return 0;
     }
 
-    /* look for a free handler id */
-    handler_id = find_next_handler_id();
+    handler_id = register_handler (NULL, QOF_EVENT_NONE, handler, NULL,
+                                   user_data);
+    LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
+    return handler_id;
+}
 
-    /* Found one, add the handler */
-    hi = g_new0 (HandlerInfo, 1);
+gint
+qof_event_register_filtered_handler (QofIdTypeConst entity_type,
+                                     QofEventId event_mask,
+                                     QofEventHandler handler,
+                                     gpointer user_data)
+{
+    gint handler_id;
 
-    hi->handler = handler;
-    hi->user_data = user_data;
-    hi->handler_id = handler_id;
+    ENTER ("(type=%s, mask=%d, handler=%p, data=%p)",
+           entity_type ? entity_type : "(any)", event_mask, handler, user_data);
+
+    /* sanity check */
+    if (!handler)
+    {
+        PERR ("no handler specified");
+        return 0;
+    }
 
-    handlers = g_list_prepend (handlers, hi);
+    handler_id = register_handler (entity_type, event_mask, handler, NULL,
+                                   user_data);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
 
+gint
+qof_event_register_batch_handler (QofIdTypeConst entity_type,
+                                  QofEventId event_mask,
+                                  QofEventBatchHandler handler,
+                                  gpointer user_data)
+{
+    gint handler_id;
+
+    ENTER ("(type=%s, mask=%d, handler=%p, data=%p)",
+           entity_type ? entity_type : "(any)", event_mask, handler, user_data);
+
+    /* sanity check */
+    if (!handler)
+    {
+        PERR ("no handler specified");
+        return 0;
+    }
+
+    handler_id = register_handler (entity_type, event_mask, NULL, handler,
+                                   user_data);
+    LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
+    return handler_id;
+}
+
+static gboolean
+handler_is_unregistered (HandlerInfo *hi)
+{
+    return !hi->handler && !hi->batch_handler;
+}
+
+static bool
+handler_is_registered (HandlerInfo *hi)
+{
+    return !handler_is_unregistered (hi);
+}
+
+/* Drop the collected events, and their references on the types. */
+static void
+clear_batch (GArray *batch)
+{
+    for (guint i = 0; i < batch->len; i++)
+    {
+        QofEventInfo *event = &g_array_index (batch, QofEventInfo, i);
+        if (event->entity_type)
+            qof_string_cache_remove (event->entity_type);
+    }
+    g_array_set_size (batch, 0);
+}
+
+static void
+free_handler (HandlerInfo *hi)
+{
+    if (hi->entity_type)
+        qof_string_cache_remove (hi->entity_type);
+    if (hi->batch)
+    {
+        clear_batch (hi->batch);
+        g_array_free (hi->batch, TRUE);
+    }
+    g_free (hi);
+}
+
+/* Remove the unregistered handlers from the list. */
+static void
+purge_handlers (void)
+{
+    auto end = std::stable_partition (handlers.begin (), handlers.end (),
+                                      handler_is_registered);
+    std::for_each (end, handlers.end (), free_handler);
+    handlers.erase (end, handlers.end ());
+}
+
 void
 qof_event_unregister_handler (gint handler_id)
 {
-    GList *node;
+    HandlerInfo *hi;
 
     ENTER ("(handler_id=%d)", handler_id);
-    for (node = handlers; node; node = node->next)
-    {
-        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
-
-        if (hi->handler_id != handler_id)
-            continue;
-
-        /* Normally, we could actually remove the handler's node from the
-           list, but we may be unregistering the event handler as a result
-           of a generated event, such as QOF_EVENT_DESTROY.  In that case,
-           we're in the middle of walking the GList and it is wrong to
-           modify the list. So, instead, we just NULL the handler. */
-        if (hi->handler)
-            LEAVE ("(handler_id=%d) handler=%p data=%p", handler_id,
-                   hi->handler, hi->user_data);
-
-        /* safety -- clear the handler in case we're running events now */
-        hi->handler = NULL;
-
-        if (handler_run_level == 0)
-        {
-            handlers = g_list_remove_link (handlers, node);
-            g_list_free_1 (node);
-            g_free (hi);
-        }
-        else
-        {
-            pending_deletes++;
-        }
 
+    auto iter = handlers_by_id.find (handler_id);
+    if (iter == handlers_by_id.end ())
+    {
+        PERR ("no such handler: %d", handler_id);
         return;
     }
 
-    PERR ("no such handler: %d", handler_id);
+    hi = iter->second;
+    handlers_by_id.erase (iter);
+
+    LEAVE ("(handler_id=%d) handler=%p data=%p", handler_id,
+           hi->handler, hi->user_data);
+
+    /* Drop any events collected for the handler. */
+    batch_handlers.erase (std::remove (batch_handlers.begin (),
+                                       batch_handlers.end (), hi),
+                          batch_handlers.end ());
+
+    /* We may be unregistering the event handler as a result of a
+       generated event, such as QOF_EVENT_DESTROY.  In that case, we're
+       in the middle of walking the handlers and it is wrong to modify
+       the list.  So, instead, we just NULL the handler and remove it
+       later. */
+    hi->handler = NULL;
+    hi->batch_handler = NULL;
+
+    if (handler_run_level == 0)
+        purge_handlers ();
+    else
+    {
+        pending_deletes++;
+    }
 }
 
 void
@@ -167,13 +279,70 @@ qof_event_resume (void)
     suspend_counter--;
 }
 
+/* If we're the outermost event runner and we have pending deletes
+ * then go delete the handlers now.
+ */
+static void
+purge_pending_deletes (void)
+{
+    if (handler_run_level != 0 || !pending_deletes)
+        return;
+
+    purge_handlers ();
+    pending_deletes = 0;
+}
+
+static gboolean
+handler_wants_event (HandlerInfo *hi, QofInstance *entity, QofEventId event_id)
+{
+    if (handler_is_unregistered (hi) || !(hi->event_mask & event_id))
+        return FALSE;
+
+    /* both strings normally come from the string cache */
+    return !hi->entity_type || hi->entity_type == entity->e_type ||
+           g_strcmp0 (hi->entity_type, entity->e_type) == 0;
+}
+
+static void
+deliver_event (HandlerInfo *hi, QofInstance *entity, QofEventId event_id,
+               gpointer event_data)
+{
+    QofEventInfo event;
+
+    PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
+          hi->handler, event_data);
+
+    if (hi->handler)
+    {
+        hi->handler (entity, event_id, hi->user_data, event_data);
+        return;
+    }
+
+    event.guid = *qof_instance_get_guid (entity);
+    event.entity_type = entity->e_type;
+    event.event_type = event_id;
+
+    if (batch_level == 0)
+    {
+        hi->batch_handler (&event, 1, hi->user_data);
+        return;
+    }
+
+    /* The entity, and the reference it holds on its type, may be gone
+     * by the time the batch ends. */
+    if (event.entity_type)
+        event.entity_type = qof_string_cache_insert (event.entity_type);
+    if (!hi->batch)
+        hi->batch = g_array_new (FALSE, FALSE, sizeof (QofEventInfo));
+    if (hi->batch->len == 0)
+        batch_handlers.push_back (hi);
+    g_array_append_val (hi->batch, event);
+}
+
 static void
 qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                              gpointer event_data)
 {
-    GList *node;
-    GList *next_node = NULL;
-
     g_return_if_fail(entity);
 
     switch (event_id)
@@ -186,39 +355,62 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
     }
 
     handler_run_level++;
-    for (node = handlers; node; node = next_node)
+    /* Walk by index: handlers registered by a handler are appended,
+     * beyond the ones seen here, and unregistered ones stay in place
+     * with their handler cleared. */
+    for (auto i = handlers.size (); i-- > 0;)
     {
-        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        HandlerInfo *hi = handlers[i];
 
-        next_node = node->next;
-        if (hi->handler)
-        {
-            PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
-                  hi->handler, event_data);
-            hi->handler (entity, event_id, hi->user_data, event_data);
-        }
+        if (handler_wants_event (hi, entity, event_id))
+            deliver_event (hi, entity, event_id, event_data);
     }
     handler_run_level--;
 
-    /* If we're the outermost event runner and we have pending deletes
-     * then go delete the handlers now.
-     */
-    if (handler_run_level == 0 && pending_deletes)
-    {
-        for (node = handlers; node; node = next_node)
-        {
-            HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
-            next_node = node->next;
-            if (hi->handler == NULL)
-            {
-                /* remove this node from the list, then free this node */
-                handlers = g_list_remove_link (handlers, node);
-                g_list_free_1 (node);
-                g_free (hi);
-            }
-        }
-        pending_deletes = 0;
+    purge_pending_deletes ();
+}
+
+void
+qof_event_begin_batch (void)
+{
+    batch_level++;
+}
+
+void
+qof_event_end_batch (void)
+{
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
     }
+
+    if (--batch_level != 0)
+        return;
+
+    /* Handlers may generate events, which are delivered right away,
+     * or start a new batch, so take the collected ones out first. */
+    HandlerList pending;
+    pending.swap (batch_handlers);
+
+    handler_run_level++;
+    for (auto hi : pending)
+    {
+        GArray *batch = hi->batch;
+
+        hi->batch = NULL;
+        if (hi->batch_handler)
+            hi->batch_handler (&g_array_index (batch, QofEventInfo, 0),
+                               batch->len, hi->user_data);
+        clear_batch (batch);
+        if (hi->batch)
+            g_array_free (batch, TRUE);
+        else
+            hi->batch = batch;
+    }
+    handler_run_level--;
+
+    purge_pending_deletes ();
 }
 
 void
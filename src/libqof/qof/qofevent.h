@@ -90,6 +90,10 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
                                  gpointer handler_data, gpointer event_data);
 
 /** \brief Register a handler for events.
+ *
+ * The handler is invoked for every event on every entity; see
+ * qof_event_register_filtered_handler() for handlers only interested
+ * in some of them.
  *
  * @param handler:   handler to register
  * @param handler_data: data provided when handler is invoked
@@ -104,6 +108,75 @@ gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data)
  */
 void qof_event_unregister_handler (gint handler_id);
 
+/** \brief Register a handler for the events of one type of entity.
+ *
+ * Unlike the handlers registered with qof_event_register_handler(),
+ * which see every event and have to sort out the ones they care
+ * about, the handler is only invoked for matching events.  Handlers
+ * of either kind are invoked in one sequence, the most recently
+ * registered first.
+ *
+ * @param entity_type: the type of the entities to watch, or NULL for
+ * entities of any type
+ * @param event_mask: the events to watch, or QOF_EVENT_NONE for all
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler, to be passed to
+ * qof_event_unregister_handler()
+ */
+gint qof_event_register_filtered_handler (QofIdTypeConst entity_type,
+        QofEventId event_mask,
+        QofEventHandler handler,
+        gpointer handler_data);
+
+/** \brief An event as handed to a QofEventBatchHandler.
+ *
+ * The entity may have been destroyed by the time a batch is delivered,
+ * so the event identifies it by GUID; look it up with
+ * qof_collection_lookup_entity() if it is needed.  The event_data
+ * passed to qof_event_gen() is not kept.
+ */
+typedef struct
+{
+    /** A copy of the GncGUID of the entity. */
+    GncGUID guid;
+    /** The type of the entity, valid for the duration of the call. */
+    QofIdTypeConst entity_type;
+    QofEventId event_type;
+} QofEventInfo;
+
+/** \brief Handler invoked with a number of events.
+ *
+ * @param events:   the events, in the order they were generated
+ * @param n_events: the number of events
+ * @param handler_data:   data supplied when handler was registered.
+ */
+typedef void (*QofEventBatchHandler) (const QofEventInfo *events,
+                                      guint n_events,
+                                      gpointer handler_data);
+
+/** \brief Register a handler receiving the events in batches.
+ *
+ * Between qof_event_begin_batch() and qof_event_end_batch() the
+ * matching events are collected and the handler is invoked once with
+ * all of them when the batch ends.  Outside of a batch each event is
+ * handed over on its own, right away.
+ *
+ * @param entity_type: the type of the entities to watch, or NULL for
+ * entities of any type
+ * @param event_mask: the events to watch, or QOF_EVENT_NONE for all
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler, to be passed to
+ * qof_event_unregister_handler()
+ */
+gint qof_event_register_batch_handler (QofIdTypeConst entity_type,
+                                       QofEventId event_mask,
+                                       QofEventBatchHandler handler,
+                                       gpointer handler_data);
+
 /** \brief Invoke all registered event handlers using the given arguments.
 
    Certain default events are used by QOF:
@@ -139,6 +212,19 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start collecting the events for the batch handlers.
+ *
+ * Bulk edits should be wrapped in qof_event_begin_batch() and
+ * qof_event_end_batch() so that the handlers registered with
+ * qof_event_register_batch_handler() are invoked once for all of the
+ * edits.  Other handlers still see each event as it happens.  Batches
+ * may be nested; the events are delivered when the outermost one ends.
+ */
+void qof_event_begin_batch (void);
+
+/** \brief Deliver the events collected since qof_event_begin_batch(). */
+void qof_event_end_batch (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,15 +35,28 @@ extern "C"
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
+/* The entities live in a dense array so that they can be walked
+ * without allocating; the hash maps each GUID to its slot (stored as
+ * index + 1, so that a missing GUID and slot 0 differ).  Removing an
+ * entity moves the last one into its slot.  While a foreach is running
+ * a removal only empties the slot instead, and the holes are squeezed
+ * out when the last walk finishes, so the callbacks may add and remove
+ * entities freely. */
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
     GHashTable * hash_of_entities;
+    GPtrArray  * entities;
+    guint        num_holes;
+    gint         iterating;  /* number of foreach walks in progress */
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
+/* Entities below this many per thread are not worth a thread of their own. */
+#define PARALLEL_FOREACH_MIN_CHUNK 4096
+
 /* =============================================================== */
 
 QofCollection *
@@ -53,6 +66,7 @@ qof_collection_new (QofIdType type)
     col = g_new0(QofCollection, 1);
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
     col->hash_of_entities = guid_hash_table_new();
+    col->entities = g_ptr_array_new();
     col->data = NULL;
     return col;
 }
@@ -62,12 +76,91 @@ qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
     g_hash_table_destroy(col->hash_of_entities);
+    g_ptr_array_free(col->entities, TRUE);
     col->e_type = NULL;
     col->hash_of_entities = NULL;
+    col->entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
 
+/* =============================================================== */
+/* slot management */
+
+static inline guint
+collection_slot (const QofCollection *col, const GncGUID *guid)
+{
+    return GPOINTER_TO_UINT (g_hash_table_lookup (col->hash_of_entities, guid));
+}
+
+static void
+collection_store (QofCollection *col, const GncGUID *guid, QofInstance *ent)
+{
+    guint slot = collection_slot (col, guid);
+
+    if (slot)
+    {
+        /* Another entity with the same GUID gives up its slot. */
+        g_ptr_array_index (col->entities, slot - 1) = ent;
+        g_hash_table_replace (col->hash_of_entities, (gpointer)guid,
+                              GUINT_TO_POINTER (slot));
+        return;
+    }
+    g_ptr_array_add (col->entities, ent);
+    g_hash_table_insert (col->hash_of_entities, (gpointer)guid,
+                         GUINT_TO_POINTER (col->entities->len));
+}
+
+/* Fill slot index with the last entity, which is then patched into the
+ * hash. */
+static void
+collection_fill_slot (QofCollection *col, guint index)
+{
+    g_ptr_array_remove_index_fast (col->entities, index);
+    if (index < col->entities->len)
+    {
+        auto moved = static_cast<QofInstance*>(g_ptr_array_index (col->entities, index));
+        if (moved)
+            g_hash_table_insert (col->hash_of_entities,
+                                 (gpointer)qof_instance_get_guid (moved),
+                                 GUINT_TO_POINTER (index + 1));
+    }
+}
+
+static void
+collection_forget (QofCollection *col, const GncGUID *guid)
+{
+    guint slot = collection_slot (col, guid);
+
+    if (!slot) return;
+    g_hash_table_remove (col->hash_of_entities, guid);
+    if (g_atomic_int_get (&col->iterating))
+    {
+        g_ptr_array_index (col->entities, slot - 1) = NULL;
+        col->num_holes++;
+    }
+    else
+        collection_fill_slot (col, slot - 1);
+}
+
+static void
+collection_compact (QofCollection *col)
+{
+    guint i = 0;
+
+    while (col->num_holes && i < col->entities->len)
+    {
+        if (g_ptr_array_index (col->entities, i))
+        {
+            i++;
+            continue;
+        }
+        collection_fill_slot (col, i);
+        col->num_holes--;
+    }
+    col->num_holes = 0;
+}
+
 /* =============================================================== */
 /* getters */
 
@@ -89,7 +182,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    collection_forget (col, guid);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -103,7 +196,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    collection_store (col, guid, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -129,7 +222,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    collection_store (coll, guid, ent);
     return TRUE;
 }
 
@@ -213,12 +306,12 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
+    guint slot;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
-    return ent;
+    slot = collection_slot (col, guid);
+    if (!slot) return NULL;
+    return static_cast<QofInstance*>(g_ptr_array_index (col->entities, slot - 1));
 }
 
 QofCollection *
@@ -302,40 +395,102 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
+void
+qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
+                        gpointer user_data)
+{
+    QofCollection *mcol = const_cast<QofCollection*>(col);
+    guint i, len;
+
+    g_return_if_fail (col);
+    g_return_if_fail (cb_func);
+
+    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+
+    /* Entities added by the callback land past len and are not visited;
+     * the array may be reallocated, so index it afresh every time. */
+    g_atomic_int_inc (&mcol->iterating);
+    len = col->entities->len;
+    for (i = 0; i < len; i++)
+    {
+        auto ent = static_cast<QofInstance*>(g_ptr_array_index (col->entities, i));
+        if (ent)
+            cb_func (ent, user_data);
+    }
+    if (g_atomic_int_dec_and_test (&mcol->iterating) && col->num_holes)
+        collection_compact (mcol);
+
+    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+}
+
+struct _parallel_iterate
 {
+    const QofCollection      *col;
     QofInstanceForeachCB      fcn;
-    gpointer                data;
+    gpointer                  data;
+    guint                     begin;
+    guint                     end;
 };
 
-static void
-foreach_cb (gpointer item, gpointer arg)
+static gpointer
+parallel_foreach_thread (gpointer arg)
 {
-    struct _iterate *iter = static_cast<_iterate*>(arg);
-    QofInstance *ent = static_cast<QofInstance*>(item);
+    auto iter = static_cast<_parallel_iterate*>(arg);
+    guint i;
 
-    iter->fcn (ent, iter->data);
+    for (i = iter->begin; i < iter->end; i++)
+    {
+        auto ent = static_cast<QofInstance*>(g_ptr_array_index (iter->col->entities, i));
+        if (ent)
+            iter->fcn (ent, iter->data);
+    }
+    return NULL;
 }
 
 void
-qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
-                        gpointer user_data)
+qof_collection_foreach_parallel (const QofCollection *col,
+                                 QofInstanceForeachCB cb_func,
+                                 gpointer user_data)
 {
-    struct _iterate iter;
-    GList *entries;
+    QofCollection *mcol = const_cast<QofCollection*>(col);
+    guint len, num_threads, chunk, i;
+    _parallel_iterate *iters;
+    GThread **threads;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
-
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
-
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    len = col->entities->len;
+    num_threads = MIN (g_get_num_processors (),
+                       len / PARALLEL_FOREACH_MIN_CHUNK);
+    if (num_threads < 2)
+    {
+        qof_collection_foreach (col, cb_func, user_data);
+        return;
+    }
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    g_atomic_int_inc (&mcol->iterating);
+    iters = g_new (_parallel_iterate, num_threads);
+    threads = g_new (GThread*, num_threads);
+    chunk = (len + num_threads - 1) / num_threads;
+    for (i = 0; i < num_threads; i++)
+    {
+        iters[i].col = col;
+        iters[i].fcn = cb_func;
+        iters[i].data = user_data;
+        iters[i].begin = i * chunk;
+        iters[i].end = MIN (len, (i + 1) * chunk);
+    }
+    /* The calling thread takes the first chunk itself. */
+    for (i = 1; i < num_threads; i++)
+        threads[i] = g_thread_new ("qof-foreach", parallel_foreach_thread,
+                                   &iters[i]);
+    parallel_foreach_thread (&iters[0]);
+    for (i = 1; i < num_threads; i++)
+        g_thread_join (threads[i]);
+    g_free (threads);
+    g_free (iters);
+    if (g_atomic_int_dec_and_test (&mcol->iterating) && col->num_holes)
+        collection_compact (mcol);
 }
 /* =============================================================== */
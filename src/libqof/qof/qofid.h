@@ -167,10 +167,21 @@ QofInstance * qof_collection_lookup_entity (const QofCollection *, const GncGUID
 /** Callback type for qof_collection_foreach */
 typedef void (*QofInstanceForeachCB) (QofInstance *, gpointer user_data);
 
-/** Call the callback for each entity in the collection. */
+/** Call the callback for each entity in the collection.  The walk
+ *  does not allocate.  The callback may add entities to the collection
+ *  or remove them from it: removed entities that were not yet visited
+ *  are skipped, and added ones are not visited. */
 void qof_collection_foreach (const QofCollection *, QofInstanceForeachCB,
                              gpointer user_data);
 
+/** Like qof_collection_foreach(), but large collections are split
+ *  between several threads.  The callback must only read: it may not
+ *  change the collection and must be safe to run concurrently with
+ *  itself.  Returns when every entity has been visited. */
+void qof_collection_foreach_parallel (const QofCollection *,
+                                      QofInstanceForeachCB,
+                                      gpointer user_data);
+
 /** Store and retrieve arbitrary object-defined data
  *
  * XXX We need to add a callback for when the collection is being
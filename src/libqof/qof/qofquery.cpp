@@ -29,6 +29,7 @@ extern "C"
 #include <time.h>
 #include <glib.h>
 #include <regex.h>
+#include <stdlib.h>
 #include <string.h>
 }
 
@@ -99,6 +100,10 @@ struct _QofQuery
     /* a map of book to backend-compiled queries */
     GHashTable*       be_compiled;
 
+    /* the terms lowered by compile_terms, one GArray of QofQueryOp
+     * per OR-term */
+    GPtrArray *       program;
+
     /* cache the results so we don't have to run the whole search
      * again until it's really necessary */
     gint              changed;
@@ -106,13 +111,30 @@ struct _QofQuery
     GList *           results;
 };
 
+/* Objects are checked against the query this many at a time */
+#define QUERY_BATCH_SIZE 256
+
+/* A matching object, numbered in the order it was found so that ties
+ * in the sort keep that order */
+typedef struct
+{
+    gpointer          object;
+    guint             seq;
+} QofQueryResult;
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
-    GList *           list;
+    GArray *          results;      /* of QofQueryResult */
     gint              count;
+    gint              limit;        /* keep only this many, or -1 */
+    gboolean          sorted;
+    gpointer          batch[QUERY_BATCH_SIZE]; /* objects not checked yet */
+    guint             batch_len;
 } QofQueryCB;
 
+static void query_program_free (QofQuery *q);
+
 /* initial_term will be owned by the new Query */
 static void query_init (QofQuery *q, QofQueryTerm *initial_term)
 {
@@ -142,6 +164,8 @@ static void query_init (QofQuery *q, QofQueryTerm *initial_term)
     g_slist_free (q->secondary_sort.param_fcns);
     g_slist_free (q->tertiary_sort.param_fcns);
 
+    query_program_free (q);
+
     ht = q->be_compiled;
     memset (q, 0, sizeof (*q));
     q->be_compiled = ht;
@@ -274,6 +298,8 @@ static void free_members (QofQuery *q)
 
     g_list_free(q->results);
     q->results = NULL;
+
+    query_program_free (q);
 }
 
 static int cmp_func (const QofQuerySort *sort, QofSortFunc default_sort,
@@ -357,67 +383,397 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
 }
 
 /* ==================================================================== */
-/* This is the main workhorse for performing the query.  For each
- * object, it walks over all of the query terms to see if the
- * object passes the seive.
+/* This is the main workhorse for performing the query.  compile_terms
+ * lowers the terms into a flat program: each OR-term becomes an array
+ * of operations, each holding its getter chain in an array and, for
+ * the common core types, a specialised test that skips the generic
+ * predicate dispatch.  Within an OR-term, operations that get their
+ * value straight from the object are ordered so that the cheap and
+ * selective ones run first; since the terms are ANDed the order doesn't
+ * change the result.  An operation that walks a chain of getters, such
+ * as split->lot->guid, may rely on the terms before it to have weeded
+ * out the objects whose chain is broken, so it keeps its place: nothing
+ * written before it moves after it, and it moves ahead of nothing.
+ *
+ * Objects are then checked a batch at a time, one operation at a time,
+ * each operation narrowing down the batch for the next one.
  */
 
-static int
-check_object (const QofQuery *q, gpointer object)
+typedef enum
 {
-    const GList     * and_ptr;
-    const GList     * or_ptr;
-    const QofQueryTerm * qt;
-    int       and_terms_ok = 1;
+    QUERY_OP_GUID,      /* single GncGUID against a set of them */
+    QUERY_OP_DATE,
+    QUERY_OP_NUMERIC,
+    QUERY_OP_GENERIC,   /* the type's registered predicate */
+    QUERY_OP_STRING,
+    QUERY_OP_REGEX,
+} QofQueryOpKind;
 
-    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+typedef struct
+{
+    QofQueryOpKind          kind;
+    guint                   rank;       /* lower runs first */
+    guint                   position;   /* in the OR-term, for ties */
+    QofParam **             params;     /* the last one is the getter */
+    guint                   n_params;
+    QofQueryPredicateFunc   pred_fcn;
+    QofQueryPredData *      pdata;
+    gboolean                invert;
+    Timespec                date;       /* canonicalised for by-day */
+    gnc_numeric             amount;     /* made absolute for EQUAL/NEQ */
+    GHashTable *            guids;
+} QofQueryOp;
+
+static void
+query_op_clear (gpointer data)
+{
+    QofQueryOp *op = static_cast<QofQueryOp*>(data);
+    g_free (op->params);
+    if (op->guids)
+        g_hash_table_destroy (op->guids);
+}
+
+static void query_program_free (QofQuery *q)
+{
+    if (q->program)
+        g_ptr_array_free (q->program, TRUE);
+    q->program = NULL;
+}
+
+static gboolean
+query_op_is_type (const QofQueryTerm *qt, const QofParam *getter,
+                  const char *type)
+{
+    return !g_strcmp0 (getter->param_type, type) &&
+           !g_strcmp0 (qt->pdata->type_name, type);
+}
+
+static void
+query_op_compile (QofQueryOp *op, const QofQueryTerm *qt)
+{
+    const QofParam *getter;
+    const GSList *node;
+    guint i = 0;
+
+    op->n_params = g_slist_length (qt->param_fcns);
+    op->params = g_new (QofParam*, op->n_params);
+    for (node = qt->param_fcns; node; node = node->next)
+        op->params[i++] = static_cast<QofParam*>(node->data);
+    getter = op->params[op->n_params - 1];
+
+    op->pred_fcn = qt->pred_fcn;
+    op->pdata = qt->pdata;
+    op->invert = qt->invert;
+    op->kind = QUERY_OP_GENERIC;
+
+    if (query_op_is_type (qt, getter, QOF_TYPE_GUID))
     {
-        and_terms_ok = 1;
-        for (and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
-	     and_ptr = static_cast<GList*>(and_ptr->next))
+        query_guid_t pdata = (query_guid_t) qt->pdata;
+        if (pdata->options == QOF_GUID_MATCH_ANY ||
+            pdata->options == QOF_GUID_MATCH_NONE)
         {
-            qt = (QofQueryTerm *)(and_ptr->data);
-            if (qt->param_fcns && qt->pred_fcn)
-            {
-                const GSList *node;
-                QofParam *param = NULL;
-                gpointer conv_obj = object;
+            op->kind = QUERY_OP_GUID;
+            op->guids = g_hash_table_new (guid_hash_to_guint,
+                                          guid_g_hash_table_equal);
+            for (GList *g = pdata->guids; g; g = g->next)
+                g_hash_table_add (op->guids, g->data);
+        }
+    }
+    else if (query_op_is_type (qt, getter, QOF_TYPE_DATE))
+    {
+        query_date_t pdata = (query_date_t) qt->pdata;
+        op->kind = QUERY_OP_DATE;
+        op->date = pdata->date;
+        if (pdata->options == QOF_DATE_MATCH_DAY)
+            op->date = timespecCanonicalDayTime (op->date);
+    }
+    else if (query_op_is_type (qt, getter, QOF_TYPE_NUMERIC))
+    {
+        query_numeric_t pdata = (query_numeric_t) qt->pdata;
+        op->kind = QUERY_OP_NUMERIC;
+        op->amount = pdata->amount;
+        if (qt->pdata->how == QOF_COMPARE_EQUAL ||
+            qt->pdata->how == QOF_COMPARE_NEQ)
+            op->amount = gnc_numeric_abs (op->amount);
+    }
+    else if (query_op_is_type (qt, getter, QOF_TYPE_STRING))
+    {
+        query_string_t pdata = (query_string_t) qt->pdata;
+        op->kind = pdata->is_regex ? QUERY_OP_REGEX : QUERY_OP_STRING;
+    }
 
-                /* iterate through the conversions */
-                for (node = qt->param_fcns; node; node = node->next)
-                {
-                    param = static_cast<QofParam*>(node->data);
+    /* Cheapest test first, then fewest getters to walk, then the
+     * comparisons most likely to reject an object. */
+    op->rank = op->kind * 64 + (op->n_params - 1) * 2 +
+               (qt->pdata->how == QOF_COMPARE_NEQ ||
+                (op->kind == QUERY_OP_GUID &&
+                 ((query_guid_t) qt->pdata)->options == QOF_GUID_MATCH_NONE));
+}
 
-                    /* The last term is the actual parameter getter */
-                    if (!node->next) break;
+static gint
+query_op_order (gconstpointer a, gconstpointer b)
+{
+    const QofQueryOp *op_a = static_cast<const QofQueryOp*>(a);
+    const QofQueryOp *op_b = static_cast<const QofQueryOp*>(b);
 
-                    conv_obj = param->param_getfcn (conv_obj, param);
-                }
+    if (op_a->rank != op_b->rank)
+        return op_a->rank < op_b->rank ? -1 : 1;
+    return op_a->position < op_b->position ? -1 :
+           op_a->position > op_b->position;
+}
 
-                if (((qt->pred_fcn)(conv_obj, param, qt->pdata)) == qt->invert)
-                {
-                    and_terms_ok = 0;
-                    break;
-                }
-            }
-            else
-            {
-                /* XXX: Don't know how to do this conversion -- do we care? */
-            }
-        }
-        if (and_terms_ok)
+/* Sort each run of single-getter operations between the chained ones,
+ * which stay where the query put them. */
+static void
+query_program_order (GArray *ops)
+{
+    QofQueryOp *op = (QofQueryOp *) ops->data;
+    guint start = 0, end;
+
+    while (start < ops->len)
+    {
+        for (end = start; end < ops->len && op[end].n_params == 1; end++)
+            ;
+        if (end - start > 1)
+            qsort (op + start, end - start, sizeof (QofQueryOp),
+                   query_op_order);
+        start = end + 1;
+    }
+}
+
+static void
+query_program_compile (QofQuery *q)
+{
+    GList *or_ptr, *and_ptr;
+
+    query_program_free (q);
+    q->program = g_ptr_array_new_with_free_func ((GDestroyNotify)g_array_unref);
+
+    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        GArray *ops = g_array_new (FALSE, TRUE, sizeof (QofQueryOp));
+        guint position = 0;
+
+        g_array_set_clear_func (ops, query_op_clear);
+        for (and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
+             and_ptr = static_cast<GList*>(and_ptr->next))
         {
-            return 1;
+            const QofQueryTerm *qt =
+                static_cast<const QofQueryTerm*>(and_ptr->data);
+            QofQueryOp op;
+
+            /* XXX: Don't know how to do this conversion -- do we care?
+             * A term that can't be compiled lets everything through. */
+            if (!qt->param_fcns || !qt->pred_fcn)
+                continue;
+
+            memset (&op, 0, sizeof (op));
+            query_op_compile (&op, qt);
+            op.position = position++;
+            g_array_append_val (ops, op);
         }
+        query_program_order (ops);
+        g_ptr_array_add (q->program, ops);
+    }
+}
+
+static int
+query_op_compare_how (QofQueryCompare how, int compare)
+{
+    switch (how)
+    {
+    case QOF_COMPARE_LT:
+        return (compare < 0);
+    case QOF_COMPARE_LTE:
+        return (compare <= 0);
+    case QOF_COMPARE_EQUAL:
+        return (compare == 0);
+    case QOF_COMPARE_GT:
+        return (compare > 0);
+    case QOF_COMPARE_GTE:
+        return (compare >= 0);
+    case QOF_COMPARE_NEQ:
+        return (compare != 0);
+    default:
+        PWARN ("bad match type: %d", how);
+        return 0;
     }
+}
+
+/* These mirror the predicates in qofquerycore.cpp for the same types,
+ * minus the checks that compile time has already made. */
+static int
+query_op_match_date (const QofQueryOp *op, gpointer object, QofParam *getter)
+{
+    query_date_t pdata = (query_date_t) op->pdata;
+    Timespec ta = ((Timespec (*)(gpointer, QofParam*))getter->param_getfcn)
+                  (object, getter);
+    int compare;
+
+    if (pdata->options == QOF_DATE_MATCH_DAY)
+        ta = timespecCanonicalDayTime (ta);
+
+    if (ta.tv_sec != op->date.tv_sec)
+        compare = ta.tv_sec < op->date.tv_sec ? -1 : 1;
+    else if (ta.tv_nsec != op->date.tv_nsec)
+        compare = ta.tv_nsec < op->date.tv_nsec ? -1 : 1;
+    else
+        compare = 0;
+    return query_op_compare_how (op->pdata->how, compare);
+}
+
+static int
+query_op_match_numeric (const QofQueryOp *op, gpointer object,
+                        QofParam *getter)
+{
+    query_numeric_t pdata = (query_numeric_t) op->pdata;
+    gnc_numeric value =
+        ((gnc_numeric (*)(gpointer, QofParam*))getter->param_getfcn)
+        (object, getter);
+
+    if (pdata->options == QOF_NUMERIC_MATCH_CREDIT &&
+        gnc_numeric_positive_p (value))
+        return 0;
+    if (pdata->options == QOF_NUMERIC_MATCH_DEBIT &&
+        gnc_numeric_negative_p (value))
+        return 0;
+
+    /* Amounts are considered to be 'equal' if they match to
+     * four decimal places. (epsilon=1/10000) */
+    if (op->pdata->how == QOF_COMPARE_EQUAL || op->pdata->how == QOF_COMPARE_NEQ)
+    {
+        gnc_numeric diff = gnc_numeric_sub (gnc_numeric_abs (value), op->amount,
+                                            100000, GNC_HOW_RND_ROUND_HALF_UP);
+        int close = gnc_numeric_compare (gnc_numeric_abs (diff),
+                                         gnc_numeric_create (1, 10000)) < 0;
+        return op->pdata->how == QOF_COMPARE_EQUAL ? close : !close;
+    }
+    return query_op_compare_how (op->pdata->how,
+                                 gnc_numeric_compare (gnc_numeric_abs (value),
+                                                      op->amount));
+}
+
+static int
+query_op_match_string (const QofQueryOp *op, gpointer object,
+                       QofParam *getter)
+{
+    query_string_t pdata = (query_string_t) op->pdata;
+    QofQueryCompare how = op->pdata->how;
+    gboolean contains = (how == QOF_COMPARE_CONTAINS ||
+                         how == QOF_COMPARE_NCONTAINS);
+    const char *s = ((const char* (*)(gpointer, QofParam*))getter->param_getfcn)
+                    (object, getter);
+    int ret;
+
+    if (!s) s = "";
+
+    if (pdata->is_regex)
+    {
+        regmatch_t match;
+        ret = !regexec (&pdata->compiled, s, 1, &match, 0);
+    }
+    else if (pdata->options == QOF_STRING_MATCH_CASEINSENSITIVE)
+        ret = contains ? qof_utf8_substr_nocase (s, pdata->matchstring) :
+              safe_strcasecmp (s, pdata->matchstring) == 0;
+    else
+        ret = contains ? strstr (s, pdata->matchstring) != NULL :
+              g_strcmp0 (s, pdata->matchstring) == 0;
+
+    switch (how)
+    {
+    case QOF_COMPARE_CONTAINS:
+    case QOF_COMPARE_EQUAL:
+        return ret;
+    case QOF_COMPARE_NCONTAINS:
+    case QOF_COMPARE_NEQ:
+        return !ret;
+    default:
+        PWARN ("bad match type: %d", how);
+        return 0;
+    }
+}
+
+static gboolean
+query_op_check (const QofQueryOp *op, gpointer object)
+{
+    QofParam *getter = op->params[op->n_params - 1];
+    int result;
+    guint i;
+
+    /* iterate through the conversions */
+    for (i = 0; i + 1 < op->n_params; i++)
+        object = op->params[i]->param_getfcn (object, op->params[i]);
+
+    switch (op->kind)
+    {
+    case QUERY_OP_GUID:
+    {
+        const GncGUID *guid =
+            ((const GncGUID* (*)(gpointer, QofParam*))getter->param_getfcn)
+            (object, getter);
+        gboolean found = guid && g_hash_table_contains (op->guids, guid);
+        result = ((query_guid_t) op->pdata)->options == QOF_GUID_MATCH_ANY ?
+                 found : !found;
+        break;
+    }
+    case QUERY_OP_DATE:
+        result = query_op_match_date (op, object, getter);
+        break;
+    case QUERY_OP_NUMERIC:
+        result = query_op_match_numeric (op, object, getter);
+        break;
+    case QUERY_OP_STRING:
+    case QUERY_OP_REGEX:
+        result = query_op_match_string (op, object, getter);
+        break;
+    default:
+        result = op->pred_fcn (object, getter, op->pdata);
+        break;
+    }
+    return result != op->invert;
+}
+
+/* Set matched[i] for each of the n objects that passes the query. */
+static void
+query_program_run (const QofQuery *q, gpointer *objects, guint n,
+                   gboolean *matched)
+{
+    guint selected[QUERY_BATCH_SIZE];
+    guint i, j;
+
+    g_assert (n <= QUERY_BATCH_SIZE);
 
     /* If there are no terms, assume a "match any" applies.
      * A query with no terms is still meaningful, since the user
      * may want to get all objects, but in a particular sorted
      * order.
      */
-    if (NULL == q->terms) return 1;
-    return 0;
+    for (i = 0; i < n; i++)
+        matched[i] = (q->program->len == 0);
+
+    for (i = 0; i < q->program->len; i++)
+    {
+        GArray *ops = static_cast<GArray*>(g_ptr_array_index (q->program, i));
+        guint n_selected = 0;
+
+        for (j = 0; j < n; j++)
+            if (!matched[j])
+                selected[n_selected++] = j;
+
+        for (j = 0; j < ops->len && n_selected; j++)
+        {
+            const QofQueryOp *op = &g_array_index (ops, QofQueryOp, j);
+            guint k, kept = 0;
+
+            for (k = 0; k < n_selected; k++)
+                if (query_op_check (op, objects[selected[k]]))
+                    selected[kept++] = selected[k];
+            n_selected = kept;
+        }
+
+        for (j = 0; j < n_selected; j++)
+            matched[selected[j]] = TRUE;
+    }
 }
 
 /* walk the list of parameters, starting with the given object, and
@@ -542,6 +898,8 @@ static void compile_terms (QofQuery *q)
         }
     }
 
+    query_program_compile (q);
+
     /* Update the sort functions */
     compile_sort (&(q->primary_sort), q->search_for);
     compile_sort (&(q->secondary_sort), q->search_for);
@@ -567,17 +925,119 @@ static void compile_terms (QofQuery *q)
     LEAVE (" query=%p", q);
 }
 
+/* Order results by the query's sort, then by the order they were found
+ * in.  That is the order a stable sort of the whole list would give. */
+static gint
+result_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const QofQueryCB *ql = static_cast<const QofQueryCB*>(user_data);
+    const QofQueryResult *ra = static_cast<const QofQueryResult*>(a);
+    const QofQueryResult *rb = static_cast<const QofQueryResult*>(b);
+
+    if (ql->sorted)
+    {
+        int retval = sort_func (ra->object, rb->object, ql->query);
+        if (retval)
+            return retval;
+    }
+    return ra->seq < rb->seq ? -1 : ra->seq > rb->seq;
+}
+
+/* When only the last ql->limit results in sort order are wanted, the
+ * results array is a heap with the least wanted of them at the top. */
+static void
+result_heap_sift_down (QofQueryCB *ql, guint i)
+{
+    GArray *heap = ql->results;
+
+    while (TRUE)
+    {
+        guint least = i, left = 2 * i + 1, right = 2 * i + 2;
+        QofQueryResult tmp;
+
+        if (left < heap->len &&
+            result_cmp (&g_array_index (heap, QofQueryResult, left),
+                        &g_array_index (heap, QofQueryResult, least), ql) < 0)
+            least = left;
+        if (right < heap->len &&
+            result_cmp (&g_array_index (heap, QofQueryResult, right),
+                        &g_array_index (heap, QofQueryResult, least), ql) < 0)
+            least = right;
+        if (least == i)
+            return;
+
+        tmp = g_array_index (heap, QofQueryResult, i);
+        g_array_index (heap, QofQueryResult, i) =
+            g_array_index (heap, QofQueryResult, least);
+        g_array_index (heap, QofQueryResult, least) = tmp;
+        i = least;
+    }
+}
+
+static void
+result_add (QofQueryCB *ql, gpointer object)
+{
+    QofQueryResult result = { object, (guint) ql->count++ };
+    GArray *heap = ql->results;
+    guint i;
+
+    if (ql->limit < 0)
+    {
+        g_array_append_val (ql->results, result);
+        return;
+    }
+    if (ql->limit == 0)
+        return;
+
+    if (heap->len == (guint) ql->limit)
+    {
+        if (result_cmp (&result, &g_array_index (heap, QofQueryResult, 0),
+                        ql) <= 0)
+            return;
+        g_array_index (heap, QofQueryResult, 0) = result;
+        result_heap_sift_down (ql, 0);
+        return;
+    }
+
+    g_array_append_val (heap, result);
+    for (i = heap->len - 1; i > 0; i = (i - 1) / 2)
+    {
+        guint parent = (i - 1) / 2;
+        QofQueryResult tmp;
+
+        if (result_cmp (&g_array_index (heap, QofQueryResult, parent),
+                        &g_array_index (heap, QofQueryResult, i), ql) <= 0)
+            break;
+        tmp = g_array_index (heap, QofQueryResult, i);
+        g_array_index (heap, QofQueryResult, i) =
+            g_array_index (heap, QofQueryResult, parent);
+        g_array_index (heap, QofQueryResult, parent) = tmp;
+    }
+}
+
+static void check_batch (QofQueryCB* ql)
+{
+    gboolean matched[QUERY_BATCH_SIZE];
+    guint i;
+
+    query_program_run (ql->query, ql->batch, ql->batch_len, matched);
+    for (i = 0; i < ql->batch_len; i++)
+    {
+        if (matched[i])
+            result_add (ql, ql->batch[i]);
+    }
+    ql->batch_len = 0;
+}
+
 static void check_item_cb (gpointer object, gpointer user_data)
 {
     QofQueryCB* ql = static_cast<QofQueryCB*>(user_data);
 
     if (!object || !ql) return;
 
-    if (check_object (ql->query, object))
-    {
-        ql->list = g_list_prepend (ql->list, object);
-        ql->count++;
-    }
+    ql->batch[ql->batch_len++] = object;
+    if (ql->batch_len == QUERY_BATCH_SIZE)
+        check_batch (ql);
     return;
 }
 
@@ -706,6 +1166,7 @@ void qof_query_purge_terms (QofQuery *q, QofQueryParamList *param_list)
                     q->terms = g_list_remove_link (static_cast<GList*>(q->terms), _or_);
                     g_list_free_1 (_or_);
                     _or_ = q->terms;
+                    q->changed = 1;
                     break;
                 }
                 else
@@ -736,10 +1197,8 @@ static GList * qof_query_run_internal (QofQuery *q,
     g_return_val_if_fail (run_cb, NULL);
     ENTER (" q=%p", q);
 
-    /* XXX: Prioritize the query terms? */
-
-    /* prepare the Query for processing */
-    if (q->changed)
+    /* prepare the Query for processing; this also orders the terms */
+    if (q->changed || !q->program)
     {
         query_clear_compiles (q);
         compile_terms (q);
@@ -749,63 +1208,42 @@ static GList * qof_query_run_internal (QofQuery *q,
     if (qof_log_check (log_module, QOF_LOG_DEBUG))
         qof_query_print (q);
 
-    /* Now run the query over all the objects and save the results */
+    /* Now run the query over all the objects and save the results.
+     * With a result limit only the last max_results objects in sort
+     * order are kept, in a heap, so the whole match set is never
+     * sorted. */
     {
         QofQueryCB qcb;
+        guint i;
 
         memset (&qcb, 0, sizeof (qcb));
         qcb.query = q;
+        qcb.limit = q->max_results;
+        qcb.sorted = (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+                      (q->primary_sort.use_default && q->defaultSort));
+        qcb.results = g_array_sized_new (FALSE, FALSE, sizeof (QofQueryResult),
+                                         qcb.limit > 0 ? qcb.limit : 0);
 
         /* Run the query callback */
         run_cb(&qcb, cb_arg);
-
-        matching_objects = qcb.list;
-        object_count = qcb.count;
+        if (qcb.batch_len)
+            check_batch (&qcb);
+
+        /* The results are either in the order they were found or a
+         * heap; either way sorting them gives the final order. */
+        if (qcb.sorted || qcb.limit >= 0)
+            g_array_sort_with_data (qcb.results, result_cmp, &qcb);
+
+        for (i = qcb.results->len; i > 0; i--)
+            matching_objects =
+                g_list_prepend (matching_objects,
+                                g_array_index (qcb.results, QofQueryResult,
+                                               i - 1).object);
+        object_count = qcb.results->len;
+        g_array_free (qcb.results, TRUE);
     }
     PINFO ("matching objects=%p count=%d", matching_objects, object_count);
 
-    /* There is no absolute need to reverse this list, since it's being
-     * sorted below. However, in the common case, we will be searching
-     * in a confined location where the objects are already in order,
-     * thus reversing will put us in the correct order we want and make
-     * the sorting go much faster.
-     */
-    matching_objects = g_list_reverse(matching_objects);
-
-    /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
-    {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
-    }
-
-    /* Crop the list to limit the number of splits. */
-    if ((object_count > q->max_results) && (q->max_results > -1))
-    {
-        if (q->max_results > 0)
-        {
-            GList *mptr;
-
-            /* mptr is set to the first node of what will be the new list */
-            mptr = g_list_nth(matching_objects, object_count - q->max_results);
-            /* mptr should not be NULL, but let's be safe */
-            if (mptr != NULL)
-            {
-                if (mptr->prev != NULL) mptr->prev->next = NULL;
-                mptr->prev = NULL;
-            }
-            g_list_free(matching_objects);
-            matching_objects = mptr;
-        }
-        else
-        {
-            /* q->max_results == 0 */
-            g_list_free(matching_objects);
-            matching_objects = NULL;
-        }
-        object_count = q->max_results;
-    }
-
     q->changed = 0;
 
     g_list_free(q->results);
@@ -825,21 +1263,12 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
     for (node = qcb->query->books; node; node = node->next)
     {
         QofBook* book = static_cast<QofBook*>(node->data);
-#ifdef QOF_BACKEND_QUERY
         QofBackend* be = book->backend;
 
-
+        /* Let a backend that loads on demand fetch what the query needs */
         if (be)
-        {
-            gpointer compiled_query = g_hash_table_lookup (qcb->query->be_compiled,
-                                      book);
+            be->run_query (qcb->query);
 
-            if (compiled_query && be->run_query)
-            {
-                (be->run_query) (be, compiled_query);
-            }
-        }
-#endif
         /* And then iterate over all the objects */
         qof_object_foreach (qcb->query->search_for, book,
                             (QofInstanceForeachCB) check_item_cb, qcb);
@@ -1021,6 +1450,7 @@ QofQuery * qof_query_copy (QofQuery *q)
     copy_sort (&(copy->tertiary_sort), &(q->tertiary_sort));
 
     copy->changed = 1;
+    copy->program = NULL;
 
     return copy;
 }
@@ -512,10 +512,24 @@ QofSessionImpl::ensure_all_data_loaded () noexcept
     push_error (backend->get_error(), {});
 }
 
+/* A book whose backend left transactions in the database has to be
+ * completed before another backend writes it out, or only what happened
+ * to be loaded would be written. */
+static void
+load_book_completely (QofBook* book)
+{
+    if (!qof_book_loads_on_demand (book))
+        return;
+    auto backend = qof_book_get_backend (book);
+    backend->load (book, LOAD_TYPE_LOAD_ALL);
+}
+
 void
 QofSessionImpl::swap_books (QofSessionImpl & other) noexcept
 {
     ENTER ("sess1=%p sess2=%p", this, &other);
+    load_book_completely (m_book);
+    load_book_completely (other.m_book);
     // don't swap (that is, double-swap) read_only flags
     std::swap (m_book->read_only, other.m_book->read_only);
     std::swap (m_book, other.m_book);
@@ -557,6 +571,7 @@ QofSessionImpl::export_session (QofSessionImpl & real_session,
 
     backend2->set_percentage(percentage_func);
 
+    load_book_completely (real_book);
     backend2->export_coa(real_book);
     auto err = backend2->get_error();
     if (err != ERR_BACKEND_NO_ERR)
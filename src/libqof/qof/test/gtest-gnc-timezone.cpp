@@ -79,3 +79,38 @@ TEST(gnc_timezone_constructors, test_bogus_time_constructor)
     EXPECT_EQ(machine.get(2006)->std_zone_abbrev(),
 	      tzp.get(2006)->std_zone_abbrev());
 }
+
+TEST(gnc_timezone_functions, test_get_offset)
+{
+#if PLATFORM(WINDOWS)
+    std::string timezone("Pacific Standard Time");
+#else
+    std::string timezone("America/Los_Angeles");
+#endif
+    TimeZoneProvider tzp (timezone);
+    int32_t offset;
+    bool isdst;
+    using boost::posix_time::hours;
+    using boost::posix_time::seconds;
+    const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+    EXPECT_TRUE(tzp.get_offset (1326628800, offset, isdst)); // 2012-01-15 12:00Z
+    EXPECT_EQ(-8 * 3600, offset);
+    EXPECT_FALSE(isdst);
+    EXPECT_TRUE(tzp.get_offset (1342353600, offset, isdst)); // 2012-07-15 12:00Z
+    EXPECT_EQ(-7 * 3600, offset);
+    EXPECT_TRUE(isdst);
+    EXPECT_FALSE(tzp.get_offset (-2208988801, offset, isdst));
+    EXPECT_FALSE(tzp.get_offset (4133980800, offset, isdst));
+
+/* Every 25 hours and a second, so that all times of day get checked. */
+    for (int64_t time = -2208988800; time < 4133980800; time += 90001)
+    {
+        boost::posix_time::ptime temp(epoch.date(),
+                                      hours(time / 3600) + seconds(time % 3600));
+        boost::local_time::local_date_time ldt(temp, tzp.get(temp.date().year()));
+        ASSERT_TRUE(tzp.get_offset (time, offset, isdst));
+        ASSERT_EQ((ldt.local_time() - ldt.utc_time()).total_seconds(), offset);
+        ASSERT_EQ(ldt.is_dst(), isdst);
+    }
+}
@@ -0,0 +1,110 @@
+/********************************************************************
+ * test-gnc-timezone-perf.cpp: Compare the timezone transition      *
+ * table with boost::local_time conversions.                        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+/* Not run as part of make check: this is a benchmark.  It converts
+ * times from 1900 through 2100 to local struct tms in the current
+ * timezone (set TZ to try others), once with GncDateTime::local_tm and
+ * once through a GncDateTime, checks that every field agrees and prints
+ * how long each took.
+ *
+ * Usage: test-gnc-timezone-perf [step-in-seconds]
+ * The default step is 3593 seconds, a bit under an hour, so that the
+ * times fall at every time of day.
+ */
+extern "C"
+{
+#include "config.h"
+}
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include "../gnc-datetime.hpp"
+
+static const time64 begin_time = INT64_C(-2208988800); // 1900-01-01T00:00:00Z
+static const time64 end_time = INT64_C(4133980800);   // 2101-01-01T00:00:00Z
+
+static bool
+tm_equal (const struct tm& a, const struct tm& b)
+{
+    return a.tm_year == b.tm_year && a.tm_mon == b.tm_mon &&
+        a.tm_mday == b.tm_mday && a.tm_hour == b.tm_hour &&
+        a.tm_min == b.tm_min && a.tm_sec == b.tm_sec &&
+        a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday &&
+        a.tm_isdst == b.tm_isdst
+#if HAVE_STRUCT_TM_GMTOFF
+        && a.tm_gmtoff == b.tm_gmtoff
+#endif
+        ;
+}
+
+int
+main (int argc, char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using seconds = std::chrono::duration<double>;
+    time64 step = 3593;
+    unsigned long count = 0, mismatches = 0;
+    volatile int sink = 0;
+
+    if (argc > 1)
+        step = strtoll (argv[1], nullptr, 10);
+    if (step <= 0)
+        return 1;
+
+    /* Build the table before timing anything. */
+    GncDateTime::offset (0);
+
+    auto start = clock::now();
+    for (auto t = begin_time; t < end_time; t += step)
+        sink = GncDateTime::local_tm (t).tm_hour;
+    auto fast = seconds(clock::now() - start).count();
+
+    start = clock::now();
+    for (auto t = begin_time; t < end_time; t += step)
+        sink = static_cast<struct tm>(GncDateTime (t)).tm_hour;
+    auto slow = seconds(clock::now() - start).count();
+
+    for (auto t = begin_time; t < end_time; t += step, ++count)
+    {
+        auto fast_tm = GncDateTime::local_tm (t);
+        auto slow_tm = static_cast<struct tm>(GncDateTime (t));
+        if (!tm_equal (fast_tm, slow_tm))
+        {
+            if (mismatches++ < 10)
+                printf ("Mismatch at %" PRId64 ": %04d-%02d-%02d %02d:%02d:%02d"
+                        " dst %d, expected %04d-%02d-%02d %02d:%02d:%02d dst %d\n",
+                        t, fast_tm.tm_year + 1900, fast_tm.tm_mon + 1,
+                        fast_tm.tm_mday, fast_tm.tm_hour, fast_tm.tm_min,
+                        fast_tm.tm_sec, fast_tm.tm_isdst,
+                        slow_tm.tm_year + 1900, slow_tm.tm_mon + 1,
+                        slow_tm.tm_mday, slow_tm.tm_hour, slow_tm.tm_min,
+                        slow_tm.tm_sec, slow_tm.tm_isdst);
+        }
+    }
+
+    printf ("Converted %lu times: transition table %.3f s, boost %.3f s\n",
+            count, fast, slow);
+    printf ("%lu mismatches\n", mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -77,8 +77,89 @@ test_qof_string_cache( void )
     g_assert(str1_1 != str1_4);
 }
 
+static void
+test_qof_string_cache_stats( void )
+{
+    QofStringCacheStats stats;
+    gchar* long_str = g_strnfill(5000, 'x');
+    gpointer cached[3];
+
+    qof_string_cache_destroy();
+    qof_string_cache_get_stats(&stats);
+    g_assert_cmpuint(stats.unique_strings, ==, 0);
+    g_assert_cmpuint(stats.references, ==, 0);
+
+    cached[0] = qof_string_cache_insert("memo");
+    cached[1] = qof_string_cache_insert("memo");
+    cached[2] = qof_string_cache_insert(long_str);
+    qof_string_cache_get_stats(&stats);
+    g_assert_cmpuint(stats.unique_strings, ==, 2);
+    g_assert_cmpuint(stats.references, ==, 3);
+    g_assert_cmpuint(stats.string_bytes, ==, 5 + 5001);
+    g_assert_cmpuint(stats.bytes_saved, ==, 5);
+    g_assert_cmpuint(stats.allocated_bytes, >=, stats.string_bytes);
+    g_assert_cmpstr(cached[2], ==, long_str);
+
+    qof_string_cache_remove(cached[0]);
+    qof_string_cache_remove(cached[2]);
+    qof_string_cache_get_stats(&stats);
+    g_assert_cmpuint(stats.unique_strings, ==, 1);
+    g_assert_cmpuint(stats.references, ==, 1);
+    g_assert_cmpuint(stats.bytes_saved, ==, 0);
+    qof_string_cache_remove(cached[1]);
+    qof_string_cache_get_stats(&stats);
+    g_assert_cmpuint(stats.unique_strings, ==, 0);
+    g_free(long_str);
+}
+
+#define NUM_THREADS 4
+#define NUM_STRINGS 5000
+
+static gpointer
+cache_thread(gpointer data)
+{
+    gpointer* cached = data;
+    gchar buf[32];
+    gint i;
+
+    for (i = 0; i < NUM_STRINGS; i++)
+    {
+        g_snprintf(buf, sizeof(buf), "string %d", i);
+        cached[i] = qof_string_cache_insert(buf);
+    }
+    /* Drop every other reference again to exercise removal as well. */
+    for (i = 0; i < NUM_STRINGS; i += 2)
+        qof_string_cache_remove(cached[i]);
+    return NULL;
+}
+
+static void
+test_qof_string_cache_threads( void )
+{
+    gpointer cached[NUM_THREADS][NUM_STRINGS];
+    GThread* threads[NUM_THREADS];
+    QofStringCacheStats stats;
+    gint i, j;
+
+    qof_string_cache_destroy();
+    for (i = 0; i < NUM_THREADS; i++)
+        threads[i] = g_thread_new("cache", cache_thread, cached[i]);
+    for (i = 0; i < NUM_THREADS; i++)
+        g_thread_join(threads[i]);
+
+    qof_string_cache_get_stats(&stats);
+    g_assert_cmpuint(stats.unique_strings, ==, NUM_STRINGS / 2);
+    g_assert_cmpuint(stats.references, ==, NUM_THREADS * NUM_STRINGS / 2);
+    for (j = 1; j < NUM_STRINGS; j += 2)
+        for (i = 1; i < NUM_THREADS; i++)
+            g_assert(cached[i][j] == cached[0][j]);
+    qof_string_cache_destroy();
+}
+
 void
 test_suite_qof_string_cache ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "string-cache", test_qof_string_cache);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache stats", test_qof_string_cache_stats);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache threads", test_qof_string_cache_threads);
 }
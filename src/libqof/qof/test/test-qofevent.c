@@ -0,0 +1,225 @@
+/********************************************************************
+ * test-qofevent.c: GLib g_test test suite for qofevent.cpp.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+#include "config.h"
+#include <glib.h>
+#include <unittest-support.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qofevent";
+void test_suite_qofevent ( void );
+
+typedef struct
+{
+    QofBook *book;
+    QofInstance *watched;
+    QofInstance *other;
+} Fixture;
+
+typedef struct
+{
+    gint calls;
+    /* Shared between recorders, each appends its tag when called */
+    GString *order;
+    const gchar *tag;
+    gint handler_id;
+    gint n_events;
+    QofEventInfo events[4];
+} Recorder;
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    fixture->book = qof_book_new();
+    fixture->watched = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data(fixture->watched, "watched", fixture->book);
+    fixture->other = g_object_new(QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data(fixture->other, "other", fixture->book);
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    g_object_unref(fixture->watched);
+    g_object_unref(fixture->other);
+    qof_book_destroy(fixture->book);
+}
+
+static void
+record_handler( QofInstance *ent, QofEventId event_type,
+                gpointer handler_data, gpointer event_data )
+{
+    Recorder *rec = handler_data;
+    rec->calls++;
+    if (rec->order)
+        g_string_append(rec->order, rec->tag);
+}
+
+static void
+unregister_handler( QofInstance *ent, QofEventId event_type,
+                    gpointer handler_data, gpointer event_data )
+{
+    Recorder *rec = handler_data;
+    rec->calls++;
+    qof_event_unregister_handler(rec->handler_id);
+}
+
+static void
+record_batch_handler( const QofEventInfo *events, guint n_events,
+                      gpointer handler_data )
+{
+    Recorder *rec = handler_data;
+    guint i;
+
+    rec->calls++;
+    rec->n_events = n_events;
+    for (i = 0; i < n_events && i < G_N_ELEMENTS(rec->events); i++)
+        rec->events[i] = events[i];
+}
+
+static void
+test_qof_event_filtered_handler( Fixture *fixture, gconstpointer pData )
+{
+    Recorder any = { 0 }, typed = { 0 };
+    gint any_id, typed_id;
+
+    any_id = qof_event_register_handler(record_handler, &any);
+    typed_id = qof_event_register_filtered_handler("watched", QOF_EVENT_MODIFY,
+               record_handler, &typed);
+    g_assert_cmpint(any_id, !=, typed_id);
+
+    qof_event_gen(fixture->watched, QOF_EVENT_CREATE, NULL);
+    qof_event_gen(fixture->other, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpint(any.calls, ==, 3);
+    g_assert_cmpint(typed.calls, ==, 1);
+
+    /* Suspended events don't reach any of them */
+    qof_event_suspend();
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    qof_event_resume();
+    g_assert_cmpint(any.calls, ==, 3);
+    g_assert_cmpint(typed.calls, ==, 1);
+
+    qof_event_unregister_handler(typed_id);
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpint(any.calls, ==, 4);
+    g_assert_cmpint(typed.calls, ==, 1);
+    qof_event_unregister_handler(any_id);
+}
+
+static void
+test_qof_event_handler_order( Fixture *fixture, gconstpointer pData )
+{
+    Recorder first = { 0 }, second = { 0 }, typed = { 0 }, self = { 0 };
+    GString *order = g_string_new(NULL);
+    gint ids[3];
+
+    first.order = second.order = typed.order = order;
+    first.tag = "a";
+    second.tag = "b";
+    typed.tag = "c";
+
+    /* The most recently registered handler runs first, whether it is
+     * watching the entity's type or any type */
+    ids[0] = qof_event_register_handler(record_handler, &first);
+    ids[1] = qof_event_register_filtered_handler("watched", QOF_EVENT_NONE,
+             record_handler, &typed);
+    ids[2] = qof_event_register_filtered_handler(NULL, QOF_EVENT_NONE,
+             record_handler, &second);
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpstr(order->str, ==, "bca");
+
+    /* A handler may unregister itself while the event is delivered */
+    self.handler_id = qof_event_register_filtered_handler("watched", 0,
+                      unregister_handler, &self);
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpint(self.calls, ==, 1);
+    g_assert_cmpstr(order->str, ==, "bcabcabca");
+    g_assert_cmpint(first.calls, ==, 3);
+    g_assert_cmpint(second.calls, ==, 3);
+    g_assert_cmpint(typed.calls, ==, 3);
+
+    qof_event_unregister_handler(ids[0]);
+    qof_event_unregister_handler(ids[1]);
+    qof_event_unregister_handler(ids[2]);
+    g_string_free(order, TRUE);
+}
+
+static void
+test_qof_event_batch_handler( Fixture *fixture, gconstpointer pData )
+{
+    Recorder rec = { 0 };
+    gint id;
+    gchar data[] = "data";
+
+    id = qof_event_register_batch_handler("watched",
+                                          QOF_EVENT_MODIFY | QOF_EVENT_DESTROY,
+                                          record_batch_handler, &rec);
+
+    /* Outside of a batch, each event is delivered right away */
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, data);
+    g_assert_cmpint(rec.calls, ==, 1);
+    g_assert_cmpint(rec.n_events, ==, 1);
+    g_assert_cmpint(rec.events[0].event_type, ==, QOF_EVENT_MODIFY);
+    g_assert(guid_equal(&rec.events[0].guid,
+                        qof_instance_get_guid(fixture->watched)));
+
+    qof_event_begin_batch();
+    qof_event_gen(fixture->watched, QOF_EVENT_CREATE, NULL);
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, data);
+    qof_event_gen(fixture->other, QOF_EVENT_MODIFY, NULL);
+    qof_event_begin_batch();
+    qof_event_gen(fixture->watched, QOF_EVENT_DESTROY, NULL);
+    qof_event_end_batch();
+    g_assert_cmpint(rec.calls, ==, 1);
+    qof_event_end_batch();
+
+    g_assert_cmpint(rec.calls, ==, 2);
+    g_assert_cmpint(rec.n_events, ==, 2);
+    g_assert_cmpint(rec.events[0].event_type, ==, QOF_EVENT_MODIFY);
+    g_assert_cmpint(rec.events[1].event_type, ==, QOF_EVENT_DESTROY);
+    g_assert_cmpstr(rec.events[1].entity_type, ==, "watched");
+    g_assert(guid_equal(&rec.events[1].guid,
+                        qof_instance_get_guid(fixture->watched)));
+
+    /* Nothing matched, nothing to deliver */
+    qof_event_begin_batch();
+    qof_event_gen(fixture->other, QOF_EVENT_MODIFY, NULL);
+    qof_event_end_batch();
+    g_assert_cmpint(rec.calls, ==, 2);
+
+    /* Events collected for a handler unregistered in the meantime are
+     * dropped */
+    qof_event_begin_batch();
+    qof_event_gen(fixture->watched, QOF_EVENT_MODIFY, NULL);
+    qof_event_unregister_handler(id);
+    qof_event_end_batch();
+    g_assert_cmpint(rec.calls, ==, 2);
+}
+
+void
+test_suite_qofevent ( void )
+{
+    GNC_TEST_ADD( suitename, "filtered handler", Fixture, NULL, setup, test_qof_event_filtered_handler, teardown );
+    GNC_TEST_ADD( suitename, "handler order", Fixture, NULL, setup, test_qof_event_handler_order, teardown );
+    GNC_TEST_ADD( suitename, "batch handler", Fixture, NULL, setup, test_qof_event_batch_handler, teardown );
+}
@@ -753,6 +753,84 @@ mock_refers_to_object_from_col( const QofInstance* inst, const QofInstance* ref
     return TRUE;
 }
 
+typedef struct
+{
+    GHashTable *removed;  /* visited or removed entities */
+    GList *next;          /* where to look for the next one to remove */
+} ForeachRemoveData;
+
+static void
+collection_foreach_remove_cb( QofInstance *inst, gpointer user_data )
+{
+    ForeachRemoveData *data = static_cast<ForeachRemoveData*>(user_data);
+
+    /* Entities removed so far must have been skipped. */
+    g_assert( !g_hash_table_contains( data->removed, inst ) );
+    g_hash_table_add( data->removed, inst );
+    /* Remove the next entity that has not been visited yet */
+    for (; data->next; data->next = data->next->next)
+        if (!g_hash_table_contains( data->removed, data->next->data ))
+        {
+            qof_collection_remove_entity( QOF_INSTANCE( data->next->data ));
+            g_hash_table_add( data->removed, data->next->data );
+            break;
+        }
+}
+
+static void
+collection_count_cb( QofInstance *inst, gpointer user_data )
+{
+    g_atomic_int_inc( static_cast<gint*>(user_data) );
+}
+
+static void
+test_collection_foreach( void )
+{
+    QofIdType type = "test type";
+    QofBook *book = qof_book_new();
+    QofCollection *coll = qof_book_get_collection( book, type );
+    GList *inst_list = NULL, *node;
+    ForeachRemoveData data;
+    /* Enough entities for qof_collection_foreach_parallel to use threads */
+    const gint num_insts = 20000;
+    gint count = 0;
+    int i;
+
+    for (i = 0; i < num_insts; i++)
+    {
+        auto inst = static_cast<QofInstance*>(g_object_new( QOF_TYPE_INSTANCE, NULL ));
+        qof_instance_init_data( inst, type, book );
+        inst_list = g_list_prepend( inst_list, inst );
+    }
+    g_assert_cmpint( qof_collection_count( coll ), == , num_insts );
+
+    g_test_message( "Test the parallel walk visits every entity once" );
+    qof_collection_foreach_parallel( coll, collection_count_cb, &count );
+    g_assert_cmpint( count, == , num_insts );
+
+    g_test_message( "Test removing entities while walking the collection" );
+    data.removed = g_hash_table_new( g_direct_hash, g_direct_equal );
+    data.next = inst_list;
+    qof_collection_foreach( coll, collection_foreach_remove_cb, &data );
+    g_assert_cmpint( qof_collection_count( coll ), == , num_insts / 2 );
+    count = 0;
+    qof_collection_foreach( coll, collection_count_cb, &count );
+    g_assert_cmpint( count, == , num_insts / 2 );
+    for (node = inst_list; node; node = node->next)
+    {
+        auto inst = QOF_INSTANCE( node->data );
+        auto found = qof_collection_lookup_entity( coll, qof_instance_get_guid( inst ));
+        g_assert( found == NULL || found == inst );
+        if (found) count--;
+    }
+    g_assert_cmpint( count, == , 0 );
+
+    g_list_foreach( inst_list, (GFunc) g_object_unref, NULL );
+    g_list_free( inst_list );
+    g_hash_table_destroy( data.removed );
+    qof_book_destroy( book );
+}
+
 static void
 test_instance_get_referring_object_list_from_collection( void )
 {
@@ -1047,6 +1125,7 @@ test_suite_qofinstance ( void )
     GNC_TEST_ADD( suitename, "commit edit", Fixture, NULL, setup, test_instance_commit_edit, teardown );
     GNC_TEST_ADD( suitename, "commit edit part 2", Fixture, NULL, setup, test_instance_commit_edit_part2, teardown );
     GNC_TEST_ADD( suitename, "instance refers to object", Fixture, NULL, setup, test_instance_refers_to_object, teardown );
+    GNC_TEST_ADD_FUNC( suitename, "collection foreach", test_collection_foreach );
     GNC_TEST_ADD_FUNC( suitename, "instance get referring object list from collection", test_instance_get_referring_object_list_from_collection );
     GNC_TEST_ADD_FUNC( suitename, "instance get typed referring object list", test_instance_get_typed_referring_object_list);
     GNC_TEST_ADD_FUNC( suitename, "instance get referring object list", test_instance_get_referring_object_list );
@@ -677,6 +677,24 @@ methods_return_instance_lists(
                        })
 Account.name = property( Account.GetName, Account.SetName )
 
+#GncBalanceGrid
+class GncBalanceGrid(GnuCashCoreClass):
+    """The balances of a number of accounts at a number of dates.
+
+    Add the accounts with add_account() and the dates with add_date(),
+    then get_balance() and get_change() take an account and the index
+    of a date.  All balances are computed in one pass over the splits
+    of each account.
+    """
+
+GncBalanceGrid.add_constructor_and_methods_with_prefix('gnc_balance_grid_', 'new')
+
+balance_grid_dict = {
+                    'get_balance' : GncNumeric,
+                    'get_change' : GncNumeric
+                }
+methods_return_instance(GncBalanceGrid, balance_grid_dict)
+
 #GUID
 GUID.add_methods_with_prefix('guid_')
 GUID.add_method('xaccAccountLookup', 'AccountLookup')
@@ -1,7 +1,8 @@
 from unittest import main
 from datetime import datetime
+from time import mktime
 from gnucash import Book, Account, Split, GncCommodity, GncNumeric, \
-    Transaction
+    Transaction, GncBalanceGrid
 
 from test_book import BookSession
 
@@ -66,5 +67,47 @@ class TestAccount( AccountSession ):
         self.account.ScrubLots()
         self.assertEqual(len(self.account.GetLotList()),1)
 
+    def test_balance_grid(self):
+        self.account.SetCommodity(self.currency)
+        other = Account(self.book)
+        other.SetCommodity(self.currency)
+
+        for day, amount in ((1, 10), (3, 20)):
+            tx = Transaction(self.book)
+            tx.BeginEdit()
+            tx.SetCurrency(self.currency)
+            tx.SetDateEnteredTS(datetime.now())
+            tx.SetDatePostedTS(datetime(2016, 1, day, 12))
+
+            s1 = Split(self.book)
+            s1.SetParent(tx)
+            s1.SetAccount(self.account)
+            s1.SetAmount(GncNumeric(amount))
+            s1.SetValue(GncNumeric(amount))
+
+            s2 = Split(self.book)
+            s2.SetParent(tx)
+            s2.SetAccount(other)
+            s2.SetAmount(GncNumeric(-amount))
+            s2.SetValue(GncNumeric(-amount))
+
+            tx.CommitEdit()
+
+        grid = GncBalanceGrid()
+        grid.add_account(self.account)
+        grid.add_account(other)
+        for day in (4, 2):
+            grid.add_date(int(mktime(datetime(2016, 1, day).timetuple())))
+
+        # the dates were added latest first
+        self.assertTrue(
+            grid.get_balance(self.account, 0).equal(GncNumeric(30)))
+        self.assertTrue(
+            grid.get_balance(self.account, 1).equal(GncNumeric(10)))
+        self.assertTrue(grid.get_balance(other, 1).equal(GncNumeric(-10)))
+        self.assertTrue(
+            grid.get_change(self.account, 1).equal(GncNumeric(-20)))
+        grid.destroy()
+
 if __name__ == '__main__':
     main()
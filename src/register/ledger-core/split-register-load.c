@@ -32,6 +32,7 @@
 #include "qof.h"
 #include "gnc-ui-util.h"
 #include "gnc-gui-query.h"
+#include "gnc-trans-quickfill.h"
 #include "numcell.h"
 #include "quickfillcell.h"
 #include "recncell.h"
@@ -48,6 +49,8 @@ static QofLogModule log_module = GNC_MOD_LEDGER;
 
 static void gnc_split_register_load_xfer_cells (SplitRegister *reg,
         Account *base_account);
+static void gnc_split_register_load_desc_cells (SplitRegister *reg,
+        Account *base_account);
 
 static void
 gnc_split_register_load_recn_cells (SplitRegister *reg)
@@ -509,6 +512,7 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
 
         /* load up account names into the transfer combobox menus */
         gnc_split_register_load_xfer_cells (reg, default_account);
+        gnc_split_register_load_desc_cells (reg, default_account);
         gnc_split_register_load_associate_cells (reg);
         gnc_split_register_load_recn_cells (reg);
         gnc_split_register_load_type_cells (reg);
@@ -793,6 +797,7 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
 /* ===================================================================== */
 
 #define QKEY  "split_reg_shared_quickfill"
+#define DESC_QKEY  "split_reg_shared_desc_quickfill"
 
 static gboolean
 skip_cb (Account *account, gpointer x)
@@ -833,4 +838,26 @@ gnc_split_register_load_xfer_cells (SplitRegister *reg, Account *base_account)
     gnc_combo_cell_use_list_store_cache (cell, store);
 }
 
+/* All registers of a book share the description quickfill, so that
+ * opening one doesn't build a quickfill of its own.  The transactions
+ * loaded into the register are still added to it. */
+static void
+gnc_split_register_load_desc_cells (SplitRegister *reg, Account *base_account)
+{
+    QofBook *book = NULL;
+    QuickFillCell *cell;
+
+    if (base_account)
+        book = gnc_account_get_book (base_account);
+    if (book == NULL)
+        book = gnc_get_current_book ();
+    if (book == NULL)
+        return;
+
+    cell = (QuickFillCell *)
+           gnc_table_layout_get_cell (reg->table->layout, DESC_CELL);
+    gnc_quickfill_cell_use_quickfill_cache (cell,
+                                            gnc_get_shared_trans_desc_quickfill (book, DESC_QKEY));
+}
+
 /* ====================== END OF FILE ================================== */
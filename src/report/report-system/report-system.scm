@@ -678,6 +678,8 @@
 (export gnc-commodity-collector-commodity-count)
 (export gnc:account-get-balance-at-date)
 (export gnc:account-get-comm-balance-at-date)
+(export gnc:account-get-comm-balances-at-dates)
+(export gnc:accounts-get-balances-at-dates)
 (export gnc:account-get-comm-value-interval)
 (export gnc:account-get-comm-value-at-date)
 (export gnc:accounts-get-balance-helper)
@@ -474,37 +474,66 @@
 ;; values rather than double values.
 (define (gnc:account-get-comm-balance-at-date account 
 					      date include-children?)
-  (let ((balance-collector (gnc:make-commodity-collector))
-	(query (qof-query-create-for-splits))
-	(splits #f))
+  (car (gnc:account-get-comm-balances-at-dates
+        account (list date) include-children?)))
+
+;; Returns a list of commodity-collectors, one for each date in
+;; dates, with the balance of the account as of that date. If
+;; include-children? is true, the balances of all children (not just
+;; direct children) are included.
+;;
+;; The balances for all accounts and dates are looked up in one go,
+;; so reports showing several dates should ask for all of them at
+;; once.
+(define (gnc:account-get-comm-balances-at-dates account
+                                                dates include-children?)
+  (let* ((accounts (if include-children?
+                       (cons account (gnc-account-get-descendants account))
+                       (list account)))
+         (balances (gnc:accounts-get-balances-at-dates accounts dates)))
+    (map
+     (lambda (index)
+       (let ((balance-collector (gnc:make-commodity-collector)))
+         (for-each
+          (lambda (acct)
+            (gnc-commodity-collector-add
+             balance-collector
+             (xaccAccountGetCommodity acct)
+             (vector-ref (hash-ref balances (gncAccountGetGUID acct))
+                         index)))
+          accounts)
+         balance-collector))
+     (iota (length dates)))))
+
+;; Returns a hash table from the GUID of each account in accounts to
+;; a vector of its balances, in the account's own commodity, one for
+;; each date in dates. Children are not included.
+;;
+;; All balances come from a single balance grid, which sweeps the
+;; splits of every account once for all the dates. Reports that need
+;; the balances of many accounts should get them all with one call.
+(define (gnc:accounts-get-balances-at-dates accounts dates)
+  (let ((grid (gnc-balance-grid-new))
+        (balances (make-hash-table 23)))
+
+    (for-each
+     (lambda (acct) (gnc-balance-grid-add-account grid acct))
+     accounts)
+    (for-each
+     (lambda (date)
+       (gnc-balance-grid-add-date grid (gnc:timepair->secs date)))
+     dates)
 
-      (if include-children?
-	  (for-each 
-	   (lambda (x) 
-	     (gnc-commodity-collector-merge balance-collector x))
-	   (gnc:account-map-descendants
-	    (lambda (child)
-	      (gnc:account-get-comm-balance-at-date child date #f))
-	    account)))
-
-      (qof-query-set-book query (gnc-get-current-book))
-      (xaccQueryAddSingleAccountMatch query account QOF-QUERY-AND)
-      (xaccQueryAddDateMatchTS query #f date #t date QOF-QUERY-AND)
-      (qof-query-set-sort-order query
-				(list SPLIT-TRANS TRANS-DATE-POSTED)
-				(list QUERY-DEFAULT-SORT)
-				'())
-      (qof-query-set-sort-increasing query #t #t #t)
-      (qof-query-set-max-results query 1)
-      
-      (set! splits (qof-query-run query))
-      (qof-query-destroy query)
-
-      (if (and splits (not (null? splits)))
-	  (gnc-commodity-collector-add balance-collector
-				       (xaccAccountGetCommodity account)
-				       (xaccSplitGetBalance (car splits))))
-      balance-collector))
+    (for-each
+     (lambda (acct)
+       (hash-set! balances (gncAccountGetGUID acct)
+                  (list->vector
+                   (map (lambda (index)
+                          (gnc-balance-grid-get-balance grid acct index))
+                        (iota (length dates))))))
+     accounts)
+    (gnc-balance-grid-destroy grid)
+    balances))
 
 ;; Calculate the increase in the balance of the account in terms of
 ;; "value" (as opposed to "amount") between the specified dates.
@@ -298,7 +298,6 @@
                       (gnc:date-option-absolute-time
                        (get-option gnc:pagename-general
                                    optname-date))))
-         (date-secs (gnc:timepair->secs date-tp))
          (report-form? (get-option gnc:pagename-general
                                optname-report-form))
          (standard-order? (get-option gnc:pagename-general 
@@ -420,14 +419,27 @@
        (+ (* 2 tree-depth)
 	  (if (equal? tabbing 'canonically-tabbed) 1 0))))
     
+    ;; The balances as of date-tp of every account that is summed
+    ;; below, all looked up with a single balance grid.  The grid
+    ;; counts splits posted on its date, xaccAccountGetBalanceAsOfDate
+    ;; doesn't, so it is asked for the second before date-tp.
+    (define account-balances
+      (gnc:accounts-get-balances-at-dates
+       (append asset-accounts liability-accounts equity-accounts
+               income-expense-accounts trading-accounts)
+       (list (gnc:secs->timepair (- (gnc:timepair->secs date-tp) 1)))))
+
     ;; Return a commodity collector containing the sum of the balance of all of 
-    ;; the accounts on acct-list as of the time given in date-secs 
-    (define (account-list-balance acct-list date-secs)
+    ;; the accounts on acct-list as of date-tp
+    (define (account-list-balance acct-list)
       (let ((balance-collector (gnc:make-commodity-collector)))
         (for-each
           (lambda (x)
             (balance-collector 'add (xaccAccountGetCommodity x)
-                                    (xaccAccountGetBalanceAsOfDate x date-secs)))
+                                    (vector-ref
+                                     (hash-ref account-balances
+                                               (gncAccountGetGUID x))
+                                     0)))
           acct-list)
       balance-collector))
 
@@ -504,10 +516,10 @@
 	  ;; to report earnings....  See discussion on bugzilla.
 	  (gnc:report-percent-done 4)
 	  ;; sum assets
-	  (set! asset-balance (account-list-balance asset-accounts date-secs))
+	  (set! asset-balance (account-list-balance asset-accounts))
 	  (gnc:report-percent-done 6)
 	  ;; sum liabilities
-	  (set! neg-liability-balance (account-list-balance liability-accounts date-secs))
+	  (set! neg-liability-balance (account-list-balance liability-accounts))
 	  (set! liability-balance
                 (gnc:make-commodity-collector))
           (liability-balance 'minusmerge
@@ -515,19 +527,19 @@
 			     #f)
 	  (gnc:report-percent-done 8)
 	  ;; sum equities
-	  (set! neg-equity-balance (account-list-balance equity-accounts date-secs))
+	  (set! neg-equity-balance (account-list-balance equity-accounts))
 	  (set! equity-balance (gnc:make-commodity-collector))
 	  (equity-balance 'minusmerge
 			  neg-equity-balance
 			  #f)
 	  (gnc:report-percent-done 12)
 	  ;; sum any retained earnings
-	  (set! neg-retained-earnings (account-list-balance income-expense-accounts date-secs))
+	  (set! neg-retained-earnings (account-list-balance income-expense-accounts))
 	  (set! retained-earnings (gnc:make-commodity-collector))
 	  (retained-earnings 'minusmerge
 			  neg-retained-earnings
 			  #f)
-	  (set! neg-trading-balance (account-list-balance trading-accounts date-secs))
+	  (set! neg-trading-balance (account-list-balance trading-accounts))
 	  (set! trading-balance (gnc:make-commodity-collector))
 	  (trading-balance 'minusmerge
 	                   neg-trading-balance
@@ -428,6 +428,32 @@
        table
        (+ (* 2 tree-depth)
 	  (if (equal? tabbing 'canonically-tabbed) 1 0))))
+
+    ;; The balances just before start-date-tp and as of end-date-tp
+    ;; of every account that is summed below, all looked up with a
+    ;; single balance grid.
+    (define account-balances
+      (gnc:accounts-get-balances-at-dates
+       (append revenue-accounts expense-accounts trading-accounts)
+       (list (gnc:secs->timepair (- (gnc:timepair->secs start-date-tp) 1))
+             end-date-tp)))
+
+    ;; Return a commodity collector containing the sum of the change
+    ;; of the balance of all of the accounts on acct-list over the
+    ;; period, closing entries included
+    (define (account-list-change acct-list)
+      (let ((change-collector (gnc:make-commodity-collector)))
+        (for-each
+          (lambda (x)
+            (let ((balances (hash-ref account-balances
+                                      (gncAccountGetGUID x))))
+              (change-collector 'add (xaccAccountGetCommodity x)
+                                (gnc-numeric-sub (vector-ref balances 1)
+                                                 (vector-ref balances 0)
+                                                 GNC-DENOM-AUTO
+                                                 GNC-RND-ROUND))))
+          acct-list)
+        change-collector))
     
     (gnc:html-document-set-title! 
      doc (sprintf #f
@@ -526,21 +552,15 @@
 		 start-date-tp end-date-tp)
 		) ;; this is norm negative (credit)
 	  (set! expense-total
-		(gnc:accountlist-get-comm-balance-interval-with-closing
-		 expense-accounts
-		 start-date-tp end-date-tp))
+		(account-list-change expense-accounts))
 	  (expense-total 'minusmerge expense-closing #f)
 	  (set! neg-revenue-total
-		(gnc:accountlist-get-comm-balance-interval-with-closing
-		 revenue-accounts
-		 start-date-tp end-date-tp))
+		(account-list-change revenue-accounts))
 	  (neg-revenue-total 'minusmerge revenue-closing #f)
 	  (set! revenue-total (gnc:make-commodity-collector))
 	  (revenue-total 'minusmerge neg-revenue-total #f)
           (set! trading-total 
-                (gnc:accountlist-get-comm-balance-interval-with-closing
-                 trading-accounts
-                 start-date-tp end-date-tp))
+                (account-list-change trading-accounts))
 	  ;; calculate net income
 	  (set! net-income (gnc:make-commodity-collector))
 	  (net-income 'merge revenue-total #f)